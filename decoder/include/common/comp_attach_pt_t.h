@@ -232,6 +232,59 @@ template<class T> void componentAttachPt<T>::set_enabled(const bool enable)
     m_enabled = enable;
 }
 
+/*!
+ * @class componentAttachPtImpl
+ * @brief Single attachment point that recognises a library implementation of the interface.
+ *
+ *  If the attached interface is an object of the final class C, impl() returns a pointer to it.
+ *  The owning component can then call the implementation directly, and have its inline
+ *  functions expanded, in throughput paths. Any other attached interface uses the
+ *  virtual path through first().
+ */
+template <class T, class C>
+class componentAttachPtImpl : public componentAttachPt<T> {
+public:
+    componentAttachPtImpl() : m_impl(0) {};
+    virtual ~componentAttachPtImpl() {};
+
+    virtual ocsd_err_t attach(T* component);
+    virtual ocsd_err_t detach(T* component);
+    virtual void detach_all();
+
+    /*!
+     * Return the attached implementation object - 0 if nothing attached, the attachment
+     * point is disabled, or the attached interface is not class C.
+     *
+     * @return  C*  : implementation pointer or 0.
+     */
+    C* impl() const { return this->m_enabled ? m_impl : 0; };
+
+private:
+    C *m_impl;  /**< attached interface as the implementation class */
+};
+
+template<class T, class C> ocsd_err_t componentAttachPtImpl<T, C>::attach(T* component)
+{
+    ocsd_err_t err = componentAttachPt<T>::attach(component);
+    if (err == OCSD_OK)
+        m_impl = dynamic_cast<C *>(component);
+    return err;
+}
+
+template<class T, class C> ocsd_err_t componentAttachPtImpl<T, C>::detach(T* component)
+{
+    ocsd_err_t err = componentAttachPt<T>::detach(component);
+    if (err == OCSD_OK)
+        m_impl = 0;
+    return err;
+}
+
+template<class T, class C> void componentAttachPtImpl<T, C>::detach_all()
+{
+    componentAttachPt<T>::detach_all();
+    m_impl = 0;
+}
+
 
 /** @}*/
 
@@ -40,6 +40,9 @@
 #include "comp_attach_pt_t.h"
 #include "interfaces/trc_tgt_mem_access_i.h"
 #include "interfaces/trc_instr_decode_i.h"
+#include "common/trc_instr_blk_cache.h"
+
+#define CODE_FOLLOW_FETCH_BYTES 32  //!< size of aligned block read into the opcode fetch buffer.
 
 /*!
  * @class OcsdCodeFollower
@@ -65,6 +68,8 @@ public:
     void setMemSpaceCSID(const uint8_t csid);                           //!< memory spaces might be partitioned by CSID
     void setISA(const ocsd_isa isa);    //!< set the ISA for the decode.
     void setDSBDMBasWP();   //!< DSB and DMB can be treated as WP in some archs.
+    void setBlockCacheEnable(const bool bEnable);   //!< cache decoded instructions, if memory access supports it.
+    void setMemContext(const uint64_t ctxt_tag);    //!< memory context (VMID / context ID) for cached instructions and fetches.
 
 //********** code following API
 
@@ -107,6 +112,10 @@ private:
     bool initFollowerState();       //!< clear all the o/p data and flags, check init valid.
 
     ocsd_err_t decodeSingleOpCode();      //!< decode single opcode address from current m_inst_info packet
+    ocsd_err_t readDecodeOpCode();        //!< read memory and decode opcode at current m_inst_info address
+    ocsd_err_t readOpCode(uint32_t *num_bytes, uint32_t *p_opcode);  //!< read opcode at current m_inst_info address via fetch buffer
+    ocsd_err_t fillFetchBuf(const ocsd_vaddr_t address, const uint32_t min_bytes); //!< read memory at address into fetch buffer
+    bool inFetchBuf(const ocsd_vaddr_t address, const uint32_t num_bytes) const;
 
     ocsd_instr_info m_instr_info;
 
@@ -127,6 +136,17 @@ private:
     componentAttachPt<ITargetMemAccess> *m_pMemAccess;
     componentAttachPt<IInstrDecode> *m_pIDecode;
 
+    //! single instruction blocks - atoms repeatedly decode the same instructions.
+    TrcInstrBlockCache m_blk_cache;
+    bool m_b_blk_cache_enable;
+    uint64_t m_ctxt_tag;            //!< memory context - blocks and fetch buffer only used in the context they were read.
+
+    //! opcode fetch buffer - copy of memory from the last read, kept while the memory access generation is unchanged.
+    uint8_t m_fetch_buf[CODE_FOLLOW_FETCH_BYTES];
+    ocsd_vaddr_t m_fetch_addr;      //!< address of first byte in buffer.
+    uint32_t m_fetch_bytes;         //!< valid bytes in buffer - 0 if empty.
+    uint32_t m_fetch_gen;           //!< memory access generation when buffer filled.
+    bool m_b_fetch_keep;            //!< buffer can be kept between opcodes - memory access supplies a generation.
 };
 
 #endif // ARM_OCSD_CODE_FOLLOWER_H_INCLUDED
@@ -135,10 +155,13 @@ private:
 inline void OcsdCodeFollower::setArchProfile(const ocsd_arch_profile_t profile)
 {
     m_instr_info.pe_type = profile;
+    m_blk_cache.invalidate();
 }
 
 inline void OcsdCodeFollower::setMemSpaceAccess(const ocsd_mem_space_acc_t mem_acc_rule)
 {
+    if (m_mem_acc_rule != mem_acc_rule)
+        m_fetch_bytes = 0;
     m_mem_acc_rule = mem_acc_rule;
 }
 
@@ -149,6 +172,8 @@ inline const ocsd_mem_space_acc_t OcsdCodeFollower::getMemSpaceAccess() const
 
 inline void  OcsdCodeFollower::setMemSpaceCSID(const uint8_t csid)
 {
+    if (m_mem_space_csid != csid)
+        m_fetch_bytes = 0;
     m_mem_space_csid = csid;
 }
 
@@ -160,6 +185,20 @@ inline void OcsdCodeFollower::setISA(const ocsd_isa isa)
 inline void OcsdCodeFollower::setDSBDMBasWP()
 {
     m_instr_info.dsb_dmb_waypoints = 1;
+    m_blk_cache.invalidate();
+}
+
+inline void OcsdCodeFollower::setBlockCacheEnable(const bool bEnable)
+{
+    m_b_blk_cache_enable = bEnable;
+    m_blk_cache.invalidate();
+}
+
+inline void OcsdCodeFollower::setMemContext(const uint64_t ctxt_tag)
+{
+    if (m_ctxt_tag != ctxt_tag)
+        m_fetch_bytes = 0;
+    m_ctxt_tag = ctxt_tag;
 }
 
 //**************************************** results API
@@ -224,6 +263,11 @@ inline const ocsd_isa OcsdCodeFollower::nextISA() const
     return m_instr_info.next_isa;
 }
 
+inline bool OcsdCodeFollower::inFetchBuf(const ocsd_vaddr_t address, const uint32_t num_bytes) const
+{
+    return m_fetch_bytes && (address >= m_fetch_addr) && ((address - m_fetch_addr + num_bytes) <= m_fetch_bytes);
+}
+
 // information on error conditions
 inline const bool OcsdCodeFollower::isNacc() const
 {
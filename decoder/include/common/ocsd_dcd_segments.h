@@ -0,0 +1,203 @@
+/*!
+* \file       ocsd_dcd_segments.h
+* \brief      OpenCSD : Parallel decode of a single trace stream, split at sync points.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ARM_OCSD_DCD_SEGMENTS_H_INCLUDED
+#define ARM_OCSD_DCD_SEGMENTS_H_INCLUDED
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "opencsd/ocsd_if_types.h"
+#include "interfaces/trc_gen_elem_in_i.h"
+#include "common/trc_gen_elem.h"
+
+class DecodeTree;
+
+/** @addtogroup dcd_tree
+@{*/
+
+#define OCSD_DCD_SEG_SIZE_DEF   0x100000    // default target segment size - 1MB of trace.
+#define OCSD_DCD_SEG_SIZE_MIN   0x1000      // minimum target segment size.
+
+/*!
+ * @class DecodeSegments
+ * @brief Decode a single ETMv4 / ETE trace stream in parallel, split into segments at sync points.
+ *
+ * The stream is split at A-sync packets followed by a TraceInfo packet - points where the
+ * decoder can restart with no earlier state. Each segment is decoded on a worker thread by
+ * one of a set of decode trees supplied by the client, each with its own decoder and
+ * memory accessors, so memory access caches are not shared between workers.
+ *
+ * Decoded elements are buffered per segment and passed to the output interface in stream
+ * order on the caller thread. Each segment after the first starts with the NO_SYNC
+ * (reset-decoder) element of a decoder restarting at a sync point. End of trace elements
+ * are only output for the final segment.
+ *
+ * A decoder may only output elements from the end of a segment once later packets are seen.
+ * Workers therefore decode on into the following segment until the decoder outputs an element
+ * from after the end of the segment, keeping only the elements from before it. If the following
+ * segment gives no such element, the decoder is flushed with an end of trace.
+ *
+ * Input is a demuxed single source stream - no frame formatting. Segments are decoded once the
+ * following segment is complete, with the remainder held until the next call or decodeEnd().
+ */
+class DecodeSegments
+{
+public:
+    DecodeSegments();
+    ~DecodeSegments();
+
+    /*!
+     * Add a decode tree for a worker thread. One worker is run per tree.
+     * The tree must be a single source tree with a single ETMv4 or ETE decoder, and have
+     * memory accessors added by the client. The tree output is attached to this object,
+     * and the tree must remain valid until this object is destroyed.
+     *
+     * @param p_tree : decode tree for the worker.
+     *
+     * @return ocsd_err_t  : OCSD_OK if tree added.
+     */
+    ocsd_err_t addWorkerTree(DecodeTree *p_tree);
+    const int numWorkers() const { return (int)m_workers.size(); };
+
+    /*! Set the output for decoded elements - called on the caller thread. */
+    void setGenTraceElemOutI(ITrcGenElemIn *p_elem_out) { m_p_elem_out = p_elem_out; };
+
+    /*! Set the target segment size in bytes. Segments start at the first sync point after this many bytes.
+        Sizes below OCSD_DCD_SEG_SIZE_MIN (4096) return OCSD_ERR_INVALID_PARAM_VAL. */
+    ocsd_err_t setSegmentSize(const uint32_t seg_size);
+    const uint32_t getSegmentSize() const { return m_seg_size; };
+
+    /*!
+     * Decode a block of the trace stream. Segments followed by a complete segment in this
+     * block are decoded in parallel, and the output for them returned before this call
+     * returns. Data from the start of the first segment not decoded is copied and held for
+     * the next call.
+     *
+     * Index for the block should follow on from the previous block.
+     *
+     * @param index : trace index of the first byte in the block.
+     * @param size : size of the block.
+     * @param p_data : block data.
+     *
+     * @return ocsd_err_t  : OCSD_OK, or OCSD_ERR_DATA_DECODE_FATAL if a decoder returned a fatal error
+     *                       - no further output is made until reset().
+     */
+    ocsd_err_t decodeData(const ocsd_trc_index_t index, const uint32_t size, const uint8_t *p_data);
+
+    /*! Decode any data held from the previous block as the final segment, and output the end of trace. */
+    ocsd_err_t decodeEnd();
+
+    /*! Discard held data and clear any fatal error - next data starts a new stream. */
+    void reset();
+
+    /*! Number of segments decoded since the last reset. */
+    const uint32_t numSegments() const { return m_num_segs; };
+
+    /*!
+     * Find the next point a decoder can restart - an A-sync packet followed by a TraceInfo packet.
+     *
+     * @return uint32_t : offset of the A-sync packet in the block, or size if none complete in the block.
+     */
+    static uint32_t findSyncPoint(const uint8_t *p_data, const uint32_t size);
+
+private:
+    typedef struct _seg_elem {
+        _seg_elem(const ocsd_trc_index_t idx, const uint8_t id, const OcsdTraceElement &el) :
+            index_sop(idx), trc_chan_id(id), elem(el) {};
+        ocsd_trc_index_t index_sop;
+        uint8_t trc_chan_id;
+        OcsdTraceElement elem;
+    } seg_elem_t;
+
+    typedef struct _segment {
+        const uint8_t *p_data;
+        uint32_t size;
+        uint32_t look_size;                 // data after the segment - decoded only to flush elements from before the end.
+        ocsd_trc_index_t index;
+        std::vector<seg_elem_t> *p_elems;   // decoded output - buffer for the window slot used by the segment.
+        ocsd_datapath_resp_t resp;          // worst response from the decode tree.
+        bool done;
+    } segment_t;
+
+    // collects the output of a worker decode tree into the current segment.
+    class WorkerOut : public ITrcGenElemIn
+    {
+    public:
+        WorkerOut() : p_tree(0), p_seg(0), past_end(false) {};
+        virtual ~WorkerOut() {};
+        virtual ocsd_datapath_resp_t TraceElemIn(const ocsd_trc_index_t index_sop,
+                                                 const uint8_t trc_chan_id,
+                                                 const OcsdTraceElement &elem);
+        DecodeTree *p_tree;
+        segment_t *p_seg;
+        bool past_end;      // decoder has output an element from after the end of the segment.
+    };
+
+    ocsd_err_t decodeSegments(const bool bEnd);
+    void workerThread(WorkerOut *p_worker);
+    void decodeSegment(WorkerOut *p_worker, segment_t *p_seg);
+    ocsd_err_t outputSegment(segment_t *p_seg, const bool bFirst, const bool bLast);
+    void addSegment(const uint32_t start, const uint32_t end, const uint32_t look_end);
+
+    std::vector<WorkerOut *> m_workers;
+    ITrcGenElemIn *m_p_elem_out;
+    uint32_t m_seg_size;
+
+    std::vector<segment_t> m_segs;      // segments for the current block, in stream order.
+    size_t m_num_in_use;                // segments in use in the current block.
+    std::vector<std::vector<seg_elem_t> > m_elem_bufs;  // output buffers - one per segment decoding or waiting for output.
+    size_t m_next_seg;                  // next segment for a worker to decode.
+    size_t m_next_out;                  // next segment to output.
+    bool m_abort;                       // stop decoding - fatal error.
+    std::mutex m_lock;
+    std::condition_variable m_work_cv;  // workers wait for a segment window slot.
+    std::condition_variable m_done_cv;  // caller waits for next segment done.
+
+    std::vector<uint8_t> m_held;        // data from the start of the first segment not decoded, held for the next call.
+    ocsd_trc_index_t m_held_index;
+    std::vector<uint32_t> m_cuts;       // offsets of the sync points found in the held data - segment boundaries.
+    uint32_t m_scan_pos;                // position in held data to resume the search for a sync point.
+
+    uint32_t m_num_segs;
+    bool m_fatal;
+};
+
+/** @}*/
+
+#endif // ARM_OCSD_DCD_SEGMENTS_H_INCLUDED
+
+/* End of File ocsd_dcd_segments.h */
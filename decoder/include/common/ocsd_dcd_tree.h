@@ -38,10 +38,13 @@
 
 #include <vector>
 #include <list>
+#include <mutex>
 
 #include "opencsd.h"
 #include "ocsd_dcd_tree_elem.h"
 
+class DcdTreeThreads;
+
 /** @defgroup dcd_tree OpenCSD Library : Trace Decode Tree.
     @brief Create a multi source decode tree for a single trace capture buffer.
 
@@ -89,11 +92,18 @@ public:
     static ocsdDefaultErrorLogger* getDefaultErrorLogger() { return &s_error_logger; };
 
     /** the current error logging interface in use */
-    static ITraceErrorLog *getCurrentErrorLogI() { return s_i_error_logger; };
+    static ITraceErrorLog *getCurrentErrorLogI();
 
     /** set an alternate error logging interface. */
     static void setAlternateErrorLogger(ITraceErrorLog *p_error_logger);
 
+    /** set an error logging interface for this tree only - 0 to use the current library logger.
+        Use when decoding on multiple threads, one tree per thread, so threads do not share a logger. */
+    void setTreeErrorLogI(ITraceErrorLog *p_error_logger);
+
+    /** the error logging interface in use by this tree */
+    ITraceErrorLog *getTreeErrorLogI() const;
+
     /** get the list of packet printers for this decode tree */
     std::vector<ItemPrinter *> &getPrinterList() { return m_printer_list; };
 
@@ -139,6 +149,64 @@ public:
 
 /** @}*/
 
+/** @name Threaded Decode
+
+    By default the deformatter and all the decoders in the tree run on the thread calling TraceDataIn().
+
+    In threaded mode the deformatter runs on the caller thread, pushing the data for each trace ID into 
+    a queue, and the packet processor / decoder pairs run on a pool of worker threads. Each ID is decoded 
+    by one worker at a time, in order, so output for an ID is in the same order as for decode on the 
+    caller thread. Output for different IDs is interleaved differently from run to run.
+
+    TraceDataIn() returns once data is queued - the response is the worst response from the decoders 
+    since the previous call. EOT, FLUSH and RESET operations wait for the workers to process all 
+    queued data. WAIT responses from the output interface are handled by the worker flushing the 
+    decoder until output continues, so are never returned to the caller. Fatal errors on an ID are
+    returned on each call until the tree is reset, with further data for that ID dropped.
+
+    Memory access, error logging and (in serial output mode) output calls are serialised by the tree.
+    Tree functions that change decoders or memory accessors wait for the workers to be idle, but clients
+    that use the memory mapper or decoder objects directly must do so only after an EOT, FLUSH or RESET.
+
+    In pipelined mode the deformatter also runs on its own thread. TraceDataIn() copies data into a 
+    lock-free input queue, and the deformatter writes the data for each ID into a lock-free queue 
+    read by the decoder thread for that ID. When the input queue is full TraceDataIn() returns 
+    OCSD_RESP_WAIT with the bytes queued - the client sends OCSD_OP_FLUSH, which returns once there
+    is space, then the rest of the data. A full ID queue stalls the deformatter thread in the same way.
+    Fatal errors are returned once all the queued data has been decoded.
+@{*/
+
+    /*!
+     * Set the number of worker threads used to run the decoders in the tree.
+     * Only supported on trees with a frame deformatter.
+     *
+     * @param num_threads : Number of worker threads, 0 to run all decode on the caller thread.
+     * @param out_mode : Serialise calls to the generic element output interface, or call concurrently from the workers.
+     *
+     * @return ocsd_err_t  : Library error code or OCSD_OK if successful.
+     */
+    ocsd_err_t setDecodeThreads(const int num_threads, const ocsd_dcd_thread_out_t out_mode = OCSD_DCD_THREAD_OUT_SERIAL);
+
+    /*!
+     * Pipeline the decode in the tree - run the deformatter on its own thread, feeding the decoders
+     * on worker threads through lock-free queues. Each trace ID is decoded on one worker thread.
+     * Only supported on trees with a frame deformatter.
+     *
+     * @param num_threads : Number of decoder worker threads, 0 to run all decode on the caller thread.
+     * @param out_mode : Serialise calls to the generic element output interface, or call concurrently from the workers.
+     *
+     * @return ocsd_err_t  : Library error code or OCSD_OK if successful.
+     */
+    ocsd_err_t setDecodePipeline(const int num_threads, const ocsd_dcd_thread_out_t out_mode = OCSD_DCD_THREAD_OUT_SERIAL);
+
+    /*! @brief Return the number of worker threads running the decoders - 0 if decoding on the caller thread. */
+    const int getDecodeThreads() const;
+
+    /*! @brief Return true if the deformatter is running on a pipeline thread. */
+    const bool isDecodePipelined() const;
+
+/** @}*/
+
 /** @name Decoder Management
 @{*/
 
@@ -256,6 +324,11 @@ public:
     It is no necessary for clients to register memory accessors for all spaces - _ANY will be sufficient 
     in many cases. 
 
+    A mapper created with type MEMACC_MAP_PER_TRACE_ID keeps separate accessors for each trace ID. 
+    Accessors added with a non-zero cs_trace_id are only used when decoding trace from that ID, and are 
+    searched before accessors added with cs_trace_id 0, which are global and used for all IDs. Each ID
+    has its own cache partition. With the default MEMACC_MAP_GLOBAL mapper the cs_trace_id is ignored.
+
 
 @{*/
 
@@ -263,7 +336,7 @@ public:
     /*!
      * This creates a memory mapper within the decode tree.
      *
-     * @param type : defaults to MEMACC_MAP_GLOBAL (only type available at present)
+     * @param type : defaults to MEMACC_MAP_GLOBAL, or MEMACC_MAP_PER_TRACE_ID for accessors per trace ID.
      *
      * @return ocsd_err_t  : Library error code or OCSD_OK if successful.
      */
@@ -298,6 +371,37 @@ public:
      */
     ocsd_err_t setMemAccCacheing(const bool enable, const uint16_t page_size, const int nr_pages);
 
+    /*!
+     * Get the memory access statistics for the mapper - cache hits, misses, invalidations and 
+     * bytes read from the memory accessors.
+     *
+     * @param p_stats : block to fill with the statistics.
+     *
+     * @return ocsd_err_t  : Library error code -  OCSD_OK if successful, OCSD_ERR_NOT_INIT if no mapper.
+     */
+    ocsd_err_t getMemAccStats(ocsd_mem_acc_stats_t *p_stats);
+
+    /*!
+     * Reset the memory access statistics for the mapper.
+     * 
+     * @return ocsd_err_t  : Library error code -  OCSD_OK if successful, OCSD_ERR_NOT_INIT if no mapper.
+     */
+    ocsd_err_t resetMemAccStats();
+
+    /*!
+     * Set read-ahead for callback memory accessors - reduces the number of callbacks to the client.
+     *
+     * Reads smaller than max_block are extended to a read-ahead block, starting at min_block and
+     * doubling, up to max_block, while reads are sequential. Applies to existing callback accessors
+     * created by the decode tree, and those added later. Default is no read-ahead.
+     *
+     * @param min_block : Minimum read-ahead block size in bytes (16 or more).
+     * @param max_block : Maximum read-ahead block size in bytes (64k or less), 0 to disable read-ahead.
+     *
+     * @return ocsd_err_t  : Library error code -  OCSD_OK if successful.
+     */
+    ocsd_err_t setCallbackMemAccReadAhead(const uint32_t min_block, const uint32_t max_block);
+
 /** @}*/
 
 /** @name Memory Accessors
@@ -314,21 +418,27 @@ public:
      * @param mem_space : Memory space 
      * @param *p_mem_buffer : start of the buffer.
      * @param mem_length : length of the buffer.
+     * @param cs_trace_id : Trace ID using this accessor - 0 for all IDs.
      *
      * @return ocsd_err_t  : Library error code or OCSD_OK if successful.
      */
-    ocsd_err_t addBufferMemAcc(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t *p_mem_buffer, const uint32_t mem_length);
+    ocsd_err_t addBufferMemAcc(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t *p_mem_buffer, const uint32_t mem_length, const uint8_t cs_trace_id = 0);
     
     /*!
      * Creates a memory accessor for a memory block supplied as a contiguous binary data file, and adds to the current mapper.
      *
+     * Set OCSD_FILE_MEM_ACC_OPT_MMAP in file_acc_opts to map the file into memory rather than 
+     * read it through a file stream.
+     *
      * @param address : Start address for the memory block in the memory map. 
      * @param mem_space : Memory space
      * @param &filepath : Path to the binary data file
+     * @param file_acc_opts : Binary file accessor options - OCSD_FILE_MEM_ACC_OPT_ flags.
+     * @param cs_trace_id : Trace ID using this accessor - 0 for all IDs.
      *
      * @return ocsd_err_t  : Library error code or OCSD_OK if successful.
      */
-    ocsd_err_t addBinFileMemAcc(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const std::string &filepath);
+    ocsd_err_t addBinFileMemAcc(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const std::string &filepath, const uint32_t file_acc_opts = OCSD_FILE_MEM_ACC_OPT_NONE, const uint8_t cs_trace_id = 0);
     
     /*!
      * Creates a memory accessor for a memory block supplied as a one or more memory regions in a binary file.
@@ -336,14 +446,19 @@ public:
      * for that address, and the length of the region. This accessor can be used to point to the code section 
      * in a program file for example.
      *
+     * Set OCSD_FILE_MEM_ACC_OPT_MMAP in file_acc_opts to map the file into memory rather than 
+     * read it through a file stream.
+     *
      * @param *region_array : array of valid memory regions in the file.
      * @param num_regions : number of regions
      * @param mem_space : Memory space
      * @param &filepath : Path to the binary data file
+     * @param file_acc_opts : Binary file accessor options - OCSD_FILE_MEM_ACC_OPT_ flags.
+     * @param cs_trace_id : Trace ID using this accessor - 0 for all IDs.
      *
      * @return ocsd_err_t  : Library error code or OCSD_OK if successful.
      */
-    ocsd_err_t addBinFileRegionMemAcc(const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const std::string &filepath);
+    ocsd_err_t addBinFileRegionMemAcc(const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const std::string &filepath, const uint32_t file_acc_opts = OCSD_FILE_MEM_ACC_OPT_NONE, const uint8_t cs_trace_id = 0);
     
 
     /*!
@@ -371,21 +486,39 @@ public:
      * @param mem_space : Memory space
      * @param p_cb_func : Callback function  
      * @param *p_context : client supplied context information
+     * @param cs_trace_id : Trace ID using this accessor - 0 for all IDs.
      *
      * @return ocsd_err_t  : Library error code or OCSD_OK if successful.
      */
-    ocsd_err_t addCallbackMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAcc_CB p_cb_func, const void *p_context); 
-    ocsd_err_t addCallbackIDMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAccID_CB p_cb_func, const void *p_context);
+    ocsd_err_t addCallbackMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAcc_CB p_cb_func, const void *p_context, const uint8_t cs_trace_id = 0); 
+    ocsd_err_t addCallbackIDMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAccID_CB p_cb_func, const void *p_context, const uint8_t cs_trace_id = 0);
 
     /*!
      * Remove the memory accessor from the map, that begins at the given address, for the memory space provided.
      *
      * @param address : Start address of the memory accessor.
      * @param mem_space : Memory space for the memory accessor.
+     * @param cs_trace_id : Trace ID the accessor was added for - 0 for all IDs.
      *
      * @return ocsd_err_t  : Library error code or OCSD_OK if successful.
      */
-    ocsd_err_t removeMemAccByAddress(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space);
+    ocsd_err_t removeMemAccByAddress(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id = 0);
+
+    /*!
+     * Load a code map sidecar file and attach it to the memory accessor holding the mapped image.
+     *
+     * A code map lists the waypoint instructions in an A64 or A32 code image, created once by
+     * scanning the image (see TrcMemAccCodeMap, and the code-map-gen test program). Decoders 
+     * find the next waypoint in the map rather than decoding each instruction. The map is 
+     * only attached if the accessor memory matches the content hash recorded in the map.
+     *
+     * @param &map_path : Path to the code map file.
+     * @param mem_space : Memory space of the accessor holding the image.
+     * @param cs_trace_id : Trace ID the accessor was added for - 0 for all IDs.
+     *
+     * @return ocsd_err_t  : Library error code or OCSD_OK if successful.
+     */
+    ocsd_err_t addCodeMapFile(const std::string &map_path, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id = 0);
 
 /** @}*/
 
@@ -418,9 +551,18 @@ private:
     void destroyDecodeElement(const uint8_t CSID);
     void destroyMemAccMapper();
     ocsd_err_t initCallbackMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, 
-        const ocsd_mem_space_acc_t mem_space, void *p_cb_func, bool IDfn, const void *p_context);
+        const ocsd_mem_space_acc_t mem_space, void *p_cb_func, bool IDfn, const void *p_context, const uint8_t cs_trace_id);
     TrcPktProcI *getPktProcI(const uint8_t CSID);
 
+    // threaded decode - interfaces attached to decoders, and connection of decoders to the deformatter.
+    ITraceErrorLog *elemErrorLogI();
+    ITargetMemAccess *elemMemAccessI();
+    ITrcGenElemIn *elemGenElemOutI();
+    ocsd_err_t startDecodeThreads(const int num_threads, const ocsd_dcd_thread_out_t out_mode, const bool bPipeline);
+    ocsd_err_t connectDataIn(const uint8_t CSID, ITrcDataIn *pDataIn);
+    void connectDecodeElements(DcdTreeThreads *p_threads);
+    void waitDecodeIdle();
+
     // keep internal list of memory accessors created by this object.
     void addMemAccessorToList(TrcMemAccessorBase* p_accessor);
 
@@ -449,18 +591,29 @@ private:
     /* global error logger  - all sources */ 
     static ITraceErrorLog *s_i_error_logger;
     static std::list<DecodeTree *> s_trace_dcd_trees;
+    static std::mutex s_tree_lock;      //!< protects the tree list and global error logger.
 
     /**! default error logger */
     static ocsdDefaultErrorLogger s_error_logger;
 
-    /**! default instruction decoder */
-    static TrcIDecode s_instruction_decoder;
+    /**! error logger for this tree - 0 to use the global error logger */
+    ITraceErrorLog *m_i_error_logger;
+
+    /**! instruction decoder - one per tree so trees can decode on separate threads */
+    TrcIDecode m_instruction_decoder;
 
     /**! demux stats block */
     ocsd_demux_stats_t m_demux_stats;
 
     /**! List of accessors created by the decode tree */
     std::list<TrcMemAccessorBase*> m_mem_accessors;
+
+    /**! read-ahead block sizes for callback accessors */
+    uint32_t m_cb_read_ahead_min;
+    uint32_t m_cb_read_ahead_max;
+
+    /**! worker threads for threaded decode - 0 if decoding on the caller thread */
+    DcdTreeThreads *m_p_threads;
 };
 
 /** @}*/
@@ -0,0 +1,462 @@
+/*!
+* \file       ocsd_dcd_tree_threads.h
+* \brief      OpenCSD : Worker threads for per trace ID decode in a decode tree.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ARM_OCSD_DCD_TREE_THREADS_H_INCLUDED
+#define ARM_OCSD_DCD_TREE_THREADS_H_INCLUDED
+
+#include <new>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+#include "opencsd/ocsd_if_types.h"
+#include "interfaces/trc_data_raw_in_i.h"
+#include "interfaces/trc_gen_elem_in_i.h"
+#include "interfaces/trc_tgt_mem_access_i.h"
+#include "interfaces/trc_error_log_i.h"
+
+/** @addtogroup dcd_tree
+@{*/
+
+#define OCSD_DCD_THREADS_MAX        64          // maximum worker threads for a decode tree
+#define OCSD_DCD_THREAD_QUEUE_MAX   0x40000     // queued bytes for an ID before the caller waits for the worker
+#define OCSD_DCD_THREAD_MEM_WIN     128         // bytes copied per ID for memory pointer reads
+
+#define OCSD_DCD_PIPE_IN_BLK        0x1000      // pipelined decode : bytes per input queue block - multiple of the frame size.
+#define OCSD_DCD_PIPE_IN_BLKS       64          // pipelined decode : input queue blocks - power of 2.
+#define OCSD_DCD_PIPE_ID_BLK        16          // pipelined decode : bytes per ID queue block - a frame has at most 15 bytes for an ID.
+#define OCSD_DCD_PIPE_ID_BLKS       0x1000      // pipelined decode : ID queue blocks - power of 2.
+#define OCSD_DCD_PIPE_SPIN          64          // pipelined decode : yields on an empty or full queue before a thread sleeps.
+
+class DcdTreeThreads;
+
+/*!
+ * Trace data block or datapath operation in a pipelined decode queue.
+ */
+template<uint32_t N> struct DcdPipeBlk
+{
+    ocsd_datapath_op_t op;
+    ocsd_trc_index_t index;
+    uint32_t size;          // data bytes - 0 for none data ops.
+    uint8_t data[N];
+};
+
+/*!
+ * Single producer / single consumer lock-free ring of pipeline blocks.
+ *
+ * The producer fills the block at the tail then pushes it. The consumer processes the block
+ * at the head then pops it, so an empty ring has no blocks waiting or being processed.
+ */
+template<class T> class DcdPipeRing
+{
+public:
+    DcdPipeRing() : m_blks(0), m_mask(0), m_head(0), m_tail(0) {};
+    ~DcdPipeRing() { delete [] m_blks; };
+
+    /*! allocate the ring - num_blks must be a power of 2. */
+    bool init(const uint32_t num_blks)
+    {
+        m_blks = new (std::nothrow) T[num_blks];
+        m_mask = num_blks - 1;
+        return (m_blks != 0);
+    };
+
+    /* producer thread */
+    T *tailBlk()
+    {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        return ((tail - m_head.load(std::memory_order_acquire)) > m_mask) ? 0 : &m_blks[tail & m_mask];
+    };
+    void push() { m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); };
+
+    /* consumer thread */
+    T *headBlk()
+    {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        return (head == m_tail.load(std::memory_order_acquire)) ? 0 : &m_blks[head & m_mask];
+    };
+    void pop() { m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); };
+
+    /* any thread */
+    bool empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); };
+    bool full() const { return (m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire)) > m_mask; };
+
+private:
+    T *m_blks;
+    uint32_t m_mask;
+    std::atomic<uint32_t> m_head;
+    char m_pad[64];                 // keep consumer and producer indexes on separate cache lines.
+    std::atomic<uint32_t> m_tail;
+};
+
+/*!
+ * Wakes a pipelined decode thread waiting on an empty or full ring.
+ *
+ * The waiter spins briefly before sleeping, and the lock is only taken to sleep or to
+ * wake a sleeping thread - so the notify on every push / pop is a fence and a flag test.
+ */
+class DcdPipeEvent
+{
+public:
+    DcdPipeEvent() : m_waiting(false) {};
+
+    template<class Pred> void wait(Pred ready)
+    {
+        int spin = 0;
+        while (!ready())
+        {
+            if (spin++ < OCSD_DCD_PIPE_SPIN)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);    // flag visible before the ring is checked.
+            if (!ready())
+                m_cv.wait_for(lock, std::chrono::milliseconds(10));
+            m_waiting.store(false, std::memory_order_relaxed);
+        }
+    };
+
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);        // ring update visible before the flag is checked.
+        if (m_waiting.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_cv.notify_all();
+        }
+    };
+
+private:
+    std::atomic<bool> m_waiting;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+};
+
+/*!
+ * Per trace ID input queue for threaded decode.
+ *
+ * Attached to the deformatter output for the ID in place of the packet processor.
+ * Data blocks and datapath operations are copied into the queue on the caller thread,
+ * and passed on in order to the packet processor on a worker thread.
+ *
+ * In pipelined decode the queue is a lock-free ring from the deformatter thread to the
+ * decoder thread for the ID. A full ring returns OCSD_RESP_WAIT for data, with the bytes
+ * that fitted processed, so the deformatter holds the rest of the frame until flushed.
+ */
+class DcdTreeIDQueue : public ITrcDataIn
+{
+public:
+    DcdTreeIDQueue();
+    virtual ~DcdTreeIDQueue() {};
+
+    virtual ocsd_datapath_resp_t TraceDataIn(const ocsd_datapath_op_t op,
+                                             const ocsd_trc_index_t index,
+                                             const uint32_t dataBlockSize,
+                                             const uint8_t *pDataBlock,
+                                             uint32_t *numBytesProcessed);
+
+    void setDataIn(ITrcDataIn *pDataIn) { m_p_data_in = pDataIn; };
+    ITrcDataIn *getDataIn() const { return m_p_data_in; };
+
+private:
+    friend class DcdTreeThreads;
+
+    typedef struct _queue_blk {
+        ocsd_datapath_op_t op;
+        ocsd_trc_index_t index;
+        uint32_t offset;        // offset of block in data buffer
+        uint32_t size;          // block size - 0 for none data ops.
+    } queue_blk_t;
+
+    typedef struct _queue_buf {
+        std::vector<queue_blk_t> blks;
+        std::vector<uint8_t> data;
+    } queue_buf_t;
+
+    typedef DcdPipeBlk<OCSD_DCD_PIPE_ID_BLK> pipe_blk_t;
+
+    void clearBuf(queue_buf_t &buf) { buf.blks.clear(); buf.data.clear(); };
+
+    ocsd_datapath_resp_t pipeDataIn(const ocsd_datapath_op_t op,
+                                    const ocsd_trc_index_t index,
+                                    const uint32_t dataBlockSize,
+                                    const uint8_t *pDataBlock,
+                                    uint32_t *numBytesProcessed);
+
+    ITrcDataIn *m_p_data_in;    // packet processor input
+    DcdTreeThreads *m_p_threads;    // owning thread pool.
+
+    queue_buf_t m_pend;         // added on caller thread, not yet submitted to workers.
+    queue_buf_t m_queue;        // submitted, waiting for a worker - pool lock held to access.
+    queue_buf_t m_active;       // being processed by a worker.
+
+    bool m_ready;               // ID in the pool ready list.
+    bool m_busy;                // worker processing m_active.
+    ocsd_datapath_resp_t m_resp;    // worst packet processor response since the last reset.
+
+    DcdPipeRing<pipe_blk_t> *m_p_ring;  // pipelined decode : deformatter thread to decoder thread ring - 0 if not pipelined.
+    int m_pipe_worker;                  // pipelined decode : decoder thread for the ID.
+    ocsd_datapath_resp_t m_pipe_resp;   // pipelined decode : response - decoder thread copy.
+};
+
+/*!
+ * Target memory access for worker threads.
+ *
+ * The per trace ID mapper keeps all read state by trace ID, so calls for different IDs run 
+ * concurrently under a lock per ID, and pointer reads return the mapper's pointer. Only one worker 
+ * decodes an ID at a time, so the pointer stays valid until the next read for the ID, as in 
+ * single threaded decode.
+ *
+ * Other mappers share read state between IDs - calls are serialised, and pointer reads are copied 
+ * into a window buffer per trace ID as a pointer into mapper cache pages could be invalidated 
+ * by another thread.
+ */
+class DcdTreeLockedMemAcc : public ITargetMemAccess
+{
+public:
+    DcdTreeLockedMemAcc() : m_p_mem_acc(0), m_per_id(false) {};
+    virtual ~DcdTreeLockedMemAcc() {};
+
+    void setMemAccessI(ITargetMemAccess *p_mem_acc);
+
+    virtual ocsd_err_t ReadTargetMemory(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space,
+                                        uint32_t *num_bytes, uint8_t *p_buffer);
+    virtual ocsd_err_t ReadTargetMemoryPtr(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space,
+                                           uint32_t *num_bytes, const uint8_t **pp_data);
+    virtual void InvalidateMemAccCache(const uint8_t cs_trace_id);
+    virtual void SetMemAccContext(const uint8_t cs_trace_id, const uint64_t ctxt_tag);
+    virtual ocsd_err_t GetMemAccGeneration(const uint8_t cs_trace_id, uint32_t *p_generation);
+    virtual ocsd_err_t FindCodeMapWaypoint(const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space,
+                                           ocsd_instr_info *instr_info, uint32_t *num_instr);
+
+private:
+    std::mutex &lockFor(const uint8_t cs_trace_id) { return m_per_id ? m_id_lock[cs_trace_id & 0x7F] : m_lock; };
+
+    ITargetMemAccess *m_p_mem_acc;
+    bool m_per_id;                      // mapper keeps read state per trace ID - lock by ID, no copy.
+    std::mutex m_lock;                  // serialise calls for mappers with shared read state.
+    std::mutex m_id_lock[128];          // lock per ID for the per trace ID mapper.
+    std::vector<uint8_t> m_win[128];    // pointer read window per ID.
+};
+
+/*!
+ * Generic element output for worker threads - serialises calls to the client output sink.
+ * Shares the output lock with the error logger so element and error output do not interleave.
+ */
+class DcdTreeLockedElemOut : public ITrcGenElemIn
+{
+public:
+    DcdTreeLockedElemOut(std::recursive_mutex &lock) : m_p_elem_out(0), m_lock(lock) {};
+    virtual ~DcdTreeLockedElemOut() {};
+
+    void setGenElemOutI(ITrcGenElemIn *p_elem_out) { m_p_elem_out = p_elem_out; };
+
+    virtual ocsd_datapath_resp_t TraceElemIn(const ocsd_trc_index_t index_sop,
+                                             const uint8_t trc_chan_id,
+                                             const OcsdTraceElement &el);
+
+private:
+    ITrcGenElemIn *m_p_elem_out;
+    std::recursive_mutex &m_lock;
+};
+
+/*!
+ * Error logger for worker threads - serialises calls to the library or client error logger.
+ * Shares the output lock with all the loggers and the element output for the decode tree.
+ */
+class DcdTreeLockedErrLog : public ITraceErrorLog
+{
+public:
+    DcdTreeLockedErrLog(std::recursive_mutex &lock) : m_p_err_log(0), m_lock(lock) {};
+    virtual ~DcdTreeLockedErrLog() {};
+
+    void setErrorLogI(ITraceErrorLog *p_err_log) { m_p_err_log = p_err_log; };
+    ITraceErrorLog *getErrorLogI() const { return m_p_err_log; };
+
+    virtual const ocsd_hndl_err_log_t RegisterErrorSource(const std::string &component_name);
+    virtual const ocsd_err_severity_t GetErrorLogVerbosity() const;
+    virtual void LogError(const ocsd_hndl_err_log_t handle, const ocsdError *Error);
+    virtual void LogMessage(const ocsd_hndl_err_log_t handle, const ocsd_err_severity_t filter_level, const std::string &msg);
+    virtual ocsdError *GetLastError();
+    virtual ocsdError *GetLastIDError(const uint8_t chan_id);
+    virtual ocsdMsgLogger *getOutputLogger();
+    virtual void setOutputLogger(ocsdMsgLogger *pLogger);
+
+private:
+    ITraceErrorLog *m_p_err_log;
+    std::recursive_mutex &m_lock;
+};
+
+/*!
+ * @class DcdTreeThreads
+ * @brief Worker thread pool running the per trace ID decoders in a decode tree.
+ *
+ * The deformatter runs on the caller thread, pushing the demuxed data for each ID
+ * into the queue for that ID. Each queue is processed by one worker at a time, so
+ * the packet processor and decoder for an ID see the same sequence of datapath
+ * calls as for decode on the caller thread, and output for the ID is in the same order.
+ * Decoders for different IDs run concurrently.
+ *
+ * In pipelined mode the deformatter runs on its own thread, fed by the caller through a
+ * lock-free input ring, and writes the data for each ID into a lock-free ring read by the
+ * decoder thread that owns the ID. Each ring has a single producer and a single consumer.
+ * Demux and decode overlap without locks on the data path - the caller gets OCSD_RESP_WAIT
+ * when the input ring is full, and the deformatter thread gets it when an ID ring is full.
+ */
+class DcdTreeThreads
+{
+public:
+    DcdTreeThreads();
+    ~DcdTreeThreads();
+
+    /*!
+     * Start the worker threads.
+     *
+     * @param num_threads : number of decoder worker threads.
+     * @param out_mode : serial or concurrent generic element output.
+     * @param p_pipe_in : deformatter input - run the deformatter on a pipeline thread. 0 to run on the caller thread.
+     */
+    ocsd_err_t start(const int num_threads, const ocsd_dcd_thread_out_t out_mode, ITrcDataIn *p_pipe_in = 0);
+    void stop();    // process all queued data and end the worker threads.
+
+    const int numThreads() const { return m_num_threads; };
+    const ocsd_dcd_thread_out_t outMode() const { return m_out_mode; };
+    const bool isPipeline() const { return m_p_pipe_in != 0; };
+
+    DcdTreeIDQueue *getIDQueue(const uint8_t id) { return &m_queues[id & 0x7F]; };
+
+    /*! Set the packet processor input for an ID queue - adds the ring and decoder thread for the ID in pipelined mode. */
+    ocsd_err_t connectIDQueue(const uint8_t id, ITrcDataIn *pDataIn);
+
+    /*!
+     * Pipelined mode data input from the caller. Data is copied into the input ring, returning
+     * OCSD_RESP_WAIT with the bytes that fitted if the ring is full. A FLUSH after a WAIT returns
+     * once the ring has space. Other none-data ops wait for the pipeline to drain.
+     */
+    ocsd_datapath_resp_t pipeDataIn(const ocsd_datapath_op_t op,
+                                    const ocsd_trc_index_t index,
+                                    const uint32_t dataBlockSize,
+                                    const uint8_t *pDataBlock,
+                                    uint32_t *numBytesProcessed);
+
+    /* interfaces attached to decoders in place of the client interfaces */
+    DcdTreeLockedMemAcc *getMemAccessI() { return &m_mem_acc; };
+    DcdTreeLockedElemOut *getGenElemOutI() { return &m_elem_out; };
+
+    /*! Return the serialising logger for an error logger - components keep logging to the same logger. */
+    ITraceErrorLog *lockedErrorLogI(ITraceErrorLog *p_err_log);
+    /*! Return the error logger for a serialising logger, or the logger passed if not one of ours. */
+    ITraceErrorLog *callerErrorLogI(ITraceErrorLog *p_err_log);
+
+    /*! Submit data pending on all ID queues to the workers. Returns the worst response seen from the decoders. */
+    ocsd_datapath_resp_t submit();
+
+    /*! Submit pending data and wait until all queues are empty. Returns the worst response seen from the decoders. */
+    ocsd_datapath_resp_t waitIdle();
+
+private:
+    friend class DcdTreeIDQueue;
+
+    typedef DcdPipeBlk<OCSD_DCD_PIPE_IN_BLK> pipe_in_blk_t;
+
+    // decoder thread in pipelined mode - reads the rings for the IDs it owns.
+    typedef struct _pipe_worker {
+        DcdPipeEvent evt;               // wait for data on an owned ring.
+        std::atomic<int> num_ids;       // IDs owned - added by the caller thread while the pipeline is idle.
+        DcdTreeIDQueue *ids[128];
+    } pipe_worker_t;
+
+    void workerThread();
+    ocsd_datapath_resp_t processQueue(DcdTreeIDQueue *pQueue, ocsd_datapath_resp_t resp, bool &bReset);
+    ocsd_datapath_resp_t passBlock(ITrcDataIn *pDataIn, const ocsd_datapath_op_t op, ocsd_trc_index_t index, uint32_t size, const uint8_t *p_data);
+    ocsd_datapath_resp_t flushWait(ITrcDataIn *pDataIn, ocsd_datapath_resp_t resp);
+    void queueBuf(DcdTreeIDQueue *pQueue);
+    ocsd_datapath_resp_t collectResp();
+
+    ocsd_err_t startPipeline(const int num_threads);
+    void stopPipeline();
+    void dfmtThread();
+    void dfmtBlock(const pipe_in_blk_t *p_blk);
+    ocsd_datapath_resp_t dfmtFlushWait(ocsd_datapath_resp_t resp);
+    void dcdThread(pipe_worker_t *p_worker);
+    bool dcdReady(const pipe_worker_t *p_worker) const;
+    void pipeBlock(DcdTreeIDQueue *pQueue, const DcdTreeIDQueue::pipe_blk_t *p_blk);
+    bool pipeIdle() const;
+
+    DcdTreeIDQueue m_queues[128];
+    std::deque<DcdTreeIDQueue *> m_ready;   // queues with data waiting for a worker.
+    int m_num_active;                   // queues ready or being processed.
+    std::vector<std::thread> m_workers;
+    bool m_stop;
+
+    std::mutex m_lock;                  // protects queues and ready list.
+    std::condition_variable m_work_cv;  // workers wait for queued data.
+    std::condition_variable m_done_cv;  // caller waits for queues to drain.
+
+    ocsd_dcd_thread_out_t m_out_mode;
+    int m_num_threads;
+
+    // pipelined mode
+    ITrcDataIn *m_p_pipe_in;            // deformatter input - 0 if not pipelined.
+    DcdPipeRing<pipe_in_blk_t> *m_p_in_ring;    // caller to deformatter thread.
+    std::vector<pipe_worker_t *> m_pipe_workers;
+    int m_next_pipe_worker;             // decoder thread for the next ID connected.
+    std::atomic<bool> m_pipe_stop;
+    DcdPipeEvent m_dfmt_evt;            // deformatter thread waits for input, or for space on an ID ring.
+    DcdPipeEvent m_caller_evt;          // caller waits for space on the input ring, or for the pipeline to drain.
+    bool m_in_wait;                     // caller thread : WAIT returned for a full input ring.
+    DcdTreeIDQueue *m_p_blocked;        // deformatter thread : ID ring that returned WAIT.
+    bool m_bp_flush;                    // deformatter thread : flushing to resume after a full ID ring - not passed to the decoders.
+    ocsd_datapath_resp_t m_dfmt_resp;   // deformatter thread : worst deformatter response since the last reset.
+    ocsd_datapath_resp_t m_dfmt_fatal;  // fatal deformatter response - pool lock held to access.
+
+    std::recursive_mutex m_out_lock;    // element and error output lock.
+    DcdTreeLockedMemAcc m_mem_acc;
+    DcdTreeLockedElemOut m_elem_out;
+    std::vector<DcdTreeLockedErrLog *> m_err_logs;
+};
+
+/** @}*/
+
+#endif // ARM_OCSD_DCD_TREE_THREADS_H_INCLUDED
+
+/* End of File ocsd_dcd_tree_threads.h */
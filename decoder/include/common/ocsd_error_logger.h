@@ -38,6 +38,7 @@
 #include <string>
 #include <vector>
 //#include <fstream>
+#include <mutex>
 
 #include "interfaces/trc_error_log_i.h"
 #include "ocsd_error.h"
@@ -81,6 +82,8 @@ private:
     bool m_created_output_logger;      // true if this class created it's own logger;
 
     std::vector<std::string> m_error_sources;
+
+    std::mutex m_lock;  // decoders on worker threads may log concurrently.
 };
 
 
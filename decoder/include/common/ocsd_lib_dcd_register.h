@@ -38,6 +38,7 @@
 
 #include <map>
 #include <new>
+#include <mutex>
 
 #include "opencsd/ocsd_if_types.h"
 #include "common/ocsd_dcd_mngr_i.h"
@@ -51,6 +52,8 @@
  * The decoders in the library are accessed through the decoder manager interface. This provides a set of functions to allow 
  * the creation, manipulation and destruction of registered decoders
  *
+ * Register calls are serialised so decode trees can be created on different threads. Iterating the 
+ * decoder names using getFirstNamedDecoder() and getNextNamedDecoder() should be done from one thread at a time.
  */
 class OcsdLibDcdRegister
 {
@@ -94,6 +97,7 @@ private:
     static OcsdLibDcdRegister *m_p_libMngr;
     static bool m_b_registeredBuiltins;
     static ocsd_trace_protocol_t m_nextCustomProtocolID;  
+    static std::recursive_mutex m_reg_lock;     //!< decoder trees may be created on different threads - recursive as managers register on creation.
 };
 
 /*!
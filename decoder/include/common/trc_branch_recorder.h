@@ -0,0 +1,155 @@
+/*!
+* \file       trc_branch_recorder.h
+* \brief      OpenCSD : Taken branch recorder - LBR style branch records from generic trace elements.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ARM_TRC_BRANCH_RECORDER_H_INCLUDED
+#define ARM_TRC_BRANCH_RECORDER_H_INCLUDED
+
+#include <vector>
+
+#include "opencsd/ocsd_if_types.h"
+#include "interfaces/trc_gen_elem_in_i.h"
+
+// branch record flags
+#define OCSD_BR_REC_HAS_CC      0x01    // cycle_count is valid
+#define OCSD_BR_REC_INDIRECT    0x02    // indirect branch
+#define OCSD_BR_REC_LINK        0x04    // branch with link
+
+#define OCSD_BR_STACK_MAX       64      // maximum branch stack snapshot depth
+
+/*! Taken branch record */
+typedef struct _ocsd_branch_rec {
+    ocsd_vaddr_t from_addr;     // address of the taken branch instruction
+    ocsd_vaddr_t to_addr;       // branch target address
+    uint32_t cycle_count;       // cycles since the previous record, if OCSD_BR_REC_HAS_CC
+    uint8_t isa;                // ocsd_isa of the branch instruction
+    uint8_t flags;              // OCSD_BR_REC_ flags
+} ocsd_branch_rec_t;
+
+/*!
+ * @class ITrcBranchSampleIn
+ * @brief Interface to receive periodic branch stack samples from the branch recorder.
+ */
+class ITrcBranchSampleIn
+{
+public:
+    ITrcBranchSampleIn() {};
+    virtual ~ITrcBranchSampleIn() {};
+
+    /*!
+     * Sample taken once the instruction count for the trace ID reaches the sample period.
+     *
+     * @param trc_chan_id : Trace ID of the sampled source.
+     * @param sample_addr : Address of the last instruction in the range that triggered the sample.
+     * @param *stack : Branch stack - newest record first.
+     * @param depth : Number of records in the stack.
+     */
+    virtual void BranchSampleIn(const uint8_t trc_chan_id, const ocsd_vaddr_t sample_addr,
+                                const ocsd_branch_rec_t *stack, const int depth) = 0;
+};
+
+/*!
+ * @class TrcBranchRecorder
+ * @brief Records taken branches from the generic element output of the PE decoders.
+ *
+ * Attach as the generic element output of a decode tree. Instruction range elements are converted 
+ * into (source, target) records of taken branches - the source is the last instruction of a range
+ * that ended on an executed branch, the target is the start of the next range for the same trace ID.
+ * Cycle counts from cycle count elements, or ranges with cycle counts, are accumulated into the 
+ * record for the next branch. Trace on, no sync, exception and inaccessible memory elements end the
+ * branch without a record, as the target is not a branch destination.
+ *
+ * Records are held in a ring buffer per trace ID. Clients can read records in order, or take
+ * a snapshot of the latest 16 / 32 / 64 records as a branch stack - either on demand or at 
+ * a fixed instruction count period through the sample interface. When the reader falls more than
+ * the ring size behind, the oldest records are overwritten and counted as lost.
+ *
+ * Works with ETMv3, ETMv4, ETE and PTM decoders. Use with ETM4_OPFLG_PKTDEC_MERGE_ATOM_RANGES to 
+ * reduce the number of range elements output by ETMv4 / ETE decoders.
+ */
+class TrcBranchRecorder : public ITrcGenElemIn
+{
+public:
+    TrcBranchRecorder(const uint32_t ring_size = 4096, const bool use_cc = true);
+    virtual ~TrcBranchRecorder();
+
+    virtual ocsd_datapath_resp_t TraceElemIn(const ocsd_trc_index_t index_sop,
+                                             const uint8_t trc_chan_id,
+                                             const OcsdTraceElement &elem);
+
+    /*!
+     * Set a sample interface, called every instr_period instructions per trace ID with
+     * a branch stack snapshot of up to depth records. 0 period or null interface turns off sampling.
+     */
+    void setSampling(const uint64_t instr_period, const int depth, ITrcBranchSampleIn *p_sample_if);
+
+    /* records for a trace ID */
+    const uint32_t numRecords(const uint8_t trc_chan_id) const;          // unread records in the ring
+    uint32_t readRecords(const uint8_t trc_chan_id, ocsd_branch_rec_t *p_recs, const uint32_t max_recs);
+    int getBranchStack(const uint8_t trc_chan_id, ocsd_branch_rec_t *p_stack, const int depth) const;   // newest first
+    const uint64_t getTotalRecords(const uint8_t trc_chan_id) const;
+    const uint64_t getLostRecords(const uint8_t trc_chan_id) const;
+
+    void reset();   // clear all records and state
+
+private:
+    typedef struct _br_id_state {
+        std::vector<ocsd_branch_rec_t> ring;
+        uint64_t wr_count;          // total records written
+        uint64_t rd_count;          // total records read
+        uint64_t lost_count;        // records overwritten before read
+        uint64_t instr_count;       // instructions since last sample
+        uint32_t cc_acc;            // cycles since last record
+        bool cc_valid;              // cc_acc has a cycle count
+        bool br_pending;            // last range ended on a taken branch
+        ocsd_branch_rec_t pend_rec; // record waiting on the branch target
+    } br_id_state_t;
+
+    br_id_state_t *getState(const uint8_t trc_chan_id);
+    void addRecord(br_id_state_t *p_state, const ocsd_vaddr_t to_addr);
+    void processRange(const uint8_t trc_chan_id, br_id_state_t *p_state, const OcsdTraceElement &elem);
+    int copyStack(const br_id_state_t *p_state, ocsd_branch_rec_t *p_stack, const int depth) const;
+
+    br_id_state_t *m_id_state[0x80];    // per trace ID state - created on first element for the ID
+    uint32_t m_ring_size;               // records in each ring - power of 2
+    bool m_use_cc;
+
+    uint64_t m_sample_period;
+    int m_sample_depth;
+    ITrcBranchSampleIn *m_p_sample_if;
+};
+
+#endif // ARM_TRC_BRANCH_RECORDER_H_INCLUDED
+
+/* End of File trc_branch_recorder.h */
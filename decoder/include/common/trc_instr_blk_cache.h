@@ -0,0 +1,130 @@
+/*
+* \file       trc_instr_blk_cache.h
+* \brief      OpenCSD : cache of decoded instruction blocks.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ARM_TRC_INSTR_BLK_CACHE_H_INCLUDED
+#define ARM_TRC_INSTR_BLK_CACHE_H_INCLUDED
+
+#include "opencsd/ocsd_if_types.h"
+
+#define INSTR_BLK_CACHE_SIZE 256    // number of blocks held - power of 2
+
+// identifies a decoded block - all must match for a cache hit.
+typedef struct _instr_blk_key {
+    ocsd_vaddr_t st_addr;           // address of first instruction in the block
+    uint64_t ctxt_tag;              // memory context (VMID / context ID) on the core, 0 if not traced
+    uint32_t mem_gen;               // memory access generation when block decoded
+    ocsd_mem_space_acc_t mem_space; // memory space used to read the opcodes
+    ocsd_isa isa;                   // ISA at start of block
+    uint8_t it_conditions;          // Thumb IT block conditions remaining at start of block
+} instr_blk_key_t;
+
+typedef struct _instr_blk_entry {
+    instr_blk_key_t key;
+    uint32_t num_instr;             // instructions in block - 0 if entry unused
+    ocsd_instr_info last_instr;     // decode info for the last instruction in the block, address as left by the walk.
+} instr_blk_entry_t;
+
+/** class TrcInstrBlockCache - cache the results of walking instructions to a waypoint.
+ *
+ * PE decoders follow the program image from an address to the next waypoint, reading and 
+ * decoding each instruction. Hot code is walked many times, so the result of a walk - number 
+ * of instructions and the decode info for the waypoint instruction - is cached per decoder.
+ *
+ * Blocks are tagged with the generation number from ITargetMemAccess::GetMemAccGeneration(),
+ * which changes when the memory access cache is invalidated or memory accessors change, so 
+ * stale blocks are never matched. Decoders do not use the cache if the memory access interface
+ * does not supply a generation number.
+ *
+ * Direct mapped by a hash of the start address and context.
+ */
+class TrcInstrBlockCache
+{
+public:
+    TrcInstrBlockCache();
+    ~TrcInstrBlockCache();
+
+    /* find a block - on hit copy the decode info and walk address to instr_info, set number of instructions. */
+    bool getBlock(const instr_blk_key_t &key, ocsd_instr_info &instr_info, uint32_t &num_instr);
+
+    /* add a block - instr_info is the decode info for the last instruction, as left by the walk. */
+    void addBlock(const instr_blk_key_t &key, const ocsd_instr_info &instr_info, const uint32_t num_instr);
+
+    /* discard all blocks - e.g. decode config changed */
+    void invalidate();
+
+private:
+    int entryIdx(const instr_blk_key_t &key) const;
+
+    instr_blk_entry_t *m_entries;   // allocated on first block added.
+};
+
+inline int TrcInstrBlockCache::entryIdx(const instr_blk_key_t &key) const
+{
+    const uint64_t hash = (key.st_addr >> 1) ^ (key.st_addr >> 9) ^ key.ctxt_tag ^ (key.ctxt_tag >> 32);
+    return (int)(hash & (INSTR_BLK_CACHE_SIZE - 1));
+}
+
+inline bool TrcInstrBlockCache::getBlock(const instr_blk_key_t &key, ocsd_instr_info &instr_info, uint32_t &num_instr)
+{
+    if (!m_entries)
+        return false;
+
+    const instr_blk_entry_t &entry = m_entries[entryIdx(key)];
+    if ((entry.num_instr == 0) ||
+        (entry.key.st_addr != key.st_addr) ||
+        (entry.key.mem_gen != key.mem_gen) ||
+        (entry.key.ctxt_tag != key.ctxt_tag) ||
+        (entry.key.isa != key.isa) ||
+        (entry.key.mem_space != key.mem_space) ||
+        (entry.key.it_conditions != key.it_conditions))
+        return false;
+
+    // decoder outputs only - input settings left as set by the decoder.
+    instr_info.instr_addr = entry.last_instr.instr_addr;
+    instr_info.opcode = entry.last_instr.opcode;
+    instr_info.type = entry.last_instr.type;
+    instr_info.branch_addr = entry.last_instr.branch_addr;
+    instr_info.next_isa = entry.last_instr.next_isa;
+    instr_info.instr_size = entry.last_instr.instr_size;
+    instr_info.is_conditional = entry.last_instr.is_conditional;
+    instr_info.is_link = entry.last_instr.is_link;
+    instr_info.thumb_it_conditions = entry.last_instr.thumb_it_conditions;
+    instr_info.sub_type = entry.last_instr.sub_type;
+    num_instr = entry.num_instr;
+    return true;
+}
+
+#endif // ARM_TRC_INSTR_BLK_CACHE_H_INCLUDED
+
+/* End of File trc_instr_blk_cache.h */
@@ -36,6 +36,7 @@
 #define ARM_TRC_PKT_DECODE_BASE_H_INCLUDED
 
 #include <new>
+#include <cstring>
 
 #include "trc_component.h"
 #include "comp_attach_pt_t.h"
@@ -44,6 +45,10 @@
 #include "interfaces/trc_gen_elem_in_i.h"
 #include "interfaces/trc_tgt_mem_access_i.h"
 #include "interfaces/trc_instr_decode_i.h"
+#include "i_dec/trc_idec_wp_scan.h"
+#include "i_dec/trc_idec_arminst.h"
+#include "i_dec/trc_i_decode.h"
+#include "mem_acc/trc_mem_acc_mapper.h"
 
 /** @defgroup ocsd_pkt_decode OpenCSD Library : Packet Decoders.
 
@@ -60,6 +65,23 @@
 @{*/
 
 
+/*!
+ * Window onto target memory returned by ITargetMemAccess::ReadTargetMemoryPtr.
+ * Used to walk sequential opcodes without a memory access call per instruction.
+ * Pointer is borrowed so only valid within a single walk - declare locally and zero init.
+ */
+typedef struct _mem_acc_window {
+    const uint8_t *p_data;  //!< pointer to window data - 0 if window empty.
+    ocsd_vaddr_t st_addr;   //!< address of first byte in window.
+    uint32_t num_bytes;     //!< valid bytes in window.
+} mem_acc_window_t;
+
+/*!
+ * Size of the aligned block requested when a Thumb opcode window is refilled.
+ * Memory access interfaces backed by memory return larger windows.
+ */
+#define OCSD_THUMB_FETCH_BYTES 32
+
 class TrcPktDecodeI : public TraceComponent
 {
 public:
@@ -98,14 +120,27 @@ protected:
 
     /* target access */
     ocsd_err_t accessMemory(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, uint32_t *num_bytes, uint8_t *p_buffer);
+    ocsd_err_t accessMemoryPtr(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, uint32_t *num_bytes, const uint8_t **pp_data);
+    ocsd_err_t accessOpcode(mem_acc_window_t &win, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const ocsd_isa isa, uint32_t *num_bytes, uint32_t *p_opcode);
+    uint32_t skipToWPCandidate(const mem_acc_window_t &win, const ocsd_vaddr_t address, const ocsd_isa isa);  // opcodes in window that cannot be waypoints.
     ocsd_err_t invalidateMemAccCache();
+    ocsd_err_t setMemAccContext(const uint64_t ctxt_tag);
+    bool getMemAccGeneration(uint32_t *p_generation);  // true if decoded blocks may be cached for this generation.
+    bool findCodeMapWaypoint(const ocsd_mem_space_acc_t mem_space, ocsd_instr_info *instr_info, uint32_t *num_instr); // true if walk to waypoint found in a code map.
 
     /* instruction decode */
     ocsd_err_t instrDecode(ocsd_instr_info *instr_info);
 
+private:
+    ocsd_err_t accessThumbOpcode(mem_acc_window_t &win, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, uint32_t *num_bytes, uint32_t *p_opcode);
+    ocsd_err_t fillThumbWindow(mem_acc_window_t &win, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint32_t min_bytes);
+
+protected:
+
     componentAttachPt<ITrcGenElemIn> m_trace_elem_out;
-    componentAttachPt<ITargetMemAccess> m_mem_access;
-    componentAttachPt<IInstrDecode> m_instr_decode;
+    // library memory mapper and instruction decoder are called directly, other implementations through the interface.
+    componentAttachPtImpl<ITargetMemAccess, TrcMemAccMapGlobalSpace> m_mem_access;
+    componentAttachPtImpl<IInstrDecode, TrcIDecode> m_instr_decode;
 
     ocsd_trc_index_t   m_index_curr_pkt;
 
@@ -117,6 +152,7 @@ protected:
     bool m_uses_memaccess;
     bool m_uses_idecode;
 
+    uint8_t m_mem_ptr_buf[OCSD_THUMB_FETCH_BYTES];   //!< backing for accessMemoryPtr if memory access interface does not return pointers.
 };
 
 inline TrcPktDecodeI::TrcPktDecodeI(const char *component_name) : 
@@ -172,7 +208,11 @@ inline ocsd_datapath_resp_t TrcPktDecodeI::outputTraceElementIdx(ocsd_trc_index_
 inline ocsd_err_t TrcPktDecodeI::instrDecode(ocsd_instr_info *instr_info)
 {
     if(m_uses_idecode)
+    {
+        if (m_instr_decode.impl())
+            return m_instr_decode.impl()->decodeInstrDirect(instr_info);
         return m_instr_decode.first()->DecodeInstruction(instr_info);
+    }
     return OCSD_ERR_DCD_INTERFACE_UNUSED;
 }
 
@@ -183,6 +223,124 @@ inline ocsd_err_t TrcPktDecodeI::accessMemory(const ocsd_vaddr_t address, const
     return OCSD_ERR_DCD_INTERFACE_UNUSED;
 }
 
+inline ocsd_err_t TrcPktDecodeI::accessMemoryPtr(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, uint32_t *num_bytes, const uint8_t **pp_data)
+{
+    ocsd_err_t err;
+
+    if (!m_uses_memaccess)
+        return OCSD_ERR_DCD_INTERFACE_UNUSED;
+
+    if (m_mem_access.impl())
+        return m_mem_access.impl()->readTargetMemoryPtrDirect(address, getCoreSightTraceID(), mem_space, num_bytes, pp_data);
+
+    uint32_t reqBytes = *num_bytes;
+    err = m_mem_access.first()->ReadTargetMemoryPtr(address, getCoreSightTraceID(), mem_space, num_bytes, pp_data);
+    if (err == OCSD_ERR_DCD_INTERFACE_UNUSED)
+    {
+        // interface cannot return pointers - copy into local buffer.
+        *num_bytes = (reqBytes > sizeof(m_mem_ptr_buf)) ? sizeof(m_mem_ptr_buf) : reqBytes;
+        err = m_mem_access.first()->ReadTargetMemory(address, getCoreSightTraceID(), mem_space, num_bytes, m_mem_ptr_buf);
+        *pp_data = m_mem_ptr_buf;
+    }
+    return err;
+}
+
+inline ocsd_err_t TrcPktDecodeI::accessOpcode(mem_acc_window_t &win, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const ocsd_isa isa, uint32_t *num_bytes, uint32_t *p_opcode)
+{
+    ocsd_err_t err = OCSD_OK;
+
+    if (isa == ocsd_isa_thumb2)
+        return accessThumbOpcode(win, address, mem_space, num_bytes, p_opcode);
+
+    // refill the window if the opcode is not entirely within it.
+    if (!win.p_data || (address < win.st_addr) || ((address - win.st_addr + *num_bytes) > win.num_bytes))
+    {
+        win.num_bytes = *num_bytes;
+        err = accessMemoryPtr(address, mem_space, &win.num_bytes, &win.p_data);
+        win.st_addr = address;
+        if ((err != OCSD_OK) || (win.num_bytes < *num_bytes))
+        {
+            // return bytes available to indicate memory not accessible
+            *num_bytes = (err == OCSD_OK) ? win.num_bytes : 0;
+            win.p_data = 0;
+            return err;
+        }
+    }
+    memcpy(p_opcode, win.p_data + (address - win.st_addr), *num_bytes);
+    return err;
+}
+
+/* Thumb opcodes are read a halfword at a time from the window - only a 32 bit opcode needs
+ * the second halfword, so 16 bit opcodes at the end of accessible memory do not fail.
+ * 16 bit opcodes are returned in the low halfword with the high halfword zero.
+ */
+inline ocsd_err_t TrcPktDecodeI::accessThumbOpcode(mem_acc_window_t &win, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, uint32_t *num_bytes, uint32_t *p_opcode)
+{
+    ocsd_err_t err = OCSD_OK;
+    uint16_t op_hw[2] = { 0, 0 };
+
+    if (!win.p_data || (address < win.st_addr) || ((address - win.st_addr + 2) > win.num_bytes))
+    {
+        err = fillThumbWindow(win, address, mem_space, 2);
+        if (!win.p_data)
+        {
+            *num_bytes = 0;
+            return err;
+        }
+    }
+    memcpy(&op_hw[0], win.p_data + (address - win.st_addr), 2);
+
+    if (is_wide_thumb(op_hw[0]))
+    {
+        if ((address - win.st_addr + 4) > win.num_bytes)
+        {
+            err = fillThumbWindow(win, address, mem_space, 4);
+            if (!win.p_data)
+            {
+                *num_bytes = 2;
+                return err;
+            }
+        }
+        memcpy(&op_hw[1], win.p_data + (address - win.st_addr + 2), 2);
+    }
+    *p_opcode = (uint32_t)op_hw[0] | ((uint32_t)op_hw[1] << 16);
+    *num_bytes = 4;
+    return err;
+}
+
+/* refill the window from address to the end of the aligned fetch block. Cache pages return all
+ * or none of a request, so retry for the bytes needed if the block runs past the end of memory.
+ */
+inline ocsd_err_t TrcPktDecodeI::fillThumbWindow(mem_acc_window_t &win, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint32_t min_bytes)
+{
+    ocsd_err_t err;
+    uint32_t fetch_bytes = OCSD_THUMB_FETCH_BYTES - (uint32_t)(address & (OCSD_THUMB_FETCH_BYTES - 1));
+
+    if (fetch_bytes < 4)
+        fetch_bytes = 4;
+    win.num_bytes = fetch_bytes;
+    err = accessMemoryPtr(address, mem_space, &win.num_bytes, &win.p_data);
+    if ((err == OCSD_OK) && (win.num_bytes < min_bytes) && (fetch_bytes > min_bytes))
+    {
+        win.num_bytes = min_bytes;
+        err = accessMemoryPtr(address, mem_space, &win.num_bytes, &win.p_data);
+    }
+    win.st_addr = address;
+    if ((err != OCSD_OK) || (win.num_bytes < min_bytes))
+        win.p_data = 0;
+    return err;
+}
+
+/* number of A64 / A32 opcodes from address that can be stepped over without decode - stops at end of window */
+inline uint32_t TrcPktDecodeI::skipToWPCandidate(const mem_acc_window_t &win, const ocsd_vaddr_t address, const ocsd_isa isa)
+{
+    if (!win.p_data || (address < win.st_addr) || ((address - win.st_addr) >= win.num_bytes))
+        return 0;
+
+    const uint32_t offset = (uint32_t)(address - win.st_addr);
+    return inst_scan_to_wp(isa, win.p_data + offset, (win.num_bytes - offset) / 4);
+}
+
 inline ocsd_err_t TrcPktDecodeI::invalidateMemAccCache()
 {
     if (!m_uses_memaccess)
@@ -191,6 +349,28 @@ inline ocsd_err_t TrcPktDecodeI::invalidateMemAccCache()
     return OCSD_OK;
 }
 
+inline ocsd_err_t TrcPktDecodeI::setMemAccContext(const uint64_t ctxt_tag)
+{
+    if (!m_uses_memaccess)
+        return OCSD_ERR_DCD_INTERFACE_UNUSED;
+    m_mem_access.first()->SetMemAccContext(getCoreSightTraceID(), ctxt_tag);
+    return OCSD_OK;
+}
+
+inline bool TrcPktDecodeI::getMemAccGeneration(uint32_t *p_generation)
+{
+    if (!m_uses_memaccess || (getComponentOpMode() & OCSD_OPFLG_PKTDEC_NO_BLK_CACHE))
+        return false;
+    return m_mem_access.first()->GetMemAccGeneration(getCoreSightTraceID(), p_generation) == OCSD_OK;
+}
+
+inline bool TrcPktDecodeI::findCodeMapWaypoint(const ocsd_mem_space_acc_t mem_space, ocsd_instr_info *instr_info, uint32_t *num_instr)
+{
+    if (!m_uses_memaccess)
+        return false;
+    return m_mem_access.first()->FindCodeMapWaypoint(getCoreSightTraceID(), mem_space, instr_info, num_instr) == OCSD_OK;
+}
+
 /**********************************************************************/
 template <class P, class Pc>
 class TrcPktDecodeBase : public TrcPktDecodeI, public IPktDataIn<P>
@@ -35,7 +35,68 @@
 #ifndef ARM_TRC_RAW_BUFFER_H_INCLUDED
 #define ARM_TRC_RAW_BUFFER_H_INCLUDED
 
-#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#define TRC_RAW_PKT_MAX_SIZE 64     // largest raw packet held - larger than any valid packet.
+
+/* Raw bytes for the current packet.
+ *
+ * Complete packets in the input block are referenced in place. Bytes are only copied into
+ * the fixed buffer when a packet is split across input blocks, or when collecting unsynced data.
+ */
+class TraceRawPacket
+{
+public:
+    TraceRawPacket() : m_pData(m_buf), m_size(0) {};
+    ~TraceRawPacket() {};
+
+    void clear() { m_pData = m_buf; m_size = 0; };
+    const uint32_t size() const { return m_size; };
+    const bool full() const { return m_size == TRC_RAW_PKT_MAX_SIZE; };
+    const uint8_t *data() const { return m_pData; };
+    const uint8_t &operator[](const uint32_t idx) const { return m_pData[idx]; };
+
+    void push_back(const uint8_t byte);           // copy a byte into the buffer
+    void eraseFront(const uint32_t num_bytes);    // remove bytes from the start of the buffer
+
+    // reference packet bytes in the input block
+    void setInPlace(const uint8_t *p_start, const uint32_t size = 0) { m_pData = p_start; m_size = size; };
+    void extendInPlace() { m_size++; };
+    const bool isInPlace() const { return m_pData != m_buf; };
+    void copyToBuffer();    // copy in place bytes into the buffer before the input block is released
+
+private:
+    const uint8_t *m_pData;
+    uint32_t m_size;
+    uint8_t m_buf[TRC_RAW_PKT_MAX_SIZE];
+};
+
+inline void TraceRawPacket::push_back(const uint8_t byte)
+{
+    if (m_size < TRC_RAW_PKT_MAX_SIZE)
+        m_buf[m_size++] = byte;
+}
+
+inline void TraceRawPacket::eraseFront(const uint32_t num_bytes)
+{
+    if (num_bytes >= m_size)
+        m_size = 0;
+    else
+    {
+        memmove(m_buf, m_buf + num_bytes, m_size - num_bytes);
+        m_size -= num_bytes;
+    }
+}
+
+inline void TraceRawPacket::copyToBuffer()
+{
+    if (isInPlace())
+    {
+        memcpy(m_buf, m_pData, m_size);
+        m_pData = m_buf;
+    }
+}
 
 class TraceRawBuffer
 {
@@ -49,10 +110,19 @@ public:
     ~TraceRawBuffer() {};
 
     // init the buffer
-    void init(const uint32_t size, const uint8_t *rawtrace, std::vector<uint8_t> *out_packet);
+    void init(const uint32_t size, const uint8_t *rawtrace, TraceRawPacket *out_packet);
     void copyByteToPkt();   // move a byte to the packet buffer     
     uint8_t peekNextByte(); // value of next byte in buffer.
 
+    // packets referenced in place in the input buffer
+    void startPktInPlace() { pkt->setInPlace(m_pBuffer + m_bufProcessed); };
+    void addByteInPlace() { pkt->extendInPlace(); m_bufProcessed++; };  // caller checks not empty
+
+    // direct access to unprocessed bytes for parsing complete packets.
+    const uint8_t *currPtr() const { return m_pBuffer + m_bufProcessed; };
+    const uint32_t remaining() const { return m_bufSize - m_bufProcessed; };
+    void skip(const uint32_t num_bytes) { m_bufProcessed += num_bytes; }; // caller checks <= remaining()
+
     bool empty() { return m_bufProcessed == m_bufSize; };
     // bytes processed.
     uint32_t processed() { return m_bufProcessed; };
@@ -63,12 +133,12 @@ private:
     uint32_t m_bufSize;
     uint32_t m_bufProcessed;
     const uint8_t *m_pBuffer;
-    std::vector<uint8_t> *pkt;
+    TraceRawPacket *pkt;
 
 };
 
 // init the buffer
-inline void TraceRawBuffer::init(const uint32_t size, const uint8_t *rawtrace, std::vector<uint8_t> *out_packet)
+inline void TraceRawBuffer::init(const uint32_t size, const uint8_t *rawtrace, TraceRawPacket *out_packet)
 {
     m_bufSize = size;
     m_bufProcessed = 0;
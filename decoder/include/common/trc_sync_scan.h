@@ -0,0 +1,68 @@
+/*
+* \file       trc_sync_scan.h
+* \brief      OpenCSD : scan trace data for sync patterns.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ARM_TRC_SYNC_SCAN_H_INCLUDED
+#define ARM_TRC_SYNC_SCAN_H_INCLUDED
+
+#include "opencsd/ocsd_if_types.h"
+
+/*
+Scan a span of trace data for a run of at least min_run bytes equal to run_val.
+
+Sync patterns are a run of a fixed byte value followed by a terminator - A-sync 
+packets in ETMv4 / ETE, PTM, ETMv3 and ITM are runs of 0x00, STM ASYNC and frame
+FSYNC are runs of 0xFF. Unsynchronised data cannot contain a sync before the 
+first run long enough to hold one, so protocol processors use this to step 
+over data while waiting for sync, then check the pattern from the returned index.
+
+Returns the index of the first byte of the first run of at least min_run bytes. 
+If there is no complete run, returns the start of any run that reaches the end 
+of the span, as it may continue into the next block. Returns num_bytes if neither.
+
+A min_run of 1 finds the first byte equal to run_val.
+
+Uses SIMD compares where the host supports them - SSE2 / AVX2 on x86 (AVX2 
+selected at runtime), NEON on AArch64 - with a scalar fallback.
+*/
+uint32_t ocsd_scan_byte_run(const uint8_t *p_data, const uint32_t num_bytes, const uint8_t run_val, const uint32_t min_run);
+
+/* index of the first byte equal to val, or num_bytes if none. */
+inline uint32_t ocsd_scan_byte(const uint8_t *p_data, const uint32_t num_bytes, const uint8_t val)
+{
+    return ocsd_scan_byte_run(p_data, num_bytes, val, 1);
+}
+
+#endif // ARM_TRC_SYNC_SCAN_H_INCLUDED
+
+/* End of File trc_sync_scan.h */
@@ -37,12 +37,14 @@
 #include "interfaces/trc_instr_decode_i.h"
 #include "interfaces/trc_error_log_i.h"
 #include "opencsd/ocsd_if_types.h"
+#include "i_dec/trc_idec_arminst.h"
 
 /** Throw error if AA64 opcode top 2 bytes == 0x0000. This range is invalid in AA64 */
 #define OCSD_ENV_ERR_ON_AA64_BAD_OPCODE "OPENCSD_ERR_ON_AA64_BAD_OPCODE"
 
 
-class TrcIDecode : public IInstrDecode
+// final - decoders holding the library instruction decoder call it directly (componentAttachPtImpl).
+class TrcIDecode final : public IInstrDecode
 {
 public:
     TrcIDecode();
@@ -50,6 +52,9 @@ public:
 
     virtual ocsd_err_t DecodeInstruction(ocsd_instr_info* instr_info);
 
+    /* non-virtual decode - A64 instructions that cannot be waypoints are decoded in line */
+    ocsd_err_t decodeInstrDirect(ocsd_instr_info* instr_info);
+
     /* control AA64 checking for invalid opcode */
     void setAA64_errOnBadOpcode(bool bSet);
     void envSetAA64_errOnBadOpcode();
@@ -72,6 +77,24 @@ inline void TrcIDecode::setAA64_errOnBadOpcode(bool bSet)
     aa64_err_bad_opcode = bSet;
 }
 
+inline ocsd_err_t TrcIDecode::decodeInstrDirect(ocsd_instr_info *instr_info)
+{
+    // same result as DecodeA64() for an opcode that cannot be a waypoint.
+    if ((instr_info->isa == ocsd_isa_aarch64) && !inst_A64_maybe_waypoint(instr_info->opcode) &&
+        !(aa64_err_bad_opcode && !(instr_info->opcode & 0xFFFF0000)))
+    {
+        instr_info->instr_size = 4;
+        instr_info->type = OCSD_INSTR_OTHER;
+        instr_info->next_isa = instr_info->isa;
+        instr_info->is_link = 0;
+        instr_info->thumb_it_conditions = 0;
+        instr_info->is_conditional = 0;
+        instr_info->sub_type = OCSD_S_INSTR_NONE;
+        return OCSD_OK;
+    }
+    return DecodeInstruction(instr_info);
+}
+
 #endif // ARM_TRC_I_DECODE_H_INCLUDED
 
 /* End of File trc_i_decode.h */
@@ -124,6 +124,48 @@ int inst_Thumb_wfiwfe(uint32_t inst);
 int inst_A64_wfiwfe(uint32_t inst, struct decode_info *info);
 int inst_A64_Tstart(uint32_t inst);
 
+/*
+Test whether the top byte (bits [31:24]) of an A64 instruction is shared 
+with any instruction that can be a waypoint or conditional - branches, 
+barriers, WFI/WFE and TSTART. Zero means the instruction is OTHER and
+not conditional, so the full tests above need not be run.
+
+    0x14-0x17, 0x94-0x97 : B, BL
+    0x34-0x37, 0xB4-0xB7 : CB, TB
+    0x54                 : B<cond>, BC<cond>
+    0x55                 : RETA<k>SPPC label
+    0x74, 0x75, 0xF4, 0xF5 : CB<cc>, CBB<cc>, CBH<cc>
+    0xD5                 : barriers, WFI/WFE/WFIT/WFET, TSTART
+    0xD6, 0xD7           : BR, BLR, RET, ERET and pointer auth variants
+*/
+constexpr int inst_A64_top_byte_maybe_wp(const uint32_t top)
+{
+    return ((top & 0x7C) == 0x14) ||
+           ((top & 0x7C) == 0x34) ||
+           (top == 0x54) || (top == 0x55) ||
+           ((top & 0x7E) == 0x74) ||
+           (top == 0xD5) || (top == 0xD6) || (top == 0xD7);
+}
+
+/* build 64 bits of the top byte lookup table at compile time */
+constexpr uint64_t inst_A64_wp_table_bits(const uint32_t word, const uint32_t bit = 0)
+{
+    return (bit == 64) ? 0 : 
+        (((uint64_t)inst_A64_top_byte_maybe_wp((word * 64) + bit) << bit) | inst_A64_wp_table_bits(word, bit + 1));
+}
+
+/* top byte lookup table - bit set if instructions with the top byte may be waypoints */
+static constexpr uint64_t inst_A64_wp_table[4] = {
+    inst_A64_wp_table_bits(0), inst_A64_wp_table_bits(1),
+    inst_A64_wp_table_bits(2), inst_A64_wp_table_bits(3)
+};
+
+/* Quick test: zero if the instruction is definitely not a waypoint - one table lookup. */
+inline int inst_A64_maybe_waypoint(const uint32_t inst)
+{
+    return (int)((inst_A64_wp_table[inst >> 30] >> ((inst >> 24) & 0x3F)) & 0x1);
+}
+
 /*
 Test whether an instruction is definitely undefined, e.g. because
 allocated to a "permanently UNDEFINED" space (UDF mnemonic).
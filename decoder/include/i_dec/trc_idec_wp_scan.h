@@ -0,0 +1,69 @@
+/*
+* \file       trc_idec_wp_scan.h
+* \brief      OpenCSD : scan fixed width opcodes for possible waypoints.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ARM_TRC_IDEC_WP_SCAN_H_INCLUDED
+#define ARM_TRC_IDEC_WP_SCAN_H_INCLUDED
+
+#include "opencsd/ocsd_if_types.h"
+
+/*
+Scan a span of contiguous A64 or A32 opcodes, as read from target memory,
+for the first that may be a waypoint. Returns the index of the first possible
+waypoint, or num_opcodes if there are none in the span. All opcodes before the
+returned index decode as OCSD_INSTR_OTHER, so a code follower can step over them
+without decoding each one. Candidates must be decoded as normal - the test is
+conservative and some will not be waypoints.
+
+A64 candidates include opcodes with the top 16 bits 0x0000, so the decoder can 
+apply the invalid opcode check.
+
+Uses SIMD compares where the host supports them - SSE2 / AVX2 on x86 (AVX2 
+selected at runtime), NEON on AArch64 - with a scalar fallback.
+*/
+uint32_t inst_A64_scan_to_wp(const uint8_t *p_opcodes, const uint32_t num_opcodes);
+uint32_t inst_ARM_scan_to_wp(const uint8_t *p_opcodes, const uint32_t num_opcodes);
+
+/* select the scan for the ISA - returns 0 (no opcodes skipped) for variable width ISAs. */
+inline uint32_t inst_scan_to_wp(const ocsd_isa isa, const uint8_t *p_opcodes, const uint32_t num_opcodes)
+{
+    if (isa == ocsd_isa_aarch64)
+        return inst_A64_scan_to_wp(p_opcodes, num_opcodes);
+    if (isa == ocsd_isa_arm)
+        return inst_ARM_scan_to_wp(p_opcodes, num_opcodes);
+    return 0;
+}
+
+#endif // ARM_TRC_IDEC_WP_SCAN_H_INCLUDED
+
+/* End of File trc_idec_wp_scan.h */
@@ -84,13 +84,110 @@ public:
                                             uint32_t *num_bytes, 
                                             uint8_t *p_buffer) = 0;
 
-    /*! 
+    /*!
+     * Get a read-only pointer to a block of target memory, in place of copying the data.
+     *
+     * Returns a pointer into the backing store for the memory (buffer, mapped file, or cache page)
+     * and the number of contiguous bytes valid from that pointer. This may be more than the number
+     * of bytes required, allowing a caller to walk a run of opcodes with a single call.
+     *
+     * Fewer bytes than required, along with a success return code indicates the full memory location
+     * is not accessible, as for ReadTargetMemory().
+     *
+     * The pointer is borrowed - it is only valid until the next call to any function on this interface.
+     *
+     * Default implementation returns OCSD_ERR_DCD_INTERFACE_UNUSED - callers should use ReadTargetMemory().
+     *
+     * @param address : Address to access.
+     * @param cs_trace_id : protocol source trace ID.
+     * @param mem_space : Memory space to access, (secure, non-secure, optionally with EL, or any).
+     * @param num_bytes : [in] Number of bytes required. [out] Number of bytes valid at the returned pointer.
+     * @param **pp_data : [out] Pointer to the data, 0 if no bytes accessible.
+     *
+     * @return ocsd_err_t : OCSD_OK on successful access (including memory not available)
+     */
+    virtual ocsd_err_t ReadTargetMemoryPtr( const ocsd_vaddr_t address,
+                                            const uint8_t cs_trace_id,
+                                            const ocsd_mem_space_acc_t mem_space,
+                                            uint32_t *num_bytes,
+                                            const uint8_t **pp_data)
+    {
+        *num_bytes = 0;
+        *pp_data = 0;
+        return OCSD_ERR_DCD_INTERFACE_UNUSED;
+    };
+
+    /*!
      * Invalidate any caching that the memory accessor functions are using.
      * Generally called when a memory context changes in the trace.
      *
      * @param cs_trace_id : protocol source trace ID.
      */
     virtual void InvalidateMemAccCache(const uint8_t cs_trace_id) = 0;
+
+    /*!
+     * Memory context on the core has changed - e.g. a process or virtual machine switch.
+     *
+     * The context tag identifies the new memory context (e.g. VMID and context ID).
+     * Memory accessor functions that cache data may tag cached data with the context,
+     * and keep the data for several contexts, rather than invalidating the cache.
+     *
+     * Default implementation invalidates the cache for the trace ID.
+     *
+     * @param cs_trace_id : protocol source trace ID.
+     * @param ctxt_tag : tag value identifying the memory context.
+     */
+    virtual void SetMemAccContext(const uint8_t cs_trace_id, const uint64_t ctxt_tag)
+    {
+        InvalidateMemAccCache(cs_trace_id);
+    };
+
+    /*!
+     * Get the generation number for the memory seen by a trace ID.
+     *
+     * The generation changes whenever memory data returned for the ID may have changed - 
+     * cache invalidated for the ID, or memory accessors added or removed. Memory data for
+     * a given address and memory context is otherwise unchanging. Allows decoders to cache
+     * information derived from the memory image, such as decoded instruction blocks.
+     *
+     * Default implementation returns OCSD_ERR_DCD_INTERFACE_UNUSED - memory may change at
+     * any time so callers must not cache derived information.
+     *
+     * @param cs_trace_id : protocol source trace ID.
+     * @param *p_generation : [out] current generation number.
+     *
+     * @return ocsd_err_t : OCSD_OK if generation number valid.
+     */
+    virtual ocsd_err_t GetMemAccGeneration(const uint8_t cs_trace_id, uint32_t *p_generation)
+    {
+        *p_generation = 0;
+        return OCSD_ERR_DCD_INTERFACE_UNUSED;
+    };
+
+    /*!
+     * Find the next waypoint instruction using a pre-decoded code map of the memory image.
+     *
+     * On input instr_info holds the address, ISA and decode settings for the first instruction
+     * of a walk to a waypoint. If a code map covers the address, instr_info is updated as if 
+     * each instruction had been read and decoded up to and including the next waypoint - 
+     * decode outputs for the waypoint instruction, instr_addr set to the following address.
+     *
+     * Default implementation returns OCSD_ERR_DCD_INTERFACE_UNUSED - no code maps.
+     *
+     * @param cs_trace_id : protocol source trace ID.
+     * @param mem_space : memory space for the walk.
+     * @param *instr_info : [in/out] instruction info for the walk.
+     * @param *num_instr : [out] number of instructions to the waypoint, inclusive.
+     *
+     * @return ocsd_err_t : OCSD_OK if waypoint found and instr_info updated.
+     */
+    virtual ocsd_err_t FindCodeMapWaypoint(const uint8_t cs_trace_id,
+                                           const ocsd_mem_space_acc_t mem_space,
+                                           ocsd_instr_info *instr_info,
+                                           uint32_t *num_instr)
+    {
+        return OCSD_ERR_DCD_INTERFACE_UNUSED;
+    };
 };
 
 
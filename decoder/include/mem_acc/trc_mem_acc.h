@@ -40,6 +40,7 @@
 #include "trc_mem_acc_file.h"
 #include "trc_mem_acc_mapper.h"
 #include "trc_mem_acc_cb.h"
+#include "trc_mem_acc_code_map.h"
 
 
 #endif // ARM_TRC_MEM_ACC_H_INCLUDED
@@ -37,6 +37,9 @@
 
 #include "opencsd/ocsd_if_types.h"
 #include <string>
+#include <vector>
+
+class TrcMemAccCodeMap;
 
 /*!
  * @class TrcMemAccessorBase
@@ -68,7 +71,7 @@ public:
     TrcMemAccessorBase(MemAccTypes type, ocsd_vaddr_t startAddr, ocsd_vaddr_t endAddr);
     
     /** default desctructor */
-    virtual ~TrcMemAccessorBase() {};
+    virtual ~TrcMemAccessorBase();
        
     /*!
      * Set the inclusive address range of this accessor.
@@ -118,6 +121,25 @@ public:
      */
     virtual const bool overLapRange(const TrcMemAccessorBase *p_test_acc) const;
 
+    /*!
+     * Get the number of contiguous address ranges covered by this accessor.
+     * Most accessors cover a single range, file accessors may have additional regions.
+     *
+     * @return const int  : Number of ranges.
+     */
+    virtual const int getNumRanges() const { return 1; };
+
+    /*!
+     * Get the inclusive address bounds of a range covered by this accessor.
+     *
+     * @param range_idx : Index of the range, 0 to getNumRanges() - 1.
+     * @param &startAddr : returned start address of the range.
+     * @param &endAddr : returned end address of the range.
+     *
+     * @return const bool  : true if range_idx valid and addresses returned.
+     */
+    virtual const bool getRange(const int range_idx, ocsd_vaddr_t &startAddr, ocsd_vaddr_t &endAddr) const;
+
     /*!
      * Read bytes from via the accessor from the memory range. 
      *
@@ -131,6 +153,19 @@ public:
      */
     virtual const uint32_t readBytes(const ocsd_vaddr_t s_address, const ocsd_mem_space_acc_t memSpace, const uint8_t trcID, const uint32_t reqBytes, uint8_t *byteBuffer) = 0;
 
+    /*!
+     * Get a pointer to the bytes at an address, for accessors where the data is held in memory.
+     * No copy is made - the pointer remains valid for the lifetime of the accessor.
+     *
+     * @param s_address : Start address of the read.
+     * @param memSpace  : memory space for this access. 
+     * @param trcID     : Trace ID of trace source.
+     * @param &availBytes : [out] Number of contiguous bytes available from the returned pointer.
+     *
+     * @return const uint8_t * : Pointer to the data, 0 if not in range or accessor does not support direct access.
+     */
+    virtual const uint8_t *readBytesPtr(const ocsd_vaddr_t s_address, const ocsd_mem_space_acc_t memSpace, const uint8_t trcID, uint32_t &availBytes) { availBytes = 0; return 0; };
+
     /*!
      * Validate the address range - ensure addresses aligned, different, st < en etc.
      *
@@ -151,11 +186,27 @@ public:
 
     static void getMemAccSpaceString(std::string& spaceStr, const ocsd_mem_space_acc_t mem_space);
 
+    /*!
+     * Attach a pre-decoded code map for a range of this accessor. The accessor takes 
+     * ownership of the map on success. Map must be within the accessor range, not overlap 
+     * other maps, and match the current memory content.
+     *
+     * @param *p_map : Code map to attach.
+     *
+     * @return ocsd_err_t  : OCSD_OK if attached, OCSD_ERR_MEM_ACC_CODE_MAP if image does not match.
+     */
+    ocsd_err_t addCodeMap(TrcMemAccCodeMap *p_map);
+
+    /* code map covering the address - 0 if none */
+    const TrcMemAccCodeMap *getCodeMap(const ocsd_vaddr_t address) const;
+    const bool hasCodeMaps() const { return !m_code_maps.empty(); };
+
 protected:
     ocsd_vaddr_t m_startAddress;   /**< accessible range start address */
     ocsd_vaddr_t m_endAddress;     /**< accessible range end address */
     const MemAccTypes m_type;       /**< memory accessor type */
     ocsd_mem_space_acc_t m_mem_space; /**< Matching memory space of this acessor */
+    std::vector<TrcMemAccCodeMap *> m_code_maps; /**< pre-decoded code maps for ranges in this accessor */
 };
 
 inline TrcMemAccessorBase::TrcMemAccessorBase(MemAccTypes accType, ocsd_vaddr_t startAddr, ocsd_vaddr_t endAddr) :
@@ -213,6 +264,15 @@ inline const bool TrcMemAccessorBase::overLapRange(const TrcMemAccessorBase *p_t
     return false;
 }
 
+inline const bool TrcMemAccessorBase::getRange(const int range_idx, ocsd_vaddr_t &startAddr, ocsd_vaddr_t &endAddr) const
+{
+    if (range_idx != 0)
+        return false;
+    startAddr = m_startAddress;
+    endAddr = m_endAddress;
+    return true;
+}
+
 inline const bool TrcMemAccessorBase::validateRange()
 {
     if(m_startAddress & 0x1) // at least hword aligned for thumb
@@ -232,7 +292,7 @@ class TrcMemAccFactory
 public:
     /** Accessor Creation */
     static ocsd_err_t CreateBufferAccessor(TrcMemAccessorBase **pAccessor, const ocsd_vaddr_t s_address, const uint8_t *p_buffer, const uint32_t size);
-    static ocsd_err_t CreateFileAccessor(TrcMemAccessorBase **pAccessor, const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset = 0, size_t size = 0);
+    static ocsd_err_t CreateFileAccessor(TrcMemAccessorBase **pAccessor, const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset = 0, size_t size = 0, const uint32_t file_acc_opts = OCSD_FILE_MEM_ACC_OPT_NONE, const ocsd_mem_space_acc_t mem_space = OCSD_MEM_SPACE_ANY);
     static ocsd_err_t CreateCBAccessor(TrcMemAccessorBase **pAccessor, const ocsd_vaddr_t s_address, const ocsd_vaddr_t e_address, const ocsd_mem_space_acc_t mem_space);
     
     /** Accessor Destruction */
@@ -44,6 +44,10 @@
 #define MEM_ACC_CACHE_MRU_SIZE_MAX 256
 #define MEM_ACC_CACHE_PAGE_SIZE_MIN 64
 #define MEM_ACC_CACHE_MRU_SIZE_MIN 4
+#define MEM_ACC_CACHE_SET_WAYS 4    // target pages per set - the number of sets is a power of 2
+#define MEM_ACC_CACHE_NUM_TRC_IDS 0x80  // context tags held for trace IDs 0x00 - 0x7F
+#define MEM_ACC_CACHE_LINE_SIZE 64      // alignment of page data and page metadata
+#define MEM_ACC_CACHE_HUGE_PAGE_SIZE 0x200000   // slabs of this size or larger use huge pages where supported
 
 #define OCSD_ENV_MEMACC_CACHE_OFF "OPENCSD_MEMACC_CACHE_OFF"
 #define OCSD_ENV_MEMACC_CACHE_PG_SIZE "OPENCSD_MEMACC_CACHE_PAGE_SIZE"
@@ -53,15 +57,23 @@
 class TrcMemAccessorBase;
 class ITraceErrorLog;
 
+// tags identifying the source of the data in a page - must all match for a cache hit.
+typedef struct cache_page_tag {
+    uint64_t ctxt_tag;                  // memory context (context ID / VMID) on the core when page loaded
+    const TrcMemAccessorBase *p_acc;    // accessor page loaded from
+    ocsd_mem_space_acc_t mem_space;     // memory space used to load page
+    uint8_t trcID;                      // trace ID associated with the page
+} cache_page_tag_t;
+
+// page metadata - page data held separately in the cache slab.
 typedef struct cache_block {
     ocsd_vaddr_t st_addr;
+    cache_page_tag_t tag;   // source of the page data
     uint32_t valid_len;
-    uint8_t* data;
-    uint8_t trcID;          // trace ID associated with the page
     uint32_t use_sequence; // number representing the sequence of allocation to evict oldest page.
 } cache_block_t;
 
-// enable define to collect stats for debugging / cache performance tests
+// enable define to log stats for debugging / cache performance tests
 // #define LOG_CACHE_STATS
 
 
@@ -69,11 +81,20 @@ typedef struct cache_block {
  * 
  * Reduce the need to read files / make callbacks into clients when walking memory images.
  * 
- * Caching is done on a per Core/Trace ID basis - all caches from that ID are invalidated when a context
- * switch appears on the core. This means that we do not account for memory spaces in the cache pages as
- * these only change via a context switch.
- * 
- * Memory space is used on cache miss if reading data from the underlying accessor (file / callback).
+ * Caching is done on a per Core/Trace ID basis. Pages are tagged with the trace ID, the memory context
+ * on that core (context ID / VMID) set by setContext(), the memory space and the accessor used to load the
+ * page. Pages from several contexts can be resident at once, so a core switching back to a previous
+ * context will hit pages already loaded. invalidateByTraceID() discards all pages for an ID whatever
+ * the context.
+ *
+ * Pages are organised as a set associative cache - a page is placed in a set selected by a hash of the
+ * trace ID and the page key (start address >> page shift, where 1 << page shift >= page size). Any page
+ * containing an address must therefore be in the set for the address key or the key below it, so a lookup
+ * tests at most two sets whatever the total number of pages. Eviction is least recently used within the set.
+ *
+ * Page data for all pages is held in a single cache line aligned slab, with the page metadata in a separate 
+ * packed array, so lookups only touch the metadata for the pages in the candidate sets. Large slabs are huge 
+ * page backed on Linux. Resizing reuses the existing slab and metadata array if large enough.
  */
 class TrcMemAccCache
 {
@@ -87,6 +108,7 @@ public:
     ocsd_err_t setCacheSizes(const uint16_t page_size, const int nr_pages, const bool err_on_limit = false);
 
     const bool enabled() const { return m_bCacheEnabled; };
+    void getCacheSizes(uint16_t &page_size, int &nr_pages) const { page_size = m_mru_page_size; nr_pages = m_mru_num_pages; };
     const bool enabled_for_size(const uint32_t reqSize) const
     {
         return (m_bCacheEnabled && (reqSize <= m_mru_page_size));
@@ -97,51 +119,78 @@ public:
     void invalidateByTraceID(int8_t trcID);
     void clearPage(cache_block_t* page);
 
+    /* set the current memory context tag for the trace ID - subsequent reads match pages with this tag */
+    void setContext(const uint8_t trcID, const uint64_t ctxt_tag);
+
     /** read bytes from cache if possible - load new page if needed from underlying accessor, bail out if data not available */
     ocsd_err_t readBytesFromCache(TrcMemAccessorBase *p_accessor, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, uint32_t *numBytes, uint8_t *byteBuffer);
 
+    /** as readBytesFromCache, but return a pointer into the cache page and all valid bytes in the page from the address - valid until next cache operation */
+    ocsd_err_t readPtrFromCache(TrcMemAccessorBase *p_accessor, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, uint32_t *numBytes, const uint8_t **pp_data);
+
     void setErrorLog(ITraceErrorLog *log);
-    void logAndClearCounts();
+    void logStats();    // log stats if LOG_CACHE_STATS defined
+
+    /* runtime statistics */
+    void addStats(ocsd_mem_acc_stats_t &total) const;  // add the counts from this cache into the total
+    void resetStats();
+    static void initStats(ocsd_mem_acc_stats_t &stats); // zero counts and set version
+    void countAccRead(const TrcMemAccessorBase *p_accessor, const uint32_t bytes); // count a read made from an accessor
 
     /* look for runtime cache tuning vars */
     static void getenvMemaccCacheSizes(bool& enable, int& page_size, int& num_pages);
 
 private:
-    bool blockInCache(const ocsd_vaddr_t address, const uint32_t reqBytes, const uint8_t trcID); // run through each page to look for data.
-    bool blockInPage(const ocsd_vaddr_t address, const uint32_t reqBytes, const uint8_t trcID);    
+    bool blockInCache(const ocsd_vaddr_t address, const uint32_t reqBytes, const cache_page_tag_t &tag); // look in MRU page, then candidate sets for data.
+    bool blockInPage(const int page_idx, const ocsd_vaddr_t address, const uint32_t reqBytes, const cache_page_tag_t &tag) const;
+    bool blockInSet(const int set_idx, const ocsd_vaddr_t address, const uint32_t reqBytes, const cache_page_tag_t &tag); // search ways in set, update MRU on hit
+    int pageSet(const ocsd_vaddr_t page_key, const cache_page_tag_t &tag) const; // hash page key and tags to set index
+    ocsd_err_t findBlockInCache(TrcMemAccessorBase *p_accessor, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, const uint32_t reqBytes, const uint8_t **pp_data);
 
     void logMsg(const std::string &szMsg, ocsd_err_t err = OCSD_OK);
-    int findNewPage();
+    int findNewPage(const ocsd_vaddr_t address, const cache_page_tag_t &tag);
     void incSequence(); // increment sequence on current block
 
-    ocsd_err_t createCaches();     // create caches according to current sizes 
+    ocsd_err_t createCaches();     // create caches according to current sizes - reusing existing allocations if possible
+    void calcSetSizes();           // set up sets / ways / page shift from the current sizes
     void destroyCaches();   // destroy the cache blocks
+    uint8_t *pageData(const int page_idx) const { return m_slab + ((size_t)page_idx * m_page_stride); };
 
-    cache_block_t *m_mru;       // cache pages 
+    cache_block_t *m_mru;       // cache page metadata
+    int m_mru_capacity;         // number of pages metadata allocated for
+    uint8_t *m_slab;            // page data for all pages
+    size_t m_slab_size;         // allocated size of slab
+    uint32_t m_page_stride;     // page size rounded up to cache line size
     int m_mru_idx = 0;          // in use index - most recently used page   
     uint16_t m_mru_page_size;   // page size
     int m_mru_num_pages;        // number of pages  
     uint32_t m_mru_sequence;    // allocation & use sequence number
 
+    int m_num_sets;             // number of sets - power of 2
+    int m_set_ways;             // pages per set
+    int m_page_shift;           // address shift to get page key
+
+    uint64_t m_ctxt_tags[MEM_ACC_CACHE_NUM_TRC_IDS]; // current memory context tag per trace ID
+
     bool m_bCacheEnabled = false;
 
-#ifdef LOG_CACHE_STATS    
-    uint32_t m_hits = 0;
-    uint32_t m_misses = 0;
-    uint32_t m_pages = 0;
-    uint32_t* m_hit_rl = 0;
-    uint32_t* m_hit_rl_max = 0;
-#endif
+    ocsd_mem_acc_stats_t m_stats;   // runtime statistics 
+    int m_run_idx = -1;             // page for current run of hits
+    uint64_t m_run_len = 0;         // length of current run of hits
     
     ITraceErrorLog *m_err_log = 0;
 };
 
 inline TrcMemAccCache::TrcMemAccCache() :
-    m_mru(0), m_mru_sequence(1)
+    m_mru(0), m_mru_capacity(0), m_slab(0), m_slab_size(0), m_page_stride(0), m_mru_sequence(1)
 {
     /* set default cache sizes */
     m_mru_page_size = MEM_ACC_CACHE_DEFAULT_PAGE_SIZE;
     m_mru_num_pages = MEM_ACC_CACHE_DEFAULT_MRU_SIZE;
+    calcSetSizes();
+    for (int i = 0; i < MEM_ACC_CACHE_NUM_TRC_IDS; i++)
+        m_ctxt_tags[i] = 0;
+    resetStats();
 }
 
 inline TrcMemAccCache::~TrcMemAccCache()
@@ -150,49 +199,82 @@ inline TrcMemAccCache::~TrcMemAccCache()
 }
 
 
-inline bool TrcMemAccCache::blockInPage(const ocsd_vaddr_t address, const uint32_t reqBytes, const uint8_t trcID)
+inline bool TrcMemAccCache::blockInPage(const int page_idx, const ocsd_vaddr_t address, const uint32_t reqBytes, const cache_page_tag_t &tag) const
 {
-    /* check has data, trcID and mem space */
-    if ((m_mru[m_mru_idx].trcID != trcID) ||
-        (m_mru[m_mru_idx].valid_len == 0)
+    const cache_block_t &page = m_mru[page_idx];
+
+    /* check has data, trcID, context, accessor and mem space */
+    if ((page.tag.trcID != tag.trcID) ||
+        (page.valid_len == 0) ||
+        (page.tag.ctxt_tag != tag.ctxt_tag) ||
+        (page.tag.p_acc != tag.p_acc) ||
+        (page.tag.mem_space != tag.mem_space)
         )
         return false;
 
     /* check block is in this page */
-    if ((m_mru[m_mru_idx].st_addr <= address) &&
-        m_mru[m_mru_idx].st_addr + m_mru[m_mru_idx].valid_len >= (address + reqBytes))
+    if ((page.st_addr <= address) &&
+        page.st_addr + page.valid_len >= (address + reqBytes))
         return true;
     return false;
 }
 
-inline bool TrcMemAccCache::blockInCache(const ocsd_vaddr_t address, const uint32_t reqBytes, const uint8_t trcID)
+inline int TrcMemAccCache::pageSet(const ocsd_vaddr_t page_key, const cache_page_tag_t &tag) const
+{
+    // consecutive pages go to consecutive sets, trace ID and context offset the sets used by each core / process.
+    const ocsd_vaddr_t offset = ((ocsd_vaddr_t)tag.trcID * 5) + (ocsd_vaddr_t)(tag.ctxt_tag ^ (tag.ctxt_tag >> 32)) * 3;
+    return (int)((page_key + offset) & (ocsd_vaddr_t)(m_num_sets - 1));
+}
+
+inline bool TrcMemAccCache::blockInSet(const int set_idx, const ocsd_vaddr_t address, const uint32_t reqBytes, const cache_page_tag_t &tag)
 {
-    int tests = m_mru_num_pages;
-    while (tests)
-    {        
-        if (blockInPage(address, reqBytes, trcID))
-            return true; // found address in page
-#ifdef LOG_CACHE_STATS    
-        // miss counts of current page only - to determine if we hit other page
-        if (tests == m_mru_num_pages)
-            m_misses++;
-#endif
-
-        tests--;
-        m_mru_idx++;
-        if (m_mru_idx == m_mru_num_pages)
-            m_mru_idx = 0;
+    const int first_idx = set_idx * m_set_ways;
+
+    for (int idx = first_idx; idx < first_idx + m_set_ways; idx++)
+    {
+        if (blockInPage(idx, address, reqBytes, tag))
+        {
+            m_mru_idx = idx;
+            return true;
+        }
     }
     return false;
 }
 
+inline bool TrcMemAccCache::blockInCache(const ocsd_vaddr_t address, const uint32_t reqBytes, const cache_page_tag_t &tag)
+{
+    // most likely in the page we used last
+    if (blockInPage(m_mru_idx, address, reqBytes, tag))
+        return true;
+    // page starting at or below the address must have a key of address key or address key - 1
+    const ocsd_vaddr_t page_key = address >> m_page_shift;
+    const int set_idx = pageSet(page_key, tag);
+    if (blockInSet(set_idx, address, reqBytes, tag))
+        return true;
+    if (page_key > 0)
+    {
+        const int prev_set_idx = pageSet(page_key - 1, tag);
+        if ((prev_set_idx != set_idx) && blockInSet(prev_set_idx, address, reqBytes, tag))
+            return true;
+    }
+    return false;
+}
+
+inline void TrcMemAccCache::setContext(const uint8_t trcID, const uint64_t ctxt_tag)
+{
+    m_ctxt_tags[trcID & (MEM_ACC_CACHE_NUM_TRC_IDS - 1)] = ctxt_tag;
+}
+
 // zero out page parameters rendering it empty
 inline void TrcMemAccCache::clearPage(cache_block_t* page)
 {
     page->use_sequence = 0;
     page->st_addr = 0;
     page->valid_len = 0;
-    page->trcID = OCSD_BAD_CS_SRC_ID;
+    page->tag.trcID = OCSD_BAD_CS_SRC_ID;
+    page->tag.ctxt_tag = 0;
+    page->tag.p_acc = 0;
+    page->tag.mem_space = OCSD_MEM_SPACE_NONE;
 }
 
 #endif // ARM_TRC_MEM_ACC_CACHE_H_INCLUDED
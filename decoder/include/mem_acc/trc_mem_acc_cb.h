@@ -35,9 +35,26 @@
 #ifndef ARM_TRC_MEM_ACC_CB_H_INCLUDED
 #define ARM_TRC_MEM_ACC_CB_H_INCLUDED
 
+#include <vector>
+#include <mutex>
 #include "mem_acc/trc_mem_acc_base.h"
 #include "mem_acc/trc_mem_acc_cb_if.h"
 
+#define MEM_ACC_CB_READ_AHEAD_MIN 16        // smallest read-ahead block
+#define MEM_ACC_CB_READ_AHEAD_MAX 0x10000   // largest read-ahead block
+
+/*
+ * Callback accessor - calls the client to read memory.
+ *
+ * Optional read-ahead reduces the number of callbacks: reads smaller than the maximum 
+ * read-ahead block are extended to the current block size and the extra data buffered.
+ * The block size starts at the minimum and doubles, up to the maximum, while reads follow 
+ * on sequentially from the buffered data. Buffered data is tagged with the memory space 
+ * and trace ID, and discarded when the mapper invalidates the cache for the trace ID.
+ *
+ * The accessor may be shared by decoders for different trace IDs on different threads,
+ * so reads and read-ahead updates are locked.
+ */
 class TrcMemAccCB : public TrcMemAccessorBase
 {
 public:
@@ -59,12 +76,37 @@ public:
     void setCBIfFn(Fn_MemAcc_CB p_fn, const void *p_context);
     void setCBIDIfFn(Fn_MemAccID_CB p_fn, const void *p_context);
 
+    /** set read-ahead block sizes - max_block 0 to disable read-ahead */
+    ocsd_err_t setReadAhead(const uint32_t min_block, const uint32_t max_block);
+    static const bool readAheadSizesValid(const uint32_t min_block, const uint32_t max_block);
+    void invalidateReadAhead(const uint8_t trcID);  //!< discard buffered data for the trace ID
+
+    const uint64_t getNumCallbacks() const { return m_num_callbacks; };
+    void resetNumCallbacks() { m_num_callbacks = 0; };
+
 private:
     void clearCBptrs();
+    const uint32_t callClient(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t memSpace, const uint8_t trcID, const uint32_t reqBytes, uint8_t *byteBuffer);
+    const uint32_t readAhead(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t memSpace, const uint8_t trcID, const uint32_t reqBytes, uint8_t *byteBuffer);
+
     TrcMemAccCBIF *m_p_CBclass;     //<! callback class.
     Fn_MemAcc_CB m_p_CBfn;          //<! callback function.
     Fn_MemAccID_CB m_p_CBIDfn;       //<! callback with ID function.
     const void *m_p_cbfn_context;   //<! context pointer for callback function.
+
+    uint64_t m_num_callbacks;       //<! number of calls to the client.
+
+    // read-ahead 
+    uint32_t m_ra_min;              //<! min block size
+    uint32_t m_ra_max;              //<! max block size - 0 if read-ahead disabled.
+    uint32_t m_ra_block;            //<! current block size.
+    std::vector<uint8_t> m_ra_buf;  //<! buffered data.
+    ocsd_vaddr_t m_ra_addr;         //<! address of buffered data.
+    uint32_t m_ra_len;              //<! valid bytes in buffer - 0 if none.
+    ocsd_mem_space_acc_t m_ra_space; //<! mem space for buffered data.
+    uint8_t m_ra_trcID;             //<! trace ID for buffered data.
+
+    std::mutex m_cb_lock;           //<! protects read-ahead state and the callback count.
 };
 
 inline void TrcMemAccCB::clearCBptrs()
@@ -75,6 +117,19 @@ inline void TrcMemAccCB::clearCBptrs()
     m_p_cbfn_context = 0;
 }
 
+inline const bool TrcMemAccCB::readAheadSizesValid(const uint32_t min_block, const uint32_t max_block)
+{
+    return (max_block == 0) || 
+           ((min_block >= MEM_ACC_CB_READ_AHEAD_MIN) && (max_block <= MEM_ACC_CB_READ_AHEAD_MAX) && (min_block <= max_block));
+}
+
+inline void TrcMemAccCB::invalidateReadAhead(const uint8_t trcID)
+{
+    std::lock_guard<std::mutex> lock(m_cb_lock);
+    if (m_ra_trcID == trcID)
+        m_ra_len = 0;
+}
+
 inline void TrcMemAccCB::setCBIfClass(TrcMemAccCBIF *p_if) 
 { 
     clearCBptrs();   // only one callback type per accessor.
@@ -0,0 +1,182 @@
+/*!
+* \file       trc_mem_acc_code_map.h
+* \brief      OpenCSD : Pre-decoded waypoint map of a memory image.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ARM_TRC_MEM_ACC_CODE_MAP_H_INCLUDED
+#define ARM_TRC_MEM_ACC_CODE_MAP_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "opencsd/ocsd_if_types.h"
+
+class TrcMemAccessorBase;
+
+#define OCSD_CODE_MAP_MAGIC     0x504D434F  // "OCMP"
+#define OCSD_CODE_MAP_VERSION   2
+#define OCSD_CODE_MAP_PATH_LEN  256         // image path field size, including terminator
+#define OCSD_CODE_MAP_FILE_EXT  ".ocsdmap"  // default sidecar file extension
+
+// code map decode settings flags
+#define OCSD_CODE_MAP_DSB_DMB_WP   0x01     // DMB / DSB decoded as waypoints
+#define OCSD_CODE_MAP_WFI_WFE_BR   0x02     // WFI / WFE decoded as branches
+
+// waypoint entry flags
+#define OCSD_CODE_MAP_WP_LINK      0x01     // branch with link
+#define OCSD_CODE_MAP_WP_COND      0x02     // conditional instruction
+#define OCSD_CODE_MAP_WP_TO_THUMB  0x04     // next ISA is T32 (A32 BLX immediate)
+
+// waypoint type for an opcode the instruction decoder rejected - decoders walk from the address.
+#define OCSD_CODE_MAP_WP_STOP      0xFF
+
+// sidecar file header - followed by num_wp code_map_wp_t entries, sorted by address.
+typedef struct _code_map_hdr {
+    uint32_t magic;             // OCSD_CODE_MAP_MAGIC - also checks host byte order
+    uint16_t version;           // OCSD_CODE_MAP_VERSION
+    uint16_t hdr_size;          // sizeof(code_map_hdr_t)
+    uint64_t content_hash;      // hash of the image bytes in the mapped range
+    uint64_t st_addr;           // first address in the mapped range
+    uint64_t en_addr;           // inclusive last address in the mapped range
+    uint32_t num_wp;            // number of waypoint entries
+    uint16_t arch_version;      // ocsd_arch_version_t used to decode
+    uint8_t isa;                // ocsd_isa of the mapped range (A32 or A64)
+    uint8_t dcd_flags;          // OCSD_CODE_MAP_ decode settings
+    uint8_t profile;            // ocsd_core_profile_t used to decode
+    uint8_t reserved[7];        // zero
+    char image_path[OCSD_CODE_MAP_PATH_LEN]; // image the map was built from
+} code_map_hdr_t;
+
+// waypoint instruction in the map
+typedef struct _code_map_wp {
+    uint32_t offset;            // offset of the waypoint instruction from the range start address
+    int32_t branch_offset;      // direct branch target, relative to the waypoint address
+    uint32_t opcode;            // instruction opcode
+    uint8_t type;               // ocsd_instr_type, or OCSD_CODE_MAP_WP_STOP
+    uint8_t sub_type;           // ocsd_instr_subtype
+    uint8_t flags;              // OCSD_CODE_MAP_WP_ flags
+    uint8_t size;               // instruction size in bytes
+} code_map_wp_t;
+
+/*!
+ * @class TrcMemAccCodeMap
+ * @brief Waypoint map for the code in a memory image.
+ *
+ * Created by scanning an accessor's address range once, decoding every instruction and
+ * recording the waypoints - branches, ISB and optionally barriers and WFI / WFE.
+ * Decoders walking from an address to the next waypoint can then use a binary search
+ * on the map rather than reading and decoding each instruction.
+ *
+ * Maps are saved as a sidecar file - a fixed header and an array of fixed size entries
+ * that can be used directly from a memory mapping of the file. The header records the
+ * image path, address range, core architecture and profile, decode settings and a hash 
+ * of the image content. The hash
+ * is checked against the accessor memory when a map is attached to the accessor, so a
+ * map is only used for the image it was built from.
+ *
+ * Fixed length instruction sets only - A64 and A32, ranges up to 4GB.
+ */
+class TrcMemAccCodeMap
+{
+public:
+    TrcMemAccCodeMap();
+    ~TrcMemAccCodeMap();
+
+    /*!
+     * Scan an address range of a memory accessor and build the map.
+     *
+     * @param p_accessor : Accessor for the memory image.
+     * @param st_addr : Start address of the range to scan.
+     * @param en_addr : Inclusive end address of the range to scan.
+     * @param isa : Instruction set of the code - ocsd_isa_aarch64 or ocsd_isa_arm.
+     * @param &pe_type : Architecture version and profile of the core running the code.
+     * @param dcd_flags : OCSD_CODE_MAP_ decode settings - must match the decoder settings.
+     * @param &image_path : Image identifier recorded in the map - usually the image file path.
+     *
+     * @return ocsd_err_t  : Library error code -  OCSD_OK if successful.
+     */
+    ocsd_err_t buildMap(TrcMemAccessorBase *p_accessor, const ocsd_vaddr_t st_addr, const ocsd_vaddr_t en_addr,
+                        const ocsd_isa isa, const ocsd_arch_profile_t &pe_type, const uint8_t dcd_flags,
+                        const std::string &image_path);
+
+    /*! Save the map to a sidecar file. */
+    ocsd_err_t saveMap(const std::string &map_path) const;
+
+    /*! Load a map from a sidecar file. File is memory mapped where possible. */
+    ocsd_err_t loadMap(const std::string &map_path);
+
+    /*! Check the accessor memory matches the image the map was built from. */
+    ocsd_err_t checkImage(TrcMemAccessorBase *p_accessor) const;
+
+    /*!
+     * Find the next waypoint at or after instr_info->instr_addr.
+     *
+     * Succeeds if ISA, core architecture and profile, and decode settings in instr_info match the map, and the address
+     * and waypoint are in the mapped range. instr_info is then updated as if decoded
+     * by walking the instructions to the waypoint.
+     *
+     * @param *instr_info : [in/out] Instruction info - address, ISA and settings in, waypoint decode out.
+     * @param *num_instr : [out] Number of instructions to the waypoint, inclusive.
+     *
+     * @return bool  : true if waypoint found.
+     */
+    bool findWaypoint(ocsd_instr_info *instr_info, uint32_t *num_instr) const;
+
+    /* map information */
+    const ocsd_vaddr_t getStartAddr() const { return (ocsd_vaddr_t)m_hdr.st_addr; };
+    const ocsd_vaddr_t getEndAddr() const { return (ocsd_vaddr_t)m_hdr.en_addr; };
+    const ocsd_isa getISA() const { return (ocsd_isa)m_hdr.isa; };
+    const ocsd_arch_version_t getArchVersion() const { return (ocsd_arch_version_t)m_hdr.arch_version; };
+    const ocsd_core_profile_t getCoreProfile() const { return (ocsd_core_profile_t)m_hdr.profile; };
+    const uint32_t getNumWaypoints() const { return m_hdr.num_wp; };
+    const uint64_t getContentHash() const { return m_hdr.content_hash; };
+    const std::string getImagePath() const { return std::string(m_hdr.image_path); };
+
+    /*! Default sidecar file path for an image file. */
+    static std::string defaultMapPath(const std::string &image_path) { return image_path + OCSD_CODE_MAP_FILE_EXT; };
+
+private:
+    void clear();
+    ocsd_err_t hashImage(TrcMemAccessorBase *p_accessor, uint64_t &hash) const;
+
+    code_map_hdr_t m_hdr;
+    const code_map_wp_t *m_p_wp;        // waypoint entries - in m_wp_buf or file mapping
+    std::vector<code_map_wp_t> m_wp_buf; // entries built or read from file.
+
+    const uint8_t *m_p_map_base;        // base of sidecar file mapping - 0 if not mapped
+    size_t m_map_size;                  // size of the file mapping
+    void *m_map_handle;                 // OS handle for the mapping (Windows only)
+};
+
+#endif // ARM_TRC_MEM_ACC_CODE_MAP_H_INCLUDED
+
+/* End of File trc_mem_acc_code_map.h */
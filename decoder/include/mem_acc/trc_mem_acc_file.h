@@ -39,6 +39,7 @@
 #include <string>
 #include <fstream>
 #include <list>
+#include <mutex>
 
 #include "opencsd/ocsd_if_types.h"
 #include "mem_acc/trc_mem_acc_base.h"
@@ -79,6 +80,9 @@ public:
     /** read bytes override - reads from file */
     virtual const uint32_t readBytes(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t memSpace, const uint8_t trcID, const uint32_t reqBytes, uint8_t *byteBuffer);
 
+    /** direct access override - pointer into the file mapping, 0 if file not mapped */
+    virtual const uint8_t *readBytesPtr(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t memSpace, const uint8_t trcID, uint32_t &availBytes);
+
 protected:
     TrcMemAccessorFile();   /**< protected default constructor */
     virtual ~ TrcMemAccessorFile(); /**< protected default destructor */
@@ -98,10 +102,20 @@ protected:
      *
      * @param &pathToFile : Binary file path and name
      * @param startAddr : system memory address associated with start of binary datain file.
+     * @param file_acc_opts : OCSD_FILE_MEM_ACC_OPT_ flags - set _MMAP to map the file.
      *
      * @return bool  : true if set up successfully, false if file could not be opened.
      */
-    ocsd_err_t initAccessor(const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset, size_t size);
+    ocsd_err_t initAccessor(const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset, size_t size, const uint32_t file_acc_opts);
+
+    /** map the file read-only into memory - false if mapping not possible */
+    bool mapFile(const std::string &pathToFile);
+
+    /** release any file mapping */
+    void unmapFile();
+
+    /** get the offset in the file for an address - returns 0 bytes available if not in range */
+    const uint32_t fileOffsetForAddress(const ocsd_vaddr_t address, const uint32_t reqBytes, size_t &file_offset) const;
 
     /** get the file path */
     const std::string &getFilePath() const { return m_file_path; };
@@ -121,7 +135,8 @@ public:
      * @param size   : size of range in bytes.
      * @param offset : offset into file for that data.
      *
-     * @return bool  : true if set successfully.
+     * @return bool  : true if set successfully. false if the range is empty, extends beyond the end 
+     *                 of the file or overlaps an existing range.
      */
     bool AddOffsetRange(const ocsd_vaddr_t startAddr, const size_t size, const size_t offset);
 
@@ -164,6 +179,10 @@ public:
      */
     virtual const bool overLapRange(const TrcMemAccessorBase *p_test_acc) const;
 
+    /*! Override to return the base range and any additional regions in the file. */
+    virtual const int getNumRanges() const;
+    virtual const bool getRange(const int range_idx, ocsd_vaddr_t &startAddr, ocsd_vaddr_t &endAddr) const;
+
     /*! Override to handle ranges and offset accessors plus add in file name. */
     virtual void getMemAccString(std::string &accStr) const;
 
@@ -177,12 +196,23 @@ public:
      * If an accessor using the supplied file is currently in use then a reference to that
      * accessor will be returned and the accessor reference counter updated.
      *
+     * If OCSD_FILE_MEM_ACC_OPT_MMAP is set in the options the file will be mapped read-only into
+     * memory, and data read directly from the mapping. If the mapping fails the accessor will
+     * read from the file. Options are ignored when returning an existing accessor.
+     *
+     * Accessors may be shared by decode trees on different threads. The memory space is set
+     * here, under the accessor list lock, rather than by the caller once the accessor is returned.
+     *
      * @param &pathToFile : Path to binary file
      * @param startAddr : Start address of data represented by file.
+     * @param offset : Offset into the file for the start address.
+     * @param size : Size of the region - 0 for whole file if offset is 0.
+     * @param file_acc_opts : OCSD_FILE_MEM_ACC_OPT_ flags.
+     * @param mem_space : Memory space for the accessor.
      *
      * @return TrcMemAccessorFile * : pointer to accessor if successful, 0 if it could not be created.
      */
-    static ocsd_err_t createFileAccessor(TrcMemAccessorFile **p_acc, const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset = 0, size_t size = 0);
+    static ocsd_err_t createFileAccessor(TrcMemAccessorFile **p_acc, const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset = 0, size_t size = 0, const uint32_t file_acc_opts = OCSD_FILE_MEM_ACC_OPT_NONE, const ocsd_mem_space_acc_t mem_space = OCSD_MEM_SPACE_ANY);
 
     /*!
      * Destroy supplied accessor. 
@@ -213,20 +243,27 @@ public:
      */
     static TrcMemAccessorFile * getExistingFileAccessor(const std::string &pathToFile);
 
+    /*! true if the file is mapped into memory rather than read through a file stream */
+    const bool isMapped() const { return (bool)(m_p_map_base != 0); };
 
 
 
 private:
     static std::map<std::string, TrcMemAccessorFile *> s_FileAccessorMap;   /**< map of file accessors in use. */
+    static std::mutex s_FileAccessorLock;   /**< protects the map and accessor reference counts - trees may be created on different threads */
 
 private:
     std::ifstream m_mem_file;   /**< input binary file stream */
+    mutable std::recursive_mutex m_file_lock;   /**< accessor is shared by trees on different threads - protects ranges and stream position */
     ocsd_vaddr_t m_file_size;  /**< size of the file */
     int m_ref_count;            /**< accessor reference count */
     std::string m_file_path;    /**< path to input file */
     std::list<FileRegionMemAccessor *> m_access_regions;    /**< additional regions in the file at non-zero offsets */
     bool m_base_range_set;      /**< true when offset 0 set */
     bool m_has_access_regions;  /**< true if single file contains multiple regions */
+    const uint8_t *m_p_map_base;    /**< base of read-only file mapping - 0 if reading via file stream */
+    size_t m_map_size;              /**< size of the file mapping */
+    void *m_map_handle;             /**< OS handle for the mapping (Windows only) */
 };
 
 #endif // ARM_TRC_MEM_ACC_FILE_H_INCLUDED
@@ -43,10 +43,33 @@
 #include "mem_acc/trc_mem_acc_base.h"
 #include "mem_acc/trc_mem_acc_cache.h"
 
+class TrcMemAccCodeMap;
+class TrcMemAccCB;
+
 typedef enum _memacc_mapper_t {
-    MEMACC_MAP_GLOBAL,
+    MEMACC_MAP_GLOBAL,          // all accessors common to all trace IDs
+    MEMACC_MAP_PER_TRACE_ID,    // accessors per trace ID, with common global accessors
 } memacc_mapper_t;
 
+// number of recently missed address ranges held by the mapper.
+#define MEMACC_MAP_NACC_CACHE_SIZE 4
+
+// address range with no accessor, for a memory space and trace ID.
+typedef struct _nacc_range {
+    ocsd_vaddr_t st_addr;           // start address of the gap.
+    ocsd_vaddr_t en_addr;           // inclusive end address of the gap.
+    ocsd_mem_space_acc_t mem_space; // memory space of the missed read - 0 if entry unused.
+    uint8_t trcID;                  // trace ID for mappers using trace ID, 0 otherwise.
+} nacc_range_t;
+
+// negative lookup cache of recently missed ranges, with unmapped read counts.
+typedef struct _nacc_cache {
+    nacc_range_t ranges[MEMACC_MAP_NACC_CACHE_SIZE];
+    int next;                       // next entry to replace.
+    uint64_t unmapped_reads;        // reads with no accessor.
+    uint64_t unmapped_hits;         // reads with no accessor found in the negative lookup cache.
+} nacc_cache_t;
+
 class TrcMemAccMapper : public ITargetMemAccess
 {
 public:
@@ -61,8 +84,20 @@ public:
                                             uint32_t *num_bytes, 
                                             uint8_t *p_buffer);
 
+    virtual ocsd_err_t ReadTargetMemoryPtr( const ocsd_vaddr_t address,
+                                            const uint8_t cs_trace_id,
+                                            const ocsd_mem_space_acc_t mem_space,
+                                            uint32_t *num_bytes,
+                                            const uint8_t **pp_data);
+
     virtual void InvalidateMemAccCache(const uint8_t cs_trace_id);
 
+    virtual void SetMemAccContext(const uint8_t cs_trace_id, const uint64_t ctxt_tag);
+
+    virtual ocsd_err_t GetMemAccGeneration(const uint8_t cs_trace_id, uint32_t *p_generation);
+
+    virtual ocsd_err_t FindCodeMapWaypoint(const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space, ocsd_instr_info *instr_info, uint32_t *num_instr);
+
 // mapper memory area configuration interface
 
     // add an accessor to this map
@@ -79,25 +114,57 @@ public:
     ocsd_err_t RemoveAccessorByAddress(const ocsd_vaddr_t st_address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id = 0);
     
     // set the error log.
-    void setErrorLog(ITraceErrorLog *err_log_i);
+    virtual void setErrorLog(ITraceErrorLog *err_log_i);
+    ITraceErrorLog *getErrorLog() const { return m_err_log; };
 
     // print out the ranges in this mapper.
     virtual void logMappedRanges() = 0;
 
+    // attach a code map to the accessor covering the map start address - accessor owns the map if successful.
+    ocsd_err_t AddCodeMap(TrcMemAccCodeMap *p_map, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id = 0);
+
+    // accessor ranges changed after adding to the map (e.g. regions added to a file accessor).
+    virtual void updateAccessorRanges() {};
+
     // control memory access caching at runtime
-    ocsd_err_t enableCaching(bool bEnable);
+    virtual ocsd_err_t enableCaching(bool bEnable);
 
     // set cache page size and number of pages (max 16k size, 256 pages) - 
     // optionally error if outside limits - otherwise set to max / min automatically
-    ocsd_err_t setCacheSizes(uint16_t page_size, int num_pages, const bool err_on_limit = false);
+    virtual ocsd_err_t setCacheSizes(uint16_t page_size, int num_pages, const bool err_on_limit = false);
+
+    // memory access statistics - totals for all caches in the mapper
+    virtual void getMemAccStats(ocsd_mem_acc_stats_t &stats);
+    virtual void resetMemAccStats();
 
 protected:
-    virtual bool findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id) = 0;     // set m_acc_curr if found valid range, leave unchanged if not.
-    virtual bool readFromCurrent(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id) = 0;
+    virtual TrcMemAccessorBase *findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id) = 0;     // accessor for the address, made current for the ID - 0 and current unchanged if none.
+    virtual TrcMemAccessorBase *findAccessorToRemove(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id) { return findAccessor(address, mem_space, cs_trace_id); };  // as findAccessor, for remove by address.
+    virtual TrcMemAccessorBase *readFromCurrent(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id) = 0;  // current accessor for the ID if it covers the address, 0 if not.
     virtual TrcMemAccessorBase *getFirstAccessor() = 0;
     virtual TrcMemAccessorBase *getNextAccessor() = 0;
     virtual void clearAccessorList() = 0;
 
+    // range around an address with no accessor, for any memory space - used for negative lookups.
+    virtual void getUnmappedRange(const ocsd_vaddr_t address, const uint8_t /*cs_trace_id*/, ocsd_vaddr_t &st_addr, ocsd_vaddr_t &en_addr) { st_addr = en_addr = address; };
+
+    TrcMemAccessorBase *selectAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id); // accessor for the address, 0 if none.
+    ocsd_err_t readPtrFromAccessor(TrcMemAccessorBase *p_acc, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id, uint32_t *num_bytes, const uint8_t **pp_data);
+
+    // state updated by reads, by trace ID - reads for different IDs in the per trace ID mapper use separate state.
+    virtual TrcMemAccCache &getCache(const uint8_t /*cs_trace_id*/) { return m_cache; }; // cache used for reads by trace ID.
+    virtual nacc_cache_t &getNaccCache(const uint8_t /*cs_trace_id*/) { return m_nacc; };
+    virtual std::vector<uint8_t> &getPtrReadBuf(const uint8_t /*cs_trace_id*/) { return m_ptr_read_buf; };
+    virtual void invalidateAllCaches();  // accessors changed - invalidate all cached data.
+    void invalidateReadAhead(const uint8_t cs_trace_id); // discard data buffered by callback accessors for the ID.
+
+    // negative lookup cache of recently missed ranges.
+    bool inNaccCache(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id);
+    void addNaccRange(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id);
+    virtual void invalidateNaccCache();
+    static void clearNaccCache(nacc_cache_t &nacc);
+    void accessorsChanged();     // accessors added or removed - clear negative lookups, new memory generation, update callback list.
+
     void LogMessage(const std::string &msg);
     void LogWarn(const ocsd_err_t err, const std::string &msg);
 
@@ -106,33 +173,183 @@ protected:
     const bool m_using_trace_id;        // true if we are using separate memory spaces by TraceID.
     ITraceErrorLog *m_err_log;          // error log to print out mappings on request.
     TrcMemAccCache m_cache;             // memory accessor caching.
+    std::vector<uint8_t> m_ptr_read_buf; // backing for pointer reads when accessor and cache cannot supply a pointer.
+
+    nacc_cache_t m_nacc;                // recently missed ranges.
+
+    uint32_t m_acc_generation;          // incremented when accessors change.
+    uint32_t m_id_generation[MEM_ACC_CACHE_NUM_TRC_IDS];  // incremented when cache for the trace ID invalidated.
+
+    int m_num_code_maps;                // code maps attached to accessors through this mapper.
+    std::vector<TrcMemAccCB *> m_cb_accs; // callback accessors - may hold read-ahead data to invalidate.
 };
 
 
+// entry in the sorted address index of accessor ranges.
+typedef struct _acc_range_entry {
+    ocsd_vaddr_t st_addr;       // start address of this range.
+    ocsd_vaddr_t en_addr;       // inclusive end address of this range.
+    ocsd_vaddr_t max_en_addr;   // highest end address of this and all lower index entries.
+    uint32_t add_seq;           // order accessor was added - earliest added wins on multiple matches.
+    TrcMemAccessorBase *p_acc;  // accessor owning this range.
+} acc_range_entry_t;
+
+// Accessor ranges held in an index sorted by start address, so that finding a new
+// accessor is a binary search rather than a scan of every accessor in the map. 
+class TrcMemAccRangeIndex
+{
+public:
+    TrcMemAccRangeIndex() : m_add_seq(0) {};
+    ~TrcMemAccRangeIndex() {};
+
+    void addAccessor(TrcMemAccessorBase *p_accessor);
+    void removeAccessor(const TrcMemAccessorBase *p_accessor);
+    void clear();
+
+    // find accessor covering the address in the memory space - 0 if none.
+    TrcMemAccessorBase *findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space) const;
+
+    // narrow st_addr - en_addr to exclude all ranges in the index, for an address not in any range in any memory space.
+    void limitToGap(const ocsd_vaddr_t address, ocsd_vaddr_t &st_addr, ocsd_vaddr_t &en_addr) const;
+
+private:
+    void setMaxEnd(const size_t from_idx);
+
+    std::vector<acc_range_entry_t> m_index;   // accessor ranges sorted by start address
+    uint32_t m_add_seq;                       // next accessor add sequence number.
+};
+
 // address spaces common to all sources using this mapper.
 // trace id unused when differentiating accessors - may be used by underlying read operations.
-class TrcMemAccMapGlobalSpace : public TrcMemAccMapper
+//
+// final - decoders holding the library mapper call it directly (componentAttachPtImpl).
+class TrcMemAccMapGlobalSpace final : public TrcMemAccMapper
 {
 public:
     TrcMemAccMapGlobalSpace();
     virtual ~TrcMemAccMapGlobalSpace();
 
+    // non-virtual ReadTargetMemoryPtr() - current accessor range checked in line.
+    ocsd_err_t readTargetMemoryPtrDirect(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space, uint32_t *num_bytes, const uint8_t **pp_data);
+
     // mapper creation interface - prevent overlaps
     virtual ocsd_err_t AddAccessor(TrcMemAccessorBase *p_accessor, const uint8_t cs_trace_id);
 
     // print out the ranges in this mapper.
     virtual void logMappedRanges();
 
+    // re-read accessor ranges into the index.
+    virtual void updateAccessorRanges();
+
 protected:
-    virtual bool findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id); 
-    virtual bool readFromCurrent(const ocsd_vaddr_t address,const ocsd_mem_space_acc_t mem_space,  const uint8_t cs_trace_id);    
+    virtual TrcMemAccessorBase *findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id); 
+    virtual TrcMemAccessorBase *readFromCurrent(const ocsd_vaddr_t address,const ocsd_mem_space_acc_t mem_space,  const uint8_t cs_trace_id);    
     virtual TrcMemAccessorBase *getFirstAccessor();
     virtual TrcMemAccessorBase *getNextAccessor();
     virtual void clearAccessorList();
     virtual ocsd_err_t RemoveAccessor(const TrcMemAccessorBase *p_accessor);
+    virtual void getUnmappedRange(const ocsd_vaddr_t address, const uint8_t cs_trace_id, ocsd_vaddr_t &st_addr, ocsd_vaddr_t &en_addr);
 
     std::vector<TrcMemAccessorBase *> m_acc_global;
     std::vector<TrcMemAccessorBase *>::iterator m_acc_it;
+
+    TrcMemAccRangeIndex m_acc_index;   // index of accessor ranges.
+
+private:
+    bool inCurrent(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space) const
+    {
+        return m_acc_curr && m_acc_curr->addrInRange(address) && m_acc_curr->inMemSpace(mem_space);
+    };
+};
+
+inline ocsd_err_t TrcMemAccMapGlobalSpace::readTargetMemoryPtrDirect(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space, uint32_t *num_bytes, const uint8_t **pp_data)
+{
+    TrcMemAccessorBase *p_acc = inCurrent(address, mem_space) ? m_acc_curr : selectAccessor(address, mem_space, cs_trace_id);
+    if (!p_acc)
+    {
+        *num_bytes = 0;
+        *pp_data = 0;
+        return OCSD_OK;
+    }
+    return readPtrFromAccessor(p_acc, address, mem_space, cs_trace_id, num_bytes, pp_data);
+}
+
+// number of trace ID values that may have separate accessor sets.
+#define MEMACC_MAP_NUM_TRACE_IDS 0x80
+
+// address spaces per trace ID. 
+// Accessors added with a trace ID are only used by sources with that ID, accessors added with
+// trace ID 0 are global and used by all sources where no trace ID specific accessor matches.
+//
+// Each trace ID has a separate current accessor and cache partition, so decoders for different
+// cores interleaving reads do not evict each other's working set.
+//
+// Reads only update the state for their trace ID, so reads for different IDs may run on different 
+// threads while the accessors are unchanged. Shared accessors must be safe for this - the library 
+// file and callback accessors lock internally.
+class TrcMemAccMapPerTraceID : public TrcMemAccMapper
+{
+public:
+    TrcMemAccMapPerTraceID();
+    virtual ~TrcMemAccMapPerTraceID();
+
+    // mapper creation interface - prevent overlaps within accessors for the same trace ID
+    virtual ocsd_err_t AddAccessor(TrcMemAccessorBase *p_accessor, const uint8_t cs_trace_id);
+
+    // print out the ranges in this mapper.
+    virtual void logMappedRanges();
+
+    // re-read accessor ranges into the indexes.
+    virtual void updateAccessorRanges();
+
+    // cache settings apply to the partitions for all trace IDs.
+    virtual void setErrorLog(ITraceErrorLog *err_log_i);
+    virtual ocsd_err_t enableCaching(bool bEnable);
+    virtual ocsd_err_t setCacheSizes(uint16_t page_size, int num_pages, const bool err_on_limit = false);
+
+    virtual void getMemAccStats(ocsd_mem_acc_stats_t &stats);
+    virtual void resetMemAccStats();
+
+protected:
+    virtual TrcMemAccessorBase *findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id); 
+    virtual TrcMemAccessorBase *findAccessorToRemove(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id);  // trace ID set only - no global fallback.
+    virtual TrcMemAccessorBase *readFromCurrent(const ocsd_vaddr_t address,const ocsd_mem_space_acc_t mem_space,  const uint8_t cs_trace_id);    
+    virtual TrcMemAccessorBase *getFirstAccessor();
+    virtual TrcMemAccessorBase *getNextAccessor();
+    virtual void clearAccessorList();
+    virtual ocsd_err_t RemoveAccessor(const TrcMemAccessorBase *p_accessor);
+    virtual void getUnmappedRange(const ocsd_vaddr_t address, const uint8_t cs_trace_id, ocsd_vaddr_t &st_addr, ocsd_vaddr_t &en_addr);
+
+    virtual TrcMemAccCache &getCache(const uint8_t cs_trace_id);
+    virtual nacc_cache_t &getNaccCache(const uint8_t cs_trace_id);
+    virtual std::vector<uint8_t> &getPtrReadBuf(const uint8_t cs_trace_id);
+    virtual void invalidateAllCaches();
+    virtual void invalidateNaccCache();
+
+private:
+    // accessors, and the state updated by reads, for a single trace ID
+    typedef struct _trcid_acc_set {
+        std::vector<TrcMemAccessorBase *> accessors;
+        TrcMemAccRangeIndex index;
+        TrcMemAccessorBase *acc_curr;
+        TrcMemAccCache cache;
+        nacc_cache_t nacc;
+        std::vector<uint8_t> ptr_read_buf;
+    } trcid_acc_set_t;
+
+    trcid_acc_set_t *getAccSet(const uint8_t cs_trace_id);     // get set for the ID - create if needed, 0 on error.
+    ocsd_err_t initSetCache(trcid_acc_set_t *p_set);         // apply current cache settings to the set.
+
+    trcid_acc_set_t *m_acc_sets[MEMACC_MAP_NUM_TRACE_IDS];  // accessor sets - index 0 for global accessors.
+
+    // cache settings for all sets.
+    bool m_cache_enabled;
+    uint16_t m_cache_page_size;
+    int m_cache_num_pages;
+
+    // accessor iteration
+    int m_it_set;
+    size_t m_it_idx;
 };
 
 #endif // ARM_TRC_MEM_ACC_MAPPER_H_INCLUDED
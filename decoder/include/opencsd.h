@@ -55,6 +55,7 @@
 #include "common/ocsd_error.h"
 #include "common/trc_gen_elem.h"
 #include "common/trc_core_arch_map.h"
+#include "common/trc_branch_recorder.h"
 
 /** Implemented Protocol decoders */
 #include "common/trc_frame_deformatter.h"
@@ -79,6 +80,7 @@
 /** The decode tree and decoder register*/
 #include "common/ocsd_lib_dcd_register.h"
 #include "common/ocsd_dcd_tree.h"
+#include "common/ocsd_dcd_segments.h"
 
 
 #endif // ARM_OPENCSD_H_INCLUDED
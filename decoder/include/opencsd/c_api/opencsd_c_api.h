@@ -240,6 +240,63 @@ OCSD_C_API ocsd_err_t ocsd_dt_get_decode_stats( const dcd_tree_handle_t handle,
 OCSD_C_API ocsd_err_t ocsd_dt_reset_decode_stats( const dcd_tree_handle_t handle,
                                                   const unsigned char CSID);
 
+/*!
+ * Get the memory access statistics for the decode tree memory mapper.
+ * Cache hits, misses, evictions, invalidations and bytes read from memory accessors.
+ * Caller must check p_stats->version to ensure that the block is filled in a compatible manner.
+ *
+ * @param handle : Handle to decode tree.
+ * @param p_stats : block to fill with the statistics.
+ *
+ * @return ocsd_err_t  : Library error code -  OCSD_OK if successful, 
+ *                      OCSD_ERR_NOT_INIT if no memory mapper in the decode tree.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_get_mem_acc_stats(const dcd_tree_handle_t handle,
+                                                ocsd_mem_acc_stats_t *p_stats);
+
+/*!
+ * Reset the memory access statistics for the decode tree memory mapper.
+ *
+ * @param handle : Handle to decode tree.
+ *
+ * @return ocsd_err_t  : Library error code -  OCSD_OK if successful.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_reset_mem_acc_stats(const dcd_tree_handle_t handle);
+
+/*!
+ * Set the number of worker threads used to decode the trace IDs in the decode tree.
+ * The deformatter runs on the caller thread, the decoder for each ID runs on a worker thread.
+ * Output for each ID remains in order. Requires a tree using the frame deformatter.
+ *
+ * Fatal errors from decoders on worker threads are returned on a later call to ocsd_dt_process_data(),
+ * at the latest on OCSD_OP_EOT or OCSD_OP_FLUSH.
+ *
+ * @param handle      : Handle to decode tree.
+ * @param num_threads : Number of worker threads, 0 to decode on the caller thread.
+ * @param out_mode    : OCSD_DCD_THREAD_OUT_SERIAL to serialise calls to the output callback, 
+ *                      OCSD_DCD_THREAD_OUT_CONCURRENT to call it directly from the worker threads.
+ *
+ * @return ocsd_err_t  : Library error code -  OCSD_OK if successful.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_set_decode_threads(const dcd_tree_handle_t handle, const int num_threads, const ocsd_dcd_thread_out_t out_mode);
+
+/*!
+ * Pipeline the decode in the decode tree - the deformatter runs on its own thread, passing the data for 
+ * each ID through lock-free queues to the decoder for the ID on one of the worker threads.
+ * Requires a tree using the frame deformatter.
+ *
+ * ocsd_dt_process_data() returns OCSD_RESP_WAIT when the pipeline input queue is full - send OCSD_OP_FLUSH,
+ * then the remaining data. Fatal errors are returned as for ocsd_dt_set_decode_threads(), once the queued data is decoded.
+ *
+ * @param handle      : Handle to decode tree.
+ * @param num_threads : Number of decoder worker threads, 0 to decode on the caller thread.
+ * @param out_mode    : OCSD_DCD_THREAD_OUT_SERIAL to serialise calls to the output callback, 
+ *                      OCSD_DCD_THREAD_OUT_CONCURRENT to call it directly from the worker threads.
+ *
+ * @return ocsd_err_t  : Library error code -  OCSD_OK if successful.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_set_decode_pipeline(const dcd_tree_handle_t handle, const int num_threads, const ocsd_dcd_thread_out_t out_mode);
+
 /** @}*/
 /*---------------------- Memory Access for traced opcodes ----------------------------------------------------------------------------------*/
 /** @name Library Memory Accessor configuration on decode tree.
@@ -283,6 +340,39 @@ OCSD_C_API ocsd_err_t ocsd_dt_add_binfile_mem_acc(const dcd_tree_handle_t handle
  */
 OCSD_C_API ocsd_err_t ocsd_dt_add_binfile_region_mem_acc(const dcd_tree_handle_t handle, const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const char *filepath); 
 
+/*!
+ * Add a binary file based memory range accessor to the decode tree, with file accessor options.
+ *
+ * As ocsd_dt_add_binfile_mem_acc(). Set OCSD_FILE_MEM_ACC_OPT_MMAP in file_acc_opts to map the 
+ * file read-only into memory, rather than read opcodes through a file stream.
+ *
+ * @param handle : Handle to decode tree.
+ * @param address : Start address of memory area.
+ * @param mem_space : Associated memory space.
+ * @param *filepath : Path to binary data file.
+ * @param file_acc_opts : Binary file accessor options - OCSD_FILE_MEM_ACC_OPT_ flags.
+ *
+ * @return ocsd_err_t  : Library error code -  OCSD_OK if successful.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_add_binfile_mem_acc_opts(const dcd_tree_handle_t handle, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const char *filepath, const uint32_t file_acc_opts);
+
+/*!
+ * Add a multi-region binary file based memory range accessor to the decode tree, with file accessor options.
+ *
+ * As ocsd_dt_add_binfile_region_mem_acc(). Set OCSD_FILE_MEM_ACC_OPT_MMAP in file_acc_opts to map the 
+ * file read-only into memory, rather than read opcodes through a file stream.
+ *
+ * @param handle : Handle to decode tree.
+ * @param region_list : Array of memory regions in the file.
+ * @param num_regions : Size of region array
+ * @param mem_space : Associated memory space.
+ * @param *filepath : Path to binary data file.
+ * @param file_acc_opts : Binary file accessor options - OCSD_FILE_MEM_ACC_OPT_ flags.
+ *
+ * @return ocsd_err_t  : Library error code -  OCSD_OK if successful.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_add_binfile_region_mem_acc_opts(const dcd_tree_handle_t handle, const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const char *filepath, const uint32_t file_acc_opts);
+
 /*!
  * Add a memory buffer based memory range accessor to the decode tree.
  *
@@ -340,6 +430,66 @@ OCSD_C_API ocsd_err_t ocsd_dt_add_callback_trcid_mem_acc(const dcd_tree_handle_t
  */
 OCSD_C_API ocsd_err_t ocsd_dt_remove_mem_acc(const dcd_tree_handle_t handle, const ocsd_vaddr_t st_address, const ocsd_mem_space_acc_t mem_space);
 
+/*!
+ * Create a memory mapper that holds memory accessors per trace ID. 
+ *
+ * Accessors added using the _for_id functions with a non-zero cs_trace_id are only used when 
+ * decoding trace from that ID, and are used in preference to accessors added with cs_trace_id 0, 
+ * or the functions without a trace ID, which are used for all IDs. Each trace ID has a separate
+ * memory access cache.
+ *
+ * Replaces any existing mapper - call before adding any memory accessors.
+ *
+ * @param handle : Handle to decode tree.
+ *
+ * @return OCSD_C_API ocsd_err_t  : Library error code -  RCDTL_OK if successful.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_create_per_trcid_mem_acc_mapper(const dcd_tree_handle_t handle);
+
+/*!
+ * As ocsd_dt_add_buffer_mem_acc(), for the trace ID supplied.
+ *
+ * @param cs_trace_id : Trace ID using this accessor - 0 for all IDs.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_add_buffer_mem_acc_for_id(const dcd_tree_handle_t handle, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t *p_mem_buffer, const uint32_t mem_length, const uint8_t cs_trace_id);
+
+/*!
+ * As ocsd_dt_add_binfile_region_mem_acc_opts(), for the trace ID supplied.
+ *
+ * @param cs_trace_id : Trace ID using this accessor - 0 for all IDs.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_add_binfile_region_mem_acc_for_id(const dcd_tree_handle_t handle, const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const char *filepath, const uint32_t file_acc_opts, const uint8_t cs_trace_id);
+
+/*!
+ * As ocsd_dt_add_callback_trcid_mem_acc(), for the trace ID supplied.
+ *
+ * @param cs_trace_id : Trace ID using this accessor - 0 for all IDs.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_add_callback_trcid_mem_acc_for_id(const dcd_tree_handle_t handle, const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAccID_CB p_cb_func, const void *p_context, const uint8_t cs_trace_id);
+
+/*!
+ * As ocsd_dt_remove_mem_acc(), for the trace ID supplied.
+ *
+ * @param cs_trace_id : Trace ID the accessor was added for - 0 for all IDs.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_remove_mem_acc_for_id(const dcd_tree_handle_t handle, const ocsd_vaddr_t st_address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id);
+
+/*!
+ * Load a pre-decoded code map sidecar file, and attach to the memory accessor holding the mapped image.
+ * Decoders use the map to find waypoints rather than decoding each instruction.
+ *
+ * Map is rejected with OCSD_ERR_MEM_ACC_CODE_MAP if the accessor memory does not match the image
+ * the map was created from.
+ *
+ * @param handle : Handle to decode tree.
+ * @param *map_path : Path to code map file.
+ * @param mem_space : Memory space of the accessor holding the image.
+ * @param cs_trace_id : Trace ID the accessor was added for - 0 for all IDs.
+ *
+ * @return OCSD_C_API ocsd_err_t  : Library error code -  OCSD_OK if successful.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_add_code_map_file(const dcd_tree_handle_t handle, const char *map_path, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id);
+
 /*
  *  Print the mapped memory accessor ranges to the configured logger.
  *
@@ -361,6 +511,20 @@ OCSD_C_API void ocsd_tl_log_mapped_mem_ranges(const dcd_tree_handle_t handle);
  */
 OCSD_C_API ocsd_err_t ocsd_dt_set_mem_acc_cacheing(const dcd_tree_handle_t handle, const int enable, const uint16_t page_size, const int nr_pages);
 
+/*
+ * Set read-ahead for callback memory accessors - reduce the number of callbacks to the client.
+ *
+ * Reads smaller than max_block are extended to a read-ahead block, starting at min_block and
+ * doubling up to max_block while reads are sequential. System defaults to no read-ahead.
+ *
+ * @param handle    : Handle to decode tree.
+ * @param min_block : Minimum read-ahead block size in bytes (16 or more).
+ * @param max_block : Maximum read-ahead block size in bytes (64k or less), 0 to disable read-ahead.
+ *
+ * @return ocsd_err_t  : Library error code -  OCSD_OK if successful.
+ */
+OCSD_C_API ocsd_err_t ocsd_dt_set_mem_acc_cb_read_ahead(const dcd_tree_handle_t handle, const uint32_t min_block, const uint32_t max_block);
+
 /** @}*/  
 
 /** @name Library Default Error Log Object API
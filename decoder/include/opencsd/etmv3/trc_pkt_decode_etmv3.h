@@ -238,6 +238,7 @@ private:
     void setNeedAddr(bool bNeedAddr);
     void pendExceptionReturn();
     bool preISyncValid(ocsd_etmv3_pkt_type pkt_type);
+    void updateMemContext();
 //** intra packet state;
 
     OcsdCodeFollower m_code_follower;   //!< code follower for instruction trace
@@ -248,6 +249,7 @@ private:
     bool m_bWaitISync;              //!< true if waiting for first ISync packet
 
     OcsdPeContext m_PeContext;      //!< save context data before sending in output packet
+    uint64_t m_mem_ctxt_tag;        //!< memory context (VMID / context ID) in use for memory access.
 
     OcsdGenElemList m_outputElemList;   //!< list of output elements
 
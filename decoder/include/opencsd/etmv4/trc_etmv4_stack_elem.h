@@ -36,7 +36,7 @@
 #include "opencsd/etmv4/trc_pkt_types_etmv4.h"
 #include "opencsd/trc_gen_elem_types.h"
 
-#include <deque>
+#include <new>
 #include <vector>
 
 /* ETMv4 I trace stack elements  
@@ -362,13 +362,82 @@ inline TrcStackElemITE::TrcStackElemITE(const ocsd_etmv4_i_pkt_type root_pkt, co
 {
 }
 
+/************************************************************/
+/* Element storage pool.
+   Fixed size slots, large enough for any element type, allocated in blocks
+   and recycled through a free list. Once the pool has grown to the working
+   depth of the stack, creating and deleting elements does no heap operations.
+*/
+#define P0_ELEM_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define P0_ELEM_SLOT_SIZE \
+    P0_ELEM_MAX(P0_ELEM_MAX(P0_ELEM_MAX(sizeof(TrcStackElemAddr), sizeof(TrcStackQElem)), \
+                            P0_ELEM_MAX(sizeof(TrcStackElemCtxt), sizeof(TrcStackElemExcept))), \
+                P0_ELEM_MAX(P0_ELEM_MAX(sizeof(TrcStackElemAtom), sizeof(TrcStackElemParam)), \
+                            P0_ELEM_MAX(sizeof(TrcStackElemMarker), sizeof(TrcStackElemITE))))
+#define P0_ELEM_POOL_BLOCK 64   // slots allocated each time the pool grows
+
+class EtmV4P0ElemPool
+{
+public:
+    EtmV4P0ElemPool() : m_free_list(0) {};
+    ~EtmV4P0ElemPool();
+
+    void *alloc();                      // get a slot to construct an element in - 0 if out of memory
+    void release(TrcStackElem *pElem);  // destroy an element and return the slot to the pool
+
+private:
+    union elem_slot_t {
+        elem_slot_t *next;              // link when on the free list
+        uint64_t align;
+        uint8_t data[P0_ELEM_SLOT_SIZE];
+    };
+
+    elem_slot_t *m_free_list;
+    std::vector<elem_slot_t *> m_blocks;    //!< allocated slot blocks
+};
+
+inline EtmV4P0ElemPool::~EtmV4P0ElemPool()
+{
+    for (size_t i = 0; i < m_blocks.size(); i++)
+        delete [] m_blocks[i];
+}
+
+inline void *EtmV4P0ElemPool::alloc()
+{
+    if (!m_free_list)
+    {
+        elem_slot_t *pBlock = new (std::nothrow) elem_slot_t[P0_ELEM_POOL_BLOCK];
+        if (!pBlock)
+            return 0;
+        m_blocks.push_back(pBlock);
+        for (int i = 0; i < P0_ELEM_POOL_BLOCK; i++)
+        {
+            pBlock[i].next = m_free_list;
+            m_free_list = &pBlock[i];
+        }
+    }
+    elem_slot_t *pSlot = m_free_list;
+    m_free_list = pSlot->next;
+    return pSlot;
+}
+
+inline void EtmV4P0ElemPool::release(TrcStackElem *pElem)
+{
+    pElem->~TrcStackElem();
+    elem_slot_t *pSlot = reinterpret_cast<elem_slot_t *>(pElem);
+    pSlot->next = m_free_list;
+    m_free_list = pSlot;
+}
+
 /************************************************************/
 /* P0 element stack that allows push of elements, and deletion of elements when done.
+   Elements are held in a ring buffer that grows as required, and are created in
+   slots from the element pool.
 */
 class EtmV4P0Stack
 {
 public:
-    EtmV4P0Stack() {};
+    EtmV4P0Stack() : m_front(0), m_count(0), m_iter(0) {};
     ~EtmV4P0Stack();
 
     void push_front(TrcStackElem *pElem);
@@ -382,15 +451,15 @@ public:
     // iterate through stack from front
     void from_front_init();
     TrcStackElem *from_front_next();
-    void erase_curr_from_front();  // erase the element last returned 
-    
+    void erase_curr_from_front();  // erase the element last returned
+
     void delete_all();
     void delete_back();
     void delete_front();
     void delete_popped();
 
     // creation functions - create and push if successful.
-    TrcStackElemParam *createParamElem(const p0_elem_t p0_type, const bool isP0, const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const std::vector<uint32_t> &params);
+    TrcStackElemParam *createParamElem(const p0_elem_t p0_type, const bool isP0, const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const uint32_t *params, const int num_params);
     TrcStackElem *createParamElemNoParam(const p0_elem_t p0_type, const bool isP0, const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, bool back = false);
     TrcStackElemAtom *createAtomElem (const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const ocsd_pkt_atom &atom);
     TrcStackElemExcept *createExceptElem(const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const bool bSame, const uint16_t excepNum);
@@ -405,9 +474,15 @@ public:
     int createUnseenUncommitedP0Elem(const int n_unseen, const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index);
 
 private:
-    std::deque<TrcStackElem *> m_P0_stack;  //!< P0 decode element stack
+    TrcStackElem *&at(const size_t idx);    // element at position idx from the front
+    void grow();
+
+    std::vector<TrcStackElem *> m_P0_stack;  //!< P0 decode element stack - ring buffer, size power of 2
+    size_t m_front;                         //!< ring position of front element
+    size_t m_count;                         //!< number of elements on the stack
     std::vector<TrcStackElem *> m_popped_elem;  //!< save list of popped but not deleted elements.
-    std::deque<TrcStackElem *>::iterator m_iter;    //!< iterate across the list w/o removing stuff
+    size_t m_iter;                          //!< iterate across the list w/o removing stuff
+    EtmV4P0ElemPool m_pool;                 //!< storage for the elements
 };
 
 inline EtmV4P0Stack::~EtmV4P0Stack()
@@ -416,91 +491,98 @@ inline EtmV4P0Stack::~EtmV4P0Stack()
     delete_popped();
 }
 
+inline TrcStackElem *&EtmV4P0Stack::at(const size_t idx)
+{
+    return m_P0_stack[(m_front + idx) & (m_P0_stack.size() - 1)];
+}
+
 // put an element on the front of the stack
 inline void EtmV4P0Stack::push_front(TrcStackElem *pElem)
 {
-    m_P0_stack.push_front(pElem);
+    if (m_count == m_P0_stack.size())
+        grow();
+    m_front = (m_front - 1) & (m_P0_stack.size() - 1);
+    m_P0_stack[m_front] = pElem;
+    m_count++;
 }
 
 // put an element on the back of the stack
 inline void EtmV4P0Stack::push_back(TrcStackElem *pElem)
 {
-    m_P0_stack.push_back(pElem);
+    if (m_count == m_P0_stack.size())
+        grow();
+    at(m_count) = pElem;
+    m_count++;
 }
 
 // pop last element pointer off the stack and stash it for later deletion
 inline void EtmV4P0Stack::pop_back(bool pend_delete /* = true */)
 {
     if (pend_delete)
-        m_popped_elem.push_back(m_P0_stack.back());
-    m_P0_stack.pop_back();
+        m_popped_elem.push_back(back());
+    m_count--;
 }
 
 inline void EtmV4P0Stack::pop_front(bool pend_delete /* = true */)
 {
     if (pend_delete)
-        m_popped_elem.push_back(m_P0_stack.front());
-    m_P0_stack.pop_front();
+        m_popped_elem.push_back(front());
+    m_front = (m_front + 1) & (m_P0_stack.size() - 1);
+    m_count--;
 }
 
 // pop last element pointer off the stack and delete immediately
 inline void EtmV4P0Stack::delete_back()
 {
-    if (m_P0_stack.size() > 0)
+    if (m_count > 0)
     {
-        TrcStackElem* pElem = m_P0_stack.back();
-        delete pElem;
-        m_P0_stack.pop_back();
+        m_pool.release(back());
+        m_count--;
     }
 }
 
 // pop first element pointer off the stack and delete immediately
 inline void EtmV4P0Stack::delete_front()
 {
-    if (m_P0_stack.size() > 0)
+    if (m_count > 0)
     {
-        TrcStackElem* pElem = m_P0_stack.front();
-        delete pElem;
-        m_P0_stack.pop_front();
+        m_pool.release(front());
+        m_front = (m_front + 1) & (m_P0_stack.size() - 1);
+        m_count--;
     }
 }
 
-
-
 // get a pointer to the last element on the stack
 inline TrcStackElem *EtmV4P0Stack::back()
 {
-    return m_P0_stack.back();
+    return at(m_count - 1);
 }
 
 inline TrcStackElem *EtmV4P0Stack::front()
 {
-    return m_P0_stack.front();
+    return m_P0_stack[m_front];
 }
 
 // remove and delete all the elements left on the stack
 inline void EtmV4P0Stack::delete_all()
 {
-    while (m_P0_stack.size() > 0)
+    while (m_count > 0)
         delete_back();
-    m_P0_stack.clear();
+    m_front = 0;
 }
 
 // delete list of popped elements.
 inline void EtmV4P0Stack::delete_popped()
 {
-    while (m_popped_elem.size() > 0)
-    {
-        delete m_popped_elem.back();
-        m_popped_elem.pop_back();
-    }
+    for (size_t i = 0; i < m_popped_elem.size(); i++)
+        m_pool.release(m_popped_elem[i]);
     m_popped_elem.clear();
 }
 
 // get current number of elements on the stack
 inline size_t EtmV4P0Stack::size()
 {
-    return m_P0_stack.size();
+    return m_count;
 }
 
 #endif // ARM_TRC_ETMV4_STACK_ELEM_H_INCLUDED
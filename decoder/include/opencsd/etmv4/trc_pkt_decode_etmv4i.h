@@ -40,6 +40,7 @@
 #include "opencsd/etmv4/trc_cmp_cfg_etmv4.h"
 #include "common/trc_gen_elem.h"
 #include "common/trc_ret_stack.h"
+#include "common/trc_instr_blk_cache.h"
 #include "common/ocsd_gen_elem_stack.h"
 #include "opencsd/etmv4/trc_etmv4_stack_elem.h"
 
@@ -141,6 +142,8 @@ private:
      */
     int m_num_instr_range_limit;
 
+    TrcInstrBlockCache m_blk_cache;     //!< cached results of walks to a waypoint.
+
     typedef struct {
         ocsd_vaddr_t st_addr;
         ocsd_vaddr_t en_addr;
@@ -156,6 +159,7 @@ private:
     ocsd_err_t returnStackPop();  // pop return stack and update instruction address.
 
     void setElemTraceRange(OcsdTraceElement &elemIn, const instr_range_t &addr_range, const bool executed, ocsd_trc_index_t index);
+    void extendElemTraceRange(OcsdTraceElement &elemIn, const instr_range_t &addr_range, const bool executed);
     void setElemTraceRangeInstr(OcsdTraceElement &elemIn, const instr_range_t &addr_range, 
                                 const bool executed, ocsd_trc_index_t index, ocsd_instr_info &instr);
 
@@ -283,6 +287,16 @@ private:
         return false;
     }
 
+    // merged range mode - can the current output range be extended by the next atom range?
+    // current range must be from this commit pass, end on an N atom and be followed on in the same ISA.
+    bool isAtomRangeMergeable() {
+        if (!m_merge_atom_ranges || !m_out_elem.numElemToSend())
+            return false;
+        const OcsdTraceElement &elem = outElem();
+        return (elem.getType() == OCSD_GEN_TRC_ELEM_INSTR_RANGE) && !elem.last_instr_exec &&
+               (elem.en_addr == m_instr_info.instr_addr) && (elem.isa == m_instr_info.isa);
+    }
+
     // clear thumb IT block conditions - faster just to do it irrespective of if we are in Thumb mode.
     void clearThumbITBlockConditions() {
         m_instr_info.thumb_it_conditions = 0;
@@ -294,6 +308,8 @@ private:
     bool m_range_cont_chk;
     bool m_br_check_no_thumb;
 
+    bool m_merge_atom_ranges;   // merge atom ranges joined by N atoms into single output ranges
+
 //** output element handling
     OcsdGenElemStack m_out_elem;  //!< output element stack.
     OcsdTraceElement &outElem() { return m_out_elem.getCurrElem(); };   //!< current  out element
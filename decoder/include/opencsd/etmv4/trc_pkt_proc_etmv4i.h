@@ -89,7 +89,7 @@ protected:
 
     /** packet data **/
     TraceRawBuffer m_trcIn;    // trace data in buffer
-    std::vector<uint8_t> m_currPacketData;  // raw data packet
+    TraceRawPacket m_currPacketData;  // raw data packet
     int m_currPktIdx;   // index into raw packet when expanding
     EtmV4ITrcPacket m_curr_packet;  // expanded packet
     ocsd_trc_index_t m_packet_index;   // index of the start of the current packet
@@ -182,23 +182,37 @@ private:
     void iPktInvalidCfg(const uint8_t lastByte);  // packet invalid in current config.
     void iPktITE(const uint8_t lastByte);
 
-    unsigned extractContField(const std::vector<uint8_t> &buffer, const unsigned st_idx, uint32_t &value, const unsigned byte_limit = 5);
-    unsigned extractTSField64(const std::vector<uint8_t> &buffer, const unsigned st_idx, uint64_t &value);
-    unsigned extractCondResult(const std::vector<uint8_t> &buffer, const unsigned st_idx, uint32_t& key, uint8_t &result);
-    void extractAndSetContextInfo(const std::vector<uint8_t> &buffer, const int st_idx);
-    int extract64BitLongAddr(const std::vector<uint8_t> &buffer, const int st_idx, const uint8_t IS, uint64_t &value);
-    int extract32BitLongAddr(const std::vector<uint8_t> &buffer, const int st_idx, const uint8_t IS, uint32_t &value);
-    int extractShortAddr(const std::vector<uint8_t> &buffer, const int st_idx, const uint8_t IS, uint32_t &value, int &bits);
+    unsigned extractContField(const TraceRawPacket &buffer, const unsigned st_idx, uint32_t &value, const unsigned byte_limit = 5);
+    unsigned extractTSField64(const TraceRawPacket &buffer, const unsigned st_idx, uint64_t &value);
+    unsigned extractCondResult(const TraceRawPacket &buffer, const unsigned st_idx, uint32_t& key, uint8_t &result);
+    void extractAndSetContextInfo(const TraceRawPacket &buffer, const int st_idx);
+    int extract64BitLongAddr(const TraceRawPacket &buffer, const int st_idx, const uint8_t IS, uint64_t &value);
+    int extract32BitLongAddr(const TraceRawPacket &buffer, const int st_idx, const uint8_t IS, uint32_t &value);
+    int extractShortAddr(const TraceRawPacket &buffer, const int st_idx, const uint8_t IS, uint32_t &value, int &bits);
 
     // packet processing is table driven.    
     typedef void (TrcPktProcEtmV4I::*PPKTFN)(uint8_t);
     PPKTFN m_pIPktFn;
 
+    // span parsers - parse a complete packet directly from the input block.
+    // Return packet size, or 0 if packet incomplete in the block - use byte handler.
+    typedef uint32_t (TrcPktProcEtmV4I::*PPKTSPANFN)(const uint8_t *pData, const uint32_t avail);
+
     struct _pkt_i_table_t {
         ocsd_etmv4_i_pkt_type pkt_type;
         PPKTFN pptkFn;
+        PPKTSPANFN pptkSpanFn;  // 0 if no span parser for this header.
+        uint32_t atom_En_bits;  // atom headers - decoded pattern
+        uint8_t atom_num;       // atom headers - number of atoms, 0 if not a valid atom header.
     } m_i_table[256];
 
+    ocsd_datapath_resp_t processSpanPackets();  // fast path for synced data.
+    ocsd_datapath_resp_t skipUnsyncedData();    // step over data while waiting for sync.
+
+    uint32_t sPktNoPayload(const uint8_t *pData, const uint32_t avail);
+    uint32_t sPktShortAddr(const uint8_t *pData, const uint32_t avail);
+    uint32_t sPktLongAddr(const uint8_t *pData, const uint32_t avail);
+
     void BuildIPacketTable();
 
     void throwBadSequenceError(const char *pszExtMsg);
@@ -210,6 +224,18 @@ inline const bool TrcPktProcEtmV4I::isBadPacket() const
     return m_curr_packet.isBadPacket();
 }
 
+inline ocsd_datapath_resp_t TrcPktProcEtmV4I::outputPacket()
+{
+    return outputOnAllInterfaces(m_packet_index, &m_curr_packet, &m_curr_packet.type, m_currPacketData.data(), m_currPacketData.size());
+}
+
+inline void TrcPktProcEtmV4I::InitPacketState()
+{
+    m_currPacketData.clear();
+    m_curr_packet.initNextPacket(); // clear for next packet.
+    m_update_on_unsync_packet_index = 0;
+}
+
 /** @}*/
 
 #endif // ARM_TRC_PKT_PROC_ETMV4I_IMPL_H_INCLUDED
@@ -396,8 +396,10 @@ typedef struct _ocsd_etmv4_cfg
 
 #define ETE_OPFLG_PKTDEC_SRCADDR_N_ATOMS    0x00010000 /**< Split source address output ranges for N-atoms */
 #define ETM4_OPFLG_PKTDEC_AA64_OPCODE_CHK   0x00020000 /**< check for invalid AA64 opcodes. (MSW == 0x0000) */
+#define ETM4_OPFLG_PKTDEC_MERGE_ATOM_RANGES 0x00040000 /**< Merge consecutive atom ranges joined by N atoms into a single range */
 
-#define ETE_ETM4_OPFLG_MASK (ETE_OPFLG_PKTDEC_SRCADDR_N_ATOMS | ETM4_OPFLG_PKTDEC_AA64_OPCODE_CHK)
+#define ETE_ETM4_OPFLG_MASK (ETE_OPFLG_PKTDEC_SRCADDR_N_ATOMS | ETM4_OPFLG_PKTDEC_AA64_OPCODE_CHK | \
+                             ETM4_OPFLG_PKTDEC_MERGE_ATOM_RANGES)
 
 /** @}*/
 /** @}*/
@@ -136,6 +136,7 @@ typedef enum _ocsd_err_t {
     OCSD_ERR_INVALID_OPCODE,            /**< 44 Opcode found while decoding program memory is illegal */
     OCSD_ERR_I_RANGE_LIMIT_OVERRUN,     /**< 45 An optional limit on consecutive instructions in range during decode has been exceeded. */
     OCSD_ERR_BAD_DECODE_IMAGE,          /**< 46 Inconsistencies detected between trace and decode image (e.g. not taken unconditional instructions) */
+    OCSD_ERR_MEM_ACC_CODE_MAP,          /**< 47 Code map file invalid or does not match the memory image */
     /* end marker*/
     OCSD_ERR_LAST
 } ocsd_err_t;
@@ -236,6 +237,13 @@ typedef enum _ocsd_dcd_tree_src_t {
     OCSD_TRC_SRC_SINGLE,           /**< input source is from a single protocol generator. */
 } ocsd_dcd_tree_src_t;
 
+/** Generic element output mode for a decode tree running per trace ID decode on worker threads.
+*/
+typedef enum _ocsd_dcd_thread_out_t {
+    OCSD_DCD_THREAD_OUT_SERIAL,     /**< calls to the output interface are serialised - one ID at a time. */
+    OCSD_DCD_THREAD_OUT_CONCURRENT, /**< output interface called concurrently by the worker threads - must be thread safe. */
+} ocsd_dcd_thread_out_t;
+
 #define OCSD_DFRMTR_HAS_FSYNCS         0x01 /**< Deformatter Config : formatted data has fsyncs - input data 4 byte aligned */
 #define OCSD_DFRMTR_HAS_HSYNCS         0x02 /**< Deformatter Config : formatted data has hsyncs - input data 2 byte aligned */
 #define OCSD_DFRMTR_FRAME_MEM_ALIGN    0x04 /**< Deformatter Config : formatted frames are memory aligned, no syncs. Input data 16 byte frame aligned. */
@@ -498,6 +506,10 @@ typedef struct _ocsd_file_mem_region {
     size_t                  region_size;    /**< size in bytes of memory region */
 } ocsd_file_mem_region_t;
 
+/** Binary file memory accessor options - used when adding binary file accessors */
+#define OCSD_FILE_MEM_ACC_OPT_NONE  0x00    /**< Default - read data from the file as required */
+#define OCSD_FILE_MEM_ACC_OPT_MMAP  0x01    /**< Map the file read-only into memory, read data directly from the mapping */
+
 /** @}*/
 
 /** @name Packet Processor Operation Control Flags
@@ -535,6 +547,7 @@ typedef struct _ocsd_file_mem_region {
 #define OCSD_OPFLG_STRICT_N_UNCOND_BR_CHK   0x00000800  /**< Throw error on all N atom unconditional branches */
 #define OCSD_OPFLG_CHK_RANGE_CONTINUE       0x00001000  /**< Check consecutive range consistency - detect possible bad program image inputs from client */
 #define OCSD_OPFLG_N_UNCOND_CHK_NO_THUMB    0x00002000  /**< Skip N atom cond check thumb - exception ret to IT blocks can fail */
+#define OCSD_OPFLG_PKTDEC_NO_BLK_CACHE      0x00004000  /**< Do not cache decoded instruction blocks - walk program image for every waypoint */
 
 /** mask to combine all common packet processor operational control flags */
 #define OCSD_OPFLG_PKTDEC_COMMON (OCSD_OPFLG_PKTDEC_ERROR_BAD_PKTS | \
@@ -542,7 +555,8 @@ typedef struct _ocsd_file_mem_region {
                                  OCSD_OPFLG_N_UNCOND_DIR_BR_CHK    | \
                                  OCSD_OPFLG_STRICT_N_UNCOND_BR_CHK | \
                                  OCSD_OPFLG_CHK_RANGE_CONTINUE     | \
-                                 OCSD_OPFLG_N_UNCOND_CHK_NO_THUMB)
+                                 OCSD_OPFLG_N_UNCOND_CHK_NO_THUMB  | \
+                                 OCSD_OPFLG_PKTDEC_NO_BLK_CACHE)
 
 /** @}*/
 
@@ -699,6 +713,54 @@ typedef struct _ocsd_decode_stats {
 
 /** @}*/
 
+/** @name Memory access statistics
+
+    Counts for the memory accessor cache in the decode tree memory mapper. These are totals for
+    all caches in the mapper - there is a cache per trace ID for mappers with per trace ID accessors.
+
+    Hit run lengths are the number of consecutive hits on a single cache page. The average run 
+    length is cache_hits / hit_runs.
+
+    Accessor reads count all reads of data from memory accessors, both for cache page loads and
+    direct reads when caching is disabled or the request is larger than a cache page. Callback 
+    accessors with read-ahead enabled may satisfy reads without calling the client, so the 
+    number of client callbacks is counted separately.
+
+    Reads of addresses with no memory accessor are counted as unmapped. Recently missed ranges 
+    are held in a small negative lookup cache, so repeated reads in the same gap avoid a search
+    of the accessors.
+
+@{*/
+
+typedef struct _ocsd_mem_acc_stats {
+    uint32_t version;           /**< library version number */
+    uint16_t revision;          /**< revision number - defines the structure version for the stats. */
+    /* cache counts */
+    uint64_t cache_hits;        /**< reads satisfied from a cache page */
+    uint64_t cache_misses;      /**< reads not found in the cache - page load required */
+    uint64_t page_loads;        /**< cache pages loaded with data from an accessor */
+    uint64_t page_evictions;    /**< in use pages discarded to load a new page */
+    uint64_t hit_runs;          /**< number of runs of hits on a single page */
+    uint64_t hit_run_max;       /**< longest run of hits on a single page */
+    /* invalidation counts by reason */
+    uint64_t inval_trace_id;    /**< invalidate requests for a trace ID - e.g. context change without context tags */
+    uint64_t inval_all;         /**< invalidate all - memory accessors added or removed */
+    uint64_t inval_pages;       /**< total in use pages discarded by invalidation */
+    /* accessor reads */
+    uint64_t acc_reads;         /**< number of reads from memory accessors */
+    uint64_t acc_bytes_file;    /**< bytes read from file accessors */
+    uint64_t acc_bytes_buffer;  /**< bytes read from buffer accessors */
+    uint64_t acc_bytes_cb;      /**< bytes read from callback accessors */
+    uint64_t acc_callbacks;     /**< calls made to client callbacks by callback accessors */
+    /* unmapped addresses */
+    uint64_t unmapped_reads;    /**< reads of addresses with no memory accessor */
+    uint64_t unmapped_hits;     /**< unmapped reads found in the negative lookup cache */
+} ocsd_mem_acc_stats_t;
+
+#define OCSD_MEM_ACC_STATS_REVISION 0x1
+
+/** @}*/
+
 
 /** @}*/
 #endif // ARM_OCSD_IF_TYPES_H_INCLUDED
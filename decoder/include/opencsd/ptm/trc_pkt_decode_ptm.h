@@ -39,6 +39,7 @@
 #include "opencsd/ptm/trc_cmp_cfg_ptm.h"
 #include "common/trc_gen_elem.h"
 #include "common/trc_ret_stack.h"
+#include "common/trc_instr_blk_cache.h"
 
 /**************** Atom handling class **************************************/
 class PtmAtoms
@@ -136,6 +137,7 @@ private:
     ocsd_err_t traceInstrToWP(bool &bWPFound, const waypoint_trace_t traceWPOp = TRACE_WAYPOINT, const ocsd_vaddr_t nextAddrMatch = 0);      //!< follow instructions from the current address to a WP. true if good, false if memory cannot be accessed.
     ocsd_datapath_resp_t processAtomRange(const ocsd_atm_val A, const char *pkt_msg, const waypoint_trace_t traceWPOp = TRACE_WAYPOINT, const ocsd_vaddr_t nextAddrMatch = 0);
     void checkPendingNacc(ocsd_datapath_resp_t &resp);
+    void updateMemContext();
 
     uint8_t m_CSID; //!< Coresight trace ID for this decoder.
 
@@ -169,11 +171,13 @@ private:
 
     ptm_pe_addr_state m_curr_pe_state;  //!< current instruction state for PTM decode.
     ocsd_pe_context m_pe_context;      //!< current context information
+    uint64_t m_mem_ctxt_tag;           //!< memory context (VMID / context ID) in use for memory access.
 
     // packet decode state
     bool m_need_isync;   //!< need context to continue
     
     ocsd_instr_info m_instr_info;  //!< instruction info for code follower - in address is the next to be decoded.
+    TrcInstrBlockCache m_blk_cache; //!< cached results of walks to a waypoint.
 
     bool m_mem_nacc_pending;    //!< need to output a memory access failure packet
     ocsd_vaddr_t m_nacc_addr;  //!< address of memory access failure
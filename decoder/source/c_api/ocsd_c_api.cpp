@@ -34,6 +34,7 @@
 
 #include <cstring>
 #include <new>
+#include <mutex>
 
 /* pull in the C++ decode library */
 #include "opencsd.h"
@@ -69,6 +70,7 @@ typedef struct _lib_dt_data_list {
 
 /* map lists to handles */
 static std::map<dcd_tree_handle_t, lib_dt_data_list *> s_data_map;
+static std::mutex s_data_map_lock;  /* trees may be created and destroyed on different threads */
 
 /*******************************************************************************/
 /* C API functions                                                             */
@@ -98,6 +100,7 @@ OCSD_C_API dcd_tree_handle_t ocsd_create_dcd_tree(const ocsd_dcd_tree_src_t src_
         lib_dt_data_list *pList = new (std::nothrow) lib_dt_data_list;
         if(pList != 0)
         {
+            std::lock_guard<std::mutex> lock(s_data_map_lock);
             s_data_map.insert(std::pair<dcd_tree_handle_t, lib_dt_data_list *>(handle,pList));
         }
         else
@@ -118,6 +121,7 @@ OCSD_C_API void ocsd_destroy_dcd_tree(const dcd_tree_handle_t handle)
             delete pIf;
 
         /* need to clear any associated callback data. */
+        std::lock_guard<std::mutex> lock(s_data_map_lock);
         std::map<dcd_tree_handle_t, lib_dt_data_list *>::iterator it;
         it = s_data_map.find(handle);
         if(it != s_data_map.end())
@@ -223,6 +227,7 @@ OCSD_C_API ocsd_err_t ocsd_dt_attach_packet_callback(  const dcd_tree_handle_t h
         if (err == OCSD_OK)
         {
             // save object pointer for destruction later.
+            std::lock_guard<std::mutex> lock(s_data_map_lock);
             std::map<dcd_tree_handle_t, lib_dt_data_list *>::iterator it;
             it = s_data_map.find(handle);
             if (it != s_data_map.end())
@@ -251,6 +256,39 @@ OCSD_C_API ocsd_err_t ocsd_dt_reset_decode_stats(const dcd_tree_handle_t handle,
     return pDT->resetDecoderStats(CSID);
 }
 
+OCSD_C_API ocsd_err_t ocsd_dt_get_mem_acc_stats(const dcd_tree_handle_t handle,
+                                                ocsd_mem_acc_stats_t *p_stats)
+{
+    DecodeTree *pDT = static_cast<DecodeTree *>(handle);
+
+    return pDT->getMemAccStats(p_stats);
+}
+
+OCSD_C_API ocsd_err_t ocsd_dt_reset_mem_acc_stats(const dcd_tree_handle_t handle)
+{
+    DecodeTree *pDT = static_cast<DecodeTree *>(handle);
+
+    return pDT->resetMemAccStats();
+}
+
+OCSD_C_API ocsd_err_t ocsd_dt_set_decode_threads(const dcd_tree_handle_t handle, const int num_threads, const ocsd_dcd_thread_out_t out_mode)
+{
+    if (handle == C_API_INVALID_TREE_HANDLE)
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    DecodeTree *pDT = static_cast<DecodeTree *>(handle);
+    return pDT->setDecodeThreads(num_threads, out_mode);
+}
+
+OCSD_C_API ocsd_err_t ocsd_dt_set_decode_pipeline(const dcd_tree_handle_t handle, const int num_threads, const ocsd_dcd_thread_out_t out_mode)
+{
+    if (handle == C_API_INVALID_TREE_HANDLE)
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    DecodeTree *pDT = static_cast<DecodeTree *>(handle);
+    return pDT->setDecodePipeline(num_threads, out_mode);
+}
+
 /*** Decode tree set element output */
 OCSD_C_API ocsd_err_t ocsd_dt_set_gen_elem_outfn(const dcd_tree_handle_t handle, FnTraceElemIn pFn, const void *p_context)
 {
@@ -303,6 +341,7 @@ OCSD_C_API ocsd_err_t ocsd_def_errlog_set_strprint_cb(const dcd_tree_handle_t ha
     ocsdMsgLogger *pLogger = DecodeTree::getDefaultErrorLogger()->getOutputLogger();
     if (pLogger)
     {
+        std::lock_guard<std::mutex> lock(s_data_map_lock);
         std::map<dcd_tree_handle_t, lib_dt_data_list *>::iterator it;
         it = s_data_map.find(handle);
         if (it != s_data_map.end())
@@ -413,6 +452,26 @@ OCSD_C_API ocsd_err_t ocsd_dt_add_binfile_region_mem_acc(const dcd_tree_handle_t
     return err;
 }
 
+OCSD_C_API ocsd_err_t ocsd_dt_add_binfile_mem_acc_opts(const dcd_tree_handle_t handle, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const char *filepath, const uint32_t file_acc_opts)
+{
+    ocsd_err_t err = OCSD_OK;
+    DecodeTree *pDT;
+    err = ocsd_check_and_add_mem_acc_mapper(handle,&pDT);
+    if(err == OCSD_OK)
+        err = pDT->addBinFileMemAcc(address,mem_space,filepath,file_acc_opts);
+    return err;
+}
+
+OCSD_C_API ocsd_err_t ocsd_dt_add_binfile_region_mem_acc_opts(const dcd_tree_handle_t handle, const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const char *filepath, const uint32_t file_acc_opts)
+{
+    ocsd_err_t err = OCSD_OK;
+    DecodeTree *pDT;
+    err = ocsd_check_and_add_mem_acc_mapper(handle,&pDT);
+    if(err == OCSD_OK)
+        err = pDT->addBinFileRegionMemAcc(region_array,num_regions,mem_space,filepath,file_acc_opts);
+    return err;
+}
+
 OCSD_C_API ocsd_err_t ocsd_dt_add_buffer_mem_acc(const dcd_tree_handle_t handle, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t *p_mem_buffer, const uint32_t mem_length)
 {
     ocsd_err_t err = OCSD_OK;
@@ -458,6 +517,67 @@ OCSD_C_API ocsd_err_t ocsd_dt_remove_mem_acc(const dcd_tree_handle_t handle, con
     return err;
 }
 
+OCSD_C_API ocsd_err_t ocsd_dt_create_per_trcid_mem_acc_mapper(const dcd_tree_handle_t handle)
+{
+    if(handle == C_API_INVALID_TREE_HANDLE)
+        return OCSD_ERR_INVALID_PARAM_VAL;
+    DecodeTree *pDT = static_cast<DecodeTree *>(handle);
+    return pDT->createMemAccMapper(MEMACC_MAP_PER_TRACE_ID);
+}
+
+OCSD_C_API ocsd_err_t ocsd_dt_add_buffer_mem_acc_for_id(const dcd_tree_handle_t handle, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t *p_mem_buffer, const uint32_t mem_length, const uint8_t cs_trace_id)
+{
+    ocsd_err_t err = OCSD_OK;
+    DecodeTree *pDT;
+    err = ocsd_check_and_add_mem_acc_mapper(handle,&pDT);
+    if(err == OCSD_OK)
+        err = pDT->addBufferMemAcc(address,mem_space,p_mem_buffer,mem_length,cs_trace_id);
+    return err;
+}
+
+OCSD_C_API ocsd_err_t ocsd_dt_add_binfile_region_mem_acc_for_id(const dcd_tree_handle_t handle, const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const char *filepath, const uint32_t file_acc_opts, const uint8_t cs_trace_id)
+{
+    ocsd_err_t err = OCSD_OK;
+    DecodeTree *pDT;
+    err = ocsd_check_and_add_mem_acc_mapper(handle,&pDT);
+    if(err == OCSD_OK)
+        err = pDT->addBinFileRegionMemAcc(region_array,num_regions,mem_space,filepath,file_acc_opts,cs_trace_id);
+    return err;
+}
+
+OCSD_C_API ocsd_err_t ocsd_dt_add_callback_trcid_mem_acc_for_id(const dcd_tree_handle_t handle, const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAccID_CB p_cb_func, const void *p_context, const uint8_t cs_trace_id)
+{
+    ocsd_err_t err = OCSD_OK;
+    DecodeTree *pDT;
+    err = ocsd_check_and_add_mem_acc_mapper(handle, &pDT);
+    if (err == OCSD_OK)
+        err = pDT->addCallbackIDMemAcc(st_address, en_address, mem_space, p_cb_func, p_context, cs_trace_id);
+    return err;
+}
+
+OCSD_C_API ocsd_err_t ocsd_dt_remove_mem_acc_for_id(const dcd_tree_handle_t handle, const ocsd_vaddr_t st_address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id)
+{
+    ocsd_err_t err = OCSD_OK;
+
+    if(handle != C_API_INVALID_TREE_HANDLE)
+    {
+        DecodeTree *pDT = static_cast<DecodeTree *>(handle);
+        err = pDT->removeMemAccByAddress(st_address,mem_space,cs_trace_id);
+    }
+    else
+        err = OCSD_ERR_INVALID_PARAM_VAL;
+    return err;
+}
+
+OCSD_C_API ocsd_err_t ocsd_dt_add_code_map_file(const dcd_tree_handle_t handle, const char *map_path, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id)
+{
+    if((handle == C_API_INVALID_TREE_HANDLE) || (map_path == 0))
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    DecodeTree *pDT = static_cast<DecodeTree *>(handle);
+    return pDT->addCodeMapFile(map_path, mem_space, cs_trace_id);
+}
+
 OCSD_C_API void ocsd_tl_log_mapped_mem_ranges(const dcd_tree_handle_t handle)
 {
     if(handle != C_API_INVALID_TREE_HANDLE)
@@ -482,6 +602,21 @@ OCSD_C_API ocsd_err_t ocsd_dt_set_mem_acc_cacheing(const dcd_tree_handle_t handl
     return err;
 }
 
+OCSD_C_API ocsd_err_t ocsd_dt_set_mem_acc_cb_read_ahead(const dcd_tree_handle_t handle, const uint32_t min_block, const uint32_t max_block)
+{
+    ocsd_err_t err = OCSD_OK;
+
+    if (handle != C_API_INVALID_TREE_HANDLE)
+    {
+        DecodeTree* pDT = static_cast<DecodeTree*>(handle);
+        err = pDT->setCallbackMemAccReadAhead(min_block, max_block);
+    }
+    else
+        err = OCSD_ERR_INVALID_PARAM_VAL;
+
+    return err;
+}
+
 OCSD_C_API void ocsd_gen_elem_init(ocsd_generic_trace_elem *p_pkt, const ocsd_gen_trc_elem_t elem_type)
 {
     p_pkt->elem_type = elem_type;
@@ -36,6 +36,8 @@
 
 #define DCD_NAME "DCD_ETMV3"
 
+static const uint32_t ETMV3_SUPPORTED_DECODE_OP_FLAGS = OCSD_OPFLG_PKTDEC_NO_BLK_CACHE;
+
 TrcPktDecodeEtmV3::TrcPktDecodeEtmV3() : 
     TrcPktDecodeBase(DCD_NAME)
 {
@@ -187,6 +189,7 @@ ocsd_err_t TrcPktDecodeEtmV3::onProtocolConfig()
         arch_profile.profile = m_config->getCoreProfile();
         m_code_follower.setArchProfile(arch_profile);
         m_code_follower.setMemSpaceCSID(m_CSID);
+        m_code_follower.setBlockCacheEnable(!(getComponentOpMode() & OCSD_OPFLG_PKTDEC_NO_BLK_CACHE));
         m_outputElemList.initCSID(m_CSID);
     }
     else
@@ -199,7 +202,11 @@ ocsd_err_t TrcPktDecodeEtmV3::onProtocolConfig()
 // initialise on creation
 void TrcPktDecodeEtmV3::initDecoder()
 {
+    // set the operational modes supported.
+    m_supported_op_flags = ETMV3_SUPPORTED_DECODE_OP_FLAGS;
+
     m_CSID = 0;
+    m_mem_ctxt_tag = 0;
     resetDecoder();
     m_unsync_info = UNSYNC_INIT_DECODER;
     m_code_follower.initInterfaces(getMemoryAccessAttachPt(),getInstrDecodeAttachPt());
@@ -301,6 +308,7 @@ ocsd_datapath_resp_t TrcPktDecodeEtmV3::decodePacket(bool &pktDone)
             pElem->setType(OCSD_GEN_TRC_ELEM_PE_CONTEXT);
             m_PeContext.setCtxtID(m_curr_packet_in->getCtxtID());
             pElem->setContext(m_PeContext);
+            updateMemContext();
             break;
 
         case ETM3_PKT_VMID:
@@ -308,6 +316,7 @@ ocsd_datapath_resp_t TrcPktDecodeEtmV3::decodePacket(bool &pktDone)
             pElem->setType(OCSD_GEN_TRC_ELEM_PE_CONTEXT);
             m_PeContext.setVMID(m_curr_packet_in->getVMID());
             pElem->setContext(m_PeContext);
+            updateMemContext();
             break;
 
         case ETM3_PKT_EXCEPTION_ENTRY:
@@ -437,6 +446,8 @@ ocsd_datapath_resp_t TrcPktDecodeEtmV3::processISync(const bool withCC, const bo
                 m_PeContext.setSecLevel(m_curr_packet_in->isNS() ? ocsd_sec_nonsecure : ocsd_sec_secure);
             }
 
+            updateMemContext();
+
             // prepare the context packet
             pElem->setType(OCSD_GEN_TRC_ELEM_PE_CONTEXT);
             pElem->setContext(m_PeContext);
@@ -679,4 +690,17 @@ void TrcPktDecodeEtmV3::pendExceptionReturn()
     m_outputElemList.pendLastNElem(pendElem);
 }
 
+// switch memory accessor caching, cached instructions and the opcode fetch to the traced VMID / context ID.
+void TrcPktDecodeEtmV3::updateMemContext()
+{
+    const uint64_t ctxt_tag = ((uint64_t)m_PeContext.getVMID() << 32) | m_PeContext.getCtxtID();
+
+    if (ctxt_tag != m_mem_ctxt_tag)
+    {
+        m_mem_ctxt_tag = ctxt_tag;
+        setMemAccContext(ctxt_tag);
+        m_code_follower.setMemContext(ctxt_tag);
+    }
+}
+
 /* End of File trc_pkt_decode_etmv3.cpp */
@@ -33,6 +33,7 @@
  */ 
 
 #include "trc_pkt_proc_etmv3_impl.h"
+#include "common/trc_sync_scan.h"
 
 EtmV3PktProcImpl::EtmV3PktProcImpl() :
     m_isInit(false),
@@ -293,6 +294,14 @@ uint32_t EtmV3PktProcImpl::waitForSync(const uint32_t dataBlockSize, const uint8
                 //save a byte - not start of a-sync
                 m_currPacketData.push_back(currByte);
 
+                // save any further bytes up to a possible a-sync start, in blocks of up to 16 bytes.
+                uint32_t copy_bytes = 16 - (uint32_t)m_currPacketData.size();
+                if(copy_bytes > (dataBlockSize - bytesProcessed))
+                    copy_bytes = dataBlockSize - bytesProcessed;
+                copy_bytes = ocsd_scan_byte(pDataBlock + bytesProcessed, copy_bytes, 0x00);
+                m_currPacketData.insert(m_currPacketData.end(), pDataBlock + bytesProcessed, pDataBlock + bytesProcessed + copy_bytes);
+                bytesProcessed += copy_bytes;
+
                 // done all data in this block, or got 16 unsynced bytes
                 if((bytesProcessed == dataBlockSize) || (m_currPacketData.size() == 16))
                 {
@@ -39,9 +39,11 @@
 /* implementation of P0 element stack in ETM v4 trace*/
 TrcStackElem *EtmV4P0Stack::createParamElemNoParam(const p0_elem_t p0_type, const bool isP0, const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, bool back /*= false*/)
 {
-    TrcStackElem *pElem = new (std::nothrow) TrcStackElem(p0_type, isP0, root_pkt, root_index);
-    if (pElem)
+    TrcStackElem *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
+        pElem = new (pMem) TrcStackElem(p0_type, isP0, root_pkt, root_index);
         if (back)
             push_back(pElem);
         else
@@ -50,19 +52,15 @@ TrcStackElem *EtmV4P0Stack::createParamElemNoParam(const p0_elem_t p0_type, cons
     return pElem;
 }
 
-TrcStackElemParam *EtmV4P0Stack::createParamElem(const p0_elem_t p0_type, const bool isP0, const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const std::vector<uint32_t> &params)
+TrcStackElemParam *EtmV4P0Stack::createParamElem(const p0_elem_t p0_type, const bool isP0, const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const uint32_t *params, const int num_params)
 {
-    TrcStackElemParam *pElem = new (std::nothrow) TrcStackElemParam(p0_type, isP0, root_pkt, root_index);
-    if (pElem)
+    TrcStackElemParam *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
-        int param_idx = 0;
-        int params_to_fill = (int)params.size();
-        while ((param_idx < 4) && params_to_fill)
-        {
+        pElem = new (pMem) TrcStackElemParam(p0_type, isP0, root_pkt, root_index);
+        for (int param_idx = 0; (param_idx < 4) && (param_idx < num_params); param_idx++)
             pElem->setParam(params[param_idx], param_idx);
-            param_idx++;
-            params_to_fill--;
-        }
         push_front(pElem);
     }
     return pElem;
@@ -70,9 +68,11 @@ TrcStackElemParam *EtmV4P0Stack::createParamElem(const p0_elem_t p0_type, const
 
 TrcStackElemAtom *EtmV4P0Stack::createAtomElem(const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const ocsd_pkt_atom &atom)
 {
-    TrcStackElemAtom *pElem = new (std::nothrow) TrcStackElemAtom(root_pkt, root_index);
-    if (pElem)
+    TrcStackElemAtom *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
+        pElem = new (pMem) TrcStackElemAtom(root_pkt, root_index);
         pElem->setAtom(atom);
         push_front(pElem);
     }
@@ -81,9 +81,11 @@ TrcStackElemAtom *EtmV4P0Stack::createAtomElem(const ocsd_etmv4_i_pkt_type root_
 
 TrcStackElemExcept *EtmV4P0Stack::createExceptElem(const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const bool bSame, const uint16_t excepNum)
 {
-    TrcStackElemExcept *pElem = new (std::nothrow) TrcStackElemExcept(root_pkt, root_index);
-    if (pElem)
+    TrcStackElemExcept *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
+        pElem = new (pMem) TrcStackElemExcept(root_pkt, root_index);
         pElem->setExcepNum(excepNum);
         pElem->setPrevSame(bSame);
         push_front(pElem);
@@ -93,9 +95,11 @@ TrcStackElemExcept *EtmV4P0Stack::createExceptElem(const ocsd_etmv4_i_pkt_type r
 
 TrcStackElemCtxt *EtmV4P0Stack::createContextElem(const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const etmv4_context_t &context, const uint8_t IS, const bool back /*= false*/)
 {
-    TrcStackElemCtxt *pElem = new (std::nothrow) TrcStackElemCtxt(root_pkt, root_index);
-    if (pElem)
+    TrcStackElemCtxt *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
+        pElem = new (pMem) TrcStackElemCtxt(root_pkt, root_index);
         pElem->setContext(context);
         pElem->setIS(IS);
         if (back)
@@ -109,9 +113,11 @@ TrcStackElemCtxt *EtmV4P0Stack::createContextElem(const ocsd_etmv4_i_pkt_type ro
 
 TrcStackElemAddr *EtmV4P0Stack::createAddrElem(const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const etmv4_addr_val_t &addr_val)
 {
-    TrcStackElemAddr *pElem = new (std::nothrow) TrcStackElemAddr(root_pkt, root_index);
-    if (pElem)
+    TrcStackElemAddr *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
+        pElem = new (pMem) TrcStackElemAddr(root_pkt, root_index);
         pElem->setAddr(addr_val);
         push_front(pElem);
     }
@@ -120,9 +126,11 @@ TrcStackElemAddr *EtmV4P0Stack::createAddrElem(const ocsd_etmv4_i_pkt_type root_
 
 TrcStackQElem *EtmV4P0Stack::createQElem(const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const int count)
 {
-    TrcStackQElem *pElem = new (std::nothrow) TrcStackQElem(root_pkt, root_index);
-    if (pElem)
+    TrcStackQElem *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
+        pElem = new (pMem) TrcStackQElem(root_pkt, root_index);
         pElem->setInstrCount(count);
         push_front(pElem);
     }
@@ -131,9 +139,11 @@ TrcStackQElem *EtmV4P0Stack::createQElem(const ocsd_etmv4_i_pkt_type root_pkt, c
 
 TrcStackElemMarker *EtmV4P0Stack::createMarkerElem(const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const trace_marker_payload_t &marker)
 {
-    TrcStackElemMarker *pElem = new (std::nothrow) TrcStackElemMarker(root_pkt, root_index);
-    if (pElem)
+    TrcStackElemMarker *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
+        pElem = new (pMem) TrcStackElemMarker(root_pkt, root_index);
         pElem->setMarker(marker);
         push_front(pElem);
     }
@@ -142,9 +152,11 @@ TrcStackElemMarker *EtmV4P0Stack::createMarkerElem(const ocsd_etmv4_i_pkt_type r
 
 TrcStackElemAddr *EtmV4P0Stack::createSrcAddrElem(const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const etmv4_addr_val_t &addr_val)
 {
-    TrcStackElemAddr *pElem = new (std::nothrow) TrcStackElemAddr(root_pkt, root_index, true);
-    if (pElem)
+    TrcStackElemAddr *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
+        pElem = new (pMem) TrcStackElemAddr(root_pkt, root_index, true);
         pElem->setAddr(addr_val);
         push_front(pElem);
     }
@@ -153,9 +165,11 @@ TrcStackElemAddr *EtmV4P0Stack::createSrcAddrElem(const ocsd_etmv4_i_pkt_type ro
 
 TrcStackElemITE *EtmV4P0Stack::createITEElem(const ocsd_etmv4_i_pkt_type root_pkt, const ocsd_trc_index_t root_index, const trace_sw_ite_t &ite)
 {
-    TrcStackElemITE *pElem = new (std::nothrow) TrcStackElemITE(root_pkt, root_index);
-    if (pElem)
+    TrcStackElemITE *pElem = 0;
+    void *pMem = m_pool.alloc();
+    if (pMem)
     {
+        pElem = new (pMem) TrcStackElemITE(root_pkt, root_index);
         pElem->setITE(ite);
         push_front(pElem);
     }
@@ -182,37 +196,47 @@ int EtmV4P0Stack::createUnseenUncommitedP0Elem(const int n_unseen, const ocsd_et
     return i;
 }
 
+// double the ring buffer size, keeping the elements in order from the front.
+void EtmV4P0Stack::grow()
+{
+    std::vector<TrcStackElem *> new_stack(m_P0_stack.size() ? m_P0_stack.size() * 2 : 32);
+    for (size_t i = 0; i < m_count; i++)
+        new_stack[i] = at(i);
+    m_P0_stack.swap(new_stack);
+    m_front = 0;
+}
+
 // iteration functions
 void EtmV4P0Stack::from_front_init()
 {
-    m_iter = m_P0_stack.begin();
+    m_iter = 0;
 }
 
 TrcStackElem *EtmV4P0Stack::from_front_next()
 {
     TrcStackElem *pElem = 0;
-    if (m_iter != m_P0_stack.end())
+    if (m_iter < m_count)
     {
-        pElem = *m_iter++;
+        pElem = at(m_iter++);
     }
     return pElem;
 }
 
 void EtmV4P0Stack::erase_curr_from_front()
 {
-    std::deque<TrcStackElem *>::iterator erase_iter;
-    
-    erase_iter = m_iter;
-    erase_iter--;
-    TrcStackElem* pElem = *erase_iter;
+    size_t erase_idx = m_iter - 1;
+    TrcStackElem* pElem = at(erase_idx);
 
-    // prevent overrun if we are erasing the last element
-    // - end() returned if no elements after the erased one.
-    m_iter = m_P0_stack.erase(erase_iter);
+    // close the gap - iterator then points at the element after the erased one,
+    // or the end if no elements after the erased one.
+    for (size_t i = erase_idx; i < m_count - 1; i++)
+        at(i) = at(i + 1);
+    m_count--;
+    m_iter = erase_idx;
 
     // explicitly delete the item here as the caller can no longer reference it.
     // fixes memory leak from github issue #52
-    delete pElem;
+    m_pool.release(pElem);
 }
 
 
@@ -214,6 +214,9 @@ ocsd_err_t TrcPktDecodeEtmV4I::onProtocolConfig()
 
     m_IASize64 = (m_config->iaSizeMax() == 64);
 
+    // decode settings may have changed
+    m_blk_cache.invalidate();
+
     if (m_config->enabledRetStack())
     {
         m_return_stack.set_active(true);
@@ -247,6 +250,8 @@ ocsd_err_t TrcPktDecodeEtmV4I::onProtocolConfig()
     m_range_cont_chk = (bool)(getComponentOpMode() & OCSD_OPFLG_CHK_RANGE_CONTINUE);
     m_br_check_no_thumb = (bool)(getComponentOpMode() & OCSD_OPFLG_N_UNCOND_CHK_NO_THUMB);
 
+    m_merge_atom_ranges = (bool)(getComponentOpMode() & ETM4_OPFLG_PKTDEC_MERGE_ATOM_RANGES);
+
     return err;
 }
 
@@ -468,9 +473,9 @@ ocsd_err_t TrcPktDecodeEtmV4I::decodePacket()
     // event trace
     case ETM4_PKT_I_EVENT:
         {
-            std::vector<uint32_t> params = { 0 };
+            uint32_t params[1];
             params[0] = (uint32_t)m_curr_packet_in->event_val;
-            if (m_P0_stack.createParamElem(P0_EVENT, false, m_curr_packet_in->getType(), m_index_curr_pkt, params) == 0)
+            if (m_P0_stack.createParamElem(P0_EVENT, false, m_curr_packet_in->getType(), m_index_curr_pkt, params, 1) == 0)
                 bAllocErr = true;
 
         }
@@ -481,9 +486,9 @@ ocsd_err_t TrcPktDecodeEtmV4I::decodePacket()
     case ETM4_PKT_I_CCNT_F2:
     case ETM4_PKT_I_CCNT_F3:
         {
-            std::vector<uint32_t> params = { 0 };
+            uint32_t params[1];
             params[0] = m_curr_packet_in->getCC();
-            if (m_P0_stack.createParamElem(P0_CC, false, m_curr_packet_in->getType(), m_index_curr_pkt, params) == 0)
+            if (m_P0_stack.createParamElem(P0_CC, false, m_curr_packet_in->getType(), m_index_curr_pkt, params, 1) == 0)
                 bAllocErr = true;
             m_elem_res.P0_commit = m_curr_packet_in->getCommitElem();
 
@@ -495,12 +500,12 @@ ocsd_err_t TrcPktDecodeEtmV4I::decodePacket()
         {
             bool bTSwithCC = m_config->enabledCCI();
             uint64_t ts = m_curr_packet_in->getTS();
-            std::vector<uint32_t> params = { 0, 0, 0 };
+            uint32_t params[3] = { 0, 0, 0 };
             params[0] = (uint32_t)(ts & 0xFFFFFFFF);
             params[1] = (uint32_t)((ts >> 32) & 0xFFFFFFFF);
             if (bTSwithCC)
                 params[2] = m_curr_packet_in->getCC();
-            if (m_P0_stack.createParamElem(bTSwithCC ? P0_TS_CC : P0_TS, false, m_curr_packet_in->getType(), m_index_curr_pkt, params) == 0)
+            if (m_P0_stack.createParamElem(bTSwithCC ? P0_TS_CC : P0_TS, false, m_curr_packet_in->getType(), m_index_curr_pkt, params, 3) == 0)
                 bAllocErr = true;
 
         }
@@ -817,9 +822,13 @@ ocsd_err_t TrcPktDecodeEtmV4I::commitElements()
                             // context can be used.
                             contextFlush = true;
                             
-                            // invalidate memory accessor cacheing - force next memory access out to client to 
-                            // ensure that the correct memory context is in play when decoding subsequent atoms.
-                            invalidateMemAccCache();
+                            // switch memory accessor cacheing to the new context, or invalidate if no context ID / VMID
+                            // traced - force next memory access out to client to ensure that the correct memory 
+                            // context is in play when decoding subsequent atoms.
+                            if (m_config->enabledCID() || m_config->enabledVMID())
+                                setMemAccContext(((uint64_t)m_vmid_id << 32) | m_context_id);
+                            else
+                                invalidateMemAccCache();
                         }
                     }
                 }
@@ -1357,16 +1366,29 @@ void TrcPktDecodeEtmV4I::setElemTraceRangeInstr(OcsdTraceElement &elemIn, const
         instr.isa = instr.next_isa;
 }
 
+// extend the current range element with a range that follows on from it.
+void TrcPktDecodeEtmV4I::extendElemTraceRange(OcsdTraceElement &elemIn, const instr_range_t &addr_range,
+    const bool executed)
+{
+    elemIn.setLastInstrInfo(executed, m_instr_info.type, m_instr_info.sub_type, m_instr_info.instr_size);
+    elemIn.setLastInstrCond(m_instr_info.is_conditional);
+    elemIn.setAddrRange(elemIn.st_addr, addr_range.en_addr, elemIn.num_instr_range + addr_range.num_instr);
+    if (executed)
+        m_instr_info.isa = m_instr_info.next_isa;
+}
+
 ocsd_err_t TrcPktDecodeEtmV4I::processAtom(const ocsd_atm_val atom)
 {
-    ocsd_err_t err;
+    ocsd_err_t err = OCSD_OK;
     TrcStackElem *pElem = m_P0_stack.back();  // get the atom element
     WP_res_t WPRes;
     instr_range_t addr_range;
     bool ETE_ERET = false;
 
-    // new element for this processed atom
-    if ((err = m_out_elem.addElem(pElem->getRootIndex())) != OCSD_OK)
+    // in merged range mode, a range following on from an N atom extends the current
+    // element, otherwise new element for this processed atom
+    bool extend_range = isAtomRangeMergeable();
+    if (!extend_range && ((err = m_out_elem.addElem(pElem->getRootIndex())) != OCSD_OK))
         return err;
 
     err = traceInstrToWP(addr_range, WPRes);
@@ -1449,7 +1471,10 @@ ocsd_err_t TrcPktDecodeEtmV4I::processAtom(const ocsd_atm_val atom)
             }
             break;
         }
-        setElemTraceRange(outElem(), addr_range, (atom == ATOM_E), pElem->getRootIndex());
+        if (extend_range)
+            extendElemTraceRange(outElem(), addr_range, (atom == ATOM_E));
+        else
+            setElemTraceRange(outElem(), addr_range, (atom == ATOM_E), pElem->getRootIndex());
 
         // check for discontinuity in address ranges where incorrect memory images supplied to decoder.
         if (m_range_cont_chk)
@@ -1484,12 +1509,17 @@ ocsd_err_t TrcPktDecodeEtmV4I::processAtom(const ocsd_atm_val atom)
         if(addr_range.st_addr != addr_range.en_addr)
         {
             // some trace before we were out of memory access range
-            setElemTraceRange(outElem(), addr_range, true, pElem->getRootIndex());
+            if (extend_range)
+                extendElemTraceRange(outElem(), addr_range, true);
+            else
+                setElemTraceRange(outElem(), addr_range, true, pElem->getRootIndex());
 
             // another element for the nacc...
             if (WPNacc(WPRes))
                 err = m_out_elem.addElem(pElem->getRootIndex());
         }
+        else if (extend_range && WPNacc(WPRes))
+            err = m_out_elem.addElem(pElem->getRootIndex());    // no range to merge - element for the nacc
 
         if(WPNacc(WPRes) && !err)
         {
@@ -1739,12 +1769,13 @@ ocsd_err_t TrcPktDecodeEtmV4I::processQElement()
     addr_range.num_instr = 0;
 
     // walk iCount instructions
+    mem_acc_window_t mem_win = { 0, 0, 0 };
     for (int i = 0; i < iCount; i++)
     {
         uint32_t opcode;
         uint32_t bytesReq = 4;
 
-        err = accessMemory(m_instr_info.instr_addr, getCurrMemSpace(), &bytesReq, (uint8_t *)&opcode);
+        err = accessOpcode(mem_win, m_instr_info.instr_addr, getCurrMemSpace(), m_instr_info.isa, &bytesReq, &opcode);
         if (err != OCSD_OK) break;
 
         if (bytesReq == 4) // got data back
@@ -1875,6 +1906,7 @@ ocsd_err_t TrcPktDecodeEtmV4I::processSourceAddress()
             // need to count T32 - 2 or 4 byte instructions or we are spotting N atoms
             ocsd_instr_info instr; // going back to start of range so make a copy of info.
             bool bMemAccErr = false;
+            mem_acc_window_t mem_win = { 0, 0, 0 };
 
             instr.instr_addr = out_range.st_addr;
             instr.isa = m_instr_info.isa;
@@ -1886,7 +1918,7 @@ ocsd_err_t TrcPktDecodeEtmV4I::processSourceAddress()
             while ((instr.instr_addr < out_range.en_addr) && !bMemAccErr)
             {
                 bytesReq = 4;
-                err = accessMemory(instr.instr_addr, getCurrMemSpace(), &bytesReq, (uint8_t *)&opcode);
+                err = accessOpcode(mem_win, instr.instr_addr, getCurrMemSpace(), instr.isa, &bytesReq, &opcode);
                 if (err != OCSD_OK)
                 {
                     LogError(ocsdError(OCSD_ERR_SEV_ERROR, err, pElem->getRootIndex(), m_CSID, "Mem access error processing source address packet."));
@@ -1980,17 +2012,48 @@ ocsd_err_t TrcPktDecodeEtmV4I::traceInstrToWP(instr_range_t &range, WP_res_t &WP
     uint32_t opcode;
     uint32_t bytesReq;
     ocsd_err_t err = OCSD_OK;
+    mem_acc_window_t mem_win = { 0, 0, 0 };
+    instr_blk_key_t blk_key;
+    bool use_blk_cache = false;
 
     range.st_addr = range.en_addr = m_instr_info.instr_addr;
     range.num_instr = 0;
 
     WPRes = WP_NOT_FOUND;
 
+    // walks to a real waypoint can use a previously decoded block, or a pre-decoded code map
+    if (!traceToAddrNext && !m_num_instr_range_limit)
+    {
+        if (getMemAccGeneration(&blk_key.mem_gen))
+        {
+            blk_key.st_addr = m_instr_info.instr_addr;
+            blk_key.ctxt_tag = (m_config->enabledCID() || m_config->enabledVMID()) ? (((uint64_t)m_vmid_id << 32) | m_context_id) : 0;
+            blk_key.mem_space = getCurrMemSpace();
+            blk_key.isa = m_instr_info.isa;
+            blk_key.it_conditions = m_instr_info.thumb_it_conditions;
+            use_blk_cache = true;
+
+            if (m_blk_cache.getBlock(blk_key, m_instr_info, range.num_instr))
+            {
+                WPRes = WP_FOUND;
+                range.en_addr = m_instr_info.instr_addr;
+                return err;
+            }
+        }
+
+        if (findCodeMapWaypoint(getCurrMemSpace(), &m_instr_info, &range.num_instr))
+        {
+            WPRes = WP_FOUND;
+            range.en_addr = m_instr_info.instr_addr;
+            return err;
+        }
+    }
+
     while(WPRes == WP_NOT_FOUND)
     {
         // start off by reading next opcode;
         bytesReq = 4;
-        err = accessMemory(m_instr_info.instr_addr, getCurrMemSpace(),&bytesReq,(uint8_t *)&opcode);
+        err = accessOpcode(mem_win, m_instr_info.instr_addr, getCurrMemSpace(), m_instr_info.isa, &bytesReq, &opcode);
         if(err != OCSD_OK) break;
 
         if(bytesReq == 4) // got data back
@@ -2011,6 +2074,13 @@ ocsd_err_t TrcPktDecodeEtmV4I::traceInstrToWP(instr_range_t &range, WP_res_t &WP
             }
             else if (m_instr_info.type != OCSD_INSTR_OTHER)
                 WPRes = WP_FOUND;
+            else if (!m_num_instr_range_limit)
+            {
+                // step over straight line code to the next possible waypoint in the memory window
+                uint32_t num_skip = skipToWPCandidate(mem_win, m_instr_info.instr_addr, m_instr_info.isa);
+                m_instr_info.instr_addr += num_skip * 4;
+                range.num_instr += num_skip;
+            }
         }
         else
         {
@@ -2029,6 +2099,9 @@ ocsd_err_t TrcPktDecodeEtmV4I::traceInstrToWP(instr_range_t &range, WP_res_t &WP
     }
     // update the range decoded address in the output packet.
     range.en_addr = m_instr_info.instr_addr;
+
+    if (use_blk_cache && (err == OCSD_OK) && WPFound(WPRes))
+        m_blk_cache.addBlock(blk_key, m_instr_info, range.num_instr);
     return err;
 }
 
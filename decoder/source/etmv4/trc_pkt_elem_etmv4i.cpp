@@ -69,24 +69,6 @@ void EtmV4ITrcPacket::initStartState()
     initNextPacket();
 }
 
-void EtmV4ITrcPacket::initNextPacket()
-{
-    // clear valid bits for elements that are only valid over a single packet.
-    pkt_valid.bits.cc_valid = 0;
-    pkt_valid.bits.commit_elem_valid = 0;
-    pkt_valid.bits.cancel_elem_valid = 0;
-
-    atom.num = 0;
-    context.updated = 0;
-    context.updated_v = 0;
-    context.updated_c = 0;
-    err_type = ETM4_PKT_I_NO_ERR_TYPE;
-
-    // handling for TINFO fields
-    trace_info.bits.initial_t_info = 0;
-    trace_info.bits.spec_field_present = 0;
-}
-
 // printing
 void EtmV4ITrcPacket::toString(std::string &str) const
 {
@@ -34,6 +34,7 @@
 
 #include "opencsd/etmv4/trc_pkt_proc_etmv4.h"
 #include "common/ocsd_error.h"
+#include "common/trc_sync_scan.h"
 
 #ifdef __GNUC__
  // G++ doesn't like the ## pasting
@@ -45,6 +46,8 @@
 
 static const uint32_t ETMV4_SUPPORTED_OP_FLAGS = OCSD_OPFLG_PKTPROC_COMMON;
 
+#define ETM4_ASYNC_0_BYTES 11   // A-sync packet is 11 x 0x00 followed by 0x80
+
 // test defines - if testing with ETMv4 sources, disable error on ERET.
 // #define ETE_TRACE_ERET_AS_IGNORE
 
@@ -105,6 +108,13 @@ ocsd_datapath_resp_t TrcPktProcEtmV4I::processData(  const ocsd_trc_index_t inde
                 switch (m_process_state)
                 {
                 case PROC_HDR:
+                    if (m_is_sync)
+                    {
+                        // complete packets parsed directly from the input block
+                        resp = processSpanPackets();
+                        if (m_trcIn.empty() || !OCSD_DATA_RESP_IS_CONT(resp))
+                            break;
+                    }
                     m_packet_index = m_blockIndex + m_trcIn.processed();
                     if (m_is_sync)
                     {
@@ -120,10 +130,37 @@ ocsd_datapath_resp_t TrcPktProcEtmV4I::processData(  const ocsd_trc_index_t inde
                     }
                     m_process_state = PROC_DATA;
 
+                    if (m_is_sync)
+                    {
+                        // parse the packet in place in the input block - only copied if it runs past the end of the block.
+                        m_trcIn.startPktInPlace();
+                        while (!m_trcIn.empty() && (m_process_state == PROC_DATA))
+                        {
+                            if (m_currPacketData.full())
+                                throwBadSequenceError("Packet exceeds maximum length");
+                            nextByte = m_trcIn.peekNextByte();
+                            m_trcIn.addByteInPlace();
+                            (this->*m_pIPktFn)(nextByte);
+                        }
+                        if (m_process_state == PROC_DATA)
+                            m_currPacketData.copyToBuffer();
+                        break;
+                    }
+
                 case PROC_DATA:
+                    // waiting for sync with no raw monitor - step over data that cannot hold an A-sync.
+                    if ((m_pIPktFn == &TrcPktProcEtmV4I::iNotSync) && (m_currPacketData.size() == 0) && !hasRawMon())
+                    {
+                        resp = skipUnsyncedData();
+                        if (m_trcIn.empty() || !OCSD_DATA_RESP_IS_CONT(resp))
+                            break;
+                    }
+
                     // loop till full packet or no more data...
                     while (!m_trcIn.empty() && (m_process_state == PROC_DATA))
                     {
+                        if (m_currPacketData.full())
+                            throwBadSequenceError("Packet exceeds maximum length");
                         nextByte = m_trcIn.peekNextByte();
                         m_trcIn.copyByteToPkt();  // move next byte into the packet
                         (this->*m_pIPktFn)(nextByte);
@@ -185,6 +222,61 @@ ocsd_datapath_resp_t TrcPktProcEtmV4I::processData(  const ocsd_trc_index_t inde
     return resp;
 }
 
+ocsd_datapath_resp_t TrcPktProcEtmV4I::processSpanPackets()
+{
+    ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
+    uint32_t pktSize;
+
+    while (!m_trcIn.empty() && OCSD_DATA_RESP_IS_CONT(resp))
+    {
+        const uint8_t *pData = m_trcIn.currPtr();
+        const _pkt_i_table_t &entry = m_i_table[pData[0]];
+
+        m_curr_packet.type = entry.pkt_type;
+        if (entry.atom_num)
+        {
+            // atoms are the most common packet - pattern is in the table.
+            m_curr_packet.setAtomPacket(ATOM_PATTERN, entry.atom_En_bits, entry.atom_num);
+            m_currPacketData.setInPlace(pData, 1);
+            pktSize = 1;
+        }
+        else
+        {
+            if (!entry.pptkSpanFn)
+                break;
+            pktSize = (this->*entry.pptkSpanFn)(pData, m_trcIn.remaining());
+            if (!pktSize)
+                break;  // packet runs past the end of the block.
+        }
+
+        m_packet_index = m_blockIndex + m_trcIn.processed();
+        m_trcIn.skip(pktSize);
+        resp = outputPacket();
+        InitPacketState();
+    }
+    m_process_state = PROC_HDR;
+    return resp;
+}
+
+ocsd_datapath_resp_t TrcPktProcEtmV4I::skipUnsyncedData()
+{
+    ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
+    const uint32_t unsynced_bytes = ocsd_scan_byte_run(m_trcIn.currPtr(), m_trcIn.remaining(), 0x00, ETM4_ASYNC_0_BYTES);
+
+    if (unsynced_bytes)
+    {
+        statsAddUnsyncCount(unsynced_bytes);
+        if (!m_sent_notsync_packet)
+        {
+            resp = outputDecodedPacket(m_packet_index, &m_curr_packet);
+            m_sent_notsync_packet = true;
+        }
+        m_trcIn.skip(unsynced_bytes);
+        m_packet_index = m_blockIndex + m_trcIn.processed();
+    }
+    return resp;
+}
+
 ocsd_datapath_resp_t TrcPktProcEtmV4I::onEOT()
 {
     ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
@@ -221,13 +313,6 @@ ocsd_datapath_resp_t TrcPktProcEtmV4I::onFlush()
     return OCSD_RESP_CONT;
 }
 
-void TrcPktProcEtmV4I::InitPacketState()
-{
-    m_currPacketData.clear();
-    m_curr_packet.initNextPacket(); // clear for next packet.
-    m_update_on_unsync_packet_index = 0;
-}
-
 void TrcPktProcEtmV4I::InitProcessorState()
 {
     InitPacketState();
@@ -240,19 +325,12 @@ void TrcPktProcEtmV4I::InitProcessorState()
     m_curr_packet.initStartState();
 }
 
-ocsd_datapath_resp_t TrcPktProcEtmV4I::outputPacket()
-{
-    ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
-    resp = outputOnAllInterfaces(m_packet_index,&m_curr_packet,&m_curr_packet.type,m_currPacketData);
-    return resp;
-}
-
 ocsd_datapath_resp_t TrcPktProcEtmV4I::outputUnsyncedRawPacket()
 {
     ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
     
     statsAddUnsyncCount(m_dump_unsynced_bytes);
-    outputRawPacketToMonitor(m_packet_index,&m_curr_packet,m_dump_unsynced_bytes,&m_currPacketData[0]);
+    outputRawPacketToMonitor(m_packet_index,&m_curr_packet,m_dump_unsynced_bytes,m_currPacketData.data());
         
     if(!m_sent_notsync_packet)
     {        
@@ -260,10 +338,7 @@ ocsd_datapath_resp_t TrcPktProcEtmV4I::outputUnsyncedRawPacket()
         m_sent_notsync_packet = true;
     }
     
-    if(m_currPacketData.size() <= m_dump_unsynced_bytes)
-        m_currPacketData.clear();
-    else
-        m_currPacketData.erase(m_currPacketData.begin(),m_currPacketData.begin()+m_dump_unsynced_bytes);
+    m_currPacketData.eraseFront(m_dump_unsynced_bytes);
 
     return resp;
 }
@@ -326,6 +401,13 @@ void TrcPktProcEtmV4I::iPktNoPayload(const uint8_t lastByte)
     m_process_state = SEND_PKT; // now just send it....
 }
 
+uint32_t TrcPktProcEtmV4I::sPktNoPayload(const uint8_t *pData, const uint32_t /* avail */)
+{
+    m_currPacketData.setInPlace(pData, 1);
+    iPktNoPayload(pData[0]);
+    return 1;
+}
+
 void TrcPktProcEtmV4I::iPktReserved(const uint8_t lastByte)
 {
     m_curr_packet.updateErrType(ETM4_PKT_I_RESERVED, lastByte);   // swap type for err type
@@ -885,7 +967,7 @@ void TrcPktProcEtmV4I::iPktContext(const uint8_t lastByte)
     }
 }
 
-void TrcPktProcEtmV4I::extractAndSetContextInfo(const std::vector<uint8_t> &buffer, const int st_idx)
+void TrcPktProcEtmV4I::extractAndSetContextInfo(const TraceRawPacket &buffer, const int st_idx)
 {
     // on input, buffer index points at the info byte - always present
     uint8_t infoByte = m_currPacketData[st_idx];
@@ -1014,7 +1096,7 @@ void TrcPktProcEtmV4I::iPktShortAddr(const uint8_t lastByte)
     }
 }
 
-int TrcPktProcEtmV4I::extractShortAddr(const std::vector<uint8_t> &buffer, const int st_idx, const uint8_t IS, uint32_t &value, int &bits)
+int TrcPktProcEtmV4I::extractShortAddr(const TraceRawPacket &buffer, const int st_idx, const uint8_t IS, uint32_t &value, int &bits)
 {
     int IS_shift = (IS == 0) ? 2 : 1;
     int idx = 0;
@@ -1034,6 +1116,31 @@ int TrcPktProcEtmV4I::extractShortAddr(const std::vector<uint8_t> &buffer, const
     return idx;
 }
 
+uint32_t TrcPktProcEtmV4I::sPktShortAddr(const uint8_t *pData, const uint32_t avail)
+{
+    uint32_t addr_val = 0;
+    int bits = 0;
+    uint32_t size = 2;
+
+    if (avail < 2)
+        return 0;
+    if (pData[1] & 0x80)
+    {
+        if (avail < 3)
+            return 0;
+        size = 3;
+    }
+
+    m_addrIS = 0;
+    if ((pData[0] == ETM4_PKT_I_ADDR_S_IS1) ||
+        (pData[0] == ETE_PKT_I_SRC_ADDR_S_IS1))
+        m_addrIS = 1;
+    m_currPacketData.setInPlace(pData, size);
+    extractShortAddr(m_currPacketData, 1, m_addrIS, addr_val, bits);
+    m_curr_packet.updateShortAddress(addr_val, m_addrIS, (uint8_t)bits);
+    return size;
+}
+
 void TrcPktProcEtmV4I::iPktLongAddr(const uint8_t lastByte)
 {
     if(m_currPacketData.size() == 1)    
@@ -1082,6 +1189,50 @@ void TrcPktProcEtmV4I::iPktLongAddr(const uint8_t lastByte)
     }
 }
 
+uint32_t TrcPktProcEtmV4I::sPktLongAddr(const uint8_t *pData, const uint32_t avail)
+{
+    uint8_t IS = 0;
+    bool b64bit = false;
+
+    switch (m_curr_packet.type)
+    {
+    case ETM4_PKT_I_ADDR_L_32IS1:
+    case ETE_PKT_I_SRC_ADDR_L_32IS1:
+        IS = 1;
+        break;
+
+    case ETM4_PKT_I_ADDR_L_64IS1:
+    case ETE_PKT_I_SRC_ADDR_L_64IS1:
+        IS = 1;
+    case ETM4_PKT_I_ADDR_L_64IS0:
+    case ETE_PKT_I_SRC_ADDR_L_64IS0:
+        b64bit = true;
+        break;
+
+    default:
+        break;
+    }
+
+    const uint32_t size = b64bit ? 9 : 5;
+    if (avail < size)
+        return 0;
+
+    m_currPacketData.setInPlace(pData, size);
+    if (b64bit)
+    {
+        uint64_t val64;
+        extract64BitLongAddr(m_currPacketData, 1, IS, val64);
+        m_curr_packet.set64BitAddress(val64, IS);
+    }
+    else
+    {
+        uint32_t val32;
+        extract32BitLongAddr(m_currPacketData, 1, IS, val32);
+        m_curr_packet.set32BitAddress(val32, IS);
+    }
+    return size;
+}
+
 void TrcPktProcEtmV4I::iPktQ(const uint8_t lastByte)
 {
     if(m_currPacketData.size() == 1)
@@ -1195,6 +1346,32 @@ void TrcPktProcEtmV4I::iPktQ(const uint8_t lastByte)
 }
 
 void TrcPktProcEtmV4I::iAtom(const uint8_t lastByte)
+{
+    // atom packets are single byte, no payload - pattern decoded when the table is built.
+    if (m_i_table[lastByte].atom_num)
+        m_curr_packet.setAtomPacket(ATOM_PATTERN, m_i_table[lastByte].atom_En_bits, m_i_table[lastByte].atom_num);
+    m_process_state = SEND_PKT;
+}
+
+void TrcPktProcEtmV4I::iPktITE(const uint8_t /* lastByte */)
+{
+    uint64_t value;
+    int shift = 0;
+
+    /* packet is always 10 bytes, Header, EL info byte, 8 bytes payload */
+    if (m_currPacketData.size() == 10) {
+        value = 0;
+        for (int i = 2; i < 10; i++) {
+            value |= ((uint64_t)m_currPacketData[i]) << shift;
+            shift += 8;
+        }
+        m_curr_packet.setITE(m_currPacketData[1], value);
+        m_process_state = SEND_PKT;
+    }
+}
+
+// decode the atom pattern for an atom header byte. false if invalid pattern.
+static bool decodeAtomHdr(const ocsd_etmv4_i_pkt_type type, const uint8_t lastByte, uint32_t &En_bits, uint8_t &num)
 {
     // patterns lsbit = oldest atom, ms bit = newest.
     static const uint32_t f4_patterns[] = {
@@ -1207,23 +1384,28 @@ void TrcPktProcEtmV4I::iAtom(const uint8_t lastByte)
     uint8_t pattIdx = 0, pattCount = 0;
     uint32_t pattern;
 
-    // atom packets are single byte, no payload.
-    switch(m_curr_packet.type)
+    num = 0;
+    En_bits = 0;
+    switch(type)
     {
     case ETM4_PKT_I_ATOM_F1:
-        m_curr_packet.setAtomPacket(ATOM_PATTERN,(lastByte & 0x1), 1); // 1xE or N
+        En_bits = (lastByte & 0x1); // 1xE or N
+        num = 1;
         break;
 
     case ETM4_PKT_I_ATOM_F2:
-        m_curr_packet.setAtomPacket(ATOM_PATTERN,(lastByte & 0x3), 2); // 2x (E or N)
+        En_bits = (lastByte & 0x3); // 2x (E or N)
+        num = 2;
         break;
 
     case ETM4_PKT_I_ATOM_F3:
-        m_curr_packet.setAtomPacket(ATOM_PATTERN,(lastByte & 0x7), 3); // 3x (E or N)
+        En_bits = (lastByte & 0x7); // 3x (E or N)
+        num = 3;
         break;
 
     case ETM4_PKT_I_ATOM_F4:
-        m_curr_packet.setAtomPacket(ATOM_PATTERN,f4_patterns[(lastByte & 0x3)], 4); // 4 atom pattern
+        En_bits = f4_patterns[(lastByte & 0x3)]; // 4 atom pattern
+        num = 4;
         break; 
 
     case ETM4_PKT_I_ATOM_F5:
@@ -1231,19 +1413,23 @@ void TrcPktProcEtmV4I::iAtom(const uint8_t lastByte)
         switch(pattIdx)
         {
         case 5: // 0b101
-            m_curr_packet.setAtomPacket(ATOM_PATTERN,0x1E, 5); // 5 atom pattern EEEEN
+            En_bits = 0x1E; // 5 atom pattern EEEEN
+            num = 5;
             break;
 
         case 1: // 0b001
-            m_curr_packet.setAtomPacket(ATOM_PATTERN,0x00, 5); // 5 atom pattern NNNNN
+            En_bits = 0x00; // 5 atom pattern NNNNN
+            num = 5;
             break;
 
         case 2: //0b010
-            m_curr_packet.setAtomPacket(ATOM_PATTERN,0x0A, 5); // 5 atom pattern NENEN
+            En_bits = 0x0A; // 5 atom pattern NENEN
+            num = 5;
             break;
 
         case 3: //0b011
-            m_curr_packet.setAtomPacket(ATOM_PATTERN,0x15, 5); // 5 atom pattern ENENE
+            En_bits = 0x15; // 5 atom pattern ENENE
+            num = 5;
             break;
 
         default:
@@ -1258,28 +1444,12 @@ void TrcPktProcEtmV4I::iAtom(const uint8_t lastByte)
         pattern = ((uint32_t)0x1 << pattCount) - 1; // set pattern to string of E's
         if((lastByte & 0x20) == 0x00)   // last atom is E?
             pattern |= ((uint32_t)0x1 << pattCount); 
-        m_curr_packet.setAtomPacket(ATOM_PATTERN,pattern, pattCount+1);
+        En_bits = pattern;
+        num = pattCount+1;
         break;
     }
 
-    m_process_state = SEND_PKT;
-}
-
-void TrcPktProcEtmV4I::iPktITE(const uint8_t /* lastByte */)
-{
-    uint64_t value;
-    int shift = 0;
-
-    /* packet is always 10 bytes, Header, EL info byte, 8 bytes payload */
-    if (m_currPacketData.size() == 10) {
-        value = 0;
-        for (int i = 2; i < 10; i++) {
-            value |= ((uint64_t)m_currPacketData[i]) << shift;
-            shift += 8;
-        }
-        m_curr_packet.setITE(m_currPacketData[1], value);
-        m_process_state = SEND_PKT;
-    }
+    return (num != 0);
 }
 
 // header byte processing is table driven.
@@ -1670,9 +1840,25 @@ void TrcPktProcEtmV4I::BuildIPacketTable()
         m_i_table[i].pkt_type = ETM4_PKT_I_ATOM_F3;
         m_i_table[i].pptkFn   = &TrcPktProcEtmV4I::iAtom;
     }
+
+    // atom patterns and span parsers for the most frequent packets.
+    for (int i = 0; i < 256; i++)
+    {
+        m_i_table[i].pptkSpanFn = 0;
+        m_i_table[i].atom_num = 0;
+        m_i_table[i].atom_En_bits = 0;
+        if (m_i_table[i].pptkFn == &TrcPktProcEtmV4I::iAtom)
+            decodeAtomHdr(m_i_table[i].pkt_type, (uint8_t)i, m_i_table[i].atom_En_bits, m_i_table[i].atom_num);
+        else if (m_i_table[i].pptkFn == &TrcPktProcEtmV4I::iPktNoPayload)
+            m_i_table[i].pptkSpanFn = &TrcPktProcEtmV4I::sPktNoPayload;
+        else if (m_i_table[i].pptkFn == &TrcPktProcEtmV4I::iPktShortAddr)
+            m_i_table[i].pptkSpanFn = &TrcPktProcEtmV4I::sPktShortAddr;
+        else if (m_i_table[i].pptkFn == &TrcPktProcEtmV4I::iPktLongAddr)
+            m_i_table[i].pptkSpanFn = &TrcPktProcEtmV4I::sPktLongAddr;
+    }
 }
 
- unsigned TrcPktProcEtmV4I::extractContField(const std::vector<uint8_t> &buffer, const unsigned st_idx, uint32_t &value, const unsigned byte_limit /*= 5*/)
+ unsigned TrcPktProcEtmV4I::extractContField(const TraceRawPacket &buffer, const unsigned st_idx, uint32_t &value, const unsigned byte_limit /*= 5*/)
 {
     unsigned idx = 0;
     bool lastByte = false;
@@ -1696,7 +1882,7 @@ void TrcPktProcEtmV4I::BuildIPacketTable()
     return idx;
 }
 
-unsigned TrcPktProcEtmV4I::extractTSField64(const std::vector<uint8_t> &buffer, const unsigned st_idx, uint64_t &value)
+unsigned TrcPktProcEtmV4I::extractTSField64(const TraceRawPacket &buffer, const unsigned st_idx, uint64_t &value)
 {
     const unsigned max_byte_idx = 8;    /* the 9th byte, index 8, will use full 8 bits for value */
     unsigned idx = 0;
@@ -1734,7 +1920,7 @@ unsigned TrcPktProcEtmV4I::extractTSField64(const std::vector<uint8_t> &buffer,
     return idx;
 }
 
- unsigned TrcPktProcEtmV4I::extractCondResult(const std::vector<uint8_t> &buffer, const unsigned st_idx, uint32_t& key, uint8_t &result)
+ unsigned TrcPktProcEtmV4I::extractCondResult(const TraceRawPacket &buffer, const unsigned st_idx, uint32_t& key, uint8_t &result)
 {
     unsigned idx = 0;
     bool lastByte = false;
@@ -1768,7 +1954,7 @@ unsigned TrcPktProcEtmV4I::extractTSField64(const std::vector<uint8_t> &buffer,
     return idx;
 }
 
-int TrcPktProcEtmV4I::extract64BitLongAddr(const std::vector<uint8_t> &buffer, const int st_idx, const uint8_t IS, uint64_t &value)
+int TrcPktProcEtmV4I::extract64BitLongAddr(const TraceRawPacket &buffer, const int st_idx, const uint8_t IS, uint64_t &value)
 {
     value = 0;
     if(IS == 0)
@@ -1790,7 +1976,7 @@ int TrcPktProcEtmV4I::extract64BitLongAddr(const std::vector<uint8_t> &buffer, c
     return 8;    
 }
 
-int TrcPktProcEtmV4I::extract32BitLongAddr(const std::vector<uint8_t> &buffer, const int st_idx, const uint8_t IS, uint32_t &value)
+int TrcPktProcEtmV4I::extract32BitLongAddr(const TraceRawPacket &buffer, const int st_idx, const uint8_t IS, uint32_t &value)
 {
     value = 0;
     if(IS == 0)
@@ -157,6 +157,13 @@ ocsd_err_t TrcIDecode::DecodeA64(ocsd_instr_info *instr_info, struct decode_info
     if (aa64_err_bad_opcode && !(instr_info->opcode & 0xFFFF0000))
         return OCSD_ERR_INVALID_OPCODE;
 
+    // most instructions cannot be waypoints - skip the full classification (also in line in decodeInstrDirect()).
+    if (!inst_A64_maybe_waypoint(instr_info->opcode))
+    {
+        instr_info->is_conditional = 0;
+        return OCSD_OK;
+    }
+
     if(inst_A64_is_indirect_branch_link(instr_info->opcode, &instr_info->is_link, info))
     {
         instr_info->type = OCSD_INSTR_BR_INDIRECT;
@@ -0,0 +1,230 @@
+/*
+* \file       trc_idec_wp_scan.cpp
+* \brief      OpenCSD : scan fixed width opcodes for possible waypoints.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+#include "i_dec/trc_idec_wp_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define WP_SCAN_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define WP_SCAN_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define WP_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+/*
+An opcode may be a waypoint if (opcode & mask) == value for any pair in the
+list. Unused entries repeat an earlier pair.
+*/
+#define WP_SCAN_NUM_TESTS 7
+
+typedef struct _wp_scan_tests {
+    uint32_t mask[WP_SCAN_NUM_TESTS];
+    uint32_t value[WP_SCAN_NUM_TESTS];
+} wp_scan_tests_t;
+
+/* top byte ranges from inst_A64_top_byte_maybe_wp(), plus invalid opcodes */
+static const wp_scan_tests_t a64_tests = {
+    { 0x7C000000, 0x7C000000, 0xFE000000, 0x7E000000, 0xFF000000, 0xFE000000, 0xFFFF0000 },
+    { 0x14000000, 0x34000000, 0x54000000, 0x74000000, 0xD5000000, 0xD6000000, 0x00000000 }
+};
+
+static const wp_scan_tests_t a32_tests = {
+    {   0xF0000000, /* unconditional space - BLX imm, RFE, barriers */
+        0x0E000000, /* B, BL */
+        0x0000F000, /* Rd / Rt == PC - data processing and loads to PC, WFI / WFE */
+        0x0E008000, /* LDM including PC */
+        0x0FF00000, /* BX, BLX reg, BXJ */
+        0x0FFF0F00, /* CP15 barriers */
+        0x0FFF0F00 },
+    {   0xF0000000, 
+        0x0A000000, 
+        0x0000F000, 
+        0x08008000, 
+        0x01200000, 
+        0x0E070F00, 
+        0x0E070F00 }
+};
+
+typedef uint32_t (*wp_scan_fn_t)(const wp_scan_tests_t &tests, const uint8_t *p_opcodes, const uint32_t num_opcodes);
+
+static inline bool maybe_wp(const wp_scan_tests_t &tests, const uint32_t opcode)
+{
+    bool result = false;
+    for (int i = 0; i < WP_SCAN_NUM_TESTS; i++)
+        result |= ((opcode & tests.mask[i]) == tests.value[i]);
+    return result;
+}
+
+static uint32_t scan_scalar(const wp_scan_tests_t &tests, const uint8_t *p_opcodes, const uint32_t num_opcodes)
+{
+    uint32_t opcode;
+
+    for (uint32_t i = 0; i < num_opcodes; i++)
+    {
+        memcpy(&opcode, p_opcodes + (i * 4), sizeof(opcode));
+        if (maybe_wp(tests, opcode))
+            return i;
+    }
+    return num_opcodes;
+}
+
+/* index of first set lane in a compare result bit mask */
+static inline uint32_t first_lane(uint32_t lane_bits)
+{
+    uint32_t idx = 0;
+    while (!(lane_bits & 0x1))
+    {
+        lane_bits >>= 1;
+        idx++;
+    }
+    return idx;
+}
+
+#ifdef WP_SCAN_SSE2
+static uint32_t scan_sse2(const wp_scan_tests_t &tests, const uint8_t *p_opcodes, const uint32_t num_opcodes)
+{
+    __m128i mask[WP_SCAN_NUM_TESTS], value[WP_SCAN_NUM_TESTS];
+    uint32_t i = 0;
+
+    for (int t = 0; t < WP_SCAN_NUM_TESTS; t++)
+    {
+        mask[t] = _mm_set1_epi32((int)tests.mask[t]);
+        value[t] = _mm_set1_epi32((int)tests.value[t]);
+    }
+
+    for (; (i + 4) <= num_opcodes; i += 4)
+    {
+        __m128i ops = _mm_loadu_si128((const __m128i *)(p_opcodes + (i * 4)));
+        __m128i hit = _mm_cmpeq_epi32(_mm_and_si128(ops, mask[0]), value[0]);
+        for (int t = 1; t < WP_SCAN_NUM_TESTS; t++)
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi32(_mm_and_si128(ops, mask[t]), value[t]));
+        int lanes = _mm_movemask_ps(_mm_castsi128_ps(hit));
+        if (lanes)
+            return i + first_lane((uint32_t)lanes);
+    }
+    return i + scan_scalar(tests, p_opcodes + (i * 4), num_opcodes - i);
+}
+#endif
+
+#ifdef WP_SCAN_AVX2
+__attribute__((target("avx2")))
+static uint32_t scan_avx2(const wp_scan_tests_t &tests, const uint8_t *p_opcodes, const uint32_t num_opcodes)
+{
+    __m256i mask[WP_SCAN_NUM_TESTS], value[WP_SCAN_NUM_TESTS];
+    uint32_t i = 0;
+
+    for (int t = 0; t < WP_SCAN_NUM_TESTS; t++)
+    {
+        mask[t] = _mm256_set1_epi32((int)tests.mask[t]);
+        value[t] = _mm256_set1_epi32((int)tests.value[t]);
+    }
+
+    for (; (i + 8) <= num_opcodes; i += 8)
+    {
+        __m256i ops = _mm256_loadu_si256((const __m256i *)(p_opcodes + (i * 4)));
+        __m256i hit = _mm256_cmpeq_epi32(_mm256_and_si256(ops, mask[0]), value[0]);
+        for (int t = 1; t < WP_SCAN_NUM_TESTS; t++)
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi32(_mm256_and_si256(ops, mask[t]), value[t]));
+        int lanes = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+        if (lanes)
+            return i + first_lane((uint32_t)lanes);
+    }
+    return i + scan_scalar(tests, p_opcodes + (i * 4), num_opcodes - i);
+}
+#endif
+
+#ifdef WP_SCAN_NEON
+static uint32_t scan_neon(const wp_scan_tests_t &tests, const uint8_t *p_opcodes, const uint32_t num_opcodes)
+{
+    uint32x4_t mask[WP_SCAN_NUM_TESTS], value[WP_SCAN_NUM_TESTS];
+    uint32_t i = 0;
+
+    for (int t = 0; t < WP_SCAN_NUM_TESTS; t++)
+    {
+        mask[t] = vdupq_n_u32(tests.mask[t]);
+        value[t] = vdupq_n_u32(tests.value[t]);
+    }
+
+    for (; (i + 4) <= num_opcodes; i += 4)
+    {
+        uint32x4_t ops = vreinterpretq_u32_u8(vld1q_u8(p_opcodes + (i * 4)));
+        uint32x4_t hit = vceqq_u32(vandq_u32(ops, mask[0]), value[0]);
+        for (int t = 1; t < WP_SCAN_NUM_TESTS; t++)
+            hit = vorrq_u32(hit, vceqq_u32(vandq_u32(ops, mask[t]), value[t]));
+        if (vmaxvq_u32(hit))
+            return i + scan_scalar(tests, p_opcodes + (i * 4), 4);
+    }
+    return i + scan_scalar(tests, p_opcodes + (i * 4), num_opcodes - i);
+}
+#endif
+
+/* pick the best implementation for the host */
+static wp_scan_fn_t select_scan()
+{
+#ifdef WP_SCAN_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return scan_avx2;
+#endif
+#if defined(WP_SCAN_SSE2)
+    return scan_sse2;
+#elif defined(WP_SCAN_NEON)
+    return scan_neon;
+#else
+    return scan_scalar;
+#endif
+}
+
+static inline wp_scan_fn_t scan_fn()
+{
+    static const wp_scan_fn_t fn = select_scan();
+    return fn;
+}
+
+uint32_t inst_A64_scan_to_wp(const uint8_t *p_opcodes, const uint32_t num_opcodes)
+{
+    return scan_fn()(a64_tests, p_opcodes, num_opcodes);
+}
+
+uint32_t inst_ARM_scan_to_wp(const uint8_t *p_opcodes, const uint32_t num_opcodes)
+{
+    return scan_fn()(a32_tests, p_opcodes, num_opcodes);
+}
+
+/* End of File trc_idec_wp_scan.cpp */
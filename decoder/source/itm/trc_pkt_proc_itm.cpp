@@ -33,6 +33,7 @@
   */
 
 #include "opencsd/itm/trc_pkt_proc_itm.h"
+#include "common/trc_sync_scan.h"
 
   // processor object construction
   // ************************
@@ -46,6 +47,8 @@
 
 static const uint32_t ITM_SUPPORTED_OP_FLAGS = OCSD_OPFLG_PKTPROC_COMMON;
 
+#define ITM_ASYNC_0_BYTES 5    // async packet is at least 5 x 0x00 followed by 0x80
+
 TrcPktProcItm::TrcPktProcItm() : TrcPktProcBase(ITM_PKTS_NAME)
 {
     initObj();
@@ -586,6 +589,21 @@ ocsd_datapath_resp_t TrcPktProcItm::waitForSync(const ocsd_trc_index_t blk_st_in
 
         if (!m_sync_start)
         {
+            // no raw monitor - step over data that cannot hold an async.
+            if (!hasRawMon() && (m_dump_unsynced_bytes == 0) && (m_packet_data.size() == 0))
+            {
+                uint32_t skip_bytes = ocsd_scan_byte_run(m_p_data_in + m_data_in_used, m_data_in_size - m_data_in_used, 0x00, ITM_ASYNC_0_BYTES);
+                if (skip_bytes)
+                {
+                    m_data_in_used += skip_bytes;
+                    if (!m_sent_notsync_packet)
+                    {
+                        resp = outputDecodedPacket(m_packet_index, &m_curr_packet);
+                        m_sent_notsync_packet = true;
+                    }
+                    continue;
+                }
+            }
 
             if (!readByte(byte))
                 break;
@@ -613,8 +631,8 @@ ocsd_datapath_resp_t TrcPktProcItm::waitForSync(const ocsd_trc_index_t blk_st_in
         }        
     }
 
-    // not found sync and run out of data
-    if (!m_bStreamSync && !m_sync_start)
+    // not found sync and run out of data - skipped data may leave nothing to flush.
+    if (!m_bStreamSync && !m_sync_start && m_dump_unsynced_bytes)
         resp = flushUnsyncedBytes();
 
     return resp;
@@ -625,7 +643,7 @@ ocsd_datapath_resp_t TrcPktProcItm::flushUnsyncedBytes()
     ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
 
     // we need to dump unsynced bytes to raw monitor if in use, and send a not sync packet if this is the first time.
-    outputRawPacketToMonitor(m_packet_index, &m_curr_packet, m_dump_unsynced_bytes, &m_packet_data[0]);
+    outputRawPacketToMonitor(m_packet_index, &m_curr_packet, m_dump_unsynced_bytes, m_packet_data.data());
 
     if (!m_sent_notsync_packet)
     {
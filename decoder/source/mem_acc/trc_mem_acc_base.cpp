@@ -37,6 +37,7 @@
 #include "mem_acc/trc_mem_acc_file.h"
 #include "mem_acc/trc_mem_acc_cb.h"
 #include "mem_acc/trc_mem_acc_bufptr.h"
+#include "mem_acc/trc_mem_acc_code_map.h"
 
 #include <sstream>
 #include <iomanip>
@@ -54,11 +55,11 @@ ocsd_err_t TrcMemAccFactory::CreateBufferAccessor(TrcMemAccessorBase **pAccessor
     return err;
 }
 
-ocsd_err_t TrcMemAccFactory::CreateFileAccessor(TrcMemAccessorBase **pAccessor, const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset /*= 0*/, size_t size /*= 0*/)
+ocsd_err_t TrcMemAccFactory::CreateFileAccessor(TrcMemAccessorBase **pAccessor, const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset /*= 0*/, size_t size /*= 0*/, const uint32_t file_acc_opts /*= OCSD_FILE_MEM_ACC_OPT_NONE*/, const ocsd_mem_space_acc_t mem_space /*= OCSD_MEM_SPACE_ANY*/)
 {
     ocsd_err_t err = OCSD_OK;
     TrcMemAccessorFile *pFileAccessor = 0;
-    err = TrcMemAccessorFile::createFileAccessor(&pFileAccessor, pathToFile, startAddr, offset,size);
+    err = TrcMemAccessorFile::createFileAccessor(&pFileAccessor, pathToFile, startAddr, offset,size, file_acc_opts, mem_space);
     *pAccessor = pFileAccessor;
     return err;
 }
@@ -93,6 +94,45 @@ void TrcMemAccFactory::DestroyAccessor(TrcMemAccessorBase *pAccessor)
     }
 }
 
+TrcMemAccessorBase::~TrcMemAccessorBase()
+{
+    for (size_t i = 0; i < m_code_maps.size(); i++)
+        delete m_code_maps[i];
+}
+
+ocsd_err_t TrcMemAccessorBase::addCodeMap(TrcMemAccCodeMap *p_map)
+{
+    ocsd_err_t err;
+
+    if (!p_map)
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    if (!addrInRange(p_map->getStartAddr()) || !addrInRange(p_map->getEndAddr()))
+        return OCSD_ERR_MEM_ACC_RANGE_INVALID;
+
+    for (size_t i = 0; i < m_code_maps.size(); i++)
+    {
+        if ((p_map->getStartAddr() <= m_code_maps[i]->getEndAddr()) &&
+            (p_map->getEndAddr() >= m_code_maps[i]->getStartAddr()))
+            return OCSD_ERR_MEM_ACC_OVERLAP;
+    }
+
+    // only use the map with the image it was built from.
+    err = p_map->checkImage(this);
+    if (err == OCSD_OK)
+        m_code_maps.push_back(p_map);
+    return err;
+}
+
+const TrcMemAccCodeMap *TrcMemAccessorBase::getCodeMap(const ocsd_vaddr_t address) const
+{
+    for (size_t i = 0; i < m_code_maps.size(); i++)
+    {
+        if ((address >= m_code_maps[i]->getStartAddr()) && (address <= m_code_maps[i]->getEndAddr()))
+            return m_code_maps[i];
+    }
+    return 0;
+}
 
 /* memory access info logging */
 void TrcMemAccessorBase::getMemAccString(std::string& accStr) const
@@ -65,4 +65,17 @@ const uint32_t TrcMemAccBufPtr::readBytes(const ocsd_vaddr_t address, const ocsd
     return bytesRead;
 }
 
+const uint8_t *TrcMemAccBufPtr::readBytesPtr(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, uint32_t &availBytes)
+{
+    availBytes = 0;
+    if (!m_p_buffer)
+        return 0;
+
+    // all bytes to the end of the buffer
+    availBytes = bytesInRange(address, 0xFFFFFFFF);
+    if (availBytes)
+        return m_p_buffer + address - m_startAddress;
+    return 0;
+}
+
 /* End of File trc_mem_acc_bufptr.cpp */
@@ -33,63 +33,132 @@
 */
 
 #include <cstring>
+#include <cstdlib>
 #include <sstream>
 #include <iomanip>
 #include <new>
+#ifdef WIN32
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
 #include "mem_acc/trc_mem_acc_cache.h"
 #include "mem_acc/trc_mem_acc_base.h"
 #include "interfaces/trc_error_log_i.h"
 #include "common/ocsd_error.h"
+#include "opencsd/ocsd_if_version.h"
 
-#ifdef LOG_CACHE_STATS
-#define INC_HITS_RL(idx) m_hits++; m_hit_rl[m_mru_idx]++;
-#define INC_MISS() m_misses++;
-#define INC_PAGES() m_pages++;
-#define SET_MAX_RL(idx)                         \
+/* count a hit on the current page - consecutive hits on the same page form a run */
+#define INC_HITS_RL(idx)                        \
     {                                           \
-        if (m_hit_rl_max[idx] < m_hit_rl[idx])  \
-            m_hit_rl_max[idx] = m_hit_rl[idx];  \
-        m_hit_rl[idx] = 0;                      \
+        m_stats.cache_hits++;                   \
+        if (m_run_idx != idx) {                 \
+            m_run_idx = idx;                    \
+            m_run_len = 0;                      \
+            m_stats.hit_runs++;                 \
+        }                                       \
+        if (++m_run_len > m_stats.hit_run_max)  \
+            m_stats.hit_run_max = m_run_len;    \
     }
-#define INC_RL(idx) m_hit_rl[m_mru_idx]++;
-#else
-#define INC_HITS_RL(idx)
-#define INC_MISS() 
-#define INC_PAGES() 
-#define SET_MAX_RL(idx)
-#define INC_RL(idx)  
-#endif
+#define INC_MISS() { m_stats.cache_misses++; m_run_idx = -1; }
+#define INC_PAGES() m_stats.page_loads++;
 
 // uncomment to log cache ops
 // #define LOG_CACHE_OPS
 // #define LOG_CACHE_CREATION
 
+/* Split the pages into sets - power of 2 number of sets with around MEM_ACC_CACHE_SET_WAYS
+ * pages in each. Number of pages rounded down to a multiple of the number of sets.
+ */
+void TrcMemAccCache::calcSetSizes()
+{
+    m_num_sets = 1;
+    while ((m_num_sets * 2 * MEM_ACC_CACHE_SET_WAYS) <= m_mru_num_pages)
+        m_num_sets *= 2;
+    m_set_ways = m_mru_num_pages / m_num_sets;
+    m_mru_num_pages = m_num_sets * m_set_ways;
+
+    m_page_shift = 0;
+    while ((1 << m_page_shift) < m_mru_page_size)
+        m_page_shift++;
+}
+
+/* aligned allocations for the page data slab and metadata */
+static void *cacheAlloc(const size_t size, const size_t align)
+{
+    void *p_mem = 0;
+#ifdef WIN32
+    p_mem = _aligned_malloc(size, align);
+#else
+    if (posix_memalign(&p_mem, align, size) != 0)
+        p_mem = 0;
+#endif
+    return p_mem;
+}
+
+static void cacheFree(void *p_mem)
+{
+#ifdef WIN32
+    _aligned_free(p_mem);
+#else
+    free(p_mem);
+#endif
+}
+
 ocsd_err_t TrcMemAccCache::createCaches()
 {
-    if (m_mru)
-        destroyCaches();
-    m_mru = (cache_block_t*) new (std::nothrow) cache_block_t[m_mru_num_pages];
-    if (!m_mru)
-        return OCSD_ERR_MEM;
-    for (int i = 0; i < m_mru_num_pages; i++) {
-        m_mru[i].data = new (std::nothrow) uint8_t[m_mru_page_size];
-        if (!m_mru[i].data)
+    size_t slab_size, align = MEM_ACC_CACHE_LINE_SIZE;
+
+    calcSetSizes();
+    m_page_stride = (m_mru_page_size + MEM_ACC_CACHE_LINE_SIZE - 1) & ~(MEM_ACC_CACHE_LINE_SIZE - 1);
+    slab_size = (size_t)m_page_stride * m_mru_num_pages;
+
+    // new metadata array if existing one too small
+    if (m_mru_capacity < m_mru_num_pages)
+    {
+        cacheFree(m_mru);
+        m_mru_capacity = 0;
+        m_mru = (cache_block_t *)cacheAlloc(sizeof(cache_block_t) * m_mru_num_pages, MEM_ACC_CACHE_LINE_SIZE);
+        if (!m_mru)
+        {
+            destroyCaches();
             return OCSD_ERR_MEM;
-        clearPage(&m_mru[i]);
-    }
-#ifdef LOG_CACHE_STATS
-    m_hit_rl = (uint32_t *) new (std::nothrow) uint32_t[m_mru_num_pages];
-    m_hit_rl_max = (uint32_t*) new (std::nothrow) uint32_t[m_mru_num_pages];
-    if (!m_hit_rl || !m_hit_rl_max)
-        return OCSD_ERR_MEM;
-    for (int j = 0; j < m_mru_num_pages; j++) {
-        m_hit_rl[j] = 0;
-        m_hit_rl_max[j] = 0;
+        }
+        m_mru_capacity = m_mru_num_pages;
     }
+
+    // new slab if existing one too small
+    if (m_slab_size < slab_size)
+    {
+        cacheFree(m_slab);
+        m_slab_size = 0;
+        if (slab_size >= MEM_ACC_CACHE_HUGE_PAGE_SIZE)
+        {
+            align = MEM_ACC_CACHE_HUGE_PAGE_SIZE;
+            slab_size = (slab_size + MEM_ACC_CACHE_HUGE_PAGE_SIZE - 1) & ~((size_t)MEM_ACC_CACHE_HUGE_PAGE_SIZE - 1);
+        }
+        m_slab = (uint8_t *)cacheAlloc(slab_size, align);
+        if (!m_slab)
+        {
+            destroyCaches();
+            return OCSD_ERR_MEM;
+        }
+        m_slab_size = slab_size;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        // advisory only - ignore failure
+        if (align == MEM_ACC_CACHE_HUGE_PAGE_SIZE)
+            madvise(m_slab, m_slab_size, MADV_HUGEPAGE);
 #endif
+    }
+
+    for (int i = 0; i < m_mru_num_pages; i++)
+        clearPage(&m_mru[i]);
+    m_mru_idx = 0;
+    m_run_idx = -1;
 #ifdef LOG_CACHE_CREATION
     std::ostringstream oss;
-    oss << "MemAcc Caches: Num Pages=" << m_mru_num_pages << "; Page size=" << m_mru_page_size << ";\n";
+    oss << "MemAcc Caches: Num Pages=" << m_mru_num_pages << "; Page size=" << m_mru_page_size << "; Sets=" << m_num_sets << "; Ways=" << m_set_ways;
+    oss << "; Slab size=" << m_slab_size << ";\n";
     logMsg(oss.str());
 #endif
     return OCSD_OK;
@@ -97,21 +166,12 @@ ocsd_err_t TrcMemAccCache::createCaches()
 
 void TrcMemAccCache::destroyCaches()
 {
-    if (m_mru) {
-        for (int i = 0; i < m_mru_num_pages; i++)
-            delete[] m_mru[i].data;
-        delete[] m_mru;
-        m_mru = 0;
-    }
-#ifdef LOG_CACHE_STATS
-    if (m_hit_rl)
-        delete[] m_hit_rl;
-    if (m_hit_rl_max)
-        delete[] m_hit_rl_max;
-    m_hit_rl = 0;
-    m_hit_rl_max = 0;
-#endif
-
+    cacheFree(m_mru);
+    m_mru = 0;
+    m_mru_capacity = 0;
+    cacheFree(m_slab);
+    m_slab = 0;
+    m_slab_size = 0;
 }
 
 void TrcMemAccCache::getenvMemaccCacheSizes(bool& enable, int& page_size, int& num_pages)
@@ -186,15 +246,15 @@ ocsd_err_t TrcMemAccCache::enableCaching(bool bEnable)
 
 ocsd_err_t TrcMemAccCache::setCacheSizes(const uint16_t page_size, const int nr_pages, const bool err_on_limit /*= false*/)
 {
+    uint16_t new_page_size;
+    int new_num_pages;
+
     // do't re-create what we already have.
     if (m_mru &&
         (m_mru_num_pages == nr_pages) &&
         (m_mru_page_size == page_size))
         return OCSD_OK;
 
-    /* remove any caches with the existing sizes */
-    destroyCaches();
-
     /* set page size within Max/Min range */
     if (page_size > MEM_ACC_CACHE_PAGE_SIZE_MAX)
     {
@@ -203,7 +263,7 @@ ocsd_err_t TrcMemAccCache::setCacheSizes(const uint16_t page_size, const int nr_
             logMsg("MemAcc Caching: page size too large", OCSD_ERR_INVALID_PARAM_VAL);
             return OCSD_ERR_INVALID_PARAM_VAL;
         }
-        m_mru_page_size = MEM_ACC_CACHE_PAGE_SIZE_MAX;
+        new_page_size = MEM_ACC_CACHE_PAGE_SIZE_MAX;
     }
     else if (page_size < MEM_ACC_CACHE_PAGE_SIZE_MIN)
     {
@@ -212,10 +272,10 @@ ocsd_err_t TrcMemAccCache::setCacheSizes(const uint16_t page_size, const int nr_
             logMsg("MemAcc Caching: page size too small", OCSD_ERR_INVALID_PARAM_VAL);
             return OCSD_ERR_INVALID_PARAM_VAL;
         }
-        m_mru_page_size = MEM_ACC_CACHE_PAGE_SIZE_MIN;
+        new_page_size = MEM_ACC_CACHE_PAGE_SIZE_MIN;
     }
     else
-        m_mru_page_size = page_size;
+        new_page_size = page_size;
 
     /* set num pages within max/min range */
     if (nr_pages > MEM_ACC_CACHE_MRU_SIZE_MAX)
@@ -225,7 +285,7 @@ ocsd_err_t TrcMemAccCache::setCacheSizes(const uint16_t page_size, const int nr_
             logMsg("MemAcc Caching: number of pages too large", OCSD_ERR_INVALID_PARAM_VAL);
             return OCSD_ERR_INVALID_PARAM_VAL;
         }
-        m_mru_num_pages = MEM_ACC_CACHE_MRU_SIZE_MAX;
+        new_num_pages = MEM_ACC_CACHE_MRU_SIZE_MAX;
     }
     else if (nr_pages < MEM_ACC_CACHE_MRU_SIZE_MIN)
     {
@@ -234,33 +294,32 @@ ocsd_err_t TrcMemAccCache::setCacheSizes(const uint16_t page_size, const int nr_
             logMsg("MemAcc Caching: number of pages too small", OCSD_ERR_INVALID_PARAM_VAL);
             return OCSD_ERR_INVALID_PARAM_VAL;
         }
-        m_mru_num_pages = MEM_ACC_CACHE_MRU_SIZE_MIN;
+        new_num_pages = MEM_ACC_CACHE_MRU_SIZE_MIN;
     }
     else
-        m_mru_num_pages = nr_pages;
+        new_num_pages = nr_pages;
 
-    /* re-create with new sizes */
+    /* sizes valid - re-create, reusing existing allocations if large enough */
+    m_mru_page_size = new_page_size;
+    m_mru_num_pages = new_num_pages;
     return createCaches();
 }
 
-/* return index of unused page, or oldest used page by sequence number */
-int TrcMemAccCache::findNewPage()
+/* return index of unused page, or oldest used page by sequence number, in the set for the address */
+int TrcMemAccCache::findNewPage(const ocsd_vaddr_t address, const cache_page_tag_t &tag)
 {
     uint32_t oldest_seq;
-    int current_idx, oldest_idx;
+    int current_idx, oldest_idx, end_idx;
 #ifdef LOG_CACHE_OPS
     std::ostringstream oss;
 #endif
 
-    /* set up search indexes and check the current search index has not wrapped. */
-    current_idx = m_mru_idx + 1;
-    oldest_idx = m_mru_idx;
+    current_idx = pageSet(address >> m_page_shift, tag) * m_set_ways;
+    end_idx = current_idx + m_set_ways;
+    oldest_idx = current_idx;
     oldest_seq = 0;
-    if (current_idx >= m_mru_num_pages)
-        current_idx = 0;
 
-    /* search forwards from m_mru_idx + 1 until we wrap and hit the index again */
-    while (current_idx != m_mru_idx) {
+    for (; current_idx < end_idx; current_idx++) {
         if (m_mru[current_idx].use_sequence == 0) {
 #ifdef LOG_CACHE_OPS
             oss << "TrcMemAccCache:: ALI-allocate clean page:  [page: " << std::dec << current_idx << "]\n";
@@ -274,17 +333,12 @@ int TrcMemAccCache::findNewPage()
             oldest_seq = m_mru[current_idx].use_sequence;
             oldest_idx = current_idx;
         }
-
-        current_idx++;
-
-        // wrap around?
-        if (current_idx >= m_mru_num_pages)
-            current_idx = 0;
     }
 #ifdef LOG_CACHE_OPS
     oss << "TrcMemAccCache:: ALI-evict and allocate old page:  [page: " << std::dec << oldest_idx << "]\n";
     logMsg(oss.str());
 #endif
+    m_stats.page_evictions++;
     return oldest_idx;
 }
 
@@ -306,9 +360,35 @@ void TrcMemAccCache::incSequence()
 
 ocsd_err_t TrcMemAccCache::readBytesFromCache(TrcMemAccessorBase *p_accessor, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, uint32_t *numBytes, uint8_t *byteBuffer)
 {
-    uint32_t bytesRead = 0, reqBytes = *numBytes;
+    const uint8_t *p_data = 0;
+    ocsd_err_t err = findBlockInCache(p_accessor, address, mem_space, trcID, *numBytes, &p_data);
+
+    if (p_data)
+        memcpy(byteBuffer, p_data, *numBytes);
+    else
+        *numBytes = 0;
+    return err;
+}
+
+ocsd_err_t TrcMemAccCache::readPtrFromCache(TrcMemAccessorBase *p_accessor, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, uint32_t *numBytes, const uint8_t **pp_data)
+{
+    ocsd_err_t err = findBlockInCache(p_accessor, address, mem_space, trcID, *numBytes, pp_data);
+
+    // return all the valid bytes in the page from the address
+    if (*pp_data)
+        *numBytes = (uint32_t)(m_mru[m_mru_idx].st_addr + m_mru[m_mru_idx].valid_len - address);
+    else
+        *numBytes = 0;
+    return err;
+}
+
+/* find the block in the cache, loading a page from the accessor if needed. *pp_data set to block if found, 0 otherwise. */
+ocsd_err_t TrcMemAccCache::findBlockInCache(TrcMemAccessorBase *p_accessor, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, const uint32_t reqBytes, const uint8_t **pp_data)
+{
     ocsd_err_t err = OCSD_OK;
+    cache_page_tag_t tag;
     
+    *pp_data = 0;
 
 #ifdef LOG_CACHE_OPS
     std::ostringstream oss;
@@ -317,13 +397,17 @@ ocsd_err_t TrcMemAccCache::readBytesFromCache(TrcMemAccessorBase *p_accessor, co
 
     if (m_bCacheEnabled)
     {
-        if (blockInCache(address, reqBytes, trcID))
+        tag.trcID = trcID;
+        tag.ctxt_tag = m_ctxt_tags[trcID & (MEM_ACC_CACHE_NUM_TRC_IDS - 1)];
+        tag.p_acc = p_accessor;
+        tag.mem_space = mem_space;
+
+        if (blockInCache(address, reqBytes, tag))
         {
-            bytesRead = reqBytes;
-            memcpy(byteBuffer, &m_mru[m_mru_idx].data[address - m_mru[m_mru_idx].st_addr], reqBytes);
+            *pp_data = pageData(m_mru_idx) + (address - m_mru[m_mru_idx].st_addr);
             incSequence();
 #ifdef LOG_CACHE_OPS
-            oss << "TrcMemAccCache:: hit {page: " << std::dec << m_mru_idx << "; seq: " << m_mru[m_mru_idx].use_sequence << " CSID: " << std::hex << (int)m_mru[m_mru_idx].trcID;
+            oss << "TrcMemAccCache:: hit {page: " << std::dec << m_mru_idx << "; seq: " << m_mru[m_mru_idx].use_sequence << " CSID: " << std::hex << (int)m_mru[m_mru_idx].tag.trcID;
             oss << "} [addr:0x" << std::hex << address << ", bytes: " << std::dec << reqBytes << "]\n";
             logMsg(oss.str());
 #endif
@@ -335,9 +419,12 @@ ocsd_err_t TrcMemAccCache::readBytesFromCache(TrcMemAccessorBase *p_accessor, co
             oss << "TrcMemAccCache:: miss [addr:0x" << std::hex << address << ", bytes: " << std::dec << reqBytes << "]\n";
             logMsg(oss.str());
 #endif
+            INC_MISS();
+
             /* need a new cache page - check the underlying accessor for the data */
-            m_mru_idx = findNewPage();
-            m_mru[m_mru_idx].valid_len = p_accessor->readBytes(address, mem_space, trcID, m_mru_page_size, &m_mru[m_mru_idx].data[0]);
+            m_mru_idx = findNewPage(address, tag);
+            m_mru[m_mru_idx].valid_len = p_accessor->readBytes(address, mem_space, trcID, m_mru_page_size, pageData(m_mru_idx));
+            countAccRead(p_accessor, m_mru[m_mru_idx].valid_len);
             
             /* check return length valid - v bad if return length more than request */
             if (m_mru[m_mru_idx].valid_len > m_mru_page_size)
@@ -350,26 +437,21 @@ ocsd_err_t TrcMemAccCache::readBytesFromCache(TrcMemAccessorBase *p_accessor, co
             {
                 // got some data - so save the details                
                 m_mru[m_mru_idx].st_addr = address;
-                m_mru[m_mru_idx].trcID = trcID;
+                m_mru[m_mru_idx].tag = tag;
                 incSequence();
 
-                // log the run length hit counts
-                SET_MAX_RL(m_mru_idx);
-                
 #ifdef LOG_CACHE_OPS
                 TrcMemAccessorBase::getMemAccSpaceString(memSpaceStr, mem_space);
                 oss.str("");
-                oss << "TrcMemAccCache:: ALI-load {page: " << std::dec << m_mru_idx << "; seq: " << m_mru[m_mru_idx].use_sequence << " CSID: " << std::hex << (int)m_mru[m_mru_idx].trcID;
+                oss << "TrcMemAccCache:: ALI-load {page: " << std::dec << m_mru_idx << "; seq: " << m_mru[m_mru_idx].use_sequence << " CSID: " << std::hex << (int)m_mru[m_mru_idx].tag.trcID;
                 oss << "} [mem space: " << memSpaceStr << ", addr:0x" << std::hex << address << ", bytes: " << std::dec << m_mru[m_mru_idx].valid_len << "]\n";
                 logMsg(oss.str());
 #endif
                 INC_PAGES();              
 
-                if (blockInPage(address, reqBytes, trcID)) /* check we got the data we needed */
+                if (blockInPage(m_mru_idx, address, reqBytes, tag)) /* check we got the data we needed */
                 {
-                    bytesRead = reqBytes;
-                    memcpy(byteBuffer, &m_mru[m_mru_idx].data[address - m_mru[m_mru_idx].st_addr], reqBytes);
-                    INC_RL(m_mru_idx);
+                    *pp_data = pageData(m_mru_idx) + (address - m_mru[m_mru_idx].st_addr);
                 }
                 else
                 {
@@ -378,12 +460,10 @@ ocsd_err_t TrcMemAccCache::readBytesFromCache(TrcMemAccessorBase *p_accessor, co
                     oss << "TrcMemAccCache:: miss-after-load {page: " << std::dec << m_mru_idx << " } [addr:0x" << std::hex << address << ", bytes: " << std::dec << m_mru[m_mru_idx].valid_len << "]\n";
                     logMsg(oss.str());
 #endif
-                    INC_MISS();
                 }
             }
         }
     }
-    *numBytes = bytesRead;
     return err;
 }
 
@@ -395,9 +475,15 @@ void TrcMemAccCache::invalidateAll()
     logMsg(oss.str());
 #endif
 
+    m_stats.inval_all++;
     for (int i = 0; i < m_mru_num_pages; i++)
+    {
+        if (m_mru[i].valid_len)
+            m_stats.inval_pages++;
         clearPage(&m_mru[i]);
+    }
     m_mru_idx = 0;
+    m_run_idx = -1;
 }
 
 void TrcMemAccCache::invalidateByTraceID(int8_t trcID)
@@ -408,19 +494,22 @@ void TrcMemAccCache::invalidateByTraceID(int8_t trcID)
     logMsg(oss.str());
 #endif
 
+    m_stats.inval_trace_id++;
     for (int i = 0; i < m_mru_num_pages; i++)
     {
-        if (m_mru[i].trcID == trcID)
+        if (m_mru[i].tag.trcID == trcID)
         {
+            m_stats.inval_pages++;
 #ifdef LOG_CACHE_OPS
             oss.str("");
-            oss << "TrcMemAccCache:: ALI-invalidate page {page: " << std::dec << i << "; seq: " << m_mru[i].use_sequence << " CSID: " << std::hex << (int)m_mru[i].trcID;
+            oss << "TrcMemAccCache:: ALI-invalidate page {page: " << std::dec << i << "; seq: " << m_mru[i].use_sequence << " CSID: " << std::hex << (int)m_mru[i].tag.trcID;
             oss << "} [addr:0x" << std::hex << m_mru[i].st_addr << ", bytes: " << std::dec << m_mru[i].valid_len << "]\n";
             logMsg(oss.str());
 #endif
             clearPage(&m_mru[i]);
         }
     }
+    m_run_idx = -1;
 }
 
 void TrcMemAccCache::logMsg(const std::string &szMsg, ocsd_err_t err /*= OCSD_OK */ )
@@ -442,24 +531,60 @@ void TrcMemAccCache::setErrorLog(ITraceErrorLog *log)
     m_err_log = log;
 }
 
-void TrcMemAccCache::logAndClearCounts()
+void TrcMemAccCache::logStats()
 {
 #ifdef LOG_CACHE_STATS
     std::ostringstream oss;
 
     oss << "TrcMemAccCache:: cache performance: Page Size: 0x" << std::hex << m_mru_page_size << "; Number of Pages: " << std::dec << m_mru_num_pages << "\n";
-    oss << "Cache hits(" << std::dec << m_hits << "), misses(" << m_misses << "), new pages(" << m_pages << ")\n";
+    oss << "Cache hits(" << std::dec << m_stats.cache_hits << "), misses(" << m_stats.cache_misses << "), new pages(" << m_stats.page_loads << "), evictions(" << m_stats.page_evictions << ")\n";
+    oss << "Hit runs(" << m_stats.hit_runs << "), max run length(" << m_stats.hit_run_max << ")\n";
     logMsg(oss.str());
-    for (int i = 0; i < m_mru_num_pages; i++)
+#endif
+}
+
+void TrcMemAccCache::addStats(ocsd_mem_acc_stats_t &total) const
+{
+    total.cache_hits += m_stats.cache_hits;
+    total.cache_misses += m_stats.cache_misses;
+    total.page_loads += m_stats.page_loads;
+    total.page_evictions += m_stats.page_evictions;
+    total.hit_runs += m_stats.hit_runs;
+    if (total.hit_run_max < m_stats.hit_run_max)
+        total.hit_run_max = m_stats.hit_run_max;
+    total.inval_trace_id += m_stats.inval_trace_id;
+    total.inval_all += m_stats.inval_all;
+    total.inval_pages += m_stats.inval_pages;
+    total.acc_reads += m_stats.acc_reads;
+    total.acc_bytes_file += m_stats.acc_bytes_file;
+    total.acc_bytes_buffer += m_stats.acc_bytes_buffer;
+    total.acc_bytes_cb += m_stats.acc_bytes_cb;
+}
+
+void TrcMemAccCache::initStats(ocsd_mem_acc_stats_t &stats)
+{
+    memset(&stats, 0, sizeof(ocsd_mem_acc_stats_t));
+    stats.version = OCSD_VER_NUM;
+    stats.revision = OCSD_MEM_ACC_STATS_REVISION;
+}
+
+void TrcMemAccCache::resetStats()
+{
+    initStats(m_stats);
+    m_run_idx = -1;
+    m_run_len = 0;
+}
+
+void TrcMemAccCache::countAccRead(const TrcMemAccessorBase *p_accessor, const uint32_t bytes)
+{
+    m_stats.acc_reads++;
+    switch (p_accessor->getType())
     {
-        if (m_hit_rl_max[i] < m_hit_rl[i])
-            m_hit_rl_max[i] = m_hit_rl[i];
-        oss.str("");
-        oss << "Run length max page " << std::dec << i << ": " << m_hit_rl_max[i] << "\n";
-        logMsg(oss.str());
+    case TrcMemAccessorBase::MEMACC_FILE: m_stats.acc_bytes_file += bytes; break;
+    case TrcMemAccessorBase::MEMACC_BUFPTR: m_stats.acc_bytes_buffer += bytes; break;
+    case TrcMemAccessorBase::MEMACC_CB_IF: m_stats.acc_bytes_cb += bytes; break;
+    default: break;
     }
-    m_hits = m_misses = m_pages = 0;
-#endif
 }
 
 /* End of File trc_mem_acc_cache.cpp */
@@ -5,6 +5,7 @@
  * \copyright  Copyright (c) 2015, ARM Limited. All Rights Reserved.
  */
 
+#include <cstring>
 #include "mem_acc/trc_mem_acc_cb.h"
 
 TrcMemAccCB::TrcMemAccCB(const ocsd_vaddr_t s_address, 
@@ -13,7 +14,16 @@ TrcMemAccCB::TrcMemAccCB(const ocsd_vaddr_t s_address,
     TrcMemAccessorBase(MEMACC_CB_IF, s_address, e_address),
     m_p_CBclass(0),
     m_p_CBfn(0),
-    m_p_cbfn_context(0)
+    m_p_CBIDfn(0),
+    m_p_cbfn_context(0),
+    m_num_callbacks(0),
+    m_ra_min(0),
+    m_ra_max(0),
+    m_ra_block(0),
+    m_ra_addr(0),
+    m_ra_len(0),
+    m_ra_space(OCSD_MEM_SPACE_NONE),
+    m_ra_trcID(0)
 {
     setMemSpace(mem_space);    
 }
@@ -22,18 +32,60 @@ TrcMemAccCB::TrcMemAccCB() :
     TrcMemAccessorBase(MEMACC_CB_IF),
     m_p_CBclass(0),
     m_p_CBfn(0),
-    m_p_cbfn_context(0)
+    m_p_CBIDfn(0),
+    m_p_cbfn_context(0),
+    m_num_callbacks(0),
+    m_ra_min(0),
+    m_ra_max(0),
+    m_ra_block(0),
+    m_ra_addr(0),
+    m_ra_len(0),
+    m_ra_space(OCSD_MEM_SPACE_NONE),
+    m_ra_trcID(0)
 {};
 
 void TrcMemAccCB::initAccessor(const ocsd_vaddr_t s_address, const ocsd_vaddr_t e_address, const ocsd_mem_space_acc_t mem_space)
 {
     setRange(s_address, e_address);
     setMemSpace(mem_space);
+    m_ra_len = 0;
+}
+
+ocsd_err_t TrcMemAccCB::setReadAhead(const uint32_t min_block, const uint32_t max_block)
+{
+    if (!readAheadSizesValid(min_block, max_block))
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    if (max_block == 0)
+    {
+        m_ra_max = m_ra_min = m_ra_block = 0;
+        m_ra_len = 0;
+        m_ra_buf.clear();
+        return OCSD_OK;
+    }
+
+    m_ra_min = m_ra_block = min_block;
+    m_ra_max = max_block;
+    m_ra_len = 0;
+    m_ra_buf.resize(m_ra_max);
+    return OCSD_OK;
 }
 
 /** Memory access override - allow decoder to read bytes from the buffer. */
 const uint32_t TrcMemAccCB::readBytes(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t memSpace, const uint8_t trcID, const uint32_t reqBytes, uint8_t *byteBuffer)
 {
+    std::lock_guard<std::mutex> lock(m_cb_lock);
+
+    // read-ahead for requests smaller than the read-ahead block
+    if (reqBytes < m_ra_max)
+        return readAhead(address, memSpace, trcID, reqBytes, byteBuffer);
+    return callClient(address, memSpace, trcID, reqBytes, byteBuffer);
+}
+
+const uint32_t TrcMemAccCB::callClient(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t memSpace, const uint8_t trcID, const uint32_t reqBytes, uint8_t *byteBuffer)
+{
+    m_num_callbacks++;
+
     // if we have a callback object, use it to call back.
     if(m_p_CBclass)
         return m_p_CBclass->readBytes(address,memSpace,reqBytes,byteBuffer);
@@ -44,4 +96,46 @@ const uint32_t TrcMemAccCB::readBytes(const ocsd_vaddr_t address, const ocsd_mem
     return 0;
 }
 
+const uint32_t TrcMemAccCB::readAhead(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t memSpace, const uint8_t trcID, const uint32_t reqBytes, uint8_t *byteBuffer)
+{
+    const bool buffer_match = (m_ra_len > 0) && (m_ra_trcID == trcID) && (m_ra_space == memSpace) && (address >= m_ra_addr);
+    uint32_t read_len;
+
+    // data already buffered
+    if (buffer_match && ((address - m_ra_addr + reqBytes) <= m_ra_len))
+    {
+        memcpy(byteBuffer, &m_ra_buf[(size_t)(address - m_ra_addr)], reqBytes);
+        return reqBytes;
+    }
+
+    // grow the block while reads follow on from the buffered data, otherwise back to the minimum.
+    if (buffer_match && ((address - m_ra_addr) < ((ocsd_vaddr_t)m_ra_len + m_ra_block)))
+    {
+        m_ra_block *= 2;
+        if (m_ra_block > m_ra_max)
+            m_ra_block = m_ra_max;
+    }
+    else
+        m_ra_block = m_ra_min;
+
+    // read a block, limited to the accessor range
+    read_len = bytesInRange(address, (reqBytes > m_ra_block) ? reqBytes : m_ra_block);
+    m_ra_len = callClient(address, memSpace, trcID, read_len, m_ra_buf.data());
+
+    // bad client return - pass back to caller to handle.
+    if (m_ra_len > read_len)
+    {
+        read_len = m_ra_len;
+        m_ra_len = 0;
+        return read_len;
+    }
+
+    m_ra_addr = address;
+    m_ra_space = memSpace;
+    m_ra_trcID = trcID;
+    read_len = (m_ra_len < reqBytes) ? m_ra_len : reqBytes;
+    memcpy(byteBuffer, m_ra_buf.data(), read_len);
+    return read_len;
+}
+
 /* End of File trc_mem_acc_cb.cpp */
@@ -0,0 +1,375 @@
+/*!
+* \file       trc_mem_acc_code_map.cpp
+* \brief      OpenCSD : Pre-decoded waypoint map of a memory image.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "mem_acc/trc_mem_acc_code_map.h"
+#include "mem_acc/trc_mem_acc_base.h"
+#include "i_dec/trc_i_decode.h"
+
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// block size for reading the image when scanning or hashing.
+#define CODE_MAP_READ_BLOCK 0x10000
+
+// FNV-1a 64 bit hash
+#define CODE_MAP_HASH_INIT  0xcbf29ce484222325ULL
+#define CODE_MAP_HASH_PRIME 0x00000100000001b3ULL
+
+static uint64_t hashBytes(uint64_t hash, const uint8_t *p_data, const uint32_t num_bytes)
+{
+    for (uint32_t i = 0; i < num_bytes; i++)
+    {
+        hash ^= p_data[i];
+        hash *= CODE_MAP_HASH_PRIME;
+    }
+    return hash;
+}
+
+static bool wpOffsetLess(const code_map_wp_t &wp, const uint32_t offset)
+{
+    return wp.offset < offset;
+}
+
+TrcMemAccCodeMap::TrcMemAccCodeMap() :
+    m_p_wp(0),
+    m_p_map_base(0),
+    m_map_size(0),
+    m_map_handle(0)
+{
+    clear();
+}
+
+TrcMemAccCodeMap::~TrcMemAccCodeMap()
+{
+    clear();
+}
+
+void TrcMemAccCodeMap::clear()
+{
+    if (m_p_map_base)
+    {
+#ifdef WIN32
+        UnmapViewOfFile((LPCVOID)m_p_map_base);
+        CloseHandle((HANDLE)m_map_handle);
+#else
+        munmap((void *)m_p_map_base, m_map_size);
+#endif
+    }
+    m_p_map_base = 0;
+    m_map_size = 0;
+    m_map_handle = 0;
+
+    memset(&m_hdr, 0, sizeof(m_hdr));
+    m_p_wp = 0;
+    m_wp_buf.clear();
+}
+
+ocsd_err_t TrcMemAccCodeMap::buildMap(TrcMemAccessorBase *p_accessor, const ocsd_vaddr_t st_addr, const ocsd_vaddr_t en_addr,
+                                      const ocsd_isa isa, const ocsd_arch_profile_t &pe_type, const uint8_t dcd_flags,
+                                      const std::string &image_path)
+{
+    TrcIDecode idecode;
+    ocsd_instr_info instr_info;
+    std::vector<uint8_t> block(CODE_MAP_READ_BLOCK);
+    code_map_wp_t wp;
+    uint64_t hash = CODE_MAP_HASH_INIT;
+    ocsd_vaddr_t addr = st_addr;
+    uint32_t req_bytes, read_bytes;
+
+    if (!p_accessor || ((isa != ocsd_isa_aarch64) && (isa != ocsd_isa_arm)))
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    // whole instructions only
+    if ((st_addr & 0x3) || ((en_addr + 1) & 0x3) || (en_addr <= st_addr) || ((en_addr - st_addr) > 0xFFFFFFFF))
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    if (image_path.size() >= OCSD_CODE_MAP_PATH_LEN)
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    clear();
+
+    // invalid AA64 opcodes become stop entries, so decoders walk to the error themselves.
+    idecode.setAA64_errOnBadOpcode(true);
+
+    memset(&instr_info, 0, sizeof(instr_info));
+    instr_info.pe_type = pe_type;
+    instr_info.isa = isa;
+    instr_info.dsb_dmb_waypoints = (dcd_flags & OCSD_CODE_MAP_DSB_DMB_WP) ? 1 : 0;
+    instr_info.wfi_wfe_branch = (dcd_flags & OCSD_CODE_MAP_WFI_WFE_BR) ? 1 : 0;
+
+    while (addr <= en_addr)
+    {
+        req_bytes = ((en_addr - addr) >= CODE_MAP_READ_BLOCK) ? CODE_MAP_READ_BLOCK : (uint32_t)(en_addr - addr + 1);
+        read_bytes = p_accessor->readBytes(addr, p_accessor->getMemSpace(), 0, req_bytes, block.data());
+        if (read_bytes != req_bytes)
+        {
+            clear();
+            return OCSD_ERR_MEM_NACC;
+        }
+        hash = hashBytes(hash, block.data(), read_bytes);
+
+        for (uint32_t offset = 0; offset < read_bytes; offset += 4)
+        {
+            instr_info.instr_addr = addr + offset;
+            memcpy(&instr_info.opcode, &block[offset], sizeof(uint32_t));
+            if (idecode.DecodeInstruction(&instr_info) != OCSD_OK)
+                wp.type = OCSD_CODE_MAP_WP_STOP;
+            else if (instr_info.type != OCSD_INSTR_OTHER)
+                wp.type = (uint8_t)instr_info.type;
+            else
+                continue;
+
+            wp.offset = (uint32_t)(instr_info.instr_addr - st_addr);
+            wp.branch_offset = (instr_info.type == OCSD_INSTR_BR) ? (int32_t)(instr_info.branch_addr - instr_info.instr_addr) : 0;
+            wp.opcode = instr_info.opcode;
+            wp.sub_type = (uint8_t)instr_info.sub_type;
+            wp.flags = (instr_info.is_link ? OCSD_CODE_MAP_WP_LINK : 0) |
+                       (instr_info.is_conditional ? OCSD_CODE_MAP_WP_COND : 0) |
+                       ((instr_info.next_isa == ocsd_isa_thumb2) ? OCSD_CODE_MAP_WP_TO_THUMB : 0);
+            wp.size = instr_info.instr_size;
+            m_wp_buf.push_back(wp);
+        }
+        addr += read_bytes;
+    }
+
+    m_hdr.magic = OCSD_CODE_MAP_MAGIC;
+    m_hdr.version = OCSD_CODE_MAP_VERSION;
+    m_hdr.hdr_size = sizeof(code_map_hdr_t);
+    m_hdr.content_hash = hash;
+    m_hdr.st_addr = st_addr;
+    m_hdr.en_addr = en_addr;
+    m_hdr.num_wp = (uint32_t)m_wp_buf.size();
+    m_hdr.arch_version = (uint16_t)pe_type.arch;
+    m_hdr.profile = (uint8_t)pe_type.profile;
+    m_hdr.isa = (uint8_t)isa;
+    m_hdr.dcd_flags = dcd_flags & (OCSD_CODE_MAP_DSB_DMB_WP | OCSD_CODE_MAP_WFI_WFE_BR);
+    strncpy(m_hdr.image_path, image_path.c_str(), OCSD_CODE_MAP_PATH_LEN - 1);
+    m_p_wp = m_wp_buf.data();
+    return OCSD_OK;
+}
+
+ocsd_err_t TrcMemAccCodeMap::saveMap(const std::string &map_path) const
+{
+    if (m_hdr.magic != OCSD_CODE_MAP_MAGIC)
+        return OCSD_ERR_NOT_INIT;
+
+    std::ofstream map_file(map_path.c_str(), std::ofstream::binary | std::ofstream::trunc);
+    if (!map_file.is_open())
+        return OCSD_ERR_FILE_ERROR;
+
+    map_file.write((const char *)&m_hdr, sizeof(code_map_hdr_t));
+    if (m_hdr.num_wp)
+        map_file.write((const char *)m_p_wp, sizeof(code_map_wp_t) * m_hdr.num_wp);
+    map_file.close();
+    return map_file.fail() ? OCSD_ERR_FILE_ERROR : OCSD_OK;
+}
+
+ocsd_err_t TrcMemAccCodeMap::loadMap(const std::string &map_path)
+{
+    const uint8_t *p_base = 0;
+    size_t file_size = 0;
+    std::vector<uint8_t> file_buf;
+
+    clear();
+
+    // map the sidecar file - the waypoint array is used in place.
+#ifdef WIN32
+    LARGE_INTEGER size_li;
+    HANDLE h_map = 0;
+    HANDLE h_file = CreateFileA(map_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h_file == INVALID_HANDLE_VALUE)
+        return OCSD_ERR_FILE_ERROR;
+    if (GetFileSizeEx(h_file, &size_li) && (size_li.QuadPart > 0))
+    {
+        h_map = CreateFileMappingA(h_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (h_map)
+        {
+            p_base = (const uint8_t *)MapViewOfFile(h_map, FILE_MAP_READ, 0, 0, 0);
+            if (!p_base)
+            {
+                CloseHandle(h_map);
+                h_map = 0;
+            }
+        }
+        file_size = (size_t)size_li.QuadPart;
+    }
+    CloseHandle(h_file);
+    m_map_handle = (void *)h_map;
+#else
+    struct stat file_stat;
+    int fd = open(map_path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return OCSD_ERR_FILE_ERROR;
+    if ((fstat(fd, &file_stat) == 0) && (file_stat.st_size > 0))
+    {
+        void *p_map = mmap(0, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p_map != MAP_FAILED)
+            p_base = (const uint8_t *)p_map;
+        file_size = (size_t)file_stat.st_size;
+    }
+    close(fd);
+#endif
+
+    if (p_base)
+    {
+        m_p_map_base = p_base;
+        m_map_size = file_size;
+    }
+    else
+    {
+        // mapping unavailable - read the file.
+        std::ifstream map_file(map_path.c_str(), std::ifstream::binary | std::ifstream::ate);
+        if (!map_file.is_open())
+            return OCSD_ERR_FILE_ERROR;
+        file_size = (size_t)map_file.tellg();
+        file_buf.resize(file_size);
+        map_file.seekg(0, map_file.beg);
+        if (file_size)
+            map_file.read((char *)file_buf.data(), file_size);
+        if (map_file.fail())
+            return OCSD_ERR_FILE_ERROR;
+        p_base = file_buf.data();
+    }
+
+    // validate the header and size
+    if (file_size >= sizeof(code_map_hdr_t))
+        memcpy(&m_hdr, p_base, sizeof(code_map_hdr_t));
+    if ((file_size < sizeof(code_map_hdr_t)) ||
+        (m_hdr.magic != OCSD_CODE_MAP_MAGIC) ||
+        (m_hdr.version != OCSD_CODE_MAP_VERSION) ||
+        (m_hdr.hdr_size != sizeof(code_map_hdr_t)) ||
+        (file_size != (sizeof(code_map_hdr_t) + (size_t)m_hdr.num_wp * sizeof(code_map_wp_t))) ||
+        ((m_hdr.isa != ocsd_isa_aarch64) && (m_hdr.isa != ocsd_isa_arm)) ||
+        (m_hdr.en_addr <= m_hdr.st_addr) ||
+        ((m_hdr.en_addr - m_hdr.st_addr) > 0xFFFFFFFF) ||
+        (m_hdr.image_path[OCSD_CODE_MAP_PATH_LEN - 1] != 0))
+    {
+        clear();
+        return OCSD_ERR_MEM_ACC_CODE_MAP;
+    }
+
+    if (m_p_map_base)
+        m_p_wp = (const code_map_wp_t *)(m_p_map_base + sizeof(code_map_hdr_t));
+    else
+    {
+        m_wp_buf.resize(m_hdr.num_wp);
+        if (m_hdr.num_wp)
+            memcpy(m_wp_buf.data(), p_base + sizeof(code_map_hdr_t), (size_t)m_hdr.num_wp * sizeof(code_map_wp_t));
+        m_p_wp = m_wp_buf.data();
+    }
+    return OCSD_OK;
+}
+
+ocsd_err_t TrcMemAccCodeMap::hashImage(TrcMemAccessorBase *p_accessor, uint64_t &hash) const
+{
+    std::vector<uint8_t> block(CODE_MAP_READ_BLOCK);
+    ocsd_vaddr_t addr = (ocsd_vaddr_t)m_hdr.st_addr;
+    const ocsd_vaddr_t en_addr = (ocsd_vaddr_t)m_hdr.en_addr;
+    uint32_t req_bytes, read_bytes;
+
+    hash = CODE_MAP_HASH_INIT;
+    while (addr <= en_addr)
+    {
+        req_bytes = ((en_addr - addr) >= CODE_MAP_READ_BLOCK) ? CODE_MAP_READ_BLOCK : (uint32_t)(en_addr - addr + 1);
+        read_bytes = p_accessor->readBytes(addr, p_accessor->getMemSpace(), 0, req_bytes, block.data());
+        if (read_bytes != req_bytes)
+            return OCSD_ERR_MEM_NACC;
+        hash = hashBytes(hash, block.data(), read_bytes);
+        addr += read_bytes;
+    }
+    return OCSD_OK;
+}
+
+ocsd_err_t TrcMemAccCodeMap::checkImage(TrcMemAccessorBase *p_accessor) const
+{
+    uint64_t hash;
+    ocsd_err_t err;
+
+    if (m_hdr.magic != OCSD_CODE_MAP_MAGIC)
+        return OCSD_ERR_NOT_INIT;
+
+    err = hashImage(p_accessor, hash);
+    if ((err == OCSD_OK) && (hash != m_hdr.content_hash))
+        err = OCSD_ERR_MEM_ACC_CODE_MAP;
+    return err;
+}
+
+bool TrcMemAccCodeMap::findWaypoint(ocsd_instr_info *instr_info, uint32_t *num_instr) const
+{
+    const ocsd_vaddr_t addr = instr_info->instr_addr;
+    const uint8_t dcd_flags = (instr_info->dsb_dmb_waypoints ? OCSD_CODE_MAP_DSB_DMB_WP : 0) |
+                              (instr_info->wfi_wfe_branch ? OCSD_CODE_MAP_WFI_WFE_BR : 0);
+
+    if (!m_p_wp ||
+        ((uint8_t)instr_info->isa != m_hdr.isa) ||
+        ((uint16_t)instr_info->pe_type.arch != m_hdr.arch_version) ||
+        ((uint8_t)instr_info->pe_type.profile != m_hdr.profile) ||
+        (dcd_flags != m_hdr.dcd_flags) ||
+        (addr < m_hdr.st_addr) || (addr > m_hdr.en_addr) || (addr & 0x3))
+        return false;
+
+    const code_map_wp_t *p_end = m_p_wp + m_hdr.num_wp;
+    const code_map_wp_t *p_wp = std::lower_bound(m_p_wp, p_end, (uint32_t)(addr - m_hdr.st_addr), wpOffsetLess);
+    if ((p_wp == p_end) || (p_wp->type == OCSD_CODE_MAP_WP_STOP))
+        return false;
+
+    const ocsd_vaddr_t wp_addr = (ocsd_vaddr_t)m_hdr.st_addr + p_wp->offset;
+
+    // decoder outputs as left by walking to the waypoint.
+    instr_info->opcode = p_wp->opcode;
+    instr_info->type = (ocsd_instr_type)p_wp->type;
+    instr_info->sub_type = (ocsd_instr_subtype)p_wp->sub_type;
+    if (instr_info->type == OCSD_INSTR_BR)
+        instr_info->branch_addr = wp_addr + (ocsd_vaddr_t)(int64_t)p_wp->branch_offset;
+    instr_info->next_isa = (p_wp->flags & OCSD_CODE_MAP_WP_TO_THUMB) ? ocsd_isa_thumb2 : instr_info->isa;
+    instr_info->instr_size = p_wp->size;
+    instr_info->is_link = (p_wp->flags & OCSD_CODE_MAP_WP_LINK) ? 1 : 0;
+    instr_info->is_conditional = (p_wp->flags & OCSD_CODE_MAP_WP_COND) ? 1 : 0;
+    instr_info->thumb_it_conditions = 0;
+    instr_info->instr_addr = wp_addr + p_wp->size;
+    *num_instr = (uint32_t)((wp_addr - addr) >> 2) + 1;
+    return true;
+}
+
+/* End of File trc_mem_acc_code_map.cpp */
@@ -36,6 +36,16 @@
 #include <sstream>
 #include <iomanip>
 #include <new>
+#include <cstring>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 /***************************************************/
 /* protected construction and reference counting   */
@@ -47,10 +57,14 @@ TrcMemAccessorFile::TrcMemAccessorFile() : TrcMemAccessorBase(MEMACC_FILE)
     m_base_range_set = false;
     m_has_access_regions = false;
     m_file_size = 0;
+    m_p_map_base = 0;
+    m_map_size = 0;
+    m_map_handle = 0;
 }
 
 TrcMemAccessorFile::~TrcMemAccessorFile()
 {
+    unmapFile();
     if(m_mem_file.is_open())
         m_mem_file.close();
     if(m_access_regions.size())
@@ -66,16 +80,29 @@ TrcMemAccessorFile::~TrcMemAccessorFile()
     }
 }
 
-ocsd_err_t TrcMemAccessorFile::initAccessor(const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset, size_t size)
+ocsd_err_t TrcMemAccessorFile::initAccessor(const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset, size_t size, const uint32_t file_acc_opts)
 {
     ocsd_err_t err = OCSD_OK;
     bool init = false;
+    bool file_ok = false;
 
-    m_mem_file.open(pathToFile.c_str(), std::ifstream::binary | std::ifstream::ate);
-    if(m_mem_file.is_open())
+    // try to map if requested - drop back to file stream if this fails.
+    if (file_acc_opts & OCSD_FILE_MEM_ACC_OPT_MMAP)
+        file_ok = mapFile(pathToFile);
+
+    if (!file_ok)
+    {
+        m_mem_file.open(pathToFile.c_str(), std::ifstream::binary | std::ifstream::ate);
+        if(m_mem_file.is_open())
+        {
+            m_file_size = (ocsd_vaddr_t)m_mem_file.tellg() & ((ocsd_vaddr_t)~0x1);
+            m_mem_file.seekg(0, m_mem_file.beg);
+            file_ok = true;
+        }
+    }
+
+    if(file_ok)
     {
-        m_file_size = (ocsd_vaddr_t)m_mem_file.tellg() & ((ocsd_vaddr_t)~0x1);
-        m_mem_file.seekg(0, m_mem_file.beg);
         // adding an offset of 0, sets the base range.
         if((offset == 0) && (size == 0))
         {
@@ -96,6 +123,89 @@ ocsd_err_t TrcMemAccessorFile::initAccessor(const std::string &pathToFile, ocsd_
 }
 
 
+#ifdef WIN32
+bool TrcMemAccessorFile::mapFile(const std::string &pathToFile)
+{
+    LARGE_INTEGER file_size;
+    HANDLE h_map = 0;
+    const uint8_t *p_base = 0;
+
+    HANDLE h_file = CreateFileA(pathToFile.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    if (GetFileSizeEx(h_file, &file_size) && (file_size.QuadPart > 0))
+    {
+        h_map = CreateFileMappingA(h_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (h_map)
+        {
+            p_base = (const uint8_t *)MapViewOfFile(h_map, FILE_MAP_READ, 0, 0, 0);
+            if (!p_base)
+            {
+                CloseHandle(h_map);
+                h_map = 0;
+            }
+        }
+    }
+    // the mapping holds its own reference to the file.
+    CloseHandle(h_file);
+
+    if (!p_base)
+        return false;
+
+    m_p_map_base = p_base;
+    m_map_handle = (void *)h_map;
+    m_map_size = (size_t)file_size.QuadPart;
+    m_file_size = (ocsd_vaddr_t)m_map_size & ((ocsd_vaddr_t)~0x1);
+    return true;
+}
+
+void TrcMemAccessorFile::unmapFile()
+{
+    if (m_p_map_base)
+    {
+        UnmapViewOfFile((LPCVOID)m_p_map_base);
+        CloseHandle((HANDLE)m_map_handle);
+    }
+    m_p_map_base = 0;
+    m_map_handle = 0;
+    m_map_size = 0;
+}
+#else
+bool TrcMemAccessorFile::mapFile(const std::string &pathToFile)
+{
+    struct stat file_stat;
+    void *p_base = MAP_FAILED;
+
+    int fd = open(pathToFile.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    if ((fstat(fd, &file_stat) == 0) && (file_stat.st_size > 0))
+        p_base = mmap(0, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // mapping remains valid after the file is closed.
+    close(fd);
+
+    if (p_base == MAP_FAILED)
+        return false;
+
+    m_p_map_base = (const uint8_t *)p_base;
+    m_map_size = (size_t)file_stat.st_size;
+    m_file_size = (ocsd_vaddr_t)m_map_size & ((ocsd_vaddr_t)~0x1);
+    return true;
+}
+
+void TrcMemAccessorFile::unmapFile()
+{
+    if (m_p_map_base)
+        munmap((void *)m_p_map_base, m_map_size);
+    m_p_map_base = 0;
+    m_map_handle = 0;
+    m_map_size = 0;
+}
+#endif
+
 FileRegionMemAccessor *TrcMemAccessorFile::getRegionForAddress(const ocsd_vaddr_t startAddr) const
 {
     FileRegionMemAccessor *p_region = 0;
@@ -119,10 +229,12 @@ FileRegionMemAccessor *TrcMemAccessorFile::getRegionForAddress(const ocsd_vaddr_
 /***************************************************/
 
 std::map<std::string, TrcMemAccessorFile *> TrcMemAccessorFile::s_FileAccessorMap;
+std::mutex TrcMemAccessorFile::s_FileAccessorLock;
 
 // return existing or create new accessor
-ocsd_err_t TrcMemAccessorFile::createFileAccessor(TrcMemAccessorFile **p_acc, const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset /*= 0*/, size_t size /*= 0*/)
+ocsd_err_t TrcMemAccessorFile::createFileAccessor(TrcMemAccessorFile **p_acc, const std::string &pathToFile, ocsd_vaddr_t startAddr, size_t offset /*= 0*/, size_t size /*= 0*/, const uint32_t file_acc_opts /*= OCSD_FILE_MEM_ACC_OPT_NONE*/, const ocsd_mem_space_acc_t mem_space /*= OCSD_MEM_SPACE_ANY*/)
 {
+    std::lock_guard<std::mutex> lock(s_FileAccessorLock);
     ocsd_err_t err = OCSD_OK;
     TrcMemAccessorFile * acc = 0;
     std::map<std::string, TrcMemAccessorFile *>::iterator it = s_FileAccessorMap.find(pathToFile);
@@ -130,7 +242,11 @@ ocsd_err_t TrcMemAccessorFile::createFileAccessor(TrcMemAccessorFile **p_acc, co
     {
         acc = it->second;
         if(acc->addrStartOfRange(startAddr))
+        {
             acc->IncRefCount();
+            if(acc->getMemSpace() != mem_space)
+                acc->setMemSpace(mem_space);
+        }
         else
         {
             err = OCSD_ERR_MEM_ACC_FILE_DIFF_RANGE;
@@ -142,9 +258,10 @@ ocsd_err_t TrcMemAccessorFile::createFileAccessor(TrcMemAccessorFile **p_acc, co
         acc = new (std::nothrow) TrcMemAccessorFile();
         if(acc != 0)
         {
-            if((err = acc->initAccessor(pathToFile,startAddr, offset,size)) == OCSD_OK)
+            if((err = acc->initAccessor(pathToFile,startAddr, offset,size, file_acc_opts)) == OCSD_OK)
             {
                 acc->IncRefCount();
+                acc->setMemSpace(mem_space);
                 s_FileAccessorMap.insert(std::pair<std::string, TrcMemAccessorFile *>(pathToFile,acc));
             }
             else
@@ -162,6 +279,7 @@ ocsd_err_t TrcMemAccessorFile::createFileAccessor(TrcMemAccessorFile **p_acc, co
 
 void TrcMemAccessorFile::destroyFileAccessor(TrcMemAccessorFile *p_accessor)
 {
+    std::lock_guard<std::mutex> lock(s_FileAccessorLock);
     if(p_accessor != 0)
     {
         p_accessor->DecRefCount();
@@ -179,6 +297,7 @@ void TrcMemAccessorFile::destroyFileAccessor(TrcMemAccessorFile *p_accessor)
 
 const bool TrcMemAccessorFile::isExistingFileAccessor(const std::string &pathToFile)
 {
+    std::lock_guard<std::mutex> lock(s_FileAccessorLock);
     bool bExists = false;
     std::map<std::string, TrcMemAccessorFile *>::const_iterator it = s_FileAccessorMap.find(pathToFile);
     if(it != s_FileAccessorMap.end())
@@ -188,6 +307,7 @@ const bool TrcMemAccessorFile::isExistingFileAccessor(const std::string &pathToF
 
 TrcMemAccessorFile * TrcMemAccessorFile::getExistingFileAccessor(const std::string &pathToFile)
 {
+    std::lock_guard<std::mutex> lock(s_FileAccessorLock);
     TrcMemAccessorFile * p_acc = 0;
     std::map<std::string, TrcMemAccessorFile *>::iterator it = s_FileAccessorMap.find(pathToFile);
     if(it != s_FileAccessorMap.end())
@@ -200,44 +320,89 @@ TrcMemAccessorFile * TrcMemAccessorFile::getExistingFileAccessor(const std::stri
 /***************************************************/
 /* accessor instance functions                     */
 /***************************************************/
-const uint32_t TrcMemAccessorFile::readBytes(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, const uint32_t reqBytes, uint8_t *byteBuffer)
+const uint32_t TrcMemAccessorFile::fileOffsetForAddress(const ocsd_vaddr_t address, const uint32_t reqBytes, size_t &file_offset) const
 {
-    if(!m_mem_file.is_open())
-        return 0;
-    uint32_t bytesRead = 0;
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
+    uint32_t bytesAvail = 0;
 
-    if(m_base_range_set)
+    // base class bytesInRange() uses the virtual addrInRange(), so check the base range alone first.
+    if(m_base_range_set && TrcMemAccessorBase::addrInRange(address))
+    {
+        bytesAvail = TrcMemAccessorBase::bytesInRange(address,reqBytes);    // get avialable bytes in range.
+        if(bytesAvail)
+            file_offset = (size_t)(address - m_startAddress);
+    }
+
+    if((bytesAvail == 0) && m_has_access_regions)
     {
-        bytesRead = TrcMemAccessorBase::bytesInRange(address,reqBytes);    // get avialable bytes in range.
-        if(bytesRead)
+        FileRegionMemAccessor *p_region = getRegionForAddress(address);
+        if(p_region)
         {
-            ocsd_vaddr_t addr_pos = (ocsd_vaddr_t)m_mem_file.tellg();
-            if((address - m_startAddress) != addr_pos)
-                m_mem_file.seekg(address - m_startAddress);
-            m_mem_file.read((char *)byteBuffer,bytesRead);
+            bytesAvail = p_region->bytesInRange(address,reqBytes);
+            file_offset = (size_t)(address - p_region->regionStartAddress() + p_region->getOffset());
         }
     }
 
-    if((bytesRead == 0) && m_has_access_regions)
+    // ranges are checked against the file size when added - never read beyond the file data.
+    if(bytesAvail)
+    {
+        const size_t data_size = m_p_map_base ? m_map_size : (size_t)m_file_size;
+        if(file_offset >= data_size)
+            bytesAvail = 0;
+        else if((data_size - file_offset) < bytesAvail)
+            bytesAvail = (uint32_t)(data_size - file_offset);
+    }
+    return bytesAvail;
+}
+
+const uint32_t TrcMemAccessorFile::readBytes(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, const uint32_t reqBytes, uint8_t *byteBuffer)
+{
+    size_t file_offset = 0;
+    uint32_t bytesRead = 0;
+
+    if(!m_p_map_base && !m_mem_file.is_open())
+        return 0;
+
+    bytesRead = fileOffsetForAddress(address, reqBytes, file_offset);
+    if(bytesRead)
     {
-        bytesRead = bytesInRange(address,reqBytes);
-        if(bytesRead)
+        if(m_p_map_base)
+            memcpy(byteBuffer, m_p_map_base + file_offset, bytesRead);
+        else
         {
-            FileRegionMemAccessor *p_region = getRegionForAddress(address);
+            std::lock_guard<std::recursive_mutex> lock(m_file_lock);
             ocsd_vaddr_t addr_pos = (ocsd_vaddr_t)m_mem_file.tellg();
-            if((address - p_region->regionStartAddress() + p_region->getOffset()) != addr_pos)
-                m_mem_file.seekg(address - p_region->regionStartAddress() + p_region->getOffset());
-             m_mem_file.read((char *)byteBuffer,bytesRead);
+            if(file_offset != addr_pos)
+                m_mem_file.seekg(file_offset);
+            m_mem_file.read((char *)byteBuffer,bytesRead);
         }
     }
     return bytesRead;
 }
 
+const uint8_t *TrcMemAccessorFile::readBytesPtr(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t trcID, uint32_t &availBytes)
+{
+    size_t file_offset = 0;
+
+    availBytes = 0;
+    if(!m_p_map_base)
+        return 0;
+
+    // all bytes to the end of the range containing the address, within the mapping
+    availBytes = fileOffsetForAddress(address, 0xFFFFFFFF, file_offset);
+    if(availBytes)
+        return m_p_map_base + file_offset;
+    return 0;
+}
+
 bool TrcMemAccessorFile::AddOffsetRange(const ocsd_vaddr_t startAddr, const size_t size, const size_t offset)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
     bool addOK = false;
     if(m_file_size == 0)    // must have set the file size
         return false;
+    if((size == 0) || (size > m_file_size) || (offset > (m_file_size - size)))  // must be within the file
+        return false;
     if(addrInRange(startAddr) || addrInRange(startAddr+size-1))  // cannot be overlapping
         return false;
 
@@ -253,34 +418,32 @@ bool TrcMemAccessorFile::AddOffsetRange(const ocsd_vaddr_t startAddr, const size
     }
     else
     {
-        if((offset + size) <= m_file_size)
+        FileRegionMemAccessor *frmacc = new (std::nothrow) FileRegionMemAccessor();
+        if(frmacc)
         {
-            FileRegionMemAccessor *frmacc = new (std::nothrow) FileRegionMemAccessor();
-            if(frmacc)
+            frmacc->setOffset(offset);
+            frmacc->setRange(startAddr,startAddr+size-1);
+            m_access_regions.push_back(frmacc);
+            m_access_regions.sort();
+            // may need to trim the 0 offset base range...
+            if(m_base_range_set)
             {
-                frmacc->setOffset(offset);
-                frmacc->setRange(startAddr,startAddr+size-1);
-                m_access_regions.push_back(frmacc);
-                m_access_regions.sort();
-                // may need to trim the 0 offset base range...
-                if(m_base_range_set)
-                {
-                    std::list<FileRegionMemAccessor *>::iterator it;
-                    it = m_access_regions.begin();
-                    size_t first_range_offset = (*it)->getOffset();
-                    if((m_startAddress + first_range_offset - 1) > m_endAddress)
-                        m_endAddress = m_startAddress + first_range_offset - 1;
-                }
-                addOK = true;
-                m_has_access_regions = true;
-            }        
-        }
+                std::list<FileRegionMemAccessor *>::iterator it;
+                it = m_access_regions.begin();
+                size_t first_range_offset = (*it)->getOffset();
+                if((m_startAddress + first_range_offset - 1) > m_endAddress)
+                    m_endAddress = m_startAddress + first_range_offset - 1;
+            }
+            addOK = true;
+            m_has_access_regions = true;
+        }        
     }
     return addOK;
 }
 
 const bool TrcMemAccessorFile::addrInRange(const ocsd_vaddr_t s_address) const
 {
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
     bool bInRange = false;
     if(m_base_range_set)
         bInRange = TrcMemAccessorBase::addrInRange(s_address);
@@ -295,6 +458,7 @@ const bool TrcMemAccessorFile::addrInRange(const ocsd_vaddr_t s_address) const
 
 const bool TrcMemAccessorFile::addrStartOfRange(const ocsd_vaddr_t s_address) const
 {
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
     bool bInRange = false;
     if(m_base_range_set)
         bInRange = TrcMemAccessorBase::addrStartOfRange(s_address);
@@ -311,6 +475,7 @@ const bool TrcMemAccessorFile::addrStartOfRange(const ocsd_vaddr_t s_address) co
     /* validate ranges */
 const bool TrcMemAccessorFile::validateRange()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
     bool bRangeValid = true;
     if(m_base_range_set)
         bRangeValid = TrcMemAccessorBase::validateRange();
@@ -330,14 +495,16 @@ const bool TrcMemAccessorFile::validateRange()
 
 const uint32_t TrcMemAccessorFile::bytesInRange(const ocsd_vaddr_t s_address, const uint32_t reqBytes) const
 {
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
     uint32_t bytesInRange = 0;
-    if(m_base_range_set)
+    if(m_base_range_set && TrcMemAccessorBase::addrInRange(s_address))
         bytesInRange = TrcMemAccessorBase::bytesInRange(s_address,reqBytes);
 
     if((bytesInRange == 0) && (m_has_access_regions))
     {
         FileRegionMemAccessor *p_region = getRegionForAddress(s_address);
-        bytesInRange = p_region->bytesInRange(s_address,reqBytes);
+        if(p_region)
+            bytesInRange = p_region->bytesInRange(s_address,reqBytes);
     }
 
     return bytesInRange;
@@ -345,6 +512,7 @@ const uint32_t TrcMemAccessorFile::bytesInRange(const ocsd_vaddr_t s_address, co
     
 const bool TrcMemAccessorFile::overLapRange(const TrcMemAccessorBase *p_test_acc) const
 {
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
     bool bOverLapRange = false;
     if(m_base_range_set)
         bOverLapRange = TrcMemAccessorBase::overLapRange(p_test_acc);
@@ -362,9 +530,43 @@ const bool TrcMemAccessorFile::overLapRange(const TrcMemAccessorBase *p_test_acc
     return bOverLapRange;
 }
 
+const int TrcMemAccessorFile::getNumRanges() const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
+    int num_ranges = (int)m_access_regions.size();
+    if(m_base_range_set)
+        num_ranges++;
+    return num_ranges;
+}
+
+const bool TrcMemAccessorFile::getRange(const int range_idx, ocsd_vaddr_t &startAddr, ocsd_vaddr_t &endAddr) const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
+    int region_idx = range_idx;
+
+    if(m_base_range_set)
+    {
+        if(range_idx == 0)
+            return TrcMemAccessorBase::getRange(0, startAddr, endAddr);
+        region_idx--;
+    }
+
+    std::list<FileRegionMemAccessor *>::const_iterator it;
+    it = m_access_regions.begin();
+    while(it != m_access_regions.end())
+    {
+        if(region_idx == 0)
+            return (*it)->getRange(0, startAddr, endAddr);
+        region_idx--;
+        it++;
+    }
+    return false;
+}
+
     /*! Override to handle ranges and offset accessors plus add in file name. */
 void TrcMemAccessorFile::getMemAccString(std::string &accStr) const
 {
+    std::lock_guard<std::recursive_mutex> lock(m_file_lock);
     std::ostringstream oss;
     accStr = "";
     if(m_base_range_set)
@@ -32,8 +32,15 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
  */ 
 
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <new>
+
 #include "mem_acc/trc_mem_acc_mapper.h"
 #include "mem_acc/trc_mem_acc_file.h"
+#include "mem_acc/trc_mem_acc_cb.h"
+#include "mem_acc/trc_mem_acc_code_map.h"
 #include "common/ocsd_error.h"
 
 /************************************************************************************/
@@ -44,16 +51,30 @@ TrcMemAccMapper::TrcMemAccMapper() :
     m_acc_curr(0),
     m_trace_id_curr(0),
     m_using_trace_id(false),
-    m_err_log(0)
+    m_err_log(0),
+    m_acc_generation(0),
+    m_num_code_maps(0)
 {
+    clearNaccCache(m_nacc);
+    m_nacc.unmapped_reads = 0;
+    m_nacc.unmapped_hits = 0;
+    for (int i = 0; i < MEM_ACC_CACHE_NUM_TRC_IDS; i++)
+        m_id_generation[i] = 0;
 }
 
 TrcMemAccMapper::TrcMemAccMapper(bool using_trace_id) : 
     m_acc_curr(0),
     m_trace_id_curr(0),
     m_using_trace_id(using_trace_id),
-    m_err_log(0)
+    m_err_log(0),
+    m_acc_generation(0),
+    m_num_code_maps(0)
 {
+    clearNaccCache(m_nacc);
+    m_nacc.unmapped_reads = 0;
+    m_nacc.unmapped_hits = 0;
+    for (int i = 0; i < MEM_ACC_CACHE_NUM_TRC_IDS; i++)
+        m_id_generation[i] = 0;
 }
 
 TrcMemAccMapper::~TrcMemAccMapper()
@@ -68,6 +89,7 @@ void TrcMemAccMapper::setErrorLog(ITraceErrorLog *err_log_i)
 
 ocsd_err_t TrcMemAccMapper::enableCaching(bool bEnable)
 {
+    m_acc_generation++;     // memory not tracked while caching off.
     return m_cache.enableCaching(bEnable);
 }
 
@@ -80,35 +102,26 @@ ocsd_err_t TrcMemAccMapper::setCacheSizes(uint16_t page_size, int num_pages, con
 // memory access interface
 ocsd_err_t TrcMemAccMapper::ReadTargetMemory(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space, uint32_t *num_bytes, uint8_t *p_buffer)
 {
-    bool bReadFromCurr = true;
     uint32_t readBytes = 0;
     ocsd_err_t err = OCSD_OK;
+    TrcMemAccCache &cache = getCache(cs_trace_id);
+    TrcMemAccessorBase *p_acc = selectAccessor(address, mem_space, cs_trace_id);
 
-    /* see if the address is in any range we know */
-    if (!readFromCurrent(address, mem_space, cs_trace_id))
-    {
-        bReadFromCurr = findAccessor(address, mem_space, cs_trace_id);
-
-        // found a new accessor - invalidate any cache entries used by the previous one.
-        if (m_cache.enabled() && bReadFromCurr)
-            m_cache.invalidateByTraceID(cs_trace_id); 
-    }
-
-    /* if bReadFromCurr then we know m_acc_curr is set */
-    if (bReadFromCurr)
+    if (p_acc)
     {
         // use cache if enabled and the amount fits into a cache page
-        if (m_cache.enabled_for_size(*num_bytes))
+        if (cache.enabled_for_size(*num_bytes))
         {
             // read from cache - or load a new cache page and read....
             readBytes = *num_bytes;
-            err = m_cache.readBytesFromCache(m_acc_curr, address, mem_space, cs_trace_id, &readBytes, p_buffer);
+            err = cache.readBytesFromCache(p_acc, address, mem_space, cs_trace_id, &readBytes, p_buffer);
             if (err != OCSD_OK)
                 LogWarn(err, "Mem Acc: Cache access error");
         }
         else
         {
-            readBytes = m_acc_curr->readBytes(address, mem_space, cs_trace_id, *num_bytes, p_buffer);
+            readBytes = p_acc->readBytes(address, mem_space, cs_trace_id, *num_bytes, p_buffer);
+            cache.countAccRead(p_acc, readBytes);
             // guard against bad accessor returns (e.g. callback not obeying the rules for return values)
             if (readBytes > *num_bytes)
             {
@@ -122,34 +135,268 @@ ocsd_err_t TrcMemAccMapper::ReadTargetMemory(const ocsd_vaddr_t address, const u
     return err;
 }
 
+ocsd_err_t TrcMemAccMapper::ReadTargetMemoryPtr(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space, uint32_t *num_bytes, const uint8_t **pp_data)
+{
+    TrcMemAccessorBase *p_acc = selectAccessor(address, mem_space, cs_trace_id);
+    if (!p_acc)
+    {
+        *num_bytes = 0;
+        *pp_data = 0;
+        return OCSD_OK;
+    }
+    return readPtrFromAccessor(p_acc, address, mem_space, cs_trace_id, num_bytes, pp_data);
+}
+
+ocsd_err_t TrcMemAccMapper::readPtrFromAccessor(TrcMemAccessorBase *p_acc, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id, uint32_t *num_bytes, const uint8_t **pp_data)
+{
+    uint32_t readBytes = 0;
+    const uint8_t *p_data = 0;
+    ocsd_err_t err = OCSD_OK;
+
+    // accessors backed by memory return a pointer directly
+    p_data = p_acc->readBytesPtr(address, mem_space, cs_trace_id, readBytes);
+
+    if (!p_data)
+    {
+        TrcMemAccCache &cache = getCache(cs_trace_id);
+
+        readBytes = *num_bytes;
+        if (cache.enabled_for_size(*num_bytes))
+        {
+            // point into a cache page - loading one from the accessor if necessary
+            err = cache.readPtrFromCache(p_acc, address, mem_space, cs_trace_id, &readBytes, &p_data);
+            if (err != OCSD_OK)
+                LogWarn(err, "Mem Acc: Cache access error");
+        }
+        else
+        {
+            // no cache - copy into a local buffer.
+            std::vector<uint8_t> &read_buf = getPtrReadBuf(cs_trace_id);
+            if (read_buf.size() < *num_bytes)
+                read_buf.resize(*num_bytes);
+            readBytes = p_acc->readBytes(address, mem_space, cs_trace_id, *num_bytes, read_buf.data());
+            cache.countAccRead(p_acc, readBytes);
+            if (readBytes > *num_bytes)
+            {
+                err = OCSD_ERR_MEM_ACC_BAD_LEN;
+                LogWarn(err, "Mem acc: bad return length");
+                readBytes = 0;
+            }
+            if (readBytes)
+                p_data = read_buf.data();
+        }
+    }
+
+    if (!p_data)
+        readBytes = 0;
+    *num_bytes = readBytes;
+    *pp_data = p_data;
+    return err;
+}
+
+TrcMemAccessorBase *TrcMemAccMapper::selectAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id)
+{
+    /* see if the address is in any range we know */
+    TrcMemAccessorBase *p_acc = readFromCurrent(address, mem_space, cs_trace_id);
+    if (!p_acc)
+    {
+        // recently missed - no need to search the accessors again.
+        if (inNaccCache(address, mem_space, cs_trace_id))
+            return 0;
+
+        // cache pages are tagged with the accessor that loaded them, so no need
+        // to invalidate entries used by the previous accessor.
+        p_acc = findAccessor(address, mem_space, cs_trace_id);
+        if (!p_acc)
+            addNaccRange(address, mem_space, cs_trace_id);
+    }
+    return p_acc;
+}
+
+bool TrcMemAccMapper::inNaccCache(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id)
+{
+    const uint8_t trcID = m_using_trace_id ? cs_trace_id : 0;
+    nacc_cache_t &nacc = getNaccCache(cs_trace_id);
+
+    for (int i = 0; i < MEMACC_MAP_NACC_CACHE_SIZE; i++)
+    {
+        // exact memory space match - a different space may match other accessors.
+        if ((nacc.ranges[i].mem_space == mem_space) &&
+            (nacc.ranges[i].trcID == trcID) &&
+            (address >= nacc.ranges[i].st_addr) &&
+            (address <= nacc.ranges[i].en_addr))
+        {
+            nacc.unmapped_reads++;
+            nacc.unmapped_hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TrcMemAccMapper::addNaccRange(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id)
+{
+    nacc_cache_t &nacc = getNaccCache(cs_trace_id);
+    nacc_range_t &range = nacc.ranges[nacc.next];
+
+    nacc.unmapped_reads++;
+    getUnmappedRange(address, cs_trace_id, range.st_addr, range.en_addr);
+    range.mem_space = mem_space;
+    range.trcID = m_using_trace_id ? cs_trace_id : 0;
+    nacc.next = (nacc.next + 1) % MEMACC_MAP_NACC_CACHE_SIZE;
+}
+
+void TrcMemAccMapper::invalidateNaccCache()
+{
+    clearNaccCache(m_nacc);
+}
+
+void TrcMemAccMapper::clearNaccCache(nacc_cache_t &nacc)
+{
+    for (int i = 0; i < MEMACC_MAP_NACC_CACHE_SIZE; i++)
+        nacc.ranges[i].mem_space = OCSD_MEM_SPACE_NONE;
+    nacc.next = 0;
+}
+
+void TrcMemAccMapper::accessorsChanged()
+{
+    TrcMemAccessorBase *p_acc = getFirstAccessor();
+
+    invalidateNaccCache();
+    m_acc_generation++;
+
+    // read-ahead may be set after the accessor is added, so keep all callback accessors.
+    m_cb_accs.clear();
+    while (p_acc)
+    {
+        if (p_acc->getType() == TrcMemAccessorBase::MEMACC_CB_IF)
+            m_cb_accs.push_back(static_cast<TrcMemAccCB *>(p_acc));
+        p_acc = getNextAccessor();
+    }
+}
+
 void TrcMemAccMapper::InvalidateMemAccCache(const uint8_t cs_trace_id)
 {    
-    if (m_cache.enabled())
-        m_cache.invalidateByTraceID(cs_trace_id);
+    TrcMemAccCache &cache = getCache(cs_trace_id);
+    if (cache.enabled())
+        cache.invalidateByTraceID(cs_trace_id);
+    invalidateReadAhead(cs_trace_id);
+    m_id_generation[cs_trace_id & (MEM_ACC_CACHE_NUM_TRC_IDS - 1)]++;
 }
 
-void TrcMemAccMapper::RemoveAllAccessors()
+ocsd_err_t TrcMemAccMapper::GetMemAccGeneration(const uint8_t cs_trace_id, uint32_t *p_generation)
 {
-    clearAccessorList();
-    if (m_cache.enabled()) 
+    // generation only tracks changes to cached memory - with caching off accessors may return different data at any time.
+    *p_generation = m_acc_generation + m_id_generation[cs_trace_id & (MEM_ACC_CACHE_NUM_TRC_IDS - 1)];
+    return getCache(cs_trace_id).enabled() ? OCSD_OK : OCSD_ERR_DCD_INTERFACE_UNUSED;
+}
+
+ocsd_err_t TrcMemAccMapper::FindCodeMapWaypoint(const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space, ocsd_instr_info *instr_info, uint32_t *num_instr)
+{
+    const TrcMemAccCodeMap *p_map;
+
+    if (!m_num_code_maps)
+        return OCSD_ERR_DCD_INTERFACE_UNUSED;
+
+    // walk reads stay with the current accessor while in range, so a map in that accessor covers the walk.
+    TrcMemAccessorBase *p_acc = selectAccessor(instr_info->instr_addr, mem_space, cs_trace_id);
+    if (!p_acc || !p_acc->hasCodeMaps())
+        return OCSD_ERR_MEM_NACC;
+
+    p_map = p_acc->getCodeMap(instr_info->instr_addr);
+    if (p_map && p_map->findWaypoint(instr_info, num_instr))
+        return OCSD_OK;
+    return OCSD_ERR_MEM_NACC;
+}
+
+ocsd_err_t TrcMemAccMapper::AddCodeMap(TrcMemAccCodeMap *p_map, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id /*= 0*/)
+{
+    TrcMemAccessorBase *p_acc;
+    ocsd_err_t err;
+
+    if (!p_map)
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    if ((p_acc = selectAccessor(p_map->getStartAddr(), mem_space, cs_trace_id)) == 0)
+        return OCSD_ERR_MEM_NACC;
+
+    err = p_acc->addCodeMap(p_map);
+    if (err == OCSD_OK)
+        m_num_code_maps++;
+    return err;
+}
+
+// called on every context change - only visits the callback accessors.
+void TrcMemAccMapper::invalidateReadAhead(const uint8_t cs_trace_id)
+{
+    for (size_t i = 0; i < m_cb_accs.size(); i++)
+        m_cb_accs[i]->invalidateReadAhead(cs_trace_id);
+}
+
+void TrcMemAccMapper::getMemAccStats(ocsd_mem_acc_stats_t &stats)
+{
+    TrcMemAccessorBase *p_acc = getFirstAccessor();
+
+    TrcMemAccCache::initStats(stats);
+    m_cache.addStats(stats);
+    stats.unmapped_reads = m_nacc.unmapped_reads;
+    stats.unmapped_hits = m_nacc.unmapped_hits;
+    while (p_acc)
+    {
+        if (p_acc->getType() == TrcMemAccessorBase::MEMACC_CB_IF)
+            stats.acc_callbacks += static_cast<TrcMemAccCB *>(p_acc)->getNumCallbacks();
+        p_acc = getNextAccessor();
+    }
+}
+
+void TrcMemAccMapper::resetMemAccStats()
+{
+    TrcMemAccessorBase *p_acc = getFirstAccessor();
+
+    m_cache.resetStats();
+    m_nacc.unmapped_reads = 0;
+    m_nacc.unmapped_hits = 0;
+    while (p_acc)
+    {
+        if (p_acc->getType() == TrcMemAccessorBase::MEMACC_CB_IF)
+            static_cast<TrcMemAccCB *>(p_acc)->resetNumCallbacks();
+        p_acc = getNextAccessor();
+    }
+}
+
+void TrcMemAccMapper::SetMemAccContext(const uint8_t cs_trace_id, const uint64_t ctxt_tag)
+{
+    TrcMemAccCache &cache = getCache(cs_trace_id);
+    if (cache.enabled())
+        cache.setContext(cs_trace_id, ctxt_tag);
+    invalidateReadAhead(cs_trace_id);
+}
+
+void TrcMemAccMapper::invalidateAllCaches()
+{
+    accessorsChanged();
+    if (m_cache.enabled())
     {
         m_cache.invalidateAll();
-        m_cache.logAndClearCounts();
+        m_cache.logStats();
     }
 }
 
+void TrcMemAccMapper::RemoveAllAccessors()
+{
+    clearAccessorList();
+    invalidateAllCaches();
+}
+
 ocsd_err_t TrcMemAccMapper::RemoveAccessorByAddress(const ocsd_vaddr_t st_address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id /* = 0 */)
 {
     ocsd_err_t err = OCSD_OK;
-    if(findAccessor(st_address,mem_space,cs_trace_id))
+    TrcMemAccessorBase *p_acc = findAccessorToRemove(st_address,mem_space,cs_trace_id);
+    if(p_acc)
     {
-        err = RemoveAccessor(m_acc_curr);
+        err = RemoveAccessor(p_acc);
         m_acc_curr = 0;
-        if (m_cache.enabled())
-        {
-            m_cache.invalidateAll();
-            m_cache.logAndClearCounts();
-        }
+        invalidateAllCaches();
     }
     else
         err = OCSD_ERR_INVALID_PARAM_VAL;        
@@ -172,70 +419,198 @@ void TrcMemAccMapper::LogWarn(const ocsd_err_t err, const std::string &msg)
 }
 
 /************************************************************************************/
-/* mappers global address space class - no differentiation in core trace IDs */
+/* sorted index of accessor address ranges */
 /************************************************************************************/
-TrcMemAccMapGlobalSpace::TrcMemAccMapGlobalSpace() : TrcMemAccMapper()
+static bool acc_range_entry_less(const acc_range_entry_t &lhs, const acc_range_entry_t &rhs)
 {
+    return lhs.st_addr < rhs.st_addr;
 }
 
-TrcMemAccMapGlobalSpace::~TrcMemAccMapGlobalSpace()
+static bool acc_range_addr_less(const ocsd_vaddr_t address, const acc_range_entry_t &entry)
 {
+    return address < entry.st_addr;
 }
 
-ocsd_err_t TrcMemAccMapGlobalSpace::AddAccessor(TrcMemAccessorBase *p_accessor, const uint8_t /*cs_trace_id*/)
+// add all the ranges for an accessor into the sorted index.
+void TrcMemAccRangeIndex::addAccessor(TrcMemAccessorBase *p_accessor)
 {
-    ocsd_err_t err = OCSD_OK;
-    bool bOverLap = false;
-
-    if(!p_accessor->validateRange())
-        return OCSD_ERR_MEM_ACC_RANGE_INVALID;
+    acc_range_entry_t entry;
+    size_t lowest_idx = m_index.size();
+    std::vector<acc_range_entry_t>::iterator it;
 
-    std::vector<TrcMemAccessorBase *>::const_iterator it =  m_acc_global.begin();
-    while((it != m_acc_global.end()) && !bOverLap)
+    entry.p_acc = p_accessor;
+    entry.add_seq = m_add_seq++;
+    for (int i = 0; i < p_accessor->getNumRanges(); i++)
     {
-        // if overlap and memory space match
-        if( ((*it)->overLapRange(p_accessor)) &&
-            ((*it)->inMemSpace(p_accessor->getMemSpace()))
-            )
+        if (p_accessor->getRange(i, entry.st_addr, entry.en_addr))
         {
-            bOverLap = true;
-            err = OCSD_ERR_MEM_ACC_OVERLAP;
+            entry.max_en_addr = entry.en_addr;
+            it = std::upper_bound(m_index.begin(), m_index.end(), entry, acc_range_entry_less);
+            it = m_index.insert(it, entry);
+            if ((size_t)(it - m_index.begin()) < lowest_idx)
+                lowest_idx = (size_t)(it - m_index.begin());
         }
-        it++;
     }
+    setMaxEnd(lowest_idx);
+}
 
-    // no overlap - add to the list of ranges.
-    if(!bOverLap)
-        m_acc_global.push_back(p_accessor);
+// remove all ranges for an accessor from the sorted index.
+void TrcMemAccRangeIndex::removeAccessor(const TrcMemAccessorBase *p_accessor)
+{
+    size_t lowest_idx = m_index.size();
+    size_t idx = 0;
 
-    return err;
+    while (idx < m_index.size())
+    {
+        if (m_index[idx].p_acc == p_accessor)
+        {
+            m_index.erase(m_index.begin() + idx);
+            if (idx < lowest_idx)
+                lowest_idx = idx;
+        }
+        else
+            idx++;
+    }
+    setMaxEnd(lowest_idx);
 }
 
-bool TrcMemAccMapGlobalSpace::findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t /*cs_trace_id*/)
+void TrcMemAccRangeIndex::clear()
 {
-    bool bFound = false;
-    std::vector<TrcMemAccessorBase *>::const_iterator it =  m_acc_global.begin();
-    while((it != m_acc_global.end()) && !bFound)
+    m_index.clear();
+    m_add_seq = 0;
+}
+
+TrcMemAccessorBase *TrcMemAccRangeIndex::findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space) const
+{
+    TrcMemAccessorBase *p_found = 0;
+    uint32_t found_seq = 0;
+
+    // first entry with start address beyond the search address - all candidates are below this.
+    std::vector<acc_range_entry_t>::const_iterator it;
+    it = std::upper_bound(m_index.begin(), m_index.end(), address, acc_range_addr_less);
+
+    // walk back until no lower entry can reach the address. Different memory spaces
+    // may map the same address, so check all candidates and keep the first added.
+    while(it != m_index.begin())
     {
-        if( (*it)->addrInRange(address) &&
-            (*it)->inMemSpace(mem_space))
+        it--;
+        if(it->max_en_addr < address)
+            break;
+        if( (it->en_addr >= address) &&
+            it->p_acc->inMemSpace(mem_space) &&
+            (!p_found || (it->add_seq < found_seq)))
         {
-            bFound = true;
-            m_acc_curr = *it;
+            p_found = it->p_acc;
+            found_seq = it->add_seq;
         }
+    }
+    return p_found;
+}
+
+void TrcMemAccRangeIndex::limitToGap(const ocsd_vaddr_t address, ocsd_vaddr_t &st_addr, ocsd_vaddr_t &en_addr) const
+{
+    std::vector<acc_range_entry_t>::const_iterator it;
+    it = std::upper_bound(m_index.begin(), m_index.end(), address, acc_range_addr_less);
+
+    // next range starts above the address
+    if ((it != m_index.end()) && (it->st_addr - 1 < en_addr))
+        en_addr = it->st_addr - 1;
+
+    // all lower ranges end below the address, unless a range in another memory space covers it.
+    if (it != m_index.begin())
+    {
+        it--;
+        if (it->max_en_addr >= address)
+            st_addr = address;
+        else if (it->max_en_addr + 1 > st_addr)
+            st_addr = it->max_en_addr + 1;
+    }
+}
+
+// recalculate the running maximum end address from the supplied index to the end of the index.
+void TrcMemAccRangeIndex::setMaxEnd(const size_t from_idx)
+{
+    ocsd_vaddr_t max_en = 0;
+
+    if ((from_idx > 0) && (from_idx <= m_index.size()))
+        max_en = m_index[from_idx - 1].max_en_addr;
+
+    for (size_t i = from_idx; i < m_index.size(); i++)
+    {
+        if (m_index[i].en_addr > max_en)
+            max_en = m_index[i].en_addr;
+        m_index[i].max_en_addr = max_en;
+    }
+}
+
+// check if an accessor overlaps any in the list, in a matching memory space
+static bool accessorOverlapsList(const std::vector<TrcMemAccessorBase *> &acc_list, const TrcMemAccessorBase *p_accessor)
+{
+    std::vector<TrcMemAccessorBase *>::const_iterator it =  acc_list.begin();
+    while(it != acc_list.end())
+    {
+        // if overlap and memory space match
+        if( ((*it)->overLapRange(p_accessor)) &&
+            ((*it)->inMemSpace(p_accessor->getMemSpace()))
+            )
+            return true;
         it++;
     }
-    return bFound;
+    return false;
 }
 
-bool TrcMemAccMapGlobalSpace::readFromCurrent(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t /*cs_trace_id*/)
+static void logAccessor(const TrcMemAccessorBase *p_accessor, std::string &accStr)
 {
-    bool readFromCurr = false;
-    if(m_acc_curr)
-        readFromCurr = (m_acc_curr->addrInRange(address) && m_acc_curr->inMemSpace(mem_space));
-    return readFromCurr;
+    p_accessor->getMemAccString(accStr);
+    accStr += "\n";
 }
 
+/************************************************************************************/
+/* mappers global address space class - no differentiation in core trace IDs */
+/************************************************************************************/
+TrcMemAccMapGlobalSpace::TrcMemAccMapGlobalSpace() : TrcMemAccMapper()
+{
+}
+
+TrcMemAccMapGlobalSpace::~TrcMemAccMapGlobalSpace()
+{
+}
+
+ocsd_err_t TrcMemAccMapGlobalSpace::AddAccessor(TrcMemAccessorBase *p_accessor, const uint8_t /*cs_trace_id*/)
+{
+    if(!p_accessor->validateRange())
+        return OCSD_ERR_MEM_ACC_RANGE_INVALID;
+
+    if(accessorOverlapsList(m_acc_global, p_accessor))
+        return OCSD_ERR_MEM_ACC_OVERLAP;
+
+    // no overlap - add to the list of ranges.
+    m_acc_global.push_back(p_accessor);
+    m_acc_index.addAccessor(p_accessor);
+    accessorsChanged();
+    return OCSD_OK;
+}
+
+TrcMemAccessorBase *TrcMemAccMapGlobalSpace::findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t /*cs_trace_id*/)
+{
+    TrcMemAccessorBase *p_found = m_acc_index.findAccessor(address, mem_space);
+    if(p_found)
+        m_acc_curr = p_found;
+    return p_found;
+}
+
+TrcMemAccessorBase *TrcMemAccMapGlobalSpace::readFromCurrent(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t /*cs_trace_id*/)
+{
+    return inCurrent(address, mem_space) ? m_acc_curr : 0;
+}
+
+
+void TrcMemAccMapGlobalSpace::getUnmappedRange(const ocsd_vaddr_t address, const uint8_t /*cs_trace_id*/, ocsd_vaddr_t &st_addr, ocsd_vaddr_t &en_addr)
+{
+    st_addr = 0;
+    en_addr = ~((ocsd_vaddr_t)0);
+    m_acc_index.limitToGap(address, st_addr, en_addr);
+}
 
 TrcMemAccessorBase * TrcMemAccMapGlobalSpace::getFirstAccessor()
 {
@@ -262,6 +637,7 @@ TrcMemAccessorBase *TrcMemAccMapGlobalSpace::getNextAccessor()
 void TrcMemAccMapGlobalSpace::clearAccessorList()
 {
     m_acc_global.clear();
+    m_acc_index.clear();
     m_acc_curr = 0;
 }
 
@@ -274,13 +650,10 @@ ocsd_err_t TrcMemAccMapGlobalSpace::RemoveAccessor(const TrcMemAccessorBase *p_a
         if(p_acc == p_accessor)
         {
             m_acc_global.erase(m_acc_it);
+            m_acc_index.removeAccessor(p_accessor);
             p_acc = 0;
             bFound = true;
-            if (m_cache.enabled())
-            {
-                m_cache.invalidateAll();
-                m_cache.logAndClearCounts();
-            }
+            invalidateAllCaches();
             if (m_acc_curr == p_accessor)
                 m_acc_curr = 0;
         }
@@ -291,6 +664,17 @@ ocsd_err_t TrcMemAccMapGlobalSpace::RemoveAccessor(const TrcMemAccessorBase *p_a
 }
 
 
+void TrcMemAccMapGlobalSpace::updateAccessorRanges()
+{
+    // rebuild the index in the order the accessors were added.
+    m_acc_index.clear();
+    for (size_t i = 0; i < m_acc_global.size(); i++)
+        m_acc_index.addAccessor(m_acc_global[i]);
+
+    // ranges may have changed under the cache
+    invalidateAllCaches();
+}
+
 void TrcMemAccMapGlobalSpace::logMappedRanges()
 {
     std::string accStr;
@@ -298,12 +682,404 @@ void TrcMemAccMapGlobalSpace::logMappedRanges()
     LogMessage("Mapped Memory Accessors\n");
     while(pAccessor != 0)
     {
-        pAccessor->getMemAccString(accStr);
-        accStr += "\n";
+        logAccessor(pAccessor, accStr);
         LogMessage(accStr);
         pAccessor = getNextAccessor();
     }
     LogMessage("========================\n");
 }
 
+/************************************************************************************/
+/* mappers per trace ID address space class - global accessors on trace ID 0 */
+/************************************************************************************/
+TrcMemAccMapPerTraceID::TrcMemAccMapPerTraceID() : TrcMemAccMapper(true),
+    m_cache_enabled(false),
+    m_cache_page_size(MEM_ACC_CACHE_DEFAULT_PAGE_SIZE),
+    m_cache_num_pages(MEM_ACC_CACHE_DEFAULT_MRU_SIZE),
+    m_it_set(0),
+    m_it_idx(0)
+{
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+        m_acc_sets[i] = 0;
+}
+
+TrcMemAccMapPerTraceID::~TrcMemAccMapPerTraceID()
+{
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        delete m_acc_sets[i];
+        m_acc_sets[i] = 0;
+    }
+}
+
+TrcMemAccMapPerTraceID::trcid_acc_set_t *TrcMemAccMapPerTraceID::getAccSet(const uint8_t cs_trace_id)
+{
+    trcid_acc_set_t *p_set = 0;
+
+    if (cs_trace_id >= MEMACC_MAP_NUM_TRACE_IDS)
+        return 0;
+
+    p_set = m_acc_sets[cs_trace_id];
+    if (!p_set)
+    {
+        p_set = new (std::nothrow) trcid_acc_set_t;
+        if (p_set)
+        {
+            p_set->acc_curr = 0;
+            clearNaccCache(p_set->nacc);
+            p_set->nacc.unmapped_reads = 0;
+            p_set->nacc.unmapped_hits = 0;
+            p_set->cache.setErrorLog(m_err_log);
+            if (initSetCache(p_set) != OCSD_OK)
+            {
+                delete p_set;
+                p_set = 0;
+            }
+        }
+        m_acc_sets[cs_trace_id] = p_set;
+    }
+    return p_set;
+}
+
+ocsd_err_t TrcMemAccMapPerTraceID::initSetCache(trcid_acc_set_t *p_set)
+{
+    ocsd_err_t err = OCSD_OK;
+
+    // only create cache pages if caching in use
+    if (m_cache_enabled)
+    {
+        err = p_set->cache.setCacheSizes(m_cache_page_size, m_cache_num_pages);
+        if (err == OCSD_OK)
+            err = p_set->cache.enableCaching(true);
+    }
+    else
+        err = p_set->cache.enableCaching(false);
+    return err;
+}
+
+ocsd_err_t TrcMemAccMapPerTraceID::AddAccessor(TrcMemAccessorBase *p_accessor, const uint8_t cs_trace_id)
+{
+    trcid_acc_set_t *p_set;
+
+    if (cs_trace_id >= MEMACC_MAP_NUM_TRACE_IDS)
+        return OCSD_ERR_INVALID_ID;
+
+    if(!p_accessor->validateRange())
+        return OCSD_ERR_MEM_ACC_RANGE_INVALID;
+
+    if ((p_set = getAccSet(cs_trace_id)) == 0)
+        return OCSD_ERR_MEM;
+
+    // trace ID specific accessors may overlap the global ones - and will be used in preference.
+    if(accessorOverlapsList(p_set->accessors, p_accessor))
+        return OCSD_ERR_MEM_ACC_OVERLAP;
+
+    p_set->accessors.push_back(p_accessor);
+    p_set->index.addAccessor(p_accessor);
+    accessorsChanged();
+
+    // a new trace ID specific accessor may now hide a global one
+    if (cs_trace_id != 0)
+    {
+        p_set->acc_curr = 0;
+        if (p_set->cache.enabled())
+            p_set->cache.invalidateAll();
+    }
+    return OCSD_OK;
+}
+
+TrcMemAccessorBase *TrcMemAccMapPerTraceID::findAccessor(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id)
+{
+    TrcMemAccessorBase *p_found = 0;
+    trcid_acc_set_t *p_set = (cs_trace_id < MEMACC_MAP_NUM_TRACE_IDS) ? m_acc_sets[cs_trace_id] : 0;
+
+    // trace ID accessors first, then global.
+    if (p_set)
+        p_found = p_set->index.findAccessor(address, mem_space);
+    if (!p_found && m_acc_sets[0])
+        p_found = m_acc_sets[0]->index.findAccessor(address, mem_space);
+
+    if (p_found)
+    {
+        if (!p_set)
+            p_set = getAccSet(cs_trace_id);
+        if (p_set)
+            p_set->acc_curr = p_found;
+    }
+    return p_found;
+}
+
+// only accessors added for the trace ID - a global accessor is not removed for a single ID.
+TrcMemAccessorBase *TrcMemAccMapPerTraceID::findAccessorToRemove(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id)
+{
+    trcid_acc_set_t *p_set = (cs_trace_id < MEMACC_MAP_NUM_TRACE_IDS) ? m_acc_sets[cs_trace_id] : 0;
+
+    if (p_set)
+        return p_set->index.findAccessor(address, mem_space);
+    return 0;
+}
+
+TrcMemAccessorBase *TrcMemAccMapPerTraceID::readFromCurrent(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id)
+{
+    TrcMemAccessorBase *p_curr;
+
+    if ((cs_trace_id >= MEMACC_MAP_NUM_TRACE_IDS) || !m_acc_sets[cs_trace_id])
+        return 0;
+
+    p_curr = m_acc_sets[cs_trace_id]->acc_curr;
+    if (p_curr && p_curr->addrInRange(address) && p_curr->inMemSpace(mem_space))
+        return p_curr;
+    return 0;
+}
+
+void TrcMemAccMapPerTraceID::getUnmappedRange(const ocsd_vaddr_t address, const uint8_t cs_trace_id, ocsd_vaddr_t &st_addr, ocsd_vaddr_t &en_addr)
+{
+    st_addr = 0;
+    en_addr = ~((ocsd_vaddr_t)0);
+
+    // gap in both the trace ID and global accessors.
+    if ((cs_trace_id < MEMACC_MAP_NUM_TRACE_IDS) && m_acc_sets[cs_trace_id])
+        m_acc_sets[cs_trace_id]->index.limitToGap(address, st_addr, en_addr);
+    if (m_acc_sets[0])
+        m_acc_sets[0]->index.limitToGap(address, st_addr, en_addr);
+}
+
+TrcMemAccCache &TrcMemAccMapPerTraceID::getCache(const uint8_t cs_trace_id)
+{
+    trcid_acc_set_t *p_set = getAccSet(cs_trace_id);
+
+    // unused base cache will be disabled if no partition available for the ID.
+    if (!p_set)
+        return m_cache;
+    return p_set->cache;
+}
+
+nacc_cache_t &TrcMemAccMapPerTraceID::getNaccCache(const uint8_t cs_trace_id)
+{
+    trcid_acc_set_t *p_set = getAccSet(cs_trace_id);
+
+    if (!p_set)
+        return m_nacc;
+    return p_set->nacc;
+}
+
+std::vector<uint8_t> &TrcMemAccMapPerTraceID::getPtrReadBuf(const uint8_t cs_trace_id)
+{
+    trcid_acc_set_t *p_set = getAccSet(cs_trace_id);
+
+    if (!p_set)
+        return m_ptr_read_buf;
+    return p_set->ptr_read_buf;
+}
+
+void TrcMemAccMapPerTraceID::invalidateNaccCache()
+{
+    TrcMemAccMapper::invalidateNaccCache();
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        if (m_acc_sets[i])
+            clearNaccCache(m_acc_sets[i]->nacc);
+    }
+}
+
+void TrcMemAccMapPerTraceID::getMemAccStats(ocsd_mem_acc_stats_t &stats)
+{
+    // base cache used for any reads where the trace ID partition could not be created
+    TrcMemAccMapper::getMemAccStats(stats);
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        if (m_acc_sets[i])
+        {
+            m_acc_sets[i]->cache.addStats(stats);
+            stats.unmapped_reads += m_acc_sets[i]->nacc.unmapped_reads;
+            stats.unmapped_hits += m_acc_sets[i]->nacc.unmapped_hits;
+        }
+    }
+}
+
+void TrcMemAccMapPerTraceID::resetMemAccStats()
+{
+    TrcMemAccMapper::resetMemAccStats();
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        if (m_acc_sets[i])
+        {
+            m_acc_sets[i]->cache.resetStats();
+            m_acc_sets[i]->nacc.unmapped_reads = 0;
+            m_acc_sets[i]->nacc.unmapped_hits = 0;
+        }
+    }
+}
+
+void TrcMemAccMapPerTraceID::invalidateAllCaches()
+{
+    accessorsChanged();
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        if (m_acc_sets[i] && m_acc_sets[i]->cache.enabled())
+        {
+            m_acc_sets[i]->cache.invalidateAll();
+            m_acc_sets[i]->cache.logStats();
+        }
+    }
+}
+
+TrcMemAccessorBase *TrcMemAccMapPerTraceID::getFirstAccessor()
+{
+    m_it_set = 0;
+    m_it_idx = 0;
+    return getNextAccessor();
+}
+
+TrcMemAccessorBase *TrcMemAccMapPerTraceID::getNextAccessor()
+{
+    while (m_it_set < MEMACC_MAP_NUM_TRACE_IDS)
+    {
+        if (m_acc_sets[m_it_set] && (m_it_idx < m_acc_sets[m_it_set]->accessors.size()))
+            return m_acc_sets[m_it_set]->accessors[m_it_idx++];
+        m_it_set++;
+        m_it_idx = 0;
+    }
+    return 0;
+}
+
+void TrcMemAccMapPerTraceID::clearAccessorList()
+{
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        if (m_acc_sets[i])
+        {
+            m_acc_sets[i]->accessors.clear();
+            m_acc_sets[i]->index.clear();
+            m_acc_sets[i]->acc_curr = 0;
+        }
+    }
+    m_acc_curr = 0;
+}
+
+ocsd_err_t TrcMemAccMapPerTraceID::RemoveAccessor(const TrcMemAccessorBase *p_accessor)
+{
+    bool bFound = false;
+    std::vector<TrcMemAccessorBase *>::iterator it;
+
+    // the same accessor may be in use for more than one trace ID.
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        trcid_acc_set_t *p_set = m_acc_sets[i];
+        if (!p_set)
+            continue;
+
+        it = std::find(p_set->accessors.begin(), p_set->accessors.end(), p_accessor);
+        if (it != p_set->accessors.end())
+        {
+            p_set->accessors.erase(it);
+            p_set->index.removeAccessor(p_accessor);
+            bFound = true;
+        }
+    }
+
+    if (bFound)
+    {
+        // global accessors may be current in any set.
+        for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+        {
+            if (m_acc_sets[i] && (m_acc_sets[i]->acc_curr == p_accessor))
+                m_acc_sets[i]->acc_curr = 0;
+        }
+        if (m_acc_curr == p_accessor)
+            m_acc_curr = 0;
+        invalidateAllCaches();
+    }
+    return bFound ? OCSD_OK : OCSD_ERR_INVALID_PARAM_VAL;
+}
+
+void TrcMemAccMapPerTraceID::updateAccessorRanges()
+{
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        trcid_acc_set_t *p_set = m_acc_sets[i];
+        if (p_set)
+        {
+            p_set->index.clear();
+            for (size_t j = 0; j < p_set->accessors.size(); j++)
+                p_set->index.addAccessor(p_set->accessors[j]);
+            p_set->acc_curr = 0;
+        }
+    }
+    m_acc_curr = 0;
+    invalidateAllCaches();
+}
+
+void TrcMemAccMapPerTraceID::setErrorLog(ITraceErrorLog *err_log_i)
+{
+    TrcMemAccMapper::setErrorLog(err_log_i);
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        if (m_acc_sets[i])
+            m_acc_sets[i]->cache.setErrorLog(err_log_i);
+    }
+}
+
+ocsd_err_t TrcMemAccMapPerTraceID::enableCaching(bool bEnable)
+{
+    ocsd_err_t err = OCSD_OK;
+
+    m_acc_generation++;     // memory not tracked while caching off.
+    m_cache_enabled = bEnable;
+    for (int i = 0; (i < MEMACC_MAP_NUM_TRACE_IDS) && (err == OCSD_OK); i++)
+    {
+        if (m_acc_sets[i])
+            err = initSetCache(m_acc_sets[i]);
+    }
+    return err;
+}
+
+ocsd_err_t TrcMemAccMapPerTraceID::setCacheSizes(uint16_t page_size, int num_pages, const bool err_on_limit /*= false*/)
+{
+    trcid_acc_set_t *p_global = getAccSet(0);
+    ocsd_err_t err;
+
+    if (!p_global)
+        return OCSD_ERR_MEM;
+
+    // global set cache validates and limits the sizes - use these for all sets.
+    err = p_global->cache.setCacheSizes(page_size, num_pages, err_on_limit);
+    if (err != OCSD_OK)
+        return err;
+    p_global->cache.getCacheSizes(m_cache_page_size, m_cache_num_pages);
+
+    for (int i = 1; (i < MEMACC_MAP_NUM_TRACE_IDS) && (err == OCSD_OK); i++)
+    {
+        if (m_acc_sets[i])
+            err = m_acc_sets[i]->cache.setCacheSizes(m_cache_page_size, m_cache_num_pages);
+    }
+    return err;
+}
+
+void TrcMemAccMapPerTraceID::logMappedRanges()
+{
+    std::string accStr;
+    std::ostringstream oss;
+
+    LogMessage("Mapped Memory Accessors\n");
+    for (int i = 0; i < MEMACC_MAP_NUM_TRACE_IDS; i++)
+    {
+        if (!m_acc_sets[i] || !m_acc_sets[i]->accessors.size())
+            continue;
+
+        oss.str("");
+        if (i == 0)
+            oss << "Global:\n";
+        else
+            oss << "Trace ID 0x" << std::hex << std::setw(2) << std::setfill('0') << i << ":\n";
+        LogMessage(oss.str());
+        for (size_t j = 0; j < m_acc_sets[i]->accessors.size(); j++)
+        {
+            logAccessor(m_acc_sets[i]->accessors[j], accStr);
+            LogMessage(accStr);
+        }
+    }
+    LogMessage("========================\n");
+}
+
 /* End of File trc_mem_acc_mapper.cpp */
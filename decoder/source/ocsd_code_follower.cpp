@@ -33,7 +33,10 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
  */ 
 
+#include <cstring>
+
 #include "common/ocsd_code_follower.h"
+#include "i_dec/trc_idec_arminst.h"
 
 OcsdCodeFollower::OcsdCodeFollower()
 {
@@ -52,6 +55,13 @@ OcsdCodeFollower::OcsdCodeFollower()
     m_st_range_addr =  m_en_range_addr = m_next_addr = 0;
     m_b_next_valid = false;
     m_b_nacc_err = false;
+    m_b_blk_cache_enable = false;
+    m_ctxt_tag = 0;
+    m_mem_acc_rule = OCSD_MEM_SPACE_ANY;
+    m_fetch_addr = 0;
+    m_fetch_bytes = 0;
+    m_fetch_gen = 0;
+    m_b_fetch_keep = false;
 }
 
 OcsdCodeFollower::~OcsdCodeFollower()
@@ -134,14 +144,37 @@ ocsd_err_t OcsdCodeFollower::followSingleAtom(const ocsd_vaddr_t addrStart, cons
 }
 
 ocsd_err_t OcsdCodeFollower::decodeSingleOpCode()
+{
+    ocsd_err_t err;
+    instr_blk_key_t blk_key;
+    uint32_t num_instr;
+
+    if (!m_b_blk_cache_enable ||
+        (m_pMemAccess->first()->GetMemAccGeneration(m_mem_space_csid, &blk_key.mem_gen) != OCSD_OK))
+        return readDecodeOpCode();
+
+    blk_key.st_addr = m_instr_info.instr_addr;
+    blk_key.ctxt_tag = m_ctxt_tag;
+    blk_key.mem_space = m_mem_acc_rule;
+    blk_key.isa = m_instr_info.isa;
+    blk_key.it_conditions = 0;
+    if (m_blk_cache.getBlock(blk_key, m_instr_info, num_instr))
+        return OCSD_OK;
+
+    err = readDecodeOpCode();
+    if (err == OCSD_OK)
+        m_blk_cache.addBlock(blk_key, m_instr_info, 1);
+    return err;
+}
+
+ocsd_err_t OcsdCodeFollower::readDecodeOpCode()
 {
     ocsd_err_t err = OCSD_OK;
-    // request 4 bytes for the opcode - even for Thumb which may be T32
-    uint32_t bytesReq = 4;  
+    uint32_t bytesReq = 4;
     uint32_t opcode;    // buffer for opcode
 
     // read memory location for opcode 
-    err = m_pMemAccess->first()->ReadTargetMemory(m_instr_info.instr_addr,m_mem_space_csid,m_mem_acc_rule,&bytesReq,(uint8_t *)&opcode);
+    err = readOpCode(&bytesReq, &opcode);
 
     // operational error (not access problem - that is indicated by 0 bytes returned)
     if(err != OCSD_OK)
@@ -161,4 +194,88 @@ ocsd_err_t OcsdCodeFollower::decodeSingleOpCode()
     return err;
 }
 
+/*!
+ * Read the opcode at the current address through the fetch buffer. 
+ *
+ * Thumb opcodes are read a halfword at a time, so a 16 bit opcode at the end of 
+ * accessible memory does not fail. 16 bit opcodes are returned in the low halfword
+ * with the high halfword zero.
+ *
+ * @param *num_bytes : [out] 4 if opcode read, otherwise bytes available.
+ * @param *p_opcode : [out] opcode.
+ */
+ocsd_err_t OcsdCodeFollower::readOpCode(uint32_t *num_bytes, uint32_t *p_opcode)
+{
+    ocsd_err_t err = OCSD_OK;
+    const ocsd_vaddr_t address = m_instr_info.instr_addr;
+    const uint32_t first_bytes = (m_instr_info.isa == ocsd_isa_thumb2) ? 2 : 4;
+    uint32_t mem_gen = 0;
+    uint16_t op_hw[2] = { 0, 0 };
+
+    // buffer only valid for the memory access generation it was read in.
+    m_b_fetch_keep = (m_pMemAccess->first()->GetMemAccGeneration(m_mem_space_csid, &mem_gen) == OCSD_OK);
+    if (!m_b_fetch_keep || (mem_gen != m_fetch_gen))
+    {
+        m_fetch_bytes = 0;
+        m_fetch_gen = mem_gen;
+    }
+
+    if (!inFetchBuf(address, first_bytes))
+    {
+        err = fillFetchBuf(address, first_bytes);
+        if (!m_fetch_bytes)
+        {
+            *num_bytes = 0;
+            return err;
+        }
+    }
+    memcpy(&op_hw[0], m_fetch_buf + (address - m_fetch_addr), 2);
+
+    if ((first_bytes == 4) || is_wide_thumb(op_hw[0]))
+    {
+        if (!inFetchBuf(address, 4))
+        {
+            err = fillFetchBuf(address, 4);
+            if (!m_fetch_bytes)
+            {
+                *num_bytes = 2;
+                return err;
+            }
+        }
+        memcpy(&op_hw[1], m_fetch_buf + (address - m_fetch_addr + 2), 2);
+    }
+    *p_opcode = (uint32_t)op_hw[0] | ((uint32_t)op_hw[1] << 16);
+    *num_bytes = 4;
+    return err;
+}
+
+/* Read to the end of the aligned fetch block if the buffer can be kept, otherwise the bytes for this opcode.
+ * Cache pages return all or none of a request, so retry for the bytes needed if the block runs past the 
+ * end of memory.
+ */
+ocsd_err_t OcsdCodeFollower::fillFetchBuf(const ocsd_vaddr_t address, const uint32_t min_bytes)
+{
+    ocsd_err_t err;
+    uint32_t fetch_bytes = 4;
+
+    if (m_b_fetch_keep)
+    {
+        fetch_bytes = CODE_FOLLOW_FETCH_BYTES - (uint32_t)(address & (CODE_FOLLOW_FETCH_BYTES - 1));
+        if (fetch_bytes < 4)
+            fetch_bytes = 4;
+    }
+
+    m_fetch_addr = address;
+    m_fetch_bytes = fetch_bytes;
+    err = m_pMemAccess->first()->ReadTargetMemory(address, m_mem_space_csid, m_mem_acc_rule, &m_fetch_bytes, m_fetch_buf);
+    if ((err == OCSD_OK) && (m_fetch_bytes < min_bytes) && (fetch_bytes > min_bytes))
+    {
+        m_fetch_bytes = min_bytes;
+        err = m_pMemAccess->first()->ReadTargetMemory(address, m_mem_space_csid, m_mem_acc_rule, &m_fetch_bytes, m_fetch_buf);
+    }
+    if ((err != OCSD_OK) || (m_fetch_bytes < min_bytes))
+        m_fetch_bytes = 0;
+    return err;
+}
+
 /* End of File ocsd_code_follower.cpp */
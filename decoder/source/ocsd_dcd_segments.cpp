@@ -0,0 +1,433 @@
+/*
+* \file       ocsd_dcd_segments.cpp
+* \brief      OpenCSD : Parallel decode of a single trace stream, split at sync points.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+#include <thread>
+#include <system_error>
+
+#include "common/ocsd_dcd_segments.h"
+#include "common/ocsd_dcd_tree.h"
+#include "common/trc_sync_scan.h"
+
+// ETMv4 / ETE restart point - A-sync is 11 x 0x00 followed by 0x80, then the TraceInfo header.
+#define SEG_ASYNC_0_BYTES   11
+#define SEG_ASYNC_END       0x80
+#define SEG_TINFO_HDR       0x01
+
+DecodeSegments::DecodeSegments() :
+    m_p_elem_out(0),
+    m_seg_size(OCSD_DCD_SEG_SIZE_DEF),
+    m_num_in_use(0),
+    m_next_seg(0),
+    m_next_out(0),
+    m_abort(false),
+    m_held_index(0),
+    m_scan_pos(0),
+    m_num_segs(0),
+    m_fatal(false)
+{
+}
+
+DecodeSegments::~DecodeSegments()
+{
+    for (size_t i = 0; i < m_workers.size(); i++)
+    {
+        m_workers[i]->p_tree->setGenTraceElemOutI(0);
+        delete m_workers[i];
+    }
+}
+
+ocsd_err_t DecodeSegments::addWorkerTree(DecodeTree *p_tree)
+{
+    WorkerOut *p_worker;
+    DecodeTreeElement *pElem;
+    uint8_t elemID;
+
+    if (!p_tree || p_tree->getFrameDeformatter())
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    // single ETMv4 / ETE decoder - the only protocols with a restart point this object can find.
+    pElem = p_tree->getFirstElement(elemID);
+    if (!pElem || p_tree->getNextElement(elemID))
+        return OCSD_ERR_INVALID_PARAM_VAL;
+    if ((pElem->getProtocol() != OCSD_PROTOCOL_ETMV4I) && (pElem->getProtocol() != OCSD_PROTOCOL_ETE))
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    p_worker = new (std::nothrow) WorkerOut();
+    if (!p_worker)
+        return OCSD_ERR_MEM;
+    p_worker->p_tree = p_tree;
+    p_tree->setGenTraceElemOutI(p_worker);
+    m_workers.push_back(p_worker);
+    return OCSD_OK;
+}
+
+ocsd_err_t DecodeSegments::setSegmentSize(const uint32_t seg_size)
+{
+    if (seg_size < OCSD_DCD_SEG_SIZE_MIN)
+        return OCSD_ERR_INVALID_PARAM_VAL;
+    m_seg_size = seg_size;
+    return OCSD_OK;
+}
+
+uint32_t DecodeSegments::findSyncPoint(const uint8_t *p_data, const uint32_t size)
+{
+    uint32_t pos = 0, run_end;
+
+    while (pos < size)
+    {
+        pos += ocsd_scan_byte_run(p_data + pos, size - pos, 0x00, SEG_ASYNC_0_BYTES);
+        if (pos >= size)
+            break;
+
+        run_end = pos;
+        while ((run_end < size) && (p_data[run_end] == 0x00))
+            run_end++;
+
+        // need the A-sync end byte and the TraceInfo header in the block.
+        if ((run_end + 2) > size)
+            break;
+        if (((run_end - pos) >= SEG_ASYNC_0_BYTES) && (p_data[run_end] == SEG_ASYNC_END) && (p_data[run_end + 1] == SEG_TINFO_HDR))
+            return run_end - SEG_ASYNC_0_BYTES;
+        pos = run_end;
+    }
+    return size;
+}
+
+void DecodeSegments::reset()
+{
+    m_held.clear();
+    m_held_index = 0;
+    m_cuts.clear();
+    m_num_segs = 0;
+    m_fatal = false;
+}
+
+/* add a segment of the held data, with the data to decode on into to flush elements from before the end */
+void DecodeSegments::addSegment(const uint32_t start, const uint32_t end, const uint32_t look_end)
+{
+    if (m_num_in_use == m_segs.size())
+        m_segs.resize(m_num_in_use + 1);
+
+    segment_t &seg = m_segs[m_num_in_use++];
+    seg.p_data = m_held.data() + start;
+    seg.size = end - start;
+    seg.look_size = look_end - end;
+    seg.index = m_held_index + start;
+    seg.p_elems = 0;
+    seg.resp = OCSD_RESP_CONT;
+    seg.done = false;
+}
+
+ocsd_err_t DecodeSegments::decodeData(const ocsd_trc_index_t index, const uint32_t size, const uint8_t *p_data)
+{
+    ocsd_err_t err;
+    uint32_t seg_start = 0, held_size, search, sync, resume;
+    size_t cut;
+
+    if (m_fatal)
+        return OCSD_ERR_DATA_DECODE_FATAL;
+    if (!m_workers.size())
+        return OCSD_ERR_NOT_INIT;
+    if (!size || !p_data)
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    // append to the held data - sync points split across blocks are found as if in a single block.
+    if (!m_held.size())
+    {
+        m_held_index = index;
+        m_scan_pos = m_seg_size;
+        m_cuts.clear();
+    }
+    try
+    {
+        m_held.insert(m_held.end(), p_data, p_data + size);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return OCSD_ERR_MEM;
+    }
+    held_size = (uint32_t)m_held.size();
+
+    // split at the first sync point after each target segment size.
+    search = m_scan_pos;
+    while (search < held_size)
+    {
+        sync = search + findSyncPoint(m_held.data() + search, held_size - search);
+        if (sync >= held_size)
+            break;
+        try
+        {
+            m_cuts.push_back(sync);
+        }
+        catch (const std::bad_alloc &)
+        {
+            return OCSD_ERR_MEM;
+        }
+        search = sync + m_seg_size;
+    }
+
+    // next scan resumes at any partial sync pattern at the end of the data.
+    resume = search;
+    if (search < held_size)
+    {
+        resume = held_size;
+        if ((resume > search) && (m_held[resume - 1] == SEG_ASYNC_END))
+            resume--;
+        while ((resume > search) && (m_held[resume - 1] == 0x00))
+            resume--;
+    }
+
+    // decode the segments followed by a complete segment - the decoder runs on into it.
+    m_num_in_use = 0;
+    for (cut = 0; (cut + 1) < m_cuts.size(); cut++)
+    {
+        addSegment(seg_start, m_cuts[cut], m_cuts[cut + 1]);
+        seg_start = m_cuts[cut];
+    }
+    err = decodeSegments(false);
+
+    // hold the data from the first segment not decoded.
+    m_cuts.erase(m_cuts.begin(), m_cuts.begin() + cut);
+    for (cut = 0; cut < m_cuts.size(); cut++)
+        m_cuts[cut] -= seg_start;
+    m_held.erase(m_held.begin(), m_held.begin() + seg_start);
+    m_held_index += seg_start;
+    m_scan_pos = resume - seg_start;
+    return err;
+}
+
+ocsd_err_t DecodeSegments::decodeEnd()
+{
+    ocsd_err_t err;
+    uint32_t seg_start = 0, held_size = (uint32_t)m_held.size();
+
+    if (m_fatal)
+        return OCSD_ERR_DATA_DECODE_FATAL;
+    if (!m_workers.size())
+        return OCSD_ERR_NOT_INIT;
+
+    // all held segments, running on to the end of the data - the final segment ends the trace.
+    m_num_in_use = 0;
+    for (size_t cut = 0; cut < m_cuts.size(); cut++)
+    {
+        addSegment(seg_start, m_cuts[cut], ((cut + 1) < m_cuts.size()) ? m_cuts[cut + 1] : held_size);
+        seg_start = m_cuts[cut];
+    }
+    if (held_size)
+        addSegment(seg_start, held_size, held_size);
+    err = decodeSegments(true);
+    m_held.clear();
+    m_cuts.clear();
+    return err;
+}
+
+/* decode the segments in use on the workers, outputting them in order on the caller thread */
+ocsd_err_t DecodeSegments::decodeSegments(const bool bEnd)
+{
+    ocsd_err_t err = OCSD_OK;
+    std::vector<std::thread> threads;
+    size_t num_threads, window, out;
+
+    if (!m_num_in_use)
+        return OCSD_OK;
+
+    // workers stay within a window of segments past the one being output, to bound buffered output.
+    window = m_workers.size() * 2;
+    if (m_elem_bufs.size() < window)
+        m_elem_bufs.resize(window);
+    for (out = 0; out < m_num_in_use; out++)
+        m_segs[out].p_elems = &m_elem_bufs[out % window];
+
+    m_next_seg = 0;
+    m_next_out = 0;
+    m_abort = false;
+
+    num_threads = (m_num_in_use < m_workers.size()) ? m_num_in_use : m_workers.size();
+    try
+    {
+        for (size_t i = 0; i < num_threads; i++)
+            threads.push_back(std::thread(&DecodeSegments::workerThread, this, m_workers[i]));
+    }
+    catch (const std::system_error &)
+    {
+        err = OCSD_ERR_MEM;
+    }
+    catch (const std::bad_alloc &)
+    {
+        err = OCSD_ERR_MEM;
+    }
+
+    if (!threads.size())
+        err = OCSD_ERR_MEM;
+
+    for (out = 0; (out < m_num_in_use) && (err == OCSD_OK); out++)
+    {
+        segment_t *p_seg = &m_segs[out];
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_done_cv.wait(lock, [p_seg] { return p_seg->done; });
+        }
+
+        err = outputSegment(p_seg, m_num_segs == 0, bEnd && (out == (m_num_in_use - 1)));
+        p_seg->p_elems->clear();
+        m_num_segs++;
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_next_out = out + 1;
+        m_work_cv.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_abort = true;
+        m_work_cv.notify_all();
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    for (out = 0; out < m_num_in_use; out++)
+        m_segs[out].p_elems->clear();
+    m_num_in_use = 0;
+
+    if (err == OCSD_ERR_DATA_DECODE_FATAL)
+        m_fatal = true;
+    return err;
+}
+
+void DecodeSegments::workerThread(WorkerOut *p_worker)
+{
+    segment_t *p_seg;
+    const size_t window = m_elem_bufs.size();
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_work_cv.wait(lock, [this, window] { return m_abort || (m_next_seg >= m_num_in_use) || (m_next_seg < (m_next_out + window)); });
+            if (m_abort || (m_next_seg >= m_num_in_use))
+                return;
+            p_seg = &m_segs[m_next_seg++];
+        }
+
+        decodeSegment(p_worker, p_seg);
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        p_seg->done = true;
+        m_done_cv.notify_one();
+    }
+}
+
+/* decode a segment from reset, on until the decoder outputs an element from after the segment or end of trace */
+void DecodeSegments::decodeSegment(WorkerOut *p_worker, segment_t *p_seg)
+{
+    DecodeTree *p_tree = p_worker->p_tree;
+    ocsd_datapath_resp_t resp;
+    const uint32_t total = p_seg->size + p_seg->look_size;
+    uint32_t processed = 0, used;
+
+    p_worker->p_seg = p_seg;
+    p_worker->past_end = false;
+    resp = p_tree->TraceDataIn(OCSD_OP_RESET, p_seg->index, 0, 0, 0);
+    while ((processed < total) && !OCSD_DATA_RESP_IS_FATAL(resp) && !p_worker->past_end)
+    {
+        used = 0;
+        if (OCSD_DATA_RESP_IS_WAIT(resp))
+            resp = p_tree->TraceDataIn(OCSD_OP_FLUSH, 0, 0, 0, 0);
+        else
+        {
+            resp = p_tree->TraceDataIn(OCSD_OP_DATA, p_seg->index + processed, total - processed, p_seg->p_data + processed, &used);
+            processed += used;
+            if (!used && OCSD_DATA_RESP_IS_CONT(resp))
+                break;
+        }
+    }
+
+    // elements from before the end are all output once one from after it is seen - otherwise flush them.
+    if (p_worker->past_end)
+        resp = OCSD_RESP_CONT;
+    else if (!OCSD_DATA_RESP_IS_FATAL(resp))
+        resp = p_tree->TraceDataIn(OCSD_OP_EOT, 0, 0, 0, 0);
+    p_seg->resp = resp;
+    p_worker->p_seg = 0;
+}
+
+ocsd_datapath_resp_t DecodeSegments::WorkerOut::TraceElemIn(const ocsd_trc_index_t index_sop,
+                                                            const uint8_t trc_chan_id,
+                                                            const OcsdTraceElement &elem)
+{
+    if (!p_seg)
+        return OCSD_RESP_FATAL_NOT_INIT;
+
+    // element from the following segment - drop it and stop the decoder.
+    if (p_seg->look_size && (index_sop >= (p_seg->index + p_seg->size)))
+    {
+        past_end = true;
+        return OCSD_RESP_WAIT;
+    }
+    try
+    {
+        p_seg->p_elems->push_back(seg_elem_t(index_sop, trc_chan_id, elem));
+    }
+    catch (const std::bad_alloc &)
+    {
+        return OCSD_RESP_FATAL_SYS_ERR;
+    }
+    return OCSD_RESP_CONT;
+}
+
+/* pass the segment output on to the client - end of trace is only output at the end of the stream */
+ocsd_err_t DecodeSegments::outputSegment(segment_t *p_seg, const bool bFirst, const bool bLast)
+{
+    std::vector<seg_elem_t> &elems = *p_seg->p_elems;
+    ocsd_datapath_resp_t resp;
+
+    // workers reset the decoder for every segment - the stream itself starts from an initialised decoder.
+    if (bFirst && elems.size() && (elems[0].elem.getType() == OCSD_GEN_TRC_ELEM_NO_SYNC) &&
+        (elems[0].elem.unsync_eot_info == UNSYNC_RESET_DECODER))
+        elems[0].elem.setUnSyncEOTReason(UNSYNC_INIT_DECODER);
+
+    for (size_t i = 0; (i < elems.size()) && m_p_elem_out; i++)
+    {
+        if (!bLast && (elems[i].elem.getType() == OCSD_GEN_TRC_ELEM_EO_TRACE))
+            continue;
+        resp = m_p_elem_out->TraceElemIn(elems[i].index_sop, elems[i].trc_chan_id, elems[i].elem);
+        if (OCSD_DATA_RESP_IS_FATAL(resp))
+            return OCSD_ERR_DATA_DECODE_FATAL;
+    }
+    return OCSD_DATA_RESP_IS_FATAL(p_seg->resp) ? OCSD_ERR_DATA_DECODE_FATAL : OCSD_OK;
+}
+
+/* End of File ocsd_dcd_segments.cpp */
@@ -37,12 +37,14 @@
 #include "common/ocsd_dcd_tree.h"
 #include "common/ocsd_lib_dcd_register.h"
 #include "mem_acc/trc_mem_acc_mapper.h"
+#include "mem_acc/trc_mem_acc_code_map.h"
+#include "common/ocsd_dcd_tree_threads.h"
 
 /***************************************************************/
 ITraceErrorLog *DecodeTree::s_i_error_logger = &DecodeTree::s_error_logger; 
 std::list<DecodeTree *> DecodeTree::s_trace_dcd_trees;  /**< list of pointers to decode tree objects */
 ocsdDefaultErrorLogger DecodeTree::s_error_logger;     /**< The library default error logger */
-TrcIDecode DecodeTree::s_instruction_decoder;           /**< default instruction decode library */
+std::mutex DecodeTree::s_tree_lock;
 
 DecodeTree *DecodeTree::CreateDecodeTree(const ocsd_dcd_tree_src_t src_type, uint32_t formatterCfgFlags)
 {
@@ -51,8 +53,9 @@ DecodeTree *DecodeTree::CreateDecodeTree(const ocsd_dcd_tree_src_t src_type, uin
     {
         if(dcd_tree->initialise(src_type, formatterCfgFlags))
         {
+            dcd_tree->m_instruction_decoder.envSetAA64_errOnBadOpcode();
+            std::lock_guard<std::mutex> lock(s_tree_lock);
             s_trace_dcd_trees.push_back(dcd_tree);
-            s_instruction_decoder.envSetAA64_errOnBadOpcode();
         }
         else 
         {
@@ -66,43 +69,88 @@ DecodeTree *DecodeTree::CreateDecodeTree(const ocsd_dcd_tree_src_t src_type, uin
 void DecodeTree::DestroyDecodeTree(DecodeTree *p_dcd_tree)
 {
     std::list<DecodeTree *>::iterator it;
-    bool bDestroyed = false;
-    it = s_trace_dcd_trees.begin();
-    while(!bDestroyed && (it != s_trace_dcd_trees.end()))
+    bool bFound = false;
     {
-        if(*it == p_dcd_tree)
+        std::lock_guard<std::mutex> lock(s_tree_lock);
+        it = s_trace_dcd_trees.begin();
+        while(!bFound && (it != s_trace_dcd_trees.end()))
         {
-            s_trace_dcd_trees.erase(it);
-            delete p_dcd_tree;
-            bDestroyed = true;
+            if(*it == p_dcd_tree)
+            {
+                s_trace_dcd_trees.erase(it);
+                bFound = true;
+            }
+            else
+                it++;
         }
-        else
-            it++;
     }
+    // delete outside the lock - other trees may be created or destroyed while this one is cleaned up.
+    if(bFound)
+        delete p_dcd_tree;
+}
+
+ITraceErrorLog *DecodeTree::getCurrentErrorLogI()
+{
+    std::lock_guard<std::mutex> lock(s_tree_lock);
+    return s_i_error_logger;
 }
 
 void DecodeTree::setAlternateErrorLogger(ITraceErrorLog *p_error_logger)
 {
+    std::lock_guard<std::mutex> lock(s_tree_lock);
     if(p_error_logger)
         s_i_error_logger = p_error_logger;
     else
         s_i_error_logger = &s_error_logger;
 
     // set debug error logger on the decoder.
-    TrcIDecode::setErrLogger(getCurrentErrorLogI());
+    TrcIDecode::setErrLogger(s_i_error_logger);
+}
+
+void DecodeTree::setTreeErrorLogI(ITraceErrorLog *p_error_logger)
+{
+    uint8_t elemID;
+    DecodeTreeElement *pElem;
+
+    // decoders on worker threads may be logging.
+    waitDecodeIdle();
+    m_i_error_logger = p_error_logger;
+
+    // reattach all the components in the tree.
+    if(m_frame_deformatter_root)
+        m_frame_deformatter_root->getErrLogAttachPt()->replace_first(elemErrorLogI());
+    pElem = getFirstElement(elemID);
+    while(pElem)
+    {
+        pElem->getDecoderMngr()->attachErrorLogger(pElem->getDecoderHandle(), elemErrorLogI());
+        pElem = getNextElement(elemID);
+    }
+    if(m_default_mapper)
+        m_default_mapper->setErrorLog(elemErrorLogI());
+}
+
+ITraceErrorLog *DecodeTree::getTreeErrorLogI() const
+{
+    if(m_i_error_logger)
+        return m_i_error_logger;
+    return getCurrentErrorLogI();
 }
 
 /***************************************************************/
 
 DecodeTree::DecodeTree() :
-    m_i_instr_decode(&s_instruction_decoder),
+    m_i_instr_decode(&m_instruction_decoder),
     m_i_mem_access(0),
     m_i_gen_elem_out(0),
     m_i_decoder_root(0),
     m_frame_deformatter_root(0),
     m_decode_elem_iter(0),
     m_default_mapper(0),
-    m_created_mapper(false)
+    m_created_mapper(false),
+    m_i_error_logger(0),
+    m_cb_read_ahead_min(0),
+    m_cb_read_ahead_max(0),
+    m_p_threads(0)
 {
     for(int i = 0; i < 0x80; i++)
         m_decode_elements[i] = 0;
@@ -117,6 +165,7 @@ DecodeTree::DecodeTree() :
 
 DecodeTree::~DecodeTree()
 {
+    setDecodeThreads(0);
     destroyMemAccessors();
     destroyMemAccMapper();
     for(uint8_t i = 0; i < 0x80; i++)
@@ -136,7 +185,21 @@ ocsd_datapath_resp_t DecodeTree::TraceDataIn( const ocsd_datapath_op_t op,
                                                uint32_t *numBytesProcessed)
 {
     if(m_i_decoder_root)
-        return m_i_decoder_root->TraceDataIn(op,index,dataBlockSize,pDataBlock,numBytesProcessed);
+    {
+        // deformatter on a pipeline thread - queue the data for it.
+        if(m_p_threads && m_p_threads->isPipeline())
+            return m_p_threads->pipeDataIn(op,index,dataBlockSize,pDataBlock,numBytesProcessed);
+
+        ocsd_datapath_resp_t resp = m_i_decoder_root->TraceDataIn(op,index,dataBlockSize,pDataBlock,numBytesProcessed);
+        if(m_p_threads)
+        {
+            // decoders on worker threads - pass on queued data, waiting for the workers on none-data operations.
+            ocsd_datapath_resp_t thread_resp = (op == OCSD_OP_DATA) ? m_p_threads->submit() : m_p_threads->waitIdle();
+            if(thread_resp > resp)
+                resp = thread_resp;
+        }
+        return resp;
+    }
     *numBytesProcessed = 0;
     return OCSD_RESP_FATAL_NOT_INIT;
 }
@@ -147,6 +210,7 @@ void DecodeTree::setInstrDecoder(IInstrDecode *i_instr_decode)
     uint8_t elemID;
     DecodeTreeElement *pElem = 0;
 
+    waitDecodeIdle();
     pElem = getFirstElement(elemID);
     while(pElem != 0)
     {
@@ -160,13 +224,17 @@ void DecodeTree::setMemAccessI(ITargetMemAccess *i_mem_access)
     uint8_t elemID;
     DecodeTreeElement *pElem = 0;
    
+    waitDecodeIdle();
+    m_i_mem_access = i_mem_access;
+    if(m_p_threads)
+        m_p_threads->getMemAccessI()->setMemAccessI(i_mem_access);
+
     pElem = getFirstElement(elemID);
     while(pElem != 0)
     {
-        pElem->getDecoderMngr()->attachMemAccessor(pElem->getDecoderHandle(),i_mem_access);
+        pElem->getDecoderMngr()->attachMemAccessor(pElem->getDecoderHandle(),elemMemAccessI());
         pElem = getNextElement(elemID);
     }
-    m_i_mem_access = i_mem_access;
 }
 
 void DecodeTree::setGenTraceElemOutI(ITrcGenElemIn *i_gen_trace_elem)
@@ -174,14 +242,18 @@ void DecodeTree::setGenTraceElemOutI(ITrcGenElemIn *i_gen_trace_elem)
     uint8_t elemID;
     DecodeTreeElement *pElem = 0;
 
+    /* set local copy of interface to return in getGenTraceElemOutI */
+    waitDecodeIdle();
+    m_i_gen_elem_out = i_gen_trace_elem;
+    if(m_p_threads)
+        m_p_threads->getGenElemOutI()->setGenElemOutI(i_gen_trace_elem);
+
     pElem = getFirstElement(elemID);
     while(pElem != 0)
     {
-        pElem->getDecoderMngr()->attachOutputSink(pElem->getDecoderHandle(),i_gen_trace_elem);
+        pElem->getDecoderMngr()->attachOutputSink(pElem->getDecoderHandle(),elemGenElemOutI());
         pElem = getNextElement(elemID);
     }
-    /* set local copy of interface to return in getGenTraceElemOutI */
-    m_i_gen_elem_out = i_gen_trace_elem;
 }
 
 ocsd_err_t DecodeTree::createMemAccMapper(memacc_mapper_t type /* = MEMACC_MAP_GLOBAL*/ )
@@ -196,6 +268,10 @@ ocsd_err_t DecodeTree::createMemAccMapper(memacc_mapper_t type /* = MEMACC_MAP_G
     case MEMACC_MAP_GLOBAL:
         m_default_mapper = new (std::nothrow) TrcMemAccMapGlobalSpace();
         break;
+
+    case MEMACC_MAP_PER_TRACE_ID:
+        m_default_mapper = new (std::nothrow) TrcMemAccMapPerTraceID();
+        break;
     }
 
     // set the access interface
@@ -207,7 +283,7 @@ ocsd_err_t DecodeTree::createMemAccMapper(memacc_mapper_t type /* = MEMACC_MAP_G
 
         m_created_mapper = true;
         setMemAccessI(m_default_mapper);
-        m_default_mapper->setErrorLog(s_i_error_logger);
+        m_default_mapper->setErrorLog(elemErrorLogI());
         TrcMemAccCache::getenvMemaccCacheSizes(enableCaching, cachePageSize, cachePageNum);
         if ((m_default_mapper->setCacheSizes(cachePageSize, cachePageNum) != OCSD_OK) ||
             (m_default_mapper->enableCaching(enableCaching) != OCSD_OK))
@@ -219,12 +295,14 @@ ocsd_err_t DecodeTree::createMemAccMapper(memacc_mapper_t type /* = MEMACC_MAP_G
 
 void DecodeTree::setExternMemAccMapper(TrcMemAccMapper* pMapper)
 {
+    waitDecodeIdle();
     destroyMemAccMapper();  // destroy any existing mapper - if decode tree created it.
     m_default_mapper = pMapper;
 }
 
 void DecodeTree::destroyMemAccMapper()
 {
+    waitDecodeIdle();
     if(m_default_mapper && m_created_mapper)
     {
         m_default_mapper->RemoveAllAccessors();
@@ -255,12 +333,14 @@ void DecodeTree::destroyMemAccessors()
 
 void DecodeTree::logMappedRanges()
 {
+    waitDecodeIdle();
     if(m_default_mapper)
         m_default_mapper->logMappedRanges();
 }
 
 ocsd_err_t DecodeTree::setMemAccCacheing(const bool enable, const uint16_t page_size, const int nr_pages)
 {
+    waitDecodeIdle();
     ocsd_err_t err = OCSD_OK;
 
     if (!m_default_mapper)
@@ -278,9 +358,48 @@ ocsd_err_t DecodeTree::setMemAccCacheing(const bool enable, const uint16_t page_
     return err;
 }
 
-/* Memory accessor creation - all on default mem accessor using the 0 CSID for global core space. */
-ocsd_err_t DecodeTree::addBufferMemAcc(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t *p_mem_buffer, const uint32_t mem_length)
+ocsd_err_t DecodeTree::getMemAccStats(ocsd_mem_acc_stats_t *p_stats)
+{
+    waitDecodeIdle();
+    if (!m_default_mapper)
+        return OCSD_ERR_NOT_INIT;
+    if (!p_stats)
+        return OCSD_ERR_INVALID_PARAM_VAL;
+    m_default_mapper->getMemAccStats(*p_stats);
+    return OCSD_OK;
+}
+
+ocsd_err_t DecodeTree::resetMemAccStats()
+{
+    waitDecodeIdle();
+    if (!m_default_mapper)
+        return OCSD_ERR_NOT_INIT;
+    m_default_mapper->resetMemAccStats();
+    return OCSD_OK;
+}
+
+ocsd_err_t DecodeTree::setCallbackMemAccReadAhead(const uint32_t min_block, const uint32_t max_block)
 {
+    waitDecodeIdle();
+    std::list<TrcMemAccessorBase *>::iterator it;
+
+    if (!TrcMemAccCB::readAheadSizesValid(min_block, max_block))
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    m_cb_read_ahead_min = min_block;
+    m_cb_read_ahead_max = max_block;
+    for (it = m_mem_accessors.begin(); it != m_mem_accessors.end(); it++)
+    {
+        if ((*it)->getType() == TrcMemAccessorBase::MEMACC_CB_IF)
+            static_cast<TrcMemAccCB *>(*it)->setReadAhead(min_block, max_block);
+    }
+    return OCSD_OK;
+}
+
+/* Memory accessor creation - on default mem accessor, using the 0 CSID for global core space unless a CSID is given. */
+ocsd_err_t DecodeTree::addBufferMemAcc(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t *p_mem_buffer, const uint32_t mem_length, const uint8_t cs_trace_id /* = 0 */)
+{
+    waitDecodeIdle();
     if(!hasMemAccMapper())
         return OCSD_ERR_NOT_INIT;
 
@@ -296,7 +415,7 @@ ocsd_err_t DecodeTree::addBufferMemAcc(const ocsd_vaddr_t address, const ocsd_me
         if(pMBuffAcc)
         {
             pMBuffAcc->setMemSpace(mem_space);
-            err = m_default_mapper->AddAccessor(p_accessor,0);
+            err = m_default_mapper->AddAccessor(p_accessor,cs_trace_id);
         }
         else
             err = OCSD_ERR_MEM;    // wrong type of object - treat as mem error
@@ -309,8 +428,9 @@ ocsd_err_t DecodeTree::addBufferMemAcc(const ocsd_vaddr_t address, const ocsd_me
     return err;
 }
 
-ocsd_err_t DecodeTree::addBinFileMemAcc(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const std::string &filepath)
+ocsd_err_t DecodeTree::addBinFileMemAcc(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const std::string &filepath, const uint32_t file_acc_opts /* = OCSD_FILE_MEM_ACC_OPT_NONE */, const uint8_t cs_trace_id /* = 0 */)
 {
+    waitDecodeIdle();
     if(!hasMemAccMapper())
         return OCSD_ERR_NOT_INIT;
     
@@ -318,15 +438,14 @@ ocsd_err_t DecodeTree::addBinFileMemAcc(const ocsd_vaddr_t address, const ocsd_m
         return OCSD_ERR_INVALID_PARAM_VAL;
 
     TrcMemAccessorBase *p_accessor;
-    ocsd_err_t err = TrcMemAccFactory::CreateFileAccessor(&p_accessor,filepath,address);
+    ocsd_err_t err = TrcMemAccFactory::CreateFileAccessor(&p_accessor,filepath,address,0,0,file_acc_opts,mem_space);
 
     if(err == OCSD_OK)
     {
         TrcMemAccessorFile *pAcc = dynamic_cast<TrcMemAccessorFile *>(p_accessor);
         if(pAcc)
         {
-            pAcc->setMemSpace(mem_space);
-            err = m_default_mapper->AddAccessor(pAcc,0);
+            err = m_default_mapper->AddAccessor(pAcc,cs_trace_id);
         }
         else
             err = OCSD_ERR_MEM;    // wrong type of object - treat as mem error
@@ -340,8 +459,9 @@ ocsd_err_t DecodeTree::addBinFileMemAcc(const ocsd_vaddr_t address, const ocsd_m
 
 }
 
-ocsd_err_t DecodeTree::addBinFileRegionMemAcc(const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const std::string &filepath)
+ocsd_err_t DecodeTree::addBinFileRegionMemAcc(const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const std::string &filepath, const uint32_t file_acc_opts /* = OCSD_FILE_MEM_ACC_OPT_NONE */, const uint8_t cs_trace_id /* = 0 */)
 {
+    waitDecodeIdle();
     if(!hasMemAccMapper())
         return OCSD_ERR_NOT_INIT;
 
@@ -352,7 +472,7 @@ ocsd_err_t DecodeTree::addBinFileRegionMemAcc(const ocsd_file_mem_region_t *regi
     int curr_region_idx = 0;
 
     // add first region during the creation of the file accessor.
-    ocsd_err_t err = TrcMemAccFactory::CreateFileAccessor(&p_accessor,filepath,region_array[curr_region_idx].start_address,region_array[curr_region_idx].file_offset, region_array[curr_region_idx].region_size);            
+    ocsd_err_t err = TrcMemAccFactory::CreateFileAccessor(&p_accessor,filepath,region_array[curr_region_idx].start_address,region_array[curr_region_idx].file_offset, region_array[curr_region_idx].region_size, file_acc_opts, mem_space);            
     if(err == OCSD_OK)
     {
         TrcMemAccessorFile *pAcc = dynamic_cast<TrcMemAccessorFile *>(p_accessor);
@@ -367,10 +487,9 @@ ocsd_err_t DecodeTree::addBinFileRegionMemAcc(const ocsd_file_mem_region_t *regi
                                         region_array[curr_region_idx].file_offset);
                 curr_region_idx++;
             }
-            pAcc->setMemSpace(mem_space);
 
             // add the accessor to the map.
-            err = m_default_mapper->AddAccessor(pAcc,0);
+            err = m_default_mapper->AddAccessor(pAcc,cs_trace_id);
         }
         else
             err = OCSD_ERR_MEM;    // wrong type of object - treat as mem error
@@ -385,6 +504,7 @@ ocsd_err_t DecodeTree::addBinFileRegionMemAcc(const ocsd_file_mem_region_t *regi
 
 ocsd_err_t DecodeTree::updateBinFileRegionMemAcc(const ocsd_file_mem_region_t *region_array, const int num_regions, const ocsd_mem_space_acc_t mem_space, const std::string &filepath)
 {
+    waitDecodeIdle();
     if (!hasMemAccMapper())
         return OCSD_ERR_NOT_INIT;
 
@@ -395,25 +515,32 @@ ocsd_err_t DecodeTree::updateBinFileRegionMemAcc(const ocsd_file_mem_region_t *r
     if (!pAcc) 
         return OCSD_ERR_INVALID_PARAM_VAL;
 
+    ocsd_err_t err = OCSD_OK;
     int curr_region_idx = 0;
-    while (curr_region_idx < num_regions)
+    while ((curr_region_idx < num_regions) && (err == OCSD_OK))
     {
         // check "new" range
         if (!pAcc->addrStartOfRange(region_array[curr_region_idx].start_address))
         {
-            // ensure adds cleanly
+            // ensure adds cleanly - or was added by a tree on another thread sharing the accessor.
             if (!pAcc->AddOffsetRange(region_array[curr_region_idx].start_address,
                 region_array[curr_region_idx].region_size,
-                region_array[curr_region_idx].file_offset))
-                return OCSD_ERR_INVALID_PARAM_VAL;  // otherwise bail out
+                region_array[curr_region_idx].file_offset) &&
+                !pAcc->addrStartOfRange(region_array[curr_region_idx].start_address))
+                err = OCSD_ERR_INVALID_PARAM_VAL;  // otherwise bail out
         }
         curr_region_idx++;
     }
-    return OCSD_OK;
+
+    // mapper needs to see any new regions
+    m_default_mapper->updateAccessorRanges();
+    return err;
 }
+
 ocsd_err_t DecodeTree::initCallbackMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, 
-    const ocsd_mem_space_acc_t mem_space, void *p_cb_func, bool IDfn, const void *p_context)
+    const ocsd_mem_space_acc_t mem_space, void *p_cb_func, bool IDfn, const void *p_context, const uint8_t cs_trace_id)
 {
+    waitDecodeIdle();
     if(!hasMemAccMapper())
         return OCSD_ERR_NOT_INIT;
 
@@ -432,7 +559,9 @@ ocsd_err_t DecodeTree::initCallbackMemAcc(const ocsd_vaddr_t st_address, const o
             else
                 pCBAcc->setCBIfFn((Fn_MemAcc_CB)p_cb_func, p_context);
 
-            err = m_default_mapper->AddAccessor(p_accessor,0);
+            err = pCBAcc->setReadAhead(m_cb_read_ahead_min, m_cb_read_ahead_max);
+            if (err == OCSD_OK)
+                err = m_default_mapper->AddAccessor(p_accessor,cs_trace_id);
         }
         else
             err = OCSD_ERR_MEM;    // wrong type of object - treat as mem error
@@ -445,21 +574,40 @@ ocsd_err_t DecodeTree::initCallbackMemAcc(const ocsd_vaddr_t st_address, const o
     return err;
 }
 
-ocsd_err_t DecodeTree::addCallbackMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAcc_CB p_cb_func, const void *p_context)
+ocsd_err_t DecodeTree::addCallbackMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAcc_CB p_cb_func, const void *p_context, const uint8_t cs_trace_id /* = 0 */)
+{
+    return initCallbackMemAcc(st_address, en_address, mem_space, (void *)p_cb_func, false, p_context, cs_trace_id);
+}
+
+ocsd_err_t DecodeTree::addCallbackIDMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAccID_CB p_cb_func, const void *p_context, const uint8_t cs_trace_id /* = 0 */)
 {
-    return initCallbackMemAcc(st_address, en_address, mem_space, (void *)p_cb_func, false, p_context);
+    return initCallbackMemAcc(st_address, en_address, mem_space, (void *)p_cb_func, true, p_context, cs_trace_id);
 }
 
-ocsd_err_t DecodeTree::addCallbackIDMemAcc(const ocsd_vaddr_t st_address, const ocsd_vaddr_t en_address, const ocsd_mem_space_acc_t mem_space, Fn_MemAccID_CB p_cb_func, const void *p_context)
+ocsd_err_t DecodeTree::removeMemAccByAddress(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id /* = 0 */)
 {
-    return initCallbackMemAcc(st_address, en_address, mem_space, (void *)p_cb_func, true, p_context);
+    waitDecodeIdle();
+    if(!hasMemAccMapper())
+        return OCSD_ERR_NOT_INIT;
+    return m_default_mapper->RemoveAccessorByAddress(address,mem_space,cs_trace_id);
 }
 
-ocsd_err_t DecodeTree::removeMemAccByAddress(const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space)
+ocsd_err_t DecodeTree::addCodeMapFile(const std::string &map_path, const ocsd_mem_space_acc_t mem_space, const uint8_t cs_trace_id /* = 0 */)
 {
+    waitDecodeIdle();
     if(!hasMemAccMapper())
         return OCSD_ERR_NOT_INIT;
-    return m_default_mapper->RemoveAccessorByAddress(address,mem_space,0);
+
+    TrcMemAccCodeMap *p_map = new (std::nothrow) TrcMemAccCodeMap();
+    if(p_map == 0)
+        return OCSD_ERR_MEM;
+
+    ocsd_err_t err = p_map->loadMap(map_path);
+    if(err == OCSD_OK)
+        err = m_default_mapper->AddCodeMap(p_map, mem_space, cs_trace_id);
+    if(err != OCSD_OK)
+        delete p_map;
+    return err;
 }
 
 ocsd_err_t DecodeTree::createDecoder(const std::string &decoderName, const int createFlags, const CSConfig *pConfig)
@@ -476,9 +624,12 @@ ocsd_err_t DecodeTree::createDecoder(const std::string &decoderName, const int c
         crtFlags |= OCSD_CREATE_FLG_INST_ID;
     }
 
+    // decoders on worker threads share the instruction decoder.
+    waitDecodeIdle();
+
     // check for the aa64 check.
     if (createFlags & ETM4_OPFLG_PKTDEC_AA64_OPCODE_CHK)
-        s_instruction_decoder.setAA64_errOnBadOpcode(true);
+        m_instruction_decoder.setAA64_errOnBadOpcode(true);
 
     // create the decode element to attach to the channel.
     if((err = createDecodeElement(CSID)) != OCSD_OK)
@@ -501,7 +652,7 @@ ocsd_err_t DecodeTree::createDecoder(const std::string &decoderName, const int c
 
     // always attach an error logger
     if(err == OCSD_OK)
-        err = pDecoderMngr->attachErrorLogger(pTraceComp,DecodeTree::s_i_error_logger);
+        err = pDecoderMngr->attachErrorLogger(pTraceComp,elemErrorLogI());
 
     // if we created a packet decoder it may need additional components.
     if(crtFlags &  OCSD_CREATE_FLG_FULL_DECODER)
@@ -513,13 +664,13 @@ ocsd_err_t DecodeTree::createDecoder(const std::string &decoderName, const int c
             err = OCSD_OK;
 
         if(m_i_mem_access && (err == OCSD_OK))
-            err = pDecoderMngr->attachMemAccessor(pTraceComp,m_i_mem_access);
+            err = pDecoderMngr->attachMemAccessor(pTraceComp,elemMemAccessI());
 
         if(err == OCSD_ERR_DCD_INTERFACE_UNUSED)    // ignore if mem accessor refused
             err = OCSD_OK;
 
         if( m_i_gen_elem_out && (err == OCSD_OK))
-            err = pDecoderMngr->attachOutputSink(pTraceComp,m_i_gen_elem_out);
+            err = pDecoderMngr->attachOutputSink(pTraceComp,elemGenElemOutI());
     }
 
     // finally attach the packet processor input to the demux output channel
@@ -530,7 +681,7 @@ ocsd_err_t DecodeTree::createDecoder(const std::string &decoderName, const int c
         {
             // got the interface -> attach to demux, or direct to input of decode tree
             if(usingFormatter())
-                err = m_frame_deformatter_root->getIDStreamAttachPt(CSID)->attach(pDataIn);
+                err = connectDataIn(CSID, pDataIn);
             else
                 m_i_decoder_root = pDataIn;
         }
@@ -565,6 +716,7 @@ ocsd_err_t DecodeTree::getDecoderStats(const uint8_t CSID, ocsd_decode_stats_t *
     TrcPktProcI *pPktProc = getPktProcI(CSID);
     if (!pPktProc)
         return OCSD_ERR_INVALID_PARAM_VAL;
+    waitDecodeIdle();
     err = pPktProc->getStatsBlock(p_stats_block);
     if (err == OCSD_OK) {
         // copy in the global demux stats.
@@ -582,6 +734,7 @@ ocsd_err_t DecodeTree::resetDecoderStats(const uint8_t CSID)
     TrcPktProcI *pPktProc = getPktProcI(CSID);
     if (!pPktProc)
         return OCSD_ERR_INVALID_PARAM_VAL;
+    waitDecodeIdle();
     pPktProc->resetStats();
 
     // reset the global demux stats.
@@ -666,7 +819,7 @@ bool DecodeTree::initialise(const ocsd_dcd_tree_src_t type, uint32_t formatterCf
         {
             if (m_frame_deformatter_root->Init() != OCSD_OK)
                 return false;
-            m_frame_deformatter_root->getErrLogAttachPt()->attach(DecodeTree::s_i_error_logger);
+            m_frame_deformatter_root->getErrLogAttachPt()->attach(getTreeErrorLogI());
             err = m_frame_deformatter_root->Configure(formatterCfgFlags);
             if (err != OCSD_OK)
                 return false;
@@ -678,7 +831,10 @@ bool DecodeTree::initialise(const ocsd_dcd_tree_src_t type, uint32_t formatterCf
     }
 
     // set debug error logger on the decoder.
-    TrcIDecode::setErrLogger(getCurrentErrorLogI());
+    {
+        std::lock_guard<std::mutex> lock(s_tree_lock);
+        TrcIDecode::setErrLogger(s_i_error_logger);
+    }
 
     return true;
 }
@@ -713,6 +869,10 @@ void DecodeTree::destroyDecodeElement(const uint8_t CSID)
     {
         if(m_decode_elements[CSID] != 0)
         {
+            // disconnect from the deformatter before destroying the decoder.
+            waitDecodeIdle();
+            if(usingFormatter())
+                connectDataIn(CSID, 0);
             m_decode_elements[CSID]->DestroyElem();
             delete m_decode_elements[CSID];
             m_decode_elements[CSID] = 0;
@@ -725,6 +885,7 @@ ocsd_err_t DecodeTree::setIDFilter(std::vector<uint8_t> &ids)
     ocsd_err_t err = OCSD_ERR_DCDT_NO_FORMATTER;
     if(usingFormatter())
     {
+        waitDecodeIdle();
         err = m_frame_deformatter_root->OutputFilterAllIDs(false);
         if(err == OCSD_OK)
             err = m_frame_deformatter_root->OutputFilterIDs(ids,true);
@@ -737,11 +898,151 @@ ocsd_err_t DecodeTree::clearIDFilter()
     ocsd_err_t err = OCSD_ERR_DCDT_NO_FORMATTER;
     if(usingFormatter())
     {
+        waitDecodeIdle();
         err = m_frame_deformatter_root->OutputFilterAllIDs(true);
     }
     return err;
 }
 
+/* threaded decode */
+ocsd_err_t DecodeTree::setDecodeThreads(const int num_threads, const ocsd_dcd_thread_out_t out_mode /* = OCSD_DCD_THREAD_OUT_SERIAL */)
+{
+    return startDecodeThreads(num_threads, out_mode, false);
+}
+
+ocsd_err_t DecodeTree::setDecodePipeline(const int num_threads, const ocsd_dcd_thread_out_t out_mode /* = OCSD_DCD_THREAD_OUT_SERIAL */)
+{
+    return startDecodeThreads(num_threads, out_mode, true);
+}
+
+ocsd_err_t DecodeTree::startDecodeThreads(const int num_threads, const ocsd_dcd_thread_out_t out_mode, const bool bPipeline)
+{
+    ocsd_err_t err = OCSD_OK;
+    DcdTreeThreads *p_threads = m_p_threads;
+
+    if(!usingFormatter())
+        return OCSD_ERR_DCDT_NO_FORMATTER;
+
+    if((num_threads < 0) || (num_threads > OCSD_DCD_THREADS_MAX))
+        return OCSD_ERR_INVALID_PARAM_VAL;
+
+    // finish any current threaded decode, and move decoders back to the caller thread.
+    if(p_threads)
+    {
+        p_threads->stop();
+        m_p_threads = 0;
+        connectDecodeElements(p_threads);
+        delete p_threads;
+    }
+
+    if(num_threads == 0)
+        return OCSD_OK;
+
+    p_threads = new (std::nothrow) DcdTreeThreads();
+    if(!p_threads)
+        return OCSD_ERR_MEM;
+
+    // workers use the interfaces the tree has attached to the decoders.
+    p_threads->getMemAccessI()->setMemAccessI(m_i_mem_access);
+    p_threads->getGenElemOutI()->setGenElemOutI(m_i_gen_elem_out);
+    err = p_threads->start(num_threads, out_mode, bPipeline ? m_i_decoder_root : 0);
+    if(err != OCSD_OK)
+    {
+        delete p_threads;
+        return err;
+    }
+
+    m_p_threads = p_threads;
+    connectDecodeElements(p_threads);
+    return OCSD_OK;
+}
+
+const int DecodeTree::getDecodeThreads() const
+{
+    return m_p_threads ? m_p_threads->numThreads() : 0;
+}
+
+const bool DecodeTree::isDecodePipelined() const
+{
+    return m_p_threads ? m_p_threads->isPipeline() : false;
+}
+
+ITraceErrorLog *DecodeTree::elemErrorLogI()
+{
+    if(m_p_threads)
+        return m_p_threads->lockedErrorLogI(getTreeErrorLogI());
+    return getTreeErrorLogI();
+}
+
+ITargetMemAccess *DecodeTree::elemMemAccessI()
+{
+    if(m_p_threads && m_i_mem_access)
+        return m_p_threads->getMemAccessI();
+    return m_i_mem_access;
+}
+
+ITrcGenElemIn *DecodeTree::elemGenElemOutI()
+{
+    if(m_p_threads && m_i_gen_elem_out && (m_p_threads->outMode() == OCSD_DCD_THREAD_OUT_SERIAL))
+        return m_p_threads->getGenElemOutI();
+    return m_i_gen_elem_out;
+}
+
+// connect decoder input to the deformatter - through the ID queue if decoding on worker threads.
+ocsd_err_t DecodeTree::connectDataIn(const uint8_t CSID, ITrcDataIn *pDataIn)
+{
+    if(m_p_threads)
+    {
+        ocsd_err_t err = m_p_threads->connectIDQueue(CSID, pDataIn);
+        if(err != OCSD_OK)
+            return err;
+        if(pDataIn)
+            pDataIn = m_p_threads->getIDQueue(CSID);
+    }
+    return m_frame_deformatter_root->getIDStreamAttachPt(CSID)->replace_first(pDataIn);
+}
+
+// attach the interfaces for the current decode mode to all the decoders in the tree.
+// Error loggers already attached are swapped for, or restored from, the serialising loggers in p_threads.
+void DecodeTree::connectDecodeElements(DcdTreeThreads *p_threads)
+{
+    uint8_t elemID;
+    ITrcDataIn *pDataIn;
+    ITraceErrorLog *p_err_log;
+    DecodeTreeElement *pElem = getFirstElement(elemID);
+
+    while(pElem != 0)
+    {
+        p_err_log = pElem->getDecoderHandle()->getErrorLogAttachPt()->first();
+        p_err_log = m_p_threads ? p_threads->lockedErrorLogI(p_err_log) : p_threads->callerErrorLogI(p_err_log);
+        pElem->getDecoderMngr()->attachErrorLogger(pElem->getDecoderHandle(), p_err_log);
+        if(m_i_mem_access)
+            pElem->getDecoderMngr()->attachMemAccessor(pElem->getDecoderHandle(), elemMemAccessI());
+        if(m_i_gen_elem_out)
+            pElem->getDecoderMngr()->attachOutputSink(pElem->getDecoderHandle(), elemGenElemOutI());
+        if(pElem->getDecoderMngr()->getDataInputI(pElem->getDecoderHandle(), &pDataIn) == OCSD_OK)
+            connectDataIn(elemID, pDataIn);
+        pElem = getNextElement(elemID);
+    }
+
+    // deformatter and memory mapper log errors on the caller and worker threads.
+    p_err_log = m_frame_deformatter_root->getErrLogAttachPt()->first();
+    p_err_log = m_p_threads ? p_threads->lockedErrorLogI(p_err_log) : p_threads->callerErrorLogI(p_err_log);
+    m_frame_deformatter_root->getErrLogAttachPt()->replace_first(p_err_log);
+    if(m_default_mapper)
+    {
+        p_err_log = m_default_mapper->getErrorLog();
+        p_err_log = m_p_threads ? p_threads->lockedErrorLogI(p_err_log) : p_threads->callerErrorLogI(p_err_log);
+        m_default_mapper->setErrorLog(p_err_log);
+    }
+}
+
+void DecodeTree::waitDecodeIdle()
+{
+    if(m_p_threads)
+        m_p_threads->waitIdle();
+}
+
 /** add a protocol packet printer */
 ocsd_err_t DecodeTree::addPacketPrinter(uint8_t CSID, bool bMonitor, ItemPrinter **ppPrinter)
 {
@@ -752,10 +1053,11 @@ ocsd_err_t DecodeTree::addPacketPrinter(uint8_t CSID, bool bMonitor, ItemPrinter
         ocsd_trace_protocol_t protocol = pElement->getProtocol();
         ItemPrinter *pPrinter;
 
+        waitDecodeIdle();
         pPrinter = PktPrinterFact::createProtocolPrinter(getPrinterList(), protocol, CSID);        
         if (pPrinter)
         {
-            pPrinter->setMessageLogger(getCurrentErrorLogI()->getOutputLogger());
+            pPrinter->setMessageLogger(getTreeErrorLogI()->getOutputLogger());
             switch (protocol)
             {
             case  OCSD_PROTOCOL_ETMV4I:
@@ -833,7 +1135,8 @@ ocsd_err_t DecodeTree::addRawFramePrinter(RawFramePrinter **ppPrinter, uint32_t
     RawFramePrinter *pPrinter = PktPrinterFact::createRawFramePrinter(getPrinterList());
     if (pPrinter)
     {
-        pPrinter->setMessageLogger((DecodeTree::getCurrentErrorLogI()->getOutputLogger()));
+        pPrinter->setMessageLogger(getTreeErrorLogI()->getOutputLogger());
+        waitDecodeIdle();
         TraceFormatterFrameDecoder *pFrameDecoder = getFrameDeformatter();
         uint32_t cfgFlags = pFrameDecoder->getConfigFlags();
         cfgFlags |= ((uint32_t)flags & (OCSD_DFRMTR_PACKED_RAW_OUT | OCSD_DFRMTR_UNPACKED_RAW_OUT));
@@ -852,7 +1155,7 @@ ocsd_err_t DecodeTree::addGenElemPrinter(TrcGenericElementPrinter **ppPrinter)
     TrcGenericElementPrinter *pPrinter = PktPrinterFact::createGenElemPrinter(getPrinterList());
     if (pPrinter)
     {
-        pPrinter->setMessageLogger((DecodeTree::getCurrentErrorLogI()->getOutputLogger()));
+        pPrinter->setMessageLogger(getTreeErrorLogI()->getOutputLogger());
         setGenTraceElemOutI(pPrinter);
         err = OCSD_OK;
         if (ppPrinter)
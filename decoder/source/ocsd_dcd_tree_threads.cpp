@@ -0,0 +1,924 @@
+/*
+* \file       ocsd_dcd_tree_threads.cpp
+* \brief      OpenCSD : Worker threads for per trace ID decode in a decode tree.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#include "common/ocsd_dcd_tree_threads.h"
+#include "mem_acc/trc_mem_acc_mapper.h"
+
+/***************************************************************/
+/* ID input queue */
+
+DcdTreeIDQueue::DcdTreeIDQueue() :
+    m_p_data_in(0),
+    m_p_threads(0),
+    m_ready(false),
+    m_busy(false),
+    m_resp(OCSD_RESP_CONT),
+    m_p_ring(0),
+    m_pipe_worker(0),
+    m_pipe_resp(OCSD_RESP_CONT)
+{
+}
+
+ocsd_datapath_resp_t DcdTreeIDQueue::TraceDataIn(const ocsd_datapath_op_t op,
+                                                 const ocsd_trc_index_t index,
+                                                 const uint32_t dataBlockSize,
+                                                 const uint8_t *pDataBlock,
+                                                 uint32_t *numBytesProcessed)
+{
+    queue_blk_t blk;
+
+    if (m_p_ring)
+        return pipeDataIn(op, index, dataBlockSize, pDataBlock, numBytesProcessed);
+
+    blk.op = op;
+    blk.index = index;
+    blk.offset = (uint32_t)m_pend.data.size();
+    blk.size = 0;
+    if (op == OCSD_OP_DATA)
+    {
+        blk.size = dataBlockSize;
+        m_pend.data.insert(m_pend.data.end(), pDataBlock, pDataBlock + dataBlockSize);
+        *numBytesProcessed = dataBlockSize;
+    }
+    m_pend.blks.push_back(blk);
+
+    // decoder responses are collected by the decode tree once the workers have run.
+    return OCSD_RESP_CONT;
+}
+
+// pipelined decode - copy into the ring for the decoder thread. Called on the deformatter thread.
+ocsd_datapath_resp_t DcdTreeIDQueue::pipeDataIn(const ocsd_datapath_op_t op,
+                                                const ocsd_trc_index_t index,
+                                                const uint32_t dataBlockSize,
+                                                const uint8_t *pDataBlock,
+                                                uint32_t *numBytesProcessed)
+{
+    DcdPipeEvent &dcd_evt = m_p_threads->m_pipe_workers[m_pipe_worker]->evt;
+    pipe_blk_t *p_blk;
+    uint32_t used = 0;
+
+    if ((op == OCSD_OP_DATA) && dataBlockSize)
+    {
+        while ((used < dataBlockSize) && ((p_blk = m_p_ring->tailBlk()) != 0))
+        {
+            p_blk->op = op;
+            p_blk->index = index + used;
+            p_blk->size = ((dataBlockSize - used) > OCSD_DCD_PIPE_ID_BLK) ? OCSD_DCD_PIPE_ID_BLK : (dataBlockSize - used);
+            memcpy(p_blk->data, pDataBlock + used, p_blk->size);
+            used += p_blk->size;
+            m_p_ring->push();
+        }
+        *numBytesProcessed = used;
+        dcd_evt.notify();
+
+        // ring full - the deformatter holds the rest of the frame until the deformatter thread flushes it.
+        if (used < dataBlockSize)
+        {
+            m_p_threads->m_p_blocked = this;
+            return OCSD_RESP_WAIT;
+        }
+        return OCSD_RESP_CONT;
+    }
+
+    // flushes to resume after a full ring are not passed on - the decoder thread handles output WAITs itself.
+    if ((op == OCSD_OP_FLUSH) && m_p_threads->m_bp_flush)
+        return OCSD_RESP_CONT;
+
+    // none data ops (and empty data blocks, so the packet processor sees the same calls) are always queued - wait for space.
+    m_p_threads->m_dfmt_evt.wait([this]() { return !m_p_ring->full(); });
+    p_blk = m_p_ring->tailBlk();
+    p_blk->op = op;
+    p_blk->index = index;
+    p_blk->size = 0;
+    m_p_ring->push();
+    dcd_evt.notify();
+    if (op == OCSD_OP_DATA)
+        *numBytesProcessed = 0;
+    return OCSD_RESP_CONT;
+}
+
+/***************************************************************/
+/* locked interfaces */
+
+void DcdTreeLockedMemAcc::setMemAccessI(ITargetMemAccess *p_mem_acc)
+{
+    m_p_mem_acc = p_mem_acc;
+    m_per_id = (dynamic_cast<TrcMemAccMapPerTraceID *>(p_mem_acc) != 0);
+}
+
+ocsd_err_t DcdTreeLockedMemAcc::ReadTargetMemory(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space,
+                                                 uint32_t *num_bytes, uint8_t *p_buffer)
+{
+    std::lock_guard<std::mutex> lock(lockFor(cs_trace_id));
+    return m_p_mem_acc->ReadTargetMemory(address, cs_trace_id, mem_space, num_bytes, p_buffer);
+}
+
+ocsd_err_t DcdTreeLockedMemAcc::ReadTargetMemoryPtr(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space,
+                                                    uint32_t *num_bytes, const uint8_t **pp_data)
+{
+    // read state is per ID - reads for other IDs do not change the data at the mapper pointer.
+    if (m_per_id)
+    {
+        std::lock_guard<std::mutex> lock(m_id_lock[cs_trace_id & 0x7F]);
+        return m_p_mem_acc->ReadTargetMemoryPtr(address, cs_trace_id, mem_space, num_bytes, pp_data);
+    }
+
+    std::vector<uint8_t> &win = m_win[cs_trace_id & 0x7F];
+    uint32_t req_bytes = (*num_bytes > OCSD_DCD_THREAD_MEM_WIN) ? OCSD_DCD_THREAD_MEM_WIN : *num_bytes;
+    const uint8_t *p_data = 0;
+    ocsd_err_t err;
+
+    if (win.size() < OCSD_DCD_THREAD_MEM_WIN)
+        win.resize(OCSD_DCD_THREAD_MEM_WIN);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    err = m_p_mem_acc->ReadTargetMemoryPtr(address, cs_trace_id, mem_space, num_bytes, &p_data);
+    if (err == OCSD_ERR_DCD_INTERFACE_UNUSED)
+    {
+        *num_bytes = req_bytes;
+        err = m_p_mem_acc->ReadTargetMemory(address, cs_trace_id, mem_space, num_bytes, win.data());
+    }
+    else
+    {
+        // copy out of the mapper while locked - take any extra bytes returned, up to the window size.
+        if (!p_data || (*num_bytes > OCSD_DCD_THREAD_MEM_WIN))
+            *num_bytes = p_data ? OCSD_DCD_THREAD_MEM_WIN : 0;
+        if (*num_bytes)
+            memcpy(win.data(), p_data, *num_bytes);
+    }
+    *pp_data = *num_bytes ? win.data() : 0;
+    return err;
+}
+
+void DcdTreeLockedMemAcc::InvalidateMemAccCache(const uint8_t cs_trace_id)
+{
+    std::lock_guard<std::mutex> lock(lockFor(cs_trace_id));
+    m_p_mem_acc->InvalidateMemAccCache(cs_trace_id);
+}
+
+void DcdTreeLockedMemAcc::SetMemAccContext(const uint8_t cs_trace_id, const uint64_t ctxt_tag)
+{
+    std::lock_guard<std::mutex> lock(lockFor(cs_trace_id));
+    m_p_mem_acc->SetMemAccContext(cs_trace_id, ctxt_tag);
+}
+
+ocsd_err_t DcdTreeLockedMemAcc::GetMemAccGeneration(const uint8_t cs_trace_id, uint32_t *p_generation)
+{
+    std::lock_guard<std::mutex> lock(lockFor(cs_trace_id));
+    return m_p_mem_acc->GetMemAccGeneration(cs_trace_id, p_generation);
+}
+
+ocsd_err_t DcdTreeLockedMemAcc::FindCodeMapWaypoint(const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space,
+                                                    ocsd_instr_info *instr_info, uint32_t *num_instr)
+{
+    std::lock_guard<std::mutex> lock(lockFor(cs_trace_id));
+    return m_p_mem_acc->FindCodeMapWaypoint(cs_trace_id, mem_space, instr_info, num_instr);
+}
+
+ocsd_datapath_resp_t DcdTreeLockedElemOut::TraceElemIn(const ocsd_trc_index_t index_sop,
+                                                       const uint8_t trc_chan_id,
+                                                       const OcsdTraceElement &el)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    return m_p_elem_out->TraceElemIn(index_sop, trc_chan_id, el);
+}
+
+const ocsd_hndl_err_log_t DcdTreeLockedErrLog::RegisterErrorSource(const std::string &component_name)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    return m_p_err_log->RegisterErrorSource(component_name);
+}
+
+const ocsd_err_severity_t DcdTreeLockedErrLog::GetErrorLogVerbosity() const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    return m_p_err_log->GetErrorLogVerbosity();
+}
+
+void DcdTreeLockedErrLog::LogError(const ocsd_hndl_err_log_t handle, const ocsdError *Error)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    m_p_err_log->LogError(handle, Error);
+}
+
+void DcdTreeLockedErrLog::LogMessage(const ocsd_hndl_err_log_t handle, const ocsd_err_severity_t filter_level, const std::string &msg)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    m_p_err_log->LogMessage(handle, filter_level, msg);
+}
+
+ocsdError *DcdTreeLockedErrLog::GetLastError()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    return m_p_err_log->GetLastError();
+}
+
+ocsdError *DcdTreeLockedErrLog::GetLastIDError(const uint8_t chan_id)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    return m_p_err_log->GetLastIDError(chan_id);
+}
+
+ocsdMsgLogger *DcdTreeLockedErrLog::getOutputLogger()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    return m_p_err_log->getOutputLogger();
+}
+
+void DcdTreeLockedErrLog::setOutputLogger(ocsdMsgLogger *pLogger)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    m_p_err_log->setOutputLogger(pLogger);
+}
+
+/***************************************************************/
+/* worker thread pool */
+
+DcdTreeThreads::DcdTreeThreads() :
+    m_num_active(0),
+    m_stop(false),
+    m_out_mode(OCSD_DCD_THREAD_OUT_SERIAL),
+    m_num_threads(0),
+    m_p_pipe_in(0),
+    m_p_in_ring(0),
+    m_next_pipe_worker(0),
+    m_pipe_stop(false),
+    m_in_wait(false),
+    m_p_blocked(0),
+    m_bp_flush(false),
+    m_dfmt_resp(OCSD_RESP_CONT),
+    m_dfmt_fatal(OCSD_RESP_CONT),
+    m_elem_out(m_out_lock)
+{
+    for (int id = 0; id < 128; id++)
+        m_queues[id].m_p_threads = this;
+}
+
+DcdTreeThreads::~DcdTreeThreads()
+{
+    stop();
+    for (size_t i = 0; i < m_err_logs.size(); i++)
+        delete m_err_logs[i];
+}
+
+ocsd_err_t DcdTreeThreads::start(const int num_threads, const ocsd_dcd_thread_out_t out_mode, ITrcDataIn *p_pipe_in /* = 0 */)
+{
+    ocsd_err_t err = OCSD_OK;
+
+    m_out_mode = out_mode;
+    m_num_threads = num_threads;
+    m_p_pipe_in = p_pipe_in;
+    try
+    {
+        if (m_p_pipe_in)
+            err = startPipeline(num_threads);
+        else
+        {
+            for (int i = 0; i < num_threads; i++)
+                m_workers.push_back(std::thread(&DcdTreeThreads::workerThread, this));
+        }
+    }
+    catch (std::system_error &)
+    {
+        err = OCSD_ERR_MEM;
+    }
+    catch (std::bad_alloc &)
+    {
+        err = OCSD_ERR_MEM;
+    }
+
+    if (err != OCSD_OK)
+        stop();
+    return err;
+}
+
+void DcdTreeThreads::stop()
+{
+    if (m_p_pipe_in)
+    {
+        waitIdle();
+        stopPipeline();
+        return;
+    }
+
+    if (m_workers.empty())
+        return;
+
+    waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stop = true;
+    }
+    m_work_cv.notify_all();
+    for (size_t i = 0; i < m_workers.size(); i++)
+        m_workers[i].join();
+    m_workers.clear();
+    m_stop = false;
+    m_num_threads = 0;
+}
+
+ITraceErrorLog *DcdTreeThreads::lockedErrorLogI(ITraceErrorLog *p_err_log)
+{
+    DcdTreeLockedErrLog *p_locked;
+
+    if (!p_err_log)
+        return 0;
+
+    for (size_t i = 0; i < m_err_logs.size(); i++)
+    {
+        if ((m_err_logs[i] == p_err_log) || (m_err_logs[i]->getErrorLogI() == p_err_log))
+            return m_err_logs[i];
+    }
+
+    p_locked = new (std::nothrow) DcdTreeLockedErrLog(m_out_lock);
+    if (!p_locked)
+        return p_err_log;
+    p_locked->setErrorLogI(p_err_log);
+    m_err_logs.push_back(p_locked);
+    return p_locked;
+}
+
+ITraceErrorLog *DcdTreeThreads::callerErrorLogI(ITraceErrorLog *p_err_log)
+{
+    for (size_t i = 0; i < m_err_logs.size(); i++)
+    {
+        if (m_err_logs[i] == p_err_log)
+            return m_err_logs[i]->getErrorLogI();
+    }
+    return p_err_log;
+}
+
+ocsd_datapath_resp_t DcdTreeThreads::submit()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    for (int id = 0; id < 128; id++)
+    {
+        DcdTreeIDQueue *pQueue = &m_queues[id];
+        if (pQueue->m_pend.blks.empty())
+            continue;
+
+        // limit the data queued for an ID - wait for the worker to take the queue.
+        while (pQueue->m_queue.data.size() >= OCSD_DCD_THREAD_QUEUE_MAX)
+            m_done_cv.wait(lock);
+        queueBuf(pQueue);
+    }
+    return collectResp();
+}
+
+ocsd_datapath_resp_t DcdTreeThreads::waitIdle()
+{
+    if (m_p_pipe_in)
+    {
+        m_caller_evt.wait([this]() { return pipeIdle(); });
+        std::lock_guard<std::mutex> lock(m_lock);
+        return collectResp();
+    }
+
+    submit();
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (m_num_active)
+        m_done_cv.wait(lock);
+    return collectResp();
+}
+
+// move pending blocks onto the queue and schedule the ID - pool lock held.
+void DcdTreeThreads::queueBuf(DcdTreeIDQueue *pQueue)
+{
+    DcdTreeIDQueue::queue_buf_t &pend = pQueue->m_pend;
+    DcdTreeIDQueue::queue_buf_t &queue = pQueue->m_queue;
+
+    if (queue.blks.empty())
+    {
+        queue.blks.swap(pend.blks);
+        queue.data.swap(pend.data);
+    }
+    else
+    {
+        uint32_t offset = (uint32_t)queue.data.size();
+        for (size_t i = 0; i < pend.blks.size(); i++)
+        {
+            queue.blks.push_back(pend.blks[i]);
+            queue.blks.back().offset += offset;
+        }
+        queue.data.insert(queue.data.end(), pend.data.begin(), pend.data.end());
+    }
+    pQueue->clearBuf(pend);
+
+    if (!pQueue->m_ready && !pQueue->m_busy)
+    {
+        pQueue->m_ready = true;
+        m_ready.push_back(pQueue);
+        m_num_active++;
+        m_work_cv.notify_one();
+    }
+}
+
+// worst response from the decoders since the last call - pool lock held.
+// Fatal responses remain on the ID until it is reset.
+ocsd_datapath_resp_t DcdTreeThreads::collectResp()
+{
+    ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
+
+    for (int id = 0; id < 128; id++)
+    {
+        if (m_queues[id].m_resp > resp)
+            resp = m_queues[id].m_resp;
+        if (!OCSD_DATA_RESP_IS_FATAL(m_queues[id].m_resp))
+            m_queues[id].m_resp = OCSD_RESP_CONT;
+    }
+    if (m_dfmt_fatal > resp)
+        resp = m_dfmt_fatal;
+    return resp;
+}
+
+void DcdTreeThreads::workerThread()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    DcdTreeIDQueue *pQueue;
+    ocsd_datapath_resp_t resp;
+    bool bReset;
+
+    while (true)
+    {
+        while (!m_stop && m_ready.empty())
+            m_work_cv.wait(lock);
+        if (m_ready.empty())
+            break;
+
+        // take all the blocks queued for the ID.
+        pQueue = m_ready.front();
+        m_ready.pop_front();
+        pQueue->m_ready = false;
+        pQueue->m_busy = true;
+        pQueue->m_active.blks.swap(pQueue->m_queue.blks);
+        pQueue->m_active.data.swap(pQueue->m_queue.data);
+        resp = OCSD_DATA_RESP_IS_FATAL(pQueue->m_resp) ? pQueue->m_resp : OCSD_RESP_CONT;
+        m_done_cv.notify_all();     // queue space for the caller.
+
+        lock.unlock();
+        resp = processQueue(pQueue, resp, bReset);
+        lock.lock();
+
+        pQueue->clearBuf(pQueue->m_active);
+        if (bReset || (resp > pQueue->m_resp))
+            pQueue->m_resp = resp;
+        pQueue->m_busy = false;
+
+        // more data arrived while processing - back on the ready list.
+        if (!pQueue->m_queue.blks.empty())
+        {
+            pQueue->m_ready = true;
+            m_ready.push_back(pQueue);
+        }
+        else
+            m_num_active--;
+        m_done_cv.notify_all();
+    }
+}
+
+// pass the blocks on to the packet processor - the only thread using the decoders for this ID.
+ocsd_datapath_resp_t DcdTreeThreads::processQueue(DcdTreeIDQueue *pQueue, ocsd_datapath_resp_t resp, bool &bReset)
+{
+    DcdTreeIDQueue::queue_buf_t &buf = pQueue->m_active;
+    ITrcDataIn *pDataIn = pQueue->m_p_data_in;
+    ocsd_datapath_resp_t blk_resp;
+
+    bReset = false;
+    if (!pDataIn)
+        return resp;
+
+    for (size_t i = 0; i < buf.blks.size(); i++)
+    {
+        const DcdTreeIDQueue::queue_blk_t &blk = buf.blks[i];
+
+        if (blk.op == OCSD_OP_RESET)
+        {
+            bReset = true;
+            resp = OCSD_RESP_CONT;
+        }
+        else if (OCSD_DATA_RESP_IS_FATAL(resp))
+            continue;   // drop data for the ID after a fatal error, until reset.
+
+        blk_resp = passBlock(pDataIn, blk.op, blk.index, blk.size, buf.data.data() + blk.offset);
+        if (blk_resp > resp)
+            resp = blk_resp;
+    }
+    return resp;
+}
+
+// pass a queued block or operation on to the packet processor.
+ocsd_datapath_resp_t DcdTreeThreads::passBlock(ITrcDataIn *pDataIn, const ocsd_datapath_op_t op, ocsd_trc_index_t index, uint32_t size, const uint8_t *p_data)
+{
+    ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
+    uint32_t used;
+
+    if (op == OCSD_OP_DATA)
+    {
+        // pass on every block as queued - the packet processor sees the same calls as on the caller thread.
+        do
+        {
+            used = 0;
+            resp = pDataIn->TraceDataIn(OCSD_OP_DATA, index, size, p_data, &used);
+            index += used;
+            p_data += used;
+            size -= used;
+
+            // no client to drive the flush - flush until the output accepts more, then send the rest of the block.
+            if (OCSD_DATA_RESP_IS_WAIT(resp))
+                resp = flushWait(pDataIn, resp);
+            else if (!used)
+                break;
+            if (OCSD_DATA_RESP_IS_FATAL(resp))
+                break;
+        } while (size);
+    }
+    else
+    {
+        resp = pDataIn->TraceDataIn(op, index, 0, 0, 0);
+        if (OCSD_DATA_RESP_IS_WAIT(resp))
+            resp = flushWait(pDataIn, resp);
+    }
+    return resp;
+}
+
+ocsd_datapath_resp_t DcdTreeThreads::flushWait(ITrcDataIn *pDataIn, ocsd_datapath_resp_t resp)
+{
+    while (OCSD_DATA_RESP_IS_WAIT(resp))
+    {
+        std::this_thread::yield();
+        resp = pDataIn->TraceDataIn(OCSD_OP_FLUSH, 0, 0, 0, 0);
+    }
+    return resp;
+}
+
+/***************************************************************/
+/* pipelined decode */
+
+// input ring, deformatter thread and decoder threads - exceptions handled by start().
+ocsd_err_t DcdTreeThreads::startPipeline(const int num_threads)
+{
+    pipe_worker_t *p_worker;
+
+    m_p_in_ring = new (std::nothrow) DcdPipeRing<pipe_in_blk_t>();
+    if (!m_p_in_ring || !m_p_in_ring->init(OCSD_DCD_PIPE_IN_BLKS))
+        return OCSD_ERR_MEM;
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        p_worker = new (std::nothrow) pipe_worker_t();
+        if (!p_worker)
+            return OCSD_ERR_MEM;
+        p_worker->num_ids.store(0);
+        m_pipe_workers.push_back(p_worker);
+    }
+
+    m_pipe_stop.store(false);
+    for (int i = 0; i < num_threads; i++)
+        m_workers.push_back(std::thread(&DcdTreeThreads::dcdThread, this, m_pipe_workers[i]));
+    m_workers.push_back(std::thread(&DcdTreeThreads::dfmtThread, this));
+    return OCSD_OK;
+}
+
+// end the pipeline threads - pipeline idle.
+void DcdTreeThreads::stopPipeline()
+{
+    m_pipe_stop.store(true);
+    m_dfmt_evt.notify();
+    for (size_t i = 0; i < m_pipe_workers.size(); i++)
+        m_pipe_workers[i]->evt.notify();
+    for (size_t i = 0; i < m_workers.size(); i++)
+        m_workers[i].join();
+    m_workers.clear();
+
+    for (int id = 0; id < 128; id++)
+    {
+        delete m_queues[id].m_p_ring;
+        m_queues[id].m_p_ring = 0;
+    }
+    for (size_t i = 0; i < m_pipe_workers.size(); i++)
+        delete m_pipe_workers[i];
+    m_pipe_workers.clear();
+    delete m_p_in_ring;
+    m_p_in_ring = 0;
+
+    m_p_pipe_in = 0;
+    m_next_pipe_worker = 0;
+    m_in_wait = false;
+    m_num_threads = 0;
+}
+
+ocsd_err_t DcdTreeThreads::connectIDQueue(const uint8_t id, ITrcDataIn *pDataIn)
+{
+    DcdTreeIDQueue *pQueue = getIDQueue(id);
+    DcdPipeRing<DcdTreeIDQueue::pipe_blk_t> *p_ring;
+    pipe_worker_t *p_worker;
+    int num_ids;
+
+    pQueue->setDataIn(pDataIn);
+    if (!m_p_pipe_in || !pDataIn || pQueue->m_p_ring)
+        return OCSD_OK;
+
+    // first connection of the ID in pipelined mode - add a ring, read by the next decoder thread in turn.
+    p_ring = new (std::nothrow) DcdPipeRing<DcdTreeIDQueue::pipe_blk_t>();
+    if (!p_ring || !p_ring->init(OCSD_DCD_PIPE_ID_BLKS))
+    {
+        delete p_ring;
+        pQueue->setDataIn(0);
+        return OCSD_ERR_MEM;
+    }
+    pQueue->m_p_ring = p_ring;
+    pQueue->m_pipe_worker = m_next_pipe_worker;
+    pQueue->m_pipe_resp = OCSD_RESP_CONT;
+    m_next_pipe_worker = (m_next_pipe_worker + 1) % (int)m_pipe_workers.size();
+
+    // called with the pipeline idle - the decoder thread sees the ID on its next pass.
+    p_worker = m_pipe_workers[pQueue->m_pipe_worker];
+    num_ids = p_worker->num_ids.load(std::memory_order_relaxed);
+    p_worker->ids[num_ids] = pQueue;
+    p_worker->num_ids.store(num_ids + 1, std::memory_order_release);
+    return OCSD_OK;
+}
+
+ocsd_datapath_resp_t DcdTreeThreads::pipeDataIn(const ocsd_datapath_op_t op,
+                                                const ocsd_trc_index_t index,
+                                                const uint32_t dataBlockSize,
+                                                const uint8_t *pDataBlock,
+                                                uint32_t *numBytesProcessed)
+{
+    pipe_in_blk_t *p_blk;
+    ocsd_datapath_resp_t resp;
+    uint32_t used = 0;
+
+    if (op == OCSD_OP_DATA)
+    {
+        if ((dataBlockSize == 0) || (pDataBlock == 0) || (numBytesProcessed == 0))
+            return OCSD_RESP_FATAL_INVALID_PARAM;
+
+        // input blocks are a multiple of the frame size, so keep the deformatter input alignment.
+        while ((used < dataBlockSize) && ((p_blk = m_p_in_ring->tailBlk()) != 0))
+        {
+            p_blk->op = op;
+            p_blk->index = index + used;
+            p_blk->size = ((dataBlockSize - used) > OCSD_DCD_PIPE_IN_BLK) ? OCSD_DCD_PIPE_IN_BLK : (dataBlockSize - used);
+            memcpy(p_blk->data, pDataBlock + used, p_blk->size);
+            used += p_blk->size;
+            m_p_in_ring->push();
+            m_dfmt_evt.notify();
+        }
+        *numBytesProcessed = used;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            resp = collectResp();
+        }
+
+        // fatal error - let the queued data drain first, so the client can stop decode once it sees the error.
+        if (OCSD_DATA_RESP_IS_FATAL(resp))
+            return waitIdle();
+        if (used < dataBlockSize)
+        {
+            m_in_wait = true;
+            resp = OCSD_RESP_WAIT;
+        }
+        return resp;
+    }
+
+    // flush after a WAIT - continue once the deformatter has taken a block.
+    if ((op == OCSD_OP_FLUSH) && m_in_wait)
+    {
+        m_caller_evt.wait([this]() { return !m_p_in_ring->full(); });
+        m_in_wait = false;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            resp = collectResp();
+        }
+        if (OCSD_DATA_RESP_IS_FATAL(resp))
+            return waitIdle();
+        return resp;
+    }
+
+    // other operations pass through the pipeline in order with the data - wait for all to be decoded.
+    m_in_wait = false;
+    m_caller_evt.wait([this]() { return !m_p_in_ring->full(); });
+    p_blk = m_p_in_ring->tailBlk();
+    p_blk->op = op;
+    p_blk->index = index;
+    p_blk->size = 0;
+    m_p_in_ring->push();
+    m_dfmt_evt.notify();
+    return waitIdle();
+}
+
+// input ring and ID rings empty - all blocks processed, as blocks are popped once processed.
+bool DcdTreeThreads::pipeIdle() const
+{
+    if (m_p_in_ring && !m_p_in_ring->empty())
+        return false;
+    for (int id = 0; id < 128; id++)
+    {
+        if (m_queues[id].m_p_ring && !m_queues[id].m_p_ring->empty())
+            return false;
+    }
+    return true;
+}
+
+void DcdTreeThreads::dfmtThread()
+{
+    const pipe_in_blk_t *p_blk;
+
+    while (true)
+    {
+        if ((p_blk = m_p_in_ring->headBlk()) != 0)
+        {
+            dfmtBlock(p_blk);
+            m_p_in_ring->pop();
+            m_caller_evt.notify();
+        }
+        else if (m_pipe_stop.load())
+            break;
+        else
+            m_dfmt_evt.wait([this]() { return !m_p_in_ring->empty() || m_pipe_stop.load(); });
+    }
+}
+
+// demux an input block into the ID rings - the deformatter only runs on this thread.
+void DcdTreeThreads::dfmtBlock(const pipe_in_blk_t *p_blk)
+{
+    ocsd_datapath_resp_t resp;
+    uint32_t offset = 0, size = p_blk->size, used;
+
+    if (p_blk->op == OCSD_OP_RESET)
+        m_dfmt_resp = OCSD_RESP_CONT;
+    else if (OCSD_DATA_RESP_IS_FATAL(m_dfmt_resp))
+        return;     // drop input after a fatal deformatter error, until reset.
+
+    if (p_blk->op == OCSD_OP_DATA)
+    {
+        do
+        {
+            used = 0;
+            resp = m_p_pipe_in->TraceDataIn(OCSD_OP_DATA, p_blk->index + offset, size, p_blk->data + offset, &used);
+            offset += used;
+            size -= used;
+
+            // ID ring full - flush the held frame data into the rings as the decoders free space, then send the rest of the block.
+            if (OCSD_DATA_RESP_IS_WAIT(resp))
+                resp = dfmtFlushWait(resp);
+            else if (!used)
+                break;
+        } while (size && !OCSD_DATA_RESP_IS_FATAL(resp));
+    }
+    else
+    {
+        resp = m_p_pipe_in->TraceDataIn(p_blk->op, p_blk->index, 0, 0, 0);
+        if (OCSD_DATA_RESP_IS_WAIT(resp))
+            resp = dfmtFlushWait(resp);
+    }
+
+    if (resp > m_dfmt_resp)
+        m_dfmt_resp = resp;
+    if (OCSD_DATA_RESP_IS_FATAL(m_dfmt_resp) || (p_blk->op == OCSD_OP_RESET))
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_dfmt_fatal = m_dfmt_resp;
+    }
+}
+
+ocsd_datapath_resp_t DcdTreeThreads::dfmtFlushWait(ocsd_datapath_resp_t resp)
+{
+    DcdTreeIDQueue *pBlocked;
+
+    while (OCSD_DATA_RESP_IS_WAIT(resp))
+    {
+        pBlocked = m_p_blocked;
+        m_p_blocked = 0;
+        if (pBlocked)
+            m_dfmt_evt.wait([pBlocked]() { return !pBlocked->m_p_ring->full(); });
+        else
+            std::this_thread::yield();
+
+        m_bp_flush = true;
+        resp = m_p_pipe_in->TraceDataIn(OCSD_OP_FLUSH, 0, 0, 0, 0);
+        m_bp_flush = false;
+    }
+    return resp;
+}
+
+bool DcdTreeThreads::dcdReady(const pipe_worker_t *p_worker) const
+{
+    int num_ids = p_worker->num_ids.load(std::memory_order_acquire);
+
+    for (int i = 0; i < num_ids; i++)
+    {
+        if (!p_worker->ids[i]->m_p_ring->empty())
+            return true;
+    }
+    return m_pipe_stop.load();
+}
+
+void DcdTreeThreads::dcdThread(pipe_worker_t *p_worker)
+{
+    const DcdTreeIDQueue::pipe_blk_t *p_blk;
+    DcdTreeIDQueue *pQueue;
+    int num_ids, blks;
+    bool bWork;
+
+    while (true)
+    {
+        bWork = false;
+        num_ids = p_worker->num_ids.load(std::memory_order_acquire);
+        for (int i = 0; i < num_ids; i++)
+        {
+            // at most a ring of blocks from each ID in turn, so a busy ID does not hold up the others.
+            pQueue = p_worker->ids[i];
+            for (blks = 0; (blks < OCSD_DCD_PIPE_ID_BLKS) && ((p_blk = pQueue->m_p_ring->headBlk()) != 0); blks++)
+            {
+                pipeBlock(pQueue, p_blk);
+                pQueue->m_p_ring->pop();
+            }
+            if (blks)
+                bWork = true;
+        }
+
+        if (bWork)
+        {
+            m_dfmt_evt.notify();    // ring space for the deformatter.
+            m_caller_evt.notify();  // pipeline may be idle.
+        }
+        else if (m_pipe_stop.load())
+            break;
+        else
+            p_worker->evt.wait([this, p_worker]() { return dcdReady(p_worker); });
+    }
+}
+
+// pass a ring block on to the packet processor - the only thread using the decoders for this ID.
+void DcdTreeThreads::pipeBlock(DcdTreeIDQueue *pQueue, const DcdTreeIDQueue::pipe_blk_t *p_blk)
+{
+    ocsd_datapath_resp_t resp = pQueue->m_pipe_resp;
+    ocsd_datapath_resp_t blk_resp;
+    bool bReset = false;
+
+    if (!pQueue->m_p_data_in)
+        return;
+
+    if (p_blk->op == OCSD_OP_RESET)
+    {
+        bReset = true;
+        resp = OCSD_RESP_CONT;
+    }
+    else if (OCSD_DATA_RESP_IS_FATAL(resp))
+        return;     // drop data for the ID after a fatal error, until reset.
+
+    blk_resp = passBlock(pQueue->m_p_data_in, p_blk->op, p_blk->index, p_blk->size, p_blk->data);
+    if (blk_resp > resp)
+        resp = blk_resp;
+    pQueue->m_pipe_resp = resp;
+
+    // WAITs are handled on this thread - only fatal responses and resets are reported to the caller.
+    if (bReset || OCSD_DATA_RESP_IS_FATAL(resp))
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        pQueue->m_resp = resp;
+    }
+}
+
+/* End of File ocsd_dcd_tree_threads.cpp */
@@ -98,6 +98,7 @@ static const char *s_errorCodeDescs[][2] = {
     {"OCSD_ERR_INVALID_OPCODE","Illegal Opode found while decoding program memory."},
     {"OCSD_ERR_I_RANGE_LIMIT_OVERRUN","An optional limit on consecutive instructions in range during decode has been exceeded."},
     {"OCSD_ERR_BAD_DECODE_IMAGE","Mismatch between trace packets and decode image."},
+    {"OCSD_ERR_MEM_ACC_CODE_MAP","Code map file invalid or does not match the memory image."},
     /* end marker*/
     {"OCSD_ERR_LAST", "No error - error code end marker"}
 };
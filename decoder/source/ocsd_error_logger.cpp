@@ -84,6 +84,8 @@ bool ocsdDefaultErrorLogger::initErrorLogger(const ocsd_err_severity_t verbosity
 
 void ocsdDefaultErrorLogger::setOutputLogger(ocsdMsgLogger *pLogger)
 {
+    std::lock_guard<std::mutex> lock(m_lock);
+
     // if we created the current logger, delete it.
     if(m_output_logger && m_created_output_logger)
         delete m_output_logger;
@@ -93,6 +95,7 @@ void ocsdDefaultErrorLogger::setOutputLogger(ocsdMsgLogger *pLogger)
 
 const ocsd_hndl_err_log_t ocsdDefaultErrorLogger::RegisterErrorSource(const std::string &component_name)
 {
+    std::lock_guard<std::mutex> lock(m_lock);
     ocsd_hndl_err_log_t handle = (ocsd_hndl_err_log_t)m_error_sources.size();
     m_error_sources.push_back(component_name);
     return handle;
@@ -103,6 +106,8 @@ void ocsdDefaultErrorLogger::LogError(const ocsd_hndl_err_log_t handle, const oc
     // only log errors that match or exceed the current verbosity
     if(m_Verbosity >= Error->getErrorSeverity())
     {
+        std::lock_guard<std::mutex> lock(m_lock);
+
         // print out only if required
         if(m_output_logger)
         {
@@ -138,6 +143,8 @@ void ocsdDefaultErrorLogger::LogMessage(const ocsd_hndl_err_log_t handle, const
     // only log errors that match or exceed the current verbosity
     if((m_Verbosity >= filter_level))
     {
+        std::lock_guard<std::mutex> lock(m_lock);
+
         if(m_output_logger)
         {
             if(m_output_logger->isLogging())
@@ -60,9 +60,11 @@ static built_in_decoder_info_t sBuiltInArray[] = {
 OcsdLibDcdRegister *OcsdLibDcdRegister::m_p_libMngr = 0;
 bool OcsdLibDcdRegister::m_b_registeredBuiltins = false;
 ocsd_trace_protocol_t OcsdLibDcdRegister::m_nextCustomProtocolID = OCSD_PROTOCOL_CUSTOM_0;  
+std::recursive_mutex OcsdLibDcdRegister::m_reg_lock;
 
 OcsdLibDcdRegister *OcsdLibDcdRegister::getDecoderRegister()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     if(m_p_libMngr == 0)
         m_p_libMngr = new (std::nothrow) OcsdLibDcdRegister();
     return m_p_libMngr;
@@ -70,6 +72,7 @@ OcsdLibDcdRegister *OcsdLibDcdRegister::getDecoderRegister()
 
 const ocsd_trace_protocol_t OcsdLibDcdRegister::getNextCustomProtocolID()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     ocsd_trace_protocol_t ret = m_nextCustomProtocolID;
     if(m_nextCustomProtocolID < OCSD_PROTOCOL_END)
         m_nextCustomProtocolID = (ocsd_trace_protocol_t)(((int)m_nextCustomProtocolID)+1);
@@ -78,6 +81,7 @@ const ocsd_trace_protocol_t OcsdLibDcdRegister::getNextCustomProtocolID()
 
 void OcsdLibDcdRegister::releaseLastCustomProtocolID()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     if(m_nextCustomProtocolID > OCSD_PROTOCOL_CUSTOM_0)
         m_nextCustomProtocolID = (ocsd_trace_protocol_t)(((int)m_nextCustomProtocolID)-1);
 }
@@ -97,6 +101,7 @@ OcsdLibDcdRegister::~OcsdLibDcdRegister()
 
 const ocsd_err_t OcsdLibDcdRegister::registerDecoderTypeByName(const std::string &name, IDecoderMngr *p_decoder_fact)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     if(isRegisteredDecoder(name))
         return OCSD_ERR_DCDREG_NAME_REPEAT;
     m_decoder_mngrs.emplace(std::pair<const std::string, IDecoderMngr *>(name,p_decoder_fact));
@@ -121,6 +126,7 @@ void OcsdLibDcdRegister::registerBuiltInDecoders()
 
 void OcsdLibDcdRegister::deregisterAllDecoders()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     if(m_b_registeredBuiltins)
     {
         for(unsigned i = 0; i < NUM_BUILTINS; i++)
@@ -150,6 +156,7 @@ void OcsdLibDcdRegister::deRegisterCustomDecoders()
 
 const ocsd_err_t OcsdLibDcdRegister::getDecoderMngrByName(const std::string &name, IDecoderMngr **p_decoder_mngr)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     if(!m_b_registeredBuiltins)
     {
         registerBuiltInDecoders();
@@ -166,6 +173,7 @@ const ocsd_err_t OcsdLibDcdRegister::getDecoderMngrByName(const std::string &nam
 
 const ocsd_err_t OcsdLibDcdRegister::getDecoderMngrByType(const ocsd_trace_protocol_t decoderType, IDecoderMngr **p_decoder_mngr)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     if(!m_b_registeredBuiltins)
     {
         registerBuiltInDecoders();
@@ -187,6 +195,7 @@ const ocsd_err_t OcsdLibDcdRegister::getDecoderMngrByType(const ocsd_trace_proto
 
 const bool OcsdLibDcdRegister::isRegisteredDecoder(const std::string &name)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     std::map<const std::string,  IDecoderMngr *>::const_iterator iter = m_decoder_mngrs.find(name);
     if(iter != m_decoder_mngrs.end())
         return true;
@@ -195,6 +204,7 @@ const bool OcsdLibDcdRegister::isRegisteredDecoder(const std::string &name)
 
 const bool OcsdLibDcdRegister::isRegisteredDecoderType(const ocsd_trace_protocol_t decoderType)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     std::map<const ocsd_trace_protocol_t, IDecoderMngr *>::const_iterator iter = m_typed_decoder_mngrs.find(decoderType);
     if(iter !=  m_typed_decoder_mngrs.end())
         return true;
@@ -203,12 +213,14 @@ const bool OcsdLibDcdRegister::isRegisteredDecoderType(const ocsd_trace_protocol
 
 const bool OcsdLibDcdRegister::getFirstNamedDecoder(std::string &name)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     m_iter = m_decoder_mngrs.begin();
     return getNextNamedDecoder(name);
 }
 
 const bool OcsdLibDcdRegister::getNextNamedDecoder(std::string &name)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_reg_lock);
     if(m_iter == m_decoder_mngrs.end())
         return false;
     name = m_iter->first;
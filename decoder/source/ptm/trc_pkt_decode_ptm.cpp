@@ -37,6 +37,8 @@
 
 #define DCD_NAME "DCD_PTM"
 
+static const uint32_t PTM_SUPPORTED_DECODE_OP_FLAGS = OCSD_OPFLG_PKTDEC_NO_BLK_CACHE;
+
 TrcPktDecodePtm::TrcPktDecodePtm()
     : TrcPktDecodeBase(DCD_NAME)
 {
@@ -185,6 +187,7 @@ ocsd_err_t TrcPktDecodePtm::onProtocolConfig()
     m_instr_info.wfi_wfe_branch = 0;
     m_instr_info.thumb_it_conditions = 0;
     m_instr_info.track_it_block = 0;    // not using it conditions to set conditional.
+    m_blk_cache.invalidate();
     return err;
 }
 
@@ -192,11 +195,15 @@ ocsd_err_t TrcPktDecodePtm::onProtocolConfig()
 
 void TrcPktDecodePtm::initDecoder()
 {
+    // set the operational modes supported.
+    m_supported_op_flags = PTM_SUPPORTED_DECODE_OP_FLAGS;
+
     m_CSID = 0;
     m_instr_info.pe_type.profile = profile_Unknown;
     m_instr_info.pe_type.arch = ARCH_UNKNOWN;
     m_instr_info.dsb_dmb_waypoints = 0;
     m_unsync_info = UNSYNC_INIT_DECODER;
+    m_mem_ctxt_tag = 0;
     resetDecoder();
 }
 
@@ -277,6 +284,7 @@ ocsd_datapath_resp_t TrcPktDecodePtm::decodePacket()
             {
                 m_pe_context.context_id = m_curr_packet_in->context.ctxtID;
                 m_pe_context.ctxt_id_valid = 1;
+                updateMemContext();
                 m_output_elem.setType(OCSD_GEN_TRC_ELEM_PE_CONTEXT);
                 m_output_elem.setContext(m_pe_context);
                 resp = outputTraceElement(m_output_elem);
@@ -294,6 +302,7 @@ ocsd_datapath_resp_t TrcPktDecodePtm::decodePacket()
             {
                 m_pe_context.vmid = m_curr_packet_in->context.VMID;
                 m_pe_context.vmid_valid = 1;
+                updateMemContext();
                 m_output_elem.setType(OCSD_GEN_TRC_ELEM_PE_CONTEXT);
                 m_output_elem.setContext(m_pe_context);
                 resp = outputTraceElement(m_output_elem);
@@ -351,6 +360,7 @@ ocsd_datapath_resp_t TrcPktDecodePtm::processIsync()
             m_pe_context.vmid_valid = 1;
             m_i_sync_pe_ctxt = true;
         }
+        updateMemContext();
         m_pe_context.security_level = m_curr_packet_in->getNS() ? ocsd_sec_nonsecure : ocsd_sec_secure;
         
         if(m_need_isync || (m_curr_packet_in->iSyncReason() != iSync_Periodic))
@@ -506,6 +516,23 @@ ocsd_datapath_resp_t TrcPktDecodePtm::processAtom()
     }
  }
 
+// switch memory accessor caching and cached blocks to the traced VMID / context ID.
+void TrcPktDecodePtm::updateMemContext()
+{
+    uint64_t ctxt_tag = 0;
+
+    if (m_pe_context.vmid_valid)
+        ctxt_tag = (uint64_t)m_pe_context.vmid << 32;
+    if (m_pe_context.ctxt_id_valid)
+        ctxt_tag |= m_pe_context.context_id;
+
+    if (ctxt_tag != m_mem_ctxt_tag)
+    {
+        m_mem_ctxt_tag = ctxt_tag;
+        setMemAccContext(ctxt_tag);
+    }
+}
+
 // given an atom element - walk the code and output a range or mark nacc.
 ocsd_datapath_resp_t TrcPktDecodePtm::processAtomRange(const ocsd_atm_val A, const char *pkt_msg, const waypoint_trace_t traceWPOp /*= TRACE_WAYPOINT*/, const ocsd_vaddr_t nextAddrMatch /*= 0*/)
 {
@@ -621,6 +648,10 @@ ocsd_err_t TrcPktDecodePtm::traceInstrToWP(bool &bWPFound, const waypoint_trace_
     uint32_t bytesReq;
     ocsd_err_t err = OCSD_OK;
     ocsd_vaddr_t curr_op_address;
+    mem_acc_window_t mem_win = { 0, 0, 0 };
+
+    instr_blk_key_t blk_key;
+    bool use_blk_cache = false;
 
     ocsd_mem_space_acc_t mem_space = (m_pe_context.security_level == ocsd_sec_secure) ? OCSD_MEM_SPACE_S : OCSD_MEM_SPACE_N;
 
@@ -629,12 +660,39 @@ ocsd_err_t TrcPktDecodePtm::traceInstrToWP(bool &bWPFound, const waypoint_trace_
 
     bWPFound = false;
 
+    // walks to a real waypoint can use a previously decoded block, or a pre-decoded code map
+    if ((traceWPOp == TRACE_WAYPOINT) && !m_mem_nacc_pending)
+    {
+        if (getMemAccGeneration(&blk_key.mem_gen))
+        {
+            blk_key.st_addr = m_instr_info.instr_addr;
+            blk_key.ctxt_tag = m_mem_ctxt_tag;
+            blk_key.mem_space = mem_space;
+            blk_key.isa = m_instr_info.isa;
+            blk_key.it_conditions = 0;
+            use_blk_cache = true;
+
+            if (m_blk_cache.getBlock(blk_key, m_instr_info, m_output_elem.num_instr_range))
+                bWPFound = true;
+        }
+
+        if (!bWPFound && findCodeMapWaypoint(mem_space, &m_instr_info, &m_output_elem.num_instr_range))
+            bWPFound = true;
+
+        if (bWPFound)
+        {
+            m_output_elem.en_addr = m_instr_info.instr_addr;
+            m_output_elem.last_i_type = m_instr_info.type;
+            return err;
+        }
+    }
+
     while(!bWPFound && !m_mem_nacc_pending)
     {
         // start off by reading next opcode;
         bytesReq = 4;
         curr_op_address = m_instr_info.instr_addr;  // save the start address for the current opcode
-        err = accessMemory(m_instr_info.instr_addr,mem_space,&bytesReq,(uint8_t *)&opcode);
+        err = accessOpcode(mem_win, m_instr_info.instr_addr, mem_space, m_instr_info.isa, &bytesReq, &opcode);
         if(err != OCSD_OK) break;
 
         if(bytesReq == 4) // got data back
@@ -660,7 +718,17 @@ ocsd_err_t TrcPktDecodePtm::traceInstrToWP(bool &bWPFound, const waypoint_trace_
                     bWPFound = (curr_op_address == nextAddrMatch);
             }
             else
+            {
                 bWPFound = (m_instr_info.type != OCSD_INSTR_OTHER);
+                if (!bWPFound)
+                {
+                    // step over straight line code to the next possible waypoint in the memory window
+                    uint32_t num_skip = skipToWPCandidate(mem_win, m_instr_info.instr_addr, m_instr_info.isa);
+                    m_instr_info.instr_addr += num_skip * 4;
+                    m_output_elem.en_addr = m_instr_info.instr_addr;
+                    m_output_elem.num_instr_range += num_skip;
+                }
+            }
         }
         else
         {
@@ -669,6 +737,9 @@ ocsd_err_t TrcPktDecodePtm::traceInstrToWP(bool &bWPFound, const waypoint_trace_
             m_nacc_addr = m_instr_info.instr_addr;
         }
     }
+
+    if (use_blk_cache && (err == OCSD_OK) && bWPFound)
+        m_blk_cache.addBlock(blk_key, m_instr_info, m_output_elem.num_instr_range);
     return err;
 }
 
@@ -35,6 +35,7 @@
 #include "opencsd/ptm/trc_pkt_proc_ptm.h"
 #include "opencsd/ptm/trc_cmp_cfg_ptm.h"
 #include "common/ocsd_error.h"
+#include "common/trc_sync_scan.h"
 
 
 #ifdef __GNUC__
@@ -280,6 +281,7 @@ ocsd_datapath_resp_t TrcPktProcPtm::waitASync()
     int unsynced_bytes = 0;
     int unsync_scan_block_start = 0;
     int pktBytesOnEntry = (int)m_currPacketData.size();  // did we have part of a potential async last time?
+    uint32_t skip_bytes;
 
     while(doScan && OCSD_DATA_RESP_IS_CONT(resp))
     {
@@ -318,7 +320,17 @@ ocsd_datapath_resp_t TrcPktProcPtm::waitASync()
         }
         else 
         {
-            if(m_pDataIn[m_dataInProcessed++] == 0x00)
+            // no raw monitor - step over data that cannot hold an async.
+            skip_bytes = 0;
+            if(!m_bAsyncRawOp)
+                skip_bytes = ocsd_scan_byte_run(m_pDataIn + m_dataInProcessed, m_dataInLen - m_dataInProcessed, 0x00, ASYNC_REQ_0);
+
+            if(skip_bytes)
+            {
+                m_dataInProcessed += skip_bytes;
+                unsynced_bytes += (int)skip_bytes;
+            }
+            else if(m_pDataIn[m_dataInProcessed++] == 0x00)
             {
                 m_waitASyncSOPkt = true;
                 m_currPacketData.push_back(0); 
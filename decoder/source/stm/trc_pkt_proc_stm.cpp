@@ -33,6 +33,7 @@
  */ 
 
 #include "opencsd/stm/trc_pkt_proc_stm.h"
+#include "common/trc_sync_scan.h"
 
 
 // processor object construction
@@ -47,6 +48,8 @@
 
 static const uint32_t STM_SUPPORTED_OP_FLAGS = OCSD_OPFLG_PKTPROC_COMMON;
 
+#define STM_ASYNC_FF_BYTES 10   // ASYNC is 21 0xF nibbles then 0x0 - at least 10 0xFF bytes
+
 TrcPktProcStm::TrcPktProcStm() : TrcPktProcBase(STM_PKTS_NAME)
 {
     initObj();
@@ -249,6 +252,19 @@ void TrcPktProcStm::waitForSync(const ocsd_trc_index_t blk_st_index)
 
     m_bWaitSyncSaveSuppressed = true;   // no need to save bytes until we want to send data.
 
+    // step over data that cannot hold an ASYNC - at least 10 0xFF bytes. Stop on the byte before any 
+    // run of 0xFF as its upper nibble may be the first F of the sequence.
+    if(!m_is_sync && !m_sync_start && !m_nibble_2nd_valid)
+    {
+        uint32_t skip_bytes = ocsd_scan_byte_run(m_p_data_in + m_data_in_used, m_data_in_size - m_data_in_used, 0xFF, STM_ASYNC_FF_BYTES);
+        if(skip_bytes)
+        {
+            skip_bytes--;
+            m_data_in_used += skip_bytes;
+            m_num_nibbles += (uint8_t)(skip_bytes * 2);
+        }
+    }
+
     while(bGotData && !m_is_sync)
     {
         bGotData = readNibble();    // read until we have a sync or run out of data
@@ -0,0 +1,264 @@
+/*
+* \file       trc_branch_recorder.cpp
+* \brief      OpenCSD : Taken branch recorder - LBR style branch records from generic trace elements.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+
+#include "common/trc_branch_recorder.h"
+#include "common/trc_gen_elem.h"
+
+TrcBranchRecorder::TrcBranchRecorder(const uint32_t ring_size /* = 4096 */, const bool use_cc /* = true */) :
+    m_use_cc(use_cc),
+    m_sample_period(0),
+    m_sample_depth(0),
+    m_p_sample_if(0)
+{
+    // ring size power of 2, at least a full branch stack.
+    m_ring_size = OCSD_BR_STACK_MAX;
+    while (m_ring_size < ring_size)
+        m_ring_size <<= 1;
+
+    for (int i = 0; i < 0x80; i++)
+        m_id_state[i] = 0;
+}
+
+TrcBranchRecorder::~TrcBranchRecorder()
+{
+    for (int i = 0; i < 0x80; i++)
+        delete m_id_state[i];
+}
+
+void TrcBranchRecorder::setSampling(const uint64_t instr_period, const int depth, ITrcBranchSampleIn *p_sample_if)
+{
+    m_p_sample_if = instr_period ? p_sample_if : 0;
+    m_sample_period = m_p_sample_if ? instr_period : 0;
+    m_sample_depth = (depth > OCSD_BR_STACK_MAX) ? OCSD_BR_STACK_MAX : depth;
+}
+
+void TrcBranchRecorder::reset()
+{
+    for (int i = 0; i < 0x80; i++)
+    {
+        delete m_id_state[i];
+        m_id_state[i] = 0;
+    }
+}
+
+ocsd_datapath_resp_t TrcBranchRecorder::TraceElemIn(const ocsd_trc_index_t /*index_sop*/,
+                                                    const uint8_t trc_chan_id,
+                                                    const OcsdTraceElement &elem)
+{
+    br_id_state_t *p_state = getState(trc_chan_id);
+    if (!p_state)
+        return OCSD_RESP_FATAL_SYS_ERR;
+
+    switch (elem.getType())
+    {
+    case OCSD_GEN_TRC_ELEM_INSTR_RANGE:
+        processRange(trc_chan_id, p_state, elem);
+        break;
+
+    case OCSD_GEN_TRC_ELEM_CYCLE_COUNT:
+        if (m_use_cc && elem.has_cc)
+        {
+            p_state->cc_acc += elem.cycle_count;
+            p_state->cc_valid = true;
+        }
+        break;
+
+    case OCSD_GEN_TRC_ELEM_EXCEPTION:
+        // return address may be the target of the branch that ended the previous range
+        if (p_state->br_pending && elem.excep_ret_addr && elem.excep_ret_addr_br_tgt)
+            addRecord(p_state, elem.en_addr);
+        p_state->br_pending = false;
+        break;
+
+    // discontinuities - next range not a branch target
+    case OCSD_GEN_TRC_ELEM_NO_SYNC:
+    case OCSD_GEN_TRC_ELEM_TRACE_ON:
+    case OCSD_GEN_TRC_ELEM_EO_TRACE:
+    case OCSD_GEN_TRC_ELEM_ADDR_NACC:
+    case OCSD_GEN_TRC_ELEM_ADDR_UNKNOWN:
+        p_state->br_pending = false;
+        break;
+
+    default:
+        break;
+    }
+    return OCSD_RESP_CONT;
+}
+
+TrcBranchRecorder::br_id_state_t *TrcBranchRecorder::getState(const uint8_t trc_chan_id)
+{
+    br_id_state_t *p_state = m_id_state[trc_chan_id & 0x7F];
+    if (!p_state)
+    {
+        p_state = new (std::nothrow) br_id_state_t;
+        if (p_state)
+        {
+            p_state->ring.resize(m_ring_size);
+            p_state->wr_count = 0;
+            p_state->rd_count = 0;
+            p_state->lost_count = 0;
+            p_state->instr_count = 0;
+            p_state->cc_acc = 0;
+            p_state->cc_valid = false;
+            p_state->br_pending = false;
+            m_id_state[trc_chan_id & 0x7F] = p_state;
+        }
+    }
+    return p_state;
+}
+
+void TrcBranchRecorder::processRange(const uint8_t trc_chan_id, br_id_state_t *p_state, const OcsdTraceElement &elem)
+{
+    // start of this range is the target of a pending branch.
+    if (p_state->br_pending)
+    {
+        addRecord(p_state, elem.st_addr);
+        p_state->br_pending = false;
+    }
+
+    // cycles for this range belong to the next record
+    if (m_use_cc && elem.has_cc)
+    {
+        p_state->cc_acc += elem.cycle_count;
+        p_state->cc_valid = true;
+    }
+
+    // range ending on a taken branch - wait for the target
+    if (elem.last_instr_exec && ((elem.last_i_type == OCSD_INSTR_BR) || (elem.last_i_type == OCSD_INSTR_BR_INDIRECT)))
+    {
+        ocsd_branch_rec_t &rec = p_state->pend_rec;
+        rec.from_addr = elem.en_addr - elem.last_instr_sz;
+        rec.isa = (uint8_t)elem.isa;
+        rec.flags = 0;
+        if (elem.last_i_type == OCSD_INSTR_BR_INDIRECT)
+            rec.flags |= OCSD_BR_REC_INDIRECT;
+        if (elem.last_i_subtype == OCSD_S_INSTR_BR_LINK)
+            rec.flags |= OCSD_BR_REC_LINK;
+        p_state->br_pending = true;
+    }
+
+    if (m_sample_period)
+    {
+        p_state->instr_count += elem.num_instr_range;
+        if (p_state->instr_count >= m_sample_period)
+        {
+            ocsd_branch_rec_t stack[OCSD_BR_STACK_MAX];
+            int depth = copyStack(p_state, stack, m_sample_depth);
+            p_state->instr_count %= m_sample_period;
+            m_p_sample_if->BranchSampleIn(trc_chan_id, elem.en_addr - elem.last_instr_sz, stack, depth);
+        }
+    }
+}
+
+void TrcBranchRecorder::addRecord(br_id_state_t *p_state, const ocsd_vaddr_t to_addr)
+{
+    ocsd_branch_rec_t &rec = p_state->ring[p_state->wr_count & (m_ring_size - 1)];
+
+    rec = p_state->pend_rec;
+    rec.to_addr = to_addr;
+    rec.cycle_count = 0;
+    if (p_state->cc_valid)
+    {
+        rec.cycle_count = p_state->cc_acc;
+        rec.flags |= OCSD_BR_REC_HAS_CC;
+        p_state->cc_acc = 0;
+        p_state->cc_valid = false;
+    }
+    p_state->wr_count++;
+
+    // reader overrun - oldest record lost
+    if ((p_state->wr_count - p_state->rd_count) > m_ring_size)
+    {
+        p_state->rd_count++;
+        p_state->lost_count++;
+    }
+}
+
+int TrcBranchRecorder::copyStack(const br_id_state_t *p_state, ocsd_branch_rec_t *p_stack, const int depth) const
+{
+    int num = 0;
+    uint64_t rec_idx = p_state->wr_count;
+
+    while ((num < depth) && (num < OCSD_BR_STACK_MAX) && (rec_idx > 0))
+    {
+        rec_idx--;
+        p_stack[num++] = p_state->ring[rec_idx & (m_ring_size - 1)];
+    }
+    return num;
+}
+
+const uint32_t TrcBranchRecorder::numRecords(const uint8_t trc_chan_id) const
+{
+    const br_id_state_t *p_state = m_id_state[trc_chan_id & 0x7F];
+    return p_state ? (uint32_t)(p_state->wr_count - p_state->rd_count) : 0;
+}
+
+uint32_t TrcBranchRecorder::readRecords(const uint8_t trc_chan_id, ocsd_branch_rec_t *p_recs, const uint32_t max_recs)
+{
+    br_id_state_t *p_state = m_id_state[trc_chan_id & 0x7F];
+    uint32_t num = 0;
+
+    if (p_state)
+    {
+        while ((num < max_recs) && (p_state->rd_count < p_state->wr_count))
+        {
+            p_recs[num++] = p_state->ring[p_state->rd_count & (m_ring_size - 1)];
+            p_state->rd_count++;
+        }
+    }
+    return num;
+}
+
+int TrcBranchRecorder::getBranchStack(const uint8_t trc_chan_id, ocsd_branch_rec_t *p_stack, const int depth) const
+{
+    const br_id_state_t *p_state = m_id_state[trc_chan_id & 0x7F];
+    return p_state ? copyStack(p_state, p_stack, depth) : 0;
+}
+
+const uint64_t TrcBranchRecorder::getTotalRecords(const uint8_t trc_chan_id) const
+{
+    const br_id_state_t *p_state = m_id_state[trc_chan_id & 0x7F];
+    return p_state ? p_state->wr_count : 0;
+}
+
+const uint64_t TrcBranchRecorder::getLostRecords(const uint8_t trc_chan_id) const
+{
+    const br_id_state_t *p_state = m_id_state[trc_chan_id & 0x7F];
+    return p_state ? p_state->lost_count : 0;
+}
+
+/* End of File trc_branch_recorder.cpp */
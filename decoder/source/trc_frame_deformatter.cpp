@@ -36,6 +36,7 @@
 
 #include "common/trc_frame_deformatter.h"
 #include "trc_frame_deformatter_impl.h"
+#include "common/trc_sync_scan.h"
 
 /***************************************************************/
 /* Implementation */
@@ -402,21 +403,29 @@ bool TraceFmtDcdImpl::checkForSync()
 
 uint32_t TraceFmtDcdImpl::findfirstFSync()
 {
+    // FSYNC is 0xFF 0xFF 0xFF 0x7F - find runs of 0xFF and check the byte after each.
+    const uint32_t scan_limit = (m_in_block_size > 3) ? m_in_block_size - 3 : 0;
     uint32_t processed = 0;
-    const uint32_t FSYNC_PATTERN = 0x7FFFFFFF;    // LE host pattern for FSYNC	 
-    const uint8_t *dataPtr = m_in_block_base;
+    uint32_t run_end;
 
-    while (processed < (m_in_block_size - 3))
+    while (processed < scan_limit)
     {
-        if (*((uint32_t *)(dataPtr)) == FSYNC_PATTERN)
+        processed += ocsd_scan_byte_run(m_in_block_base + processed, m_in_block_size - processed, 0xFF, 3);
+
+        // find the end of the run
+        run_end = processed + 3;
+        while ((run_end < m_in_block_size) && (m_in_block_base[run_end] == 0xFF))
+            run_end++;
+
+        if ((run_end < m_in_block_size) && (m_in_block_base[run_end] == 0x7F))
         {
+            processed = run_end - 3;
             m_frame_synced = true;
             break;
         }
-        processed++;
-        dataPtr++;
+        processed = run_end;
     }
-    return processed;
+    return (processed < scan_limit) ? processed : scan_limit;
 }
 
 void TraceFmtDcdImpl::outputUnsyncedBytes(uint32_t /*num_bytes*/)
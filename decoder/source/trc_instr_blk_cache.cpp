@@ -0,0 +1,73 @@
+/*
+* \file       trc_instr_blk_cache.cpp
+* \brief      OpenCSD : cache of decoded instruction blocks.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+#include "common/trc_instr_blk_cache.h"
+
+TrcInstrBlockCache::TrcInstrBlockCache() : m_entries(0)
+{
+}
+
+TrcInstrBlockCache::~TrcInstrBlockCache()
+{
+    delete [] m_entries;
+}
+
+void TrcInstrBlockCache::addBlock(const instr_blk_key_t &key, const ocsd_instr_info &instr_info, const uint32_t num_instr)
+{
+    if (!m_entries)
+    {
+        // no cache if allocation fails - decoders will walk instructions as normal.
+        m_entries = new (std::nothrow) instr_blk_entry_t[INSTR_BLK_CACHE_SIZE];
+        if (!m_entries)
+            return;
+        invalidate();
+    }
+
+    instr_blk_entry_t &entry = m_entries[entryIdx(key)];
+    entry.key = key;
+    entry.last_instr = instr_info;
+    entry.num_instr = num_instr;
+}
+
+void TrcInstrBlockCache::invalidate()
+{
+    if (m_entries)
+    {
+        for (int i = 0; i < INSTR_BLK_CACHE_SIZE; i++)
+            m_entries[i].num_instr = 0;
+    }
+}
+
+/* End of File trc_instr_blk_cache.cpp */
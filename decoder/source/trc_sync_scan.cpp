@@ -0,0 +1,250 @@
+/*
+* \file       trc_sync_scan.cpp
+* \brief      OpenCSD : scan trace data for sync patterns.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "common/trc_sync_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define SYNC_SCAN_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define SYNC_SCAN_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SYNC_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef uint32_t (*sync_scan_fn_t)(const uint8_t *p_data, const uint32_t num_bytes, const uint8_t run_val, const uint32_t min_run);
+
+/* run being tracked through the span */
+typedef struct _run_scan {
+    uint32_t run;       // number of matching bytes up to the current position
+    uint32_t min_run;   // run length to find
+} run_scan_t;
+
+/* index of lowest / highest set bit - value must be non-zero */
+static inline uint32_t lowest_set(uint32_t bits)
+{
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctz(bits);
+#else
+    uint32_t idx = 0;
+    while (!(bits & 0x1))
+    {
+        bits >>= 1;
+        idx++;
+    }
+    return idx;
+#endif
+}
+
+static inline uint32_t highest_set(uint32_t bits)
+{
+#if defined(__GNUC__)
+    return 31 - (uint32_t)__builtin_clz(bits);
+#else
+    uint32_t idx = 31;
+    while (!(bits & 0x80000000))
+    {
+        bits <<= 1;
+        idx--;
+    }
+    return idx;
+#endif
+}
+
+/*
+Process the compare result for a chunk of up to 32 bytes - bit n set if byte n matches.
+Returns true with the index of the run start if the run is found in or before the end of this chunk.
+*/
+static inline bool scan_chunk(run_scan_t &scan, const uint32_t match_bits, const uint32_t chunk_bytes, const uint32_t chunk_idx, uint32_t &run_idx)
+{
+    const uint32_t all_bits = (chunk_bytes == 32) ? 0xFFFFFFFF : (((uint32_t)1 << chunk_bytes) - 1);
+
+    if (match_bits == 0)
+    {
+        scan.run = 0;
+        return false;
+    }
+
+    if (match_bits == all_bits)
+    {
+        scan.run += chunk_bytes;
+        if (scan.run < scan.min_run)
+            return false;
+        run_idx = chunk_idx + chunk_bytes - scan.run;
+        return true;
+    }
+
+    // run continued from the previous chunk
+    if ((scan.run + lowest_set(~match_bits)) >= scan.min_run)
+    {
+        run_idx = chunk_idx - scan.run;
+        return true;
+    }
+
+    // run within the chunk - bit n remains set if bits n to n + min_run - 1 are set.
+    if (scan.min_run <= chunk_bytes)
+    {
+        uint32_t run_bits = match_bits;
+        uint32_t len = 1, step;
+        while (len < scan.min_run)
+        {
+            step = (len < (scan.min_run - len)) ? len : (scan.min_run - len);
+            run_bits &= run_bits >> step;
+            len += step;
+        }
+        if (run_bits)
+        {
+            run_idx = chunk_idx + lowest_set(run_bits);
+            return true;
+        }
+    }
+
+    // run at the end of the chunk
+    scan.run = chunk_bytes - 1 - highest_set(~match_bits & all_bits);
+    return false;
+}
+
+/* bytes after the last full chunk - also the scalar implementation */
+static uint32_t scan_tail(run_scan_t &scan, const uint8_t *p_data, uint32_t idx, const uint32_t num_bytes, const uint8_t run_val)
+{
+    for (; idx < num_bytes; idx++)
+    {
+        if (p_data[idx] != run_val)
+            scan.run = 0;
+        else if (++scan.run >= scan.min_run)
+            return idx + 1 - scan.run;
+    }
+    return num_bytes - scan.run;
+}
+
+static uint32_t scan_scalar(const uint8_t *p_data, const uint32_t num_bytes, const uint8_t run_val, const uint32_t min_run)
+{
+    run_scan_t scan = { 0, min_run };
+    return scan_tail(scan, p_data, 0, num_bytes, run_val);
+}
+
+#ifdef SYNC_SCAN_SSE2
+static uint32_t scan_sse2(const uint8_t *p_data, const uint32_t num_bytes, const uint8_t run_val, const uint32_t min_run)
+{
+    run_scan_t scan = { 0, min_run };
+    const __m128i match = _mm_set1_epi8((char)run_val);
+    uint32_t i = 0, run_idx;
+
+    for (; (i + 16) <= num_bytes; i += 16)
+    {
+        __m128i data = _mm_loadu_si128((const __m128i *)(p_data + i));
+        uint32_t match_bits = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(data, match));
+        if (scan_chunk(scan, match_bits, 16, i, run_idx))
+            return run_idx;
+    }
+    return scan_tail(scan, p_data, i, num_bytes, run_val);
+}
+#endif
+
+#ifdef SYNC_SCAN_AVX2
+__attribute__((target("avx2")))
+static uint32_t scan_avx2(const uint8_t *p_data, const uint32_t num_bytes, const uint8_t run_val, const uint32_t min_run)
+{
+    run_scan_t scan = { 0, min_run };
+    const __m256i match = _mm256_set1_epi8((char)run_val);
+    uint32_t i = 0, run_idx;
+
+    for (; (i + 32) <= num_bytes; i += 32)
+    {
+        __m256i data = _mm256_loadu_si256((const __m256i *)(p_data + i));
+        uint32_t match_bits = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, match));
+        if (scan_chunk(scan, match_bits, 32, i, run_idx))
+            return run_idx;
+    }
+    return scan_tail(scan, p_data, i, num_bytes, run_val);
+}
+#endif
+
+#ifdef SYNC_SCAN_NEON
+static uint32_t scan_neon(const uint8_t *p_data, const uint32_t num_bytes, const uint8_t run_val, const uint32_t min_run)
+{
+    static const uint8_t lane_bit_vals[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    run_scan_t scan = { 0, min_run };
+    const uint8x16_t match = vdupq_n_u8(run_val);
+    const uint8x16_t lane_bits = vld1q_u8(lane_bit_vals);
+    uint32_t i = 0, run_idx;
+
+    for (; (i + 16) <= num_bytes; i += 16)
+    {
+        uint8x16_t hit = vandq_u8(vceqq_u8(vld1q_u8(p_data + i), match), lane_bits);
+        uint32_t match_bits = (uint32_t)vaddv_u8(vget_low_u8(hit)) | ((uint32_t)vaddv_u8(vget_high_u8(hit)) << 8);
+        if (scan_chunk(scan, match_bits, 16, i, run_idx))
+            return run_idx;
+    }
+    return scan_tail(scan, p_data, i, num_bytes, run_val);
+}
+#endif
+
+/* pick the best implementation for the host */
+static sync_scan_fn_t select_scan()
+{
+#ifdef SYNC_SCAN_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return scan_avx2;
+#endif
+#if defined(SYNC_SCAN_SSE2)
+    return scan_sse2;
+#elif defined(SYNC_SCAN_NEON)
+    return scan_neon;
+#else
+    return scan_scalar;
+#endif
+}
+
+static inline sync_scan_fn_t scan_fn()
+{
+    static const sync_scan_fn_t fn = select_scan();
+    return fn;
+}
+
+uint32_t ocsd_scan_byte_run(const uint8_t *p_data, const uint32_t num_bytes, const uint8_t run_val, const uint32_t min_run)
+{
+    const uint32_t run_len = (min_run == 0) ? 1 : min_run;
+
+    // short spans - not worth the vector setup.
+    if (num_bytes < 16)
+        return scan_scalar(p_data, num_bytes, run_val, run_len);
+    return scan_fn()(p_data, num_bytes, run_val, run_len);
+}
+
+/* End of File trc_sync_scan.cpp */
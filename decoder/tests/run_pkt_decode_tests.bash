@@ -133,6 +133,31 @@ echo "Testing a55-test-tpiu..."
 ${BIN_DIR}trc_pkt_lister -ss_dir "${SNAPSHOT_DIR}/a55-test-tpiu" $@ -dstream_format -no_time_print -o_raw_packed -o_raw_unpacked -logfilename "${OUT_DIR}/a55-test-tpiu.ppl"
 echo "Done : Return $?"
 
+# === test segmented decode ===
+# raw ETMv4 stream with many sync points - decode on 1 and 4 threads must match the serial decode, apart from
+# the decoder reset that starts every segment after the first.
+echo "Testing segmented decode of juno_r1_1_etm4_raw..."
+rm -f "${OUT_DIR}"/juno_r1_1_etm4_raw*.ppl
+${BIN_DIR}trc_pkt_lister -ss_dir "${SNAPSHOT_DIR}/juno_r1_1_etm4_raw" $@ -decode_only -no_time_print -logfilename "${OUT_DIR}/juno_r1_1_etm4_raw.ppl"
+echo "Done : Return $?"
+for seg_threads in 1 4
+do
+    seg_log="${OUT_DIR}/juno_r1_1_etm4_raw_seg${seg_threads}.ppl"
+    ${BIN_DIR}trc_pkt_lister -ss_dir "${SNAPSHOT_DIR}/juno_r1_1_etm4_raw" $@ -seg_threads ${seg_threads} -seg_size 4096 -no_time_print -logfilename "${seg_log}"
+    echo "Done : Return $?"
+    echo "Comparing ${seg_threads} thread segmented decode with serial decode"
+    seg_count=$(sed -n 's/.* in \([0-9]*\) segments\./\1/p' "${seg_log}")
+    reset_count=$(grep -c "NO_SYNC( \[reset-decoder\])" "${seg_log}")
+    [ -n "$seg_count" ] && [ "$seg_count" -gt 1 ] && [ "$reset_count" -eq $((seg_count - 1)) ] && \
+        [ -s "${OUT_DIR}/juno_r1_1_etm4_raw.ppl" ] && \
+        diff <(grep "^Idx" "${OUT_DIR}/juno_r1_1_etm4_raw.ppl") <(grep "^Idx" "${seg_log}" | grep -v "NO_SYNC( \[reset-decoder\])") > /dev/null
+    echo "Done : Return $?"
+done
+echo "Checking undersized segment rejected"
+${BIN_DIR}trc_pkt_lister -ss_dir "${SNAPSHOT_DIR}/juno_r1_1_etm4_raw" $@ -seg_threads 4 -seg_size 1024 -no_time_print -logfilename "${OUT_DIR}/juno_r1_1_etm4_raw_seg_min.ppl" > /dev/null
+grep -q "seg_size must be at least 4096" "${OUT_DIR}/juno_r1_1_etm4_raw_seg_min.ppl"
+echo "Done : Return $?"
+
 # === Run uninstalled test programs ===
 if [ "$1" != "use-installed" ]; then
 
@@ -165,4 +190,36 @@ if [ "$1" != "use-installed" ]; then
     echo "Running ITM decoder test"
     ${BIN_DIR}itm-decode-test -logfilename  "${OUT_DIR}/itm-decode-test.ppl"
     echo "Done : Return $?"
+
+    # === run the branch recorder test - decodes ETMv4, ETE and PTM snapshots ===
+    echo "Running branch recorder test"
+    ${BIN_DIR}branch-rec-test -logfilename "${OUT_DIR}/branch-rec-test.ppl" > /dev/null
+    echo "Done : Return $?"
+
+    # === test the code map generator ===
+    # decode with a code map must match decode without; a map for a different core profile must not be used, 
+    # and a map for a different image must be rejected.
+    echo "Testing code maps"
+    ${BIN_DIR}code-map-gen -f ${SNAPSHOT_DIR}/juno_r1_1/kernel_dump.bin -addr 0xFFFFFFC000081000 -o ${OUT_DIR}/juno_r1_1_kernel.ocsdmap > /dev/null
+    echo "Done : Return $?"
+    ${BIN_DIR}trc_pkt_lister -ss_dir "${SNAPSHOT_DIR}/juno_r1_1" $@ -decode -no_time_print -code_map ${OUT_DIR}/juno_r1_1_kernel.ocsdmap -logfilename "${OUT_DIR}/juno_r1_1_code_map.ppl"
+    echo "Done : Return $?"
+    echo "Comparing code map decode"
+    [ -s "${OUT_DIR}/juno_r1_1.ppl" ] && [ -s "${OUT_DIR}/juno_r1_1_code_map.ppl" ] && \
+        diff <(grep "^Idx" "${OUT_DIR}/juno_r1_1.ppl") <(grep "^Idx" "${OUT_DIR}/juno_r1_1_code_map.ppl") > /dev/null
+    echo "Done : Return $?"
+    ${BIN_DIR}code-map-gen -f ${SNAPSHOT_DIR}/juno_r1_1/kernel_dump.bin -addr 0xFFFFFFC000081000 -profile r -o ${OUT_DIR}/juno_r1_1_kernel_r.ocsdmap > /dev/null
+    ${BIN_DIR}trc_pkt_lister -ss_dir "${SNAPSHOT_DIR}/juno_r1_1" $@ -decode -no_time_print -code_map ${OUT_DIR}/juno_r1_1_kernel_r.ocsdmap -logfilename "${OUT_DIR}/juno_r1_1_code_map_profile.ppl"
+    echo "Comparing code map decode with profile mismatch"
+    [ -s "${OUT_DIR}/juno_r1_1.ppl" ] && [ -s "${OUT_DIR}/juno_r1_1_code_map_profile.ppl" ] && \
+        diff <(grep "^Idx" "${OUT_DIR}/juno_r1_1.ppl") <(grep "^Idx" "${OUT_DIR}/juno_r1_1_code_map_profile.ppl") > /dev/null
+    echo "Done : Return $?"
+    cp ${SNAPSHOT_DIR}/juno_r1_1/kernel_dump.bin ${OUT_DIR}/kernel_dump_mod.bin
+    printf '\x1f\x20\x03\xd5' | dd of=${OUT_DIR}/kernel_dump_mod.bin bs=1 seek=4096 conv=notrunc 2> /dev/null
+    ${BIN_DIR}code-map-gen -f ${OUT_DIR}/kernel_dump_mod.bin -addr 0xFFFFFFC000081000 -o ${OUT_DIR}/juno_r1_1_mismatch.ocsdmap > /dev/null
+    rm ${OUT_DIR}/kernel_dump_mod.bin
+    ${BIN_DIR}trc_pkt_lister -ss_dir "${SNAPSHOT_DIR}/juno_r1_1" $@ -decode -no_time_print -code_map ${OUT_DIR}/juno_r1_1_mismatch.ocsdmap -logfilename "${OUT_DIR}/juno_r1_1_code_map_mismatch.ppl"
+    echo "Checking mismatched code map rejected"
+    grep -q "Failed to load code map" "${OUT_DIR}/juno_r1_1_code_map_mismatch.ppl"
+    echo "Done : Return $?"
 fi
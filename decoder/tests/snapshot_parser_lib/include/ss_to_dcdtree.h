@@ -36,6 +36,7 @@
 #define ARM_SS_TO_DCDTREE_H_INCLUDED
 
 #include <string>
+#include <set>
 
 #include "opencsd.h"
 #include "snapshot_parser.h"
@@ -58,6 +59,12 @@ public:
     const char *getBufferFileName() const { return m_BufferFileName.c_str(); };
     std::string getBufferFileNameFromBuffName(const std::string& buff_name);
 
+    // options used when creating file memory accessors for the snapshot dump files
+    void setFileMemAccOpts(const uint32_t file_acc_opts) { m_file_mem_acc_opts = file_acc_opts; };
+
+    // type of memory mapper created in the decode tree - snapshot dump files are added as global accessors.
+    void setMemAccMapperType(const memacc_mapper_t mapper_type) { m_mem_acc_mapper_type = mapper_type; };
+
     // TBD: add in filters for ID list, first ID found.
 
 private:
@@ -96,6 +103,8 @@ private:
 
 
     uint32_t m_add_create_flags;
+    uint32_t m_file_mem_acc_opts;
+    memacc_mapper_t m_mem_acc_mapper_type;
 
     bool m_bInit;
     DecodeTree *m_pDecodeTree;
@@ -105,6 +114,7 @@ private:
 
     bool m_bPacketProcOnly;
     std::string m_BufferFileName;
+    std::set<std::string> m_mem_acc_files;  // dump files with an accessor in this tree - accessors may be shared with other trees.
 
     CoreArchProfileMap m_arch_profiles;
 };
@@ -46,6 +46,8 @@ CreateDcdTreeFromSnapShot::CreateDcdTreeFromSnapShot() :
 {
     m_errlog_handle = 0;
     m_add_create_flags = 0;
+    m_file_mem_acc_opts = OCSD_FILE_MEM_ACC_OPT_NONE;
+    m_mem_acc_mapper_type = MEMACC_MAP_GLOBAL;
 }
 
 CreateDcdTreeFromSnapShot::~CreateDcdTreeFromSnapShot()
@@ -116,11 +118,11 @@ bool CreateDcdTreeFromSnapShot::createDecodeTree(const std::string &SourceName,
             }
 
             // use our error logger - don't use the tree default.
-            m_pDecodeTree->setAlternateErrorLogger(m_pErrLogInterface);
+            m_pDecodeTree->setTreeErrorLogI(m_pErrLogInterface);
 
             if(!bPacketProcOnly)
             {
-                m_pDecodeTree->createMemAccMapper();
+                m_pDecodeTree->createMemAccMapper(m_mem_acc_mapper_type);
             }
 
             /* run through each protocol source to this buffer... */
@@ -217,6 +219,7 @@ void CreateDcdTreeFromSnapShot::destroyDecodeTree()
     m_pErrLogInterface = 0;
     m_errlog_handle = 0;
     m_BufferFileName = "";
+    m_mem_acc_files.clear();
 }
 
 void  CreateDcdTreeFromSnapShot::LogError(const std::string &msg)
@@ -675,8 +678,12 @@ ocsd_err_t CreateDcdTreeFromSnapShot::processDumpfiles(std::vector<Parser::DumpD
 
         // ensure we respect optional length and offset parameter and
         // allow multiple dump entries with same file name to define regions
-        if (!TrcMemAccessorFile::isExistingFileAccessor(dumpFilePathName))
-            err = m_pDecodeTree->addBinFileRegionMemAcc(&region, 1, mem_space, dumpFilePathName);
+        if (!m_mem_acc_files.count(dumpFilePathName))
+        {
+            err = m_pDecodeTree->addBinFileRegionMemAcc(&region, 1, mem_space, dumpFilePathName, m_file_mem_acc_opts);
+            if (err == OCSD_OK)
+                m_mem_acc_files.insert(dumpFilePathName);
+        }
         else
             err = m_pDecodeTree->updateBinFileRegionMemAcc(&region, 1, mem_space, dumpFilePathName);
         if(err != OCSD_OK)
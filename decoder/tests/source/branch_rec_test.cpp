@@ -0,0 +1,787 @@
+/*
+* \file     branch_rec_test.cpp
+* \brief    OpenCSD: tests for the taken branch recorder.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Tests for TrcBranchRecorder.
+ *
+ * Element sequences built in the test check the record rules - exception return
+ * addresses that are branch targets, discontinuities, cycle counts - and the ring
+ * overrun / lost counts, branch stack depth and sampling.
+ *
+ * Snapshots for ETMv4, ETE and PTM are then decoded with the recorder attached. The
+ * records, branch stacks and samples are checked against records built from the
+ * same element stream by the test.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+#include "opencsd.h"              // the library
+#include "trace_snapshots.h"      // the snapshot reading test library
+
+static ocsdMsgLogger logger;
+static ocsdDefaultErrorLogger err_log;
+static int logOpts = ocsdMsgLogger::OUT_STDOUT | ocsdMsgLogger::OUT_FILE;
+static std::string logfileName = "branch_rec_test.ppl";
+
+// test pass fail counts
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+// snapshots decoded by default - ETMv4 with exceptions returning to branch targets, ETE, PTM.
+static std::vector<std::string> ss_dirs;
+static const char *default_ss_dirs[] = {
+    "./snapshots/juno-uname-002",
+    "./snapshots-ete/001-ack_test",
+    "./snapshots/TC2",
+    0
+};
+
+#define TEST_TRC_ID 0x10
+
+static void log_test_start(const char *testname)
+{
+    std::ostringstream oss;
+    oss << "*** Test " << testname << " Starting.\n";
+    logger.LogMsg(oss.str());
+}
+
+static void log_test_end(const char *testname, const int pass, const int fail)
+{
+    std::ostringstream oss;
+    oss << "*** Test " << testname << " complete. (Pass: " << pass << "; Fail:" << fail << ")\n\n";
+    logger.LogMsg(oss.str());
+}
+
+static bool log_check(const std::string &name, const bool pass)
+{
+    logger.LogMsg(name + (pass ? "; Pass\n" : "; Fail\n"));
+    return pass;
+}
+
+static bool rec_match(const ocsd_branch_rec_t &rec, const ocsd_vaddr_t from, const ocsd_vaddr_t to, const uint8_t flags, const uint32_t cc)
+{
+    return (rec.from_addr == from) && (rec.to_addr == to) && (rec.flags == flags) && (rec.cycle_count == cc);
+}
+
+static bool rec_equal(const ocsd_branch_rec_t &rec_a, const ocsd_branch_rec_t &rec_b)
+{
+    return rec_match(rec_a, rec_b.from_addr, rec_b.to_addr, rec_b.flags, rec_b.cycle_count) && (rec_a.isa == rec_b.isa);
+}
+
+/************************************************************************
+ * elements for the synthetic tests - A64, 4 byte instructions.
+ */
+
+static void send_range(TrcBranchRecorder &recorder, const ocsd_vaddr_t st_addr, const ocsd_vaddr_t en_addr,
+                       const ocsd_instr_type last_type, const bool last_exec,
+                       const ocsd_instr_subtype last_subtype = OCSD_S_INSTR_NONE, const uint32_t cc = 0)
+{
+    OcsdTraceElement elem;
+
+    elem.setType(OCSD_GEN_TRC_ELEM_INSTR_RANGE);
+    elem.setISA(ocsd_isa_aarch64);
+    elem.setAddrRange(st_addr, en_addr, (int)((en_addr - st_addr) / 4));
+    elem.setLastInstrInfo(last_exec, last_type, last_subtype, 4);
+    if (cc)
+        elem.setCycleCount(cc);
+    recorder.TraceElemIn(0, TEST_TRC_ID, elem);
+}
+
+static void send_exception(TrcBranchRecorder &recorder, const ocsd_vaddr_t ret_addr, const bool br_tgt)
+{
+    OcsdTraceElement elem;
+
+    elem.setType(OCSD_GEN_TRC_ELEM_EXCEPTION);
+    elem.en_addr = ret_addr;
+    elem.excep_ret_addr = 1;
+    elem.excep_ret_addr_br_tgt = br_tgt ? 1 : 0;
+    recorder.TraceElemIn(0, TEST_TRC_ID, elem);
+}
+
+static void send_elem(TrcBranchRecorder &recorder, const ocsd_gen_trc_elem_t type, const uint32_t cc = 0)
+{
+    OcsdTraceElement elem;
+
+    elem.setType(type);
+    if (cc)
+        elem.setCycleCount(cc);
+    recorder.TraceElemIn(0, TEST_TRC_ID, elem);
+}
+
+// ranges ending on a taken branch to the next range - each range after the first completes a record.
+#define BR_SEQ_BASE 0x10000
+#define BR_SEQ_STEP 0x100
+#define BR_SEQ_FROM(n) (BR_SEQ_BASE + ((n) * BR_SEQ_STEP) + 8)
+#define BR_SEQ_TO(n) (BR_SEQ_BASE + (((n) + 1) * BR_SEQ_STEP))
+
+static void send_branch_seq(TrcBranchRecorder &recorder, const int first_range, const int num_ranges)
+{
+    for (int i = first_range; i < first_range + num_ranges; i++)
+        send_range(recorder, BR_SEQ_BASE + (i * BR_SEQ_STEP), BR_SEQ_BASE + (i * BR_SEQ_STEP) + 12, OCSD_INSTR_BR, true);
+}
+
+/************************************************************************
+ * Record rules - targets, flags, cycle counts, exceptions and discontinuities.
+ */
+static void test_record_rules()
+{
+    TrcBranchRecorder recorder;
+    TrcBranchRecorder recorder_no_cc(64, false);
+    ocsd_branch_rec_t recs[8];
+    uint32_t num_recs;
+    int passed = 0, failed = 0;
+
+    log_test_start(__FUNCTION__);
+
+    // direct branch, then an indirect branch with link, then a branch not taken.
+    send_range(recorder, 0x1000, 0x1010, OCSD_INSTR_BR, true);
+    send_range(recorder, 0x2000, 0x2008, OCSD_INSTR_OTHER, true);
+    send_range(recorder, 0x2008, 0x2010, OCSD_INSTR_BR_INDIRECT, true, OCSD_S_INSTR_BR_LINK);
+    send_range(recorder, 0x3000, 0x3004, OCSD_INSTR_BR, false);
+    send_range(recorder, 0x3004, 0x3008, OCSD_INSTR_OTHER, true);
+
+    // cycle counts before the branch go into its record.
+    send_elem(recorder, OCSD_GEN_TRC_ELEM_CYCLE_COUNT, 10);
+    send_range(recorder, 0x3008, 0x3010, OCSD_INSTR_BR, true, OCSD_S_INSTR_NONE, 5);
+
+    // exception where the preferred return address is the target of the pending branch - completes the record.
+    send_range(recorder, 0x4000, 0x4008, OCSD_INSTR_BR, true);
+    send_exception(recorder, 0x5000, true);
+    send_range(recorder, 0x6000, 0x6008, OCSD_INSTR_BR, true);
+
+    // exception return address not the branch target - no record, and none for the vector.
+    send_exception(recorder, 0x7000, false);
+    send_range(recorder, 0x8000, 0x8008, OCSD_INSTR_BR, true);
+
+    // discontinuities - no record for the next range.
+    send_elem(recorder, OCSD_GEN_TRC_ELEM_TRACE_ON);
+    send_range(recorder, 0x9000, 0x9008, OCSD_INSTR_BR, true);
+    send_elem(recorder, OCSD_GEN_TRC_ELEM_NO_SYNC);
+    send_range(recorder, 0xA000, 0xA008, OCSD_INSTR_BR, true);
+    send_elem(recorder, OCSD_GEN_TRC_ELEM_ADDR_NACC);
+    send_range(recorder, 0xB000, 0xB008, OCSD_INSTR_OTHER, true);
+
+    num_recs = recorder.readRecords(TEST_TRC_ID, recs, 8);
+    log_check("Record count 4", (num_recs == 4) && (recorder.getTotalRecords(TEST_TRC_ID) == 4)) ? passed++ : failed++;
+    if (num_recs == 4)
+    {
+        log_check("Direct branch record", rec_match(recs[0], 0x100C, 0x2000, 0, 0)) ? passed++ : failed++;
+        log_check("Indirect branch with link record", rec_match(recs[1], 0x200C, 0x3000, OCSD_BR_REC_INDIRECT | OCSD_BR_REC_LINK, 0)) ? passed++ : failed++;
+        log_check("Cycle count record", rec_match(recs[2], 0x300C, 0x4000, OCSD_BR_REC_HAS_CC, 15)) ? passed++ : failed++;
+        log_check("Exception return to branch target record", rec_match(recs[3], 0x4004, 0x5000, 0, 0)) ? passed++ : failed++;
+    }
+    log_check("No unread records", (recorder.numRecords(TEST_TRC_ID) == 0)) ? passed++ : failed++;
+    log_check("No records for other IDs", (recorder.numRecords(TEST_TRC_ID + 1) == 0) && (recorder.getTotalRecords(TEST_TRC_ID + 1) == 0)) ? passed++ : failed++;
+
+    // cycle counts ignored if not in use.
+    send_elem(recorder_no_cc, OCSD_GEN_TRC_ELEM_CYCLE_COUNT, 10);
+    send_range(recorder_no_cc, 0x3008, 0x3010, OCSD_INSTR_BR, true, OCSD_S_INSTR_NONE, 5);
+    send_range(recorder_no_cc, 0x4000, 0x4008, OCSD_INSTR_OTHER, true);
+    num_recs = recorder_no_cc.readRecords(TEST_TRC_ID, recs, 8);
+    log_check("Cycle counts off", (num_recs == 1) && rec_match(recs[0], 0x300C, 0x4000, 0, 0)) ? passed++ : failed++;
+
+    // reset clears records and pending branches.
+    send_range(recorder, 0xC000, 0xC008, OCSD_INSTR_BR, true);
+    recorder.reset();
+    send_range(recorder, 0xD000, 0xD008, OCSD_INSTR_OTHER, true);
+    log_check("Reset", (recorder.getTotalRecords(TEST_TRC_ID) == 0)) ? passed++ : failed++;
+
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Ring overrun - oldest unread records overwritten and counted as lost.
+ */
+static bool check_counts(TrcBranchRecorder &recorder, const uint64_t total, const uint32_t unread, const uint64_t lost)
+{
+    std::ostringstream oss;
+    bool pass = (recorder.getTotalRecords(TEST_TRC_ID) == total) && (recorder.numRecords(TEST_TRC_ID) == unread) &&
+                (recorder.getLostRecords(TEST_TRC_ID) == lost);
+
+    oss << "Records total " << recorder.getTotalRecords(TEST_TRC_ID) << "; unread " << recorder.numRecords(TEST_TRC_ID);
+    oss << "; lost " << recorder.getLostRecords(TEST_TRC_ID);
+    log_check(oss.str(), pass);
+    return pass;
+}
+
+static void test_ring_overrun()
+{
+    TrcBranchRecorder recorder(64);
+    ocsd_branch_rec_t recs[128];
+    uint32_t num_recs;
+    int passed = 0, failed = 0;
+
+    log_test_start(__FUNCTION__);
+
+    // 100 records in a 64 record ring.
+    send_branch_seq(recorder, 0, 101);
+    check_counts(recorder, 100, 64, 36) ? passed++ : failed++;
+
+    // reader gets the newest 64, oldest first.
+    num_recs = recorder.readRecords(TEST_TRC_ID, recs, 128);
+    log_check("Read after overrun", (num_recs == 64) && rec_match(recs[0], BR_SEQ_FROM(36), BR_SEQ_TO(36), 0, 0) &&
+              rec_match(recs[63], BR_SEQ_FROM(99), BR_SEQ_TO(99), 0, 0)) ? passed++ : failed++;
+    check_counts(recorder, 100, 0, 36) ? passed++ : failed++;
+
+    // reader keeping up - no loss.
+    send_branch_seq(recorder, 101, 10);
+    num_recs = recorder.readRecords(TEST_TRC_ID, recs, 5);
+    log_check("Partial read", (num_recs == 5) && rec_match(recs[0], BR_SEQ_FROM(100), BR_SEQ_TO(100), 0, 0)) ? passed++ : failed++;
+    check_counts(recorder, 110, 5, 36) ? passed++ : failed++;
+
+    // 5 unread + 70 more - 11 lost.
+    send_branch_seq(recorder, 111, 70);
+    check_counts(recorder, 180, 64, 47) ? passed++ : failed++;
+    num_recs = recorder.readRecords(TEST_TRC_ID, recs, 128);
+    log_check("Read after second overrun", (num_recs == 64) && rec_match(recs[0], BR_SEQ_FROM(116), BR_SEQ_TO(116), 0, 0)) ? passed++ : failed++;
+
+    // ring size rounded up to a power of 2
+    TrcBranchRecorder recorder_100(100);
+    send_branch_seq(recorder_100, 0, 201);
+    check_counts(recorder_100, 200, 128, 72) ? passed++ : failed++;
+
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Branch stack - newest first, limited by the records available and the maximum depth.
+ */
+static bool check_stack(TrcBranchRecorder &recorder, const int depth, const int exp_depth, const int newest)
+{
+    ocsd_branch_rec_t stack[OCSD_BR_STACK_MAX * 2];
+    std::ostringstream oss;
+    bool pass;
+    int got = recorder.getBranchStack(TEST_TRC_ID, stack, depth);
+
+    pass = (got == exp_depth);
+    for (int i = 0; pass && (i < got); i++)
+        pass = rec_match(stack[i], BR_SEQ_FROM(newest - i), BR_SEQ_TO(newest - i), 0, 0);
+
+    oss << "Branch stack depth " << depth << "; got " << got;
+    log_check(oss.str(), pass);
+    return pass;
+}
+
+static void test_branch_stack()
+{
+    TrcBranchRecorder recorder(64);
+    ocsd_branch_rec_t recs[128];
+    int passed = 0, failed = 0;
+
+    log_test_start(__FUNCTION__);
+
+    log_check("Empty stack", (recorder.getBranchStack(TEST_TRC_ID, recs, 16) == 0)) ? passed++ : failed++;
+
+    send_branch_seq(recorder, 0, 6);
+    check_stack(recorder, 16, 5, 4) ? passed++ : failed++;
+
+    send_branch_seq(recorder, 6, 95);
+    check_stack(recorder, 16, 16, 99) ? passed++ : failed++;
+    check_stack(recorder, 32, 32, 99) ? passed++ : failed++;
+    check_stack(recorder, 64, 64, 99) ? passed++ : failed++;
+    check_stack(recorder, 100, OCSD_BR_STACK_MAX, 99) ? passed++ : failed++;
+
+    // stack independent of the reader.
+    recorder.readRecords(TEST_TRC_ID, recs, 128);
+    check_stack(recorder, 16, 16, 99) ? passed++ : failed++;
+    log_check("No stack for other IDs", (recorder.getBranchStack(TEST_TRC_ID + 1, recs, 16) == 0)) ? passed++ : failed++;
+
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Sampling - branch stack every N instructions.
+ */
+class SampleCollect : public ITrcBranchSampleIn
+{
+public:
+    SampleCollect() {};
+    virtual ~SampleCollect() {};
+
+    virtual void BranchSampleIn(const uint8_t trc_chan_id, const ocsd_vaddr_t sample_addr,
+                                const ocsd_branch_rec_t *stack, const int depth)
+    {
+        sample_t sample;
+        sample.trc_chan_id = trc_chan_id;
+        sample.sample_addr = sample_addr;
+        sample.depth = depth;
+        sample.newest = stack[0];
+        samples.push_back(sample);
+    }
+
+    typedef struct _sample {
+        uint8_t trc_chan_id;
+        ocsd_vaddr_t sample_addr;
+        int depth;
+        ocsd_branch_rec_t newest;
+    } sample_t;
+    std::vector<sample_t> samples;
+};
+
+static bool check_sample(SampleCollect &collect, const size_t idx, const int range, const int exp_depth)
+{
+    std::ostringstream oss;
+    bool pass = false;
+
+    if (idx < collect.samples.size())
+    {
+        const SampleCollect::sample_t &sample = collect.samples[idx];
+        // sampled at the last instruction of the range - newest record has the range start as target.
+        pass = (sample.trc_chan_id == TEST_TRC_ID) && (sample.depth == exp_depth) &&
+               (sample.sample_addr == (ocsd_vaddr_t)(BR_SEQ_FROM(range))) &&
+               rec_match(sample.newest, BR_SEQ_FROM(range - 1), BR_SEQ_TO(range - 1), 0, 0);
+        oss << "Sample " << idx << " at 0x" << std::hex << sample.sample_addr << std::dec << "; depth " << sample.depth;
+    }
+    else
+        oss << "Sample " << idx << " missing";
+    log_check(oss.str(), pass);
+    return pass;
+}
+
+static void test_sampling()
+{
+    TrcBranchRecorder recorder;
+    SampleCollect collect;
+    size_t num_samples;
+    int max_depth = 0;
+    int passed = 0, failed = 0;
+
+    log_test_start(__FUNCTION__);
+
+    // 3 instructions per range, sample every 10 - ranges 3, 6 and 9 (instructions 12, 21, 30).
+    recorder.setSampling(10, 4, &collect);
+    send_branch_seq(recorder, 0, 10);
+    log_check("Sample count", (collect.samples.size() == 3)) ? passed++ : failed++;
+    check_sample(collect, 0, 3, 3) ? passed++ : failed++;
+    check_sample(collect, 1, 6, 4) ? passed++ : failed++;
+    check_sample(collect, 2, 9, 4) ? passed++ : failed++;
+
+    // off with a 0 period or no interface.
+    num_samples = collect.samples.size();
+    recorder.setSampling(0, 4, &collect);
+    send_branch_seq(recorder, 10, 10);
+    recorder.setSampling(10, 4, 0);
+    send_branch_seq(recorder, 20, 10);
+    log_check("Sampling off", (collect.samples.size() == num_samples)) ? passed++ : failed++;
+
+    // depth limited to the maximum stack.
+    recorder.setSampling(10, 100, &collect);
+    send_branch_seq(recorder, 30, 70);
+    for (size_t i = num_samples; i < collect.samples.size(); i++)
+    {
+        if (collect.samples[i].depth > max_depth)
+            max_depth = collect.samples[i].depth;
+    }
+    log_check("Sample depth limit", (collect.samples.size() > num_samples) && (max_depth == OCSD_BR_STACK_MAX)) ? passed++ : failed++;
+
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Snapshot decode - recorder output against records built by the test from the element stream.
+ */
+
+#define SS_OVR_RING_SIZE 64
+#define SS_SAMPLE_PERIOD 1000
+#define SS_SAMPLE_DEPTH 16
+
+class BranchRecCheck : public ITrcGenElemIn, public ITrcBranchSampleIn
+{
+public:
+    BranchRecCheck() : m_rec_overrun(SS_OVR_RING_SIZE), m_samples(0), m_sample_errs(0), m_excep_recs(0)
+    {
+        m_rec_read.setSampling(SS_SAMPLE_PERIOD, SS_SAMPLE_DEPTH, this);
+    };
+    virtual ~BranchRecCheck() {};
+
+    virtual ocsd_datapath_resp_t TraceElemIn(const ocsd_trc_index_t index_sop,
+                                             const uint8_t trc_chan_id,
+                                             const OcsdTraceElement &elem)
+    {
+        ocsd_branch_rec_t recs[64];
+        uint32_t num_recs;
+
+        refElemIn(trc_chan_id, elem);
+
+        // records read as they are made from one recorder, left to overrun in the other.
+        m_rec_read.TraceElemIn(index_sop, trc_chan_id, elem);
+        while ((num_recs = m_rec_read.readRecords(trc_chan_id, recs, 64)) > 0)
+            m_got[trc_chan_id].insert(m_got[trc_chan_id].end(), recs, recs + num_recs);
+        m_rec_overrun.TraceElemIn(index_sop, trc_chan_id, elem);
+        return OCSD_RESP_CONT;
+    }
+
+    // sample stack must be the newest records so far.
+    virtual void BranchSampleIn(const uint8_t trc_chan_id, const ocsd_vaddr_t /*sample_addr*/,
+                                const ocsd_branch_rec_t *stack, const int depth)
+    {
+        m_samples++;
+        if (!stackMatch(m_ref[trc_chan_id], stack, depth, SS_SAMPLE_DEPTH))
+            m_sample_errs++;
+    }
+
+    int checkResults(const std::string &name);
+
+private:
+    typedef struct _ref_state {
+        bool pending;
+        ocsd_branch_rec_t pend_rec;
+        uint32_t cc;
+        bool cc_valid;
+    } ref_state_t;
+
+    void refElemIn(const uint8_t trc_chan_id, const OcsdTraceElement &elem);
+    void refAddRecord(const uint8_t trc_chan_id, ref_state_t &state, const ocsd_vaddr_t to_addr);
+    bool stackMatch(const std::vector<ocsd_branch_rec_t> &ref, const ocsd_branch_rec_t *stack, const int depth, const int req_depth) const;
+
+    TrcBranchRecorder m_rec_read;
+    TrcBranchRecorder m_rec_overrun;
+    std::map<uint8_t, std::vector<ocsd_branch_rec_t> > m_got;
+    std::map<uint8_t, std::vector<ocsd_branch_rec_t> > m_ref;
+    std::map<uint8_t, ref_state_t> m_ref_state;
+    int m_samples;
+    int m_sample_errs;
+    int m_excep_recs;
+};
+
+void BranchRecCheck::refElemIn(const uint8_t trc_chan_id, const OcsdTraceElement &elem)
+{
+    if (m_ref_state.find(trc_chan_id) == m_ref_state.end())
+    {
+        ref_state_t init_state;
+        memset(&init_state, 0, sizeof(init_state));
+        m_ref_state[trc_chan_id] = init_state;
+    }
+    ref_state_t &state = m_ref_state[trc_chan_id];
+
+    switch (elem.getType())
+    {
+    case OCSD_GEN_TRC_ELEM_INSTR_RANGE:
+        if (state.pending)
+            refAddRecord(trc_chan_id, state, elem.st_addr);
+        state.pending = false;
+        if (elem.has_cc)
+        {
+            state.cc += elem.cycle_count;
+            state.cc_valid = true;
+        }
+        if (elem.last_instr_exec && ((elem.last_i_type == OCSD_INSTR_BR) || (elem.last_i_type == OCSD_INSTR_BR_INDIRECT)))
+        {
+            state.pending = true;
+            state.pend_rec.from_addr = elem.en_addr - elem.last_instr_sz;
+            state.pend_rec.isa = (uint8_t)elem.isa;
+            state.pend_rec.flags = (elem.last_i_type == OCSD_INSTR_BR_INDIRECT) ? OCSD_BR_REC_INDIRECT : 0;
+            if (elem.last_i_subtype == OCSD_S_INSTR_BR_LINK)
+                state.pend_rec.flags |= OCSD_BR_REC_LINK;
+        }
+        break;
+
+    case OCSD_GEN_TRC_ELEM_CYCLE_COUNT:
+        if (elem.has_cc)
+        {
+            state.cc += elem.cycle_count;
+            state.cc_valid = true;
+        }
+        break;
+
+    case OCSD_GEN_TRC_ELEM_EXCEPTION:
+        if (state.pending && elem.excep_ret_addr && elem.excep_ret_addr_br_tgt)
+        {
+            refAddRecord(trc_chan_id, state, elem.en_addr);
+            m_excep_recs++;
+        }
+        state.pending = false;
+        break;
+
+    case OCSD_GEN_TRC_ELEM_NO_SYNC:
+    case OCSD_GEN_TRC_ELEM_TRACE_ON:
+    case OCSD_GEN_TRC_ELEM_EO_TRACE:
+    case OCSD_GEN_TRC_ELEM_ADDR_NACC:
+    case OCSD_GEN_TRC_ELEM_ADDR_UNKNOWN:
+        state.pending = false;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void BranchRecCheck::refAddRecord(const uint8_t trc_chan_id, ref_state_t &state, const ocsd_vaddr_t to_addr)
+{
+    ocsd_branch_rec_t rec = state.pend_rec;
+
+    rec.to_addr = to_addr;
+    rec.cycle_count = 0;
+    if (state.cc_valid)
+    {
+        rec.cycle_count = state.cc;
+        rec.flags |= OCSD_BR_REC_HAS_CC;
+        state.cc = 0;
+        state.cc_valid = false;
+    }
+    m_ref[trc_chan_id].push_back(rec);
+}
+
+bool BranchRecCheck::stackMatch(const std::vector<ocsd_branch_rec_t> &ref, const ocsd_branch_rec_t *stack, const int depth, const int req_depth) const
+{
+    int exp_depth = (ref.size() < (size_t)req_depth) ? (int)ref.size() : req_depth;
+
+    if (depth != exp_depth)
+        return false;
+    for (int i = 0; i < depth; i++)
+    {
+        if (!rec_equal(stack[i], ref[ref.size() - 1 - i]))
+            return false;
+    }
+    return true;
+}
+
+int BranchRecCheck::checkResults(const std::string &name)
+{
+    std::map<uint8_t, std::vector<ocsd_branch_rec_t> >::iterator it;
+    ocsd_branch_rec_t stack[SS_SAMPLE_DEPTH];
+    int fails = 0;
+
+    for (it = m_ref.begin(); it != m_ref.end(); it++)
+    {
+        const uint8_t id = it->first;
+        const std::vector<ocsd_branch_rec_t> &ref = it->second;
+        const std::vector<ocsd_branch_rec_t> &got = m_got[id];
+        const uint64_t total = ref.size();
+        const uint64_t exp_lost = (total > SS_OVR_RING_SIZE) ? total - SS_OVR_RING_SIZE : 0;
+        std::ostringstream oss;
+        bool match = (got.size() == ref.size());
+        bool pass;
+        int depth;
+
+        for (size_t i = 0; match && (i < ref.size()); i++)
+            match = rec_equal(got[i], ref[i]);
+
+        depth = m_rec_overrun.getBranchStack(id, stack, SS_SAMPLE_DEPTH);
+        pass = match && (m_rec_overrun.getTotalRecords(id) == total) && (m_rec_overrun.getLostRecords(id) == exp_lost) &&
+               (m_rec_overrun.numRecords(id) == (uint32_t)(total - exp_lost)) && stackMatch(ref, stack, depth, SS_SAMPLE_DEPTH);
+
+        oss << name << " ID 0x" << std::hex << (uint32_t)id << std::dec << ": records " << total;
+        oss << "; lost in " << SS_OVR_RING_SIZE << " ring " << m_rec_overrun.getLostRecords(id);
+        oss << "; stack depth " << depth << (match ? "" : "; record mismatch");
+        log_check(oss.str(), pass);
+        if (!pass)
+            fails++;
+    }
+
+    std::ostringstream oss;
+    oss << name << ": exception return records " << m_excep_recs << "; samples " << m_samples << "; sample mismatches " << m_sample_errs;
+    log_check(oss.str(), m_sample_errs == 0);
+    if (m_sample_errs)
+        fails++;
+    return fails;
+}
+
+static bool load_buffer(const std::string &name, std::vector<uint8_t> &data)
+{
+    std::ifstream in(name.c_str(), std::ifstream::binary);
+
+    if (!in.is_open())
+        return false;
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static bool decode_buffer(SnapShotReader &reader, const std::string &buffer_name, ITrcGenElemIn *p_elem_in)
+{
+    CreateDcdTreeFromSnapShot tree_creator;
+    std::vector<uint8_t> data;
+    ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
+    uint32_t processed = 0, num_bytes;
+    const uint32_t block_size = 1024;
+
+    tree_creator.initialise(&reader, &err_log);
+    if (!load_buffer(tree_creator.getBufferFileNameFromBuffName(buffer_name), data) ||
+        !tree_creator.createDecodeTree(buffer_name, false))
+        return false;
+
+    DecodeTree *dcd_tree = tree_creator.getDecodeTree();
+    dcd_tree->setGenTraceElemOutI(p_elem_in);
+
+    while ((processed < (uint32_t)data.size()) && !OCSD_DATA_RESP_IS_FATAL(resp))
+    {
+        num_bytes = (uint32_t)data.size() - processed;
+        if (num_bytes > block_size)
+            num_bytes = block_size;
+        resp = dcd_tree->TraceDataIn(OCSD_OP_DATA, processed, num_bytes, &data[processed], &num_bytes);
+        processed += num_bytes;
+    }
+    if (!OCSD_DATA_RESP_IS_FATAL(resp))
+        dcd_tree->TraceDataIn(OCSD_OP_EOT, 0, 0, 0, 0);
+
+    tree_creator.destroyDecodeTree();
+    return true;
+}
+
+static void test_snapshot_decode()
+{
+    int passed = 0, failed = 0;
+
+    log_test_start(__FUNCTION__);
+
+    for (size_t i = 0; i < ss_dirs.size(); i++)
+    {
+        SnapShotReader reader;
+        std::vector<std::string> buffer_names;
+
+        reader.setSnapshotDir(ss_dirs[i]);
+        reader.setErrorLogger(&err_log);
+        reader.setVerboseOutput(false);
+        if (!reader.snapshotFound() || !reader.readSnapShot() || !reader.getSourceBufferNameList(buffer_names))
+        {
+            log_check("Read snapshot " + ss_dirs[i], false);
+            failed++;
+            continue;
+        }
+
+        for (size_t j = 0; j < buffer_names.size(); j++)
+        {
+            BranchRecCheck check;
+            const std::string name = ss_dirs[i] + " [" + buffer_names[j] + "]";
+
+            if (!decode_buffer(reader, buffer_names[j], &check))
+            {
+                log_check("Decode " + name, false);
+                failed++;
+                continue;
+            }
+            (check.checkResults(name) == 0) ? passed++ : failed++;
+        }
+    }
+
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * main program
+ */
+static void print_help()
+{
+    std::ostringstream oss;
+    oss << "branch-rec-test : tests for the taken branch recorder\n\n";
+    oss << "-ss_dir <dir>       Snapshot directory to decode (may be used multiple times).\n";
+    oss << "                    Default is an ETMv4, an ETE and a PTM snapshot from the test set.\n";
+    oss << "-logfilename <name> Output to file <name> (default " << logfileName << ").\n";
+    oss << "-help               This message.\n";
+    logger.LogMsg(oss.str());
+}
+
+static bool process_cmd_line(int argc, char *argv[])
+{
+    int optIdx = 1;
+
+    while (optIdx < argc)
+    {
+        if ((strcmp(argv[optIdx], "-ss_dir") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            ss_dirs.push_back(argv[optIdx]);
+        }
+        else if ((strcmp(argv[optIdx], "-logfilename") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            logfileName = argv[optIdx];
+        }
+        else
+            return false;
+        optIdx++;
+    }
+    if (ss_dirs.empty())
+    {
+        for (int i = 0; default_ss_dirs[i] != 0; i++)
+            ss_dirs.push_back(default_ss_dirs[i]);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::ostringstream oss;
+    bool opts_ok = process_cmd_line(argc, argv);
+
+    logger.setLogOpts(opts_ok ? logOpts : (int)ocsdMsgLogger::OUT_STDOUT);
+    logger.setLogFileName(logfileName.c_str());
+    if (!opts_ok)
+    {
+        print_help();
+        return -1;
+    }
+    err_log.initErrorLogger(OCSD_ERR_SEV_ERROR);
+    err_log.setOutputLogger(&logger);
+
+    oss << "OpenCSD branch recorder tests.\n";
+    oss << "------------------------------\n\n";
+    oss << "Library Version : " << ocsdVersion::vers_str() << "\n\n";
+    logger.LogMsg(oss.str());
+
+    test_record_rules();
+
+    test_ring_overrun();
+
+    test_branch_stack();
+
+    test_sampling();
+
+    test_snapshot_decode();
+
+    oss.str("");
+    oss << "*** Branch recorder tests complete.***\nPassed: " << tests_passed << "; Failed: " << tests_failed << "\n";
+    logger.LogMsg(oss.str());
+    return (tests_failed == 0) ? 0 : -2;
+}
+
+/* End of File branch_rec_test.cpp */
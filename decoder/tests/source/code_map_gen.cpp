@@ -0,0 +1,235 @@
+/*
+* \file     code_map_gen.cpp
+* \brief    OpenCSD: create pre-decoded code map files for memory images.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* 
+ * Scan an A64 or A32 code image once and save the waypoints as a code map
+ * sidecar file. Decoders with the map attached to the image memory accessor
+ * (DecodeTree::addCodeMapFile(), trc_pkt_lister -code_map) find the next
+ * waypoint from the map rather than decoding each instruction.
+ *
+ * Decode settings must match those used by the trace decoder, otherwise the
+ * map is ignored.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+#include "opencsd.h"              // the library
+
+static std::string image_file;
+static std::string map_file;
+static std::string info_file;
+static ocsd_vaddr_t load_addr = 0;
+static size_t file_offset = 0;
+static size_t map_size = 0;
+static ocsd_isa isa = ocsd_isa_aarch64;
+static ocsd_arch_profile_t pe_type = { ARCH_V8, profile_CortexA };
+static uint8_t dcd_flags = 0;
+
+static void print_help()
+{
+    std::cout << "code-map-gen : create a pre-decoded code map file for a memory image\n\n";
+    std::cout << "-f <file>        Code image file.\n";
+    std::cout << "-addr <addr>     Load address of the image (default 0).\n";
+    std::cout << "-offset <n>      Offset of the code in the file - requires -size (default 0).\n";
+    std::cout << "-size <n>        Size of the code in the file (default whole file).\n";
+    std::cout << "-isa <a64|a32>   Instruction set of the code (default a64).\n";
+    std::cout << "-arch <v7|v8|v8r3|aa64>  Architecture of the core (default v8).\n";
+    std::cout << "-profile <a|r|m> Profile of the core (default a).\n";
+    std::cout << "-dsb_dmb_wp      DSB / DMB are waypoints (PTM with DMB/DSB waypoints configured).\n";
+    std::cout << "-wfi_wfe_br      WFI / WFE are branches (ETMv4.3 and later, ETE).\n";
+    std::cout << "-o <file>        Output code map file (default <image file>" << OCSD_CODE_MAP_FILE_EXT << ").\n";
+    std::cout << "-info <file>     Print information for an existing code map file.\n";
+    std::cout << "-help            This message.\n";
+}
+
+static bool process_cmd_line(int argc, char *argv[])
+{
+    int optIdx = 1;
+
+    while (optIdx < argc)
+    {
+        if ((strcmp(argv[optIdx], "-f") == 0) && (optIdx + 1 < argc))
+            image_file = argv[++optIdx];
+        else if ((strcmp(argv[optIdx], "-addr") == 0) && (optIdx + 1 < argc))
+            load_addr = (ocsd_vaddr_t)strtoull(argv[++optIdx], 0, 0);
+        else if ((strcmp(argv[optIdx], "-offset") == 0) && (optIdx + 1 < argc))
+            file_offset = (size_t)strtoull(argv[++optIdx], 0, 0);
+        else if ((strcmp(argv[optIdx], "-size") == 0) && (optIdx + 1 < argc))
+            map_size = (size_t)strtoull(argv[++optIdx], 0, 0);
+        else if ((strcmp(argv[optIdx], "-isa") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            if (strcmp(argv[optIdx], "a64") == 0)
+                isa = ocsd_isa_aarch64;
+            else if (strcmp(argv[optIdx], "a32") == 0)
+                isa = ocsd_isa_arm;
+            else
+            {
+                std::cout << "Unsupported ISA " << argv[optIdx] << "\n";
+                return false;
+            }
+        }
+        else if ((strcmp(argv[optIdx], "-arch") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            if (strcmp(argv[optIdx], "v7") == 0)
+                pe_type.arch = ARCH_V7;
+            else if (strcmp(argv[optIdx], "v8") == 0)
+                pe_type.arch = ARCH_V8;
+            else if (strcmp(argv[optIdx], "v8r3") == 0)
+                pe_type.arch = ARCH_V8r3;
+            else if (strcmp(argv[optIdx], "aa64") == 0)
+                pe_type.arch = ARCH_AA64;
+            else
+            {
+                std::cout << "Unsupported architecture " << argv[optIdx] << "\n";
+                return false;
+            }
+        }
+        else if ((strcmp(argv[optIdx], "-profile") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            if (strcmp(argv[optIdx], "a") == 0)
+                pe_type.profile = profile_CortexA;
+            else if (strcmp(argv[optIdx], "r") == 0)
+                pe_type.profile = profile_CortexR;
+            else if (strcmp(argv[optIdx], "m") == 0)
+                pe_type.profile = profile_CortexM;
+            else
+            {
+                std::cout << "Unsupported profile " << argv[optIdx] << "\n";
+                return false;
+            }
+        }
+        else if (strcmp(argv[optIdx], "-dsb_dmb_wp") == 0)
+            dcd_flags |= OCSD_CODE_MAP_DSB_DMB_WP;
+        else if (strcmp(argv[optIdx], "-wfi_wfe_br") == 0)
+            dcd_flags |= OCSD_CODE_MAP_WFI_WFE_BR;
+        else if ((strcmp(argv[optIdx], "-o") == 0) && (optIdx + 1 < argc))
+            map_file = argv[++optIdx];
+        else if ((strcmp(argv[optIdx], "-info") == 0) && (optIdx + 1 < argc))
+            info_file = argv[++optIdx];
+        else
+        {
+            print_help();
+            return false;
+        }
+        optIdx++;
+    }
+
+    if (image_file.empty() && info_file.empty())
+    {
+        print_help();
+        return false;
+    }
+    if (map_file.empty())
+        map_file = TrcMemAccCodeMap::defaultMapPath(image_file);
+    return true;
+}
+
+static void print_map_info(const TrcMemAccCodeMap &code_map)
+{
+    std::ostringstream oss;
+
+    oss << "Image: " << code_map.getImagePath() << "\n";
+    oss << "Range: 0x" << std::hex << code_map.getStartAddr() << ":0x" << code_map.getEndAddr();
+    oss << "; ISA: " << ((code_map.getISA() == ocsd_isa_aarch64) ? "A64" : "A32") << "\n";
+    oss << "Content hash: 0x" << std::setw(16) << std::setfill('0') << code_map.getContentHash() << "\n";
+    oss << "Arch: 0x" << std::hex << (int)code_map.getArchVersion() << std::dec << "; Profile: " << (int)code_map.getCoreProfile() << "\n";
+    oss << std::dec << "Waypoints: " << code_map.getNumWaypoints() << "\n";
+    std::cout << oss.str();
+}
+
+static std::string err_str(const ocsd_err_t err)
+{
+    ocsdError error(OCSD_ERR_SEV_ERROR, err);
+    return ocsdError::getErrorString(error);
+}
+
+int main(int argc, char *argv[])
+{
+    TrcMemAccCodeMap code_map;
+    TrcMemAccessorBase *p_accessor = 0;
+    ocsd_vaddr_t st_addr, en_addr;
+    ocsd_err_t err;
+
+    if (!process_cmd_line(argc, argv))
+        return 1;
+
+    if (!info_file.empty())
+    {
+        err = code_map.loadMap(info_file);
+        if (err != OCSD_OK)
+        {
+            std::cout << "Failed to load code map " << info_file << ": " << err_str(err) << "\n";
+            return 1;
+        }
+        print_map_info(code_map);
+        return 0;
+    }
+
+    err = TrcMemAccFactory::CreateFileAccessor(&p_accessor, image_file, load_addr, file_offset, map_size);
+    if (err != OCSD_OK)
+    {
+        std::cout << "Failed to open image " << image_file << ": " << err_str(err) << "\n";
+        return 1;
+    }
+
+    // whole instructions in the accessor range
+    p_accessor->getRange(0, st_addr, en_addr);
+    en_addr = st_addr + ((en_addr - st_addr + 1) & ~((ocsd_vaddr_t)0x3)) - 1;
+
+    err = code_map.buildMap(p_accessor, st_addr, en_addr, isa, pe_type, dcd_flags, image_file);
+    if (err == OCSD_OK)
+        err = code_map.saveMap(map_file);
+    TrcMemAccFactory::DestroyAccessor(p_accessor);
+
+    if (err != OCSD_OK)
+    {
+        std::cout << "Failed to create code map " << map_file << ": " << err_str(err) << "\n";
+        return 1;
+    }
+
+    print_map_info(code_map);
+    std::cout << "Code map saved to " << map_file << "\n";
+    return 0;
+}
+
+/* End of File code_map_gen.cpp */
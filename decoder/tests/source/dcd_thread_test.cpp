@@ -0,0 +1,348 @@
+/*
+* \file     dcd_thread_test.cpp
+* \brief    OpenCSD: stress test decoding snapshots on multiple threads, one decode tree per thread.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Decode the trace buffers in a set of snapshots on the main thread to get
+ * reference output, then decode them again on a number of threads at once.
+ * Each thread creates its own decode trees, with its own error logger, and
+ * starts at a different point in the list so different snapshots, and the same
+ * snapshot, are decoded concurrently. Output from every thread must match
+ * the reference.
+ *
+ * Trees share the library decoder register, file memory accessors, and
+ * default error logger - use with a thread sanitizer build to check these.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "opencsd.h"              // the library
+#include "trace_snapshots.h"      // the snapshot reading test library
+
+static std::string ss_base_dir = "./snapshots";
+static std::vector<std::string> ss_names;
+static int num_threads = 4;
+static int num_loops = 2;
+
+// snapshots decoded by default - the full decode set from run_pkt_decode_tests.bash
+static const char *default_ss_names[] = {
+    "a57_single_step",
+    "armv8_1m_branches",
+    "bugfix-exact-match",
+    "itm_only_csformat",
+    "itm_only_raw",
+    "juno_r1_1",
+    "juno-ret-stck",
+    "juno-uname-001",
+    "juno-uname-002",
+    "Snowball",
+    "stm-issue-27",
+    "stm_only",
+    "stm_only-2",
+    "stm_only-juno",
+    "TC2",
+    "tc2-ptm-rstk-t32",
+    "test-file-mem-offsets",
+    "trace_cov_a15",
+    0
+};
+
+/* a trace buffer to decode, with the reference output from the main thread */
+typedef struct _test_buffer {
+    SnapShotReader *p_reader;
+    std::string buffer_name;
+    std::vector<uint8_t> data;
+    std::string ref_output;
+} test_buffer_t;
+
+static std::vector<test_buffer_t> test_buffers;
+
+/* per thread results */
+typedef struct _thread_result {
+    int decodes;
+    int mismatches;
+    int failures;
+} thread_result_t;
+
+/* collect the generic element output of a tree as text */
+class ElemCollect : public ITrcGenElemIn
+{
+public:
+    ElemCollect() {};
+    virtual ~ElemCollect() {};
+
+    virtual ocsd_datapath_resp_t TraceElemIn(const ocsd_trc_index_t index_sop,
+                                             const uint8_t trc_chan_id,
+                                             const OcsdTraceElement &elem)
+    {
+        std::string elemStr;
+        std::ostringstream oss;
+
+        elem.toString(elemStr);
+        oss << "Idx:" << index_sop << "; ID:" << std::hex << (uint32_t)trc_chan_id << "; " << elemStr << "\n";
+        m_output += oss.str();
+        return OCSD_RESP_CONT;
+    }
+
+    std::string &getOutput() { return m_output; };
+
+private:
+    std::string m_output;
+};
+
+static void print_help()
+{
+    std::cout << "dcd-thread-test : decode snapshots on multiple threads, one decode tree per thread\n\n";
+    std::cout << "-ss_dir <dir>   Base directory for the snapshots (default " << ss_base_dir << ").\n";
+    std::cout << "-ss <name>      Snapshot in the base directory to decode (may be used multiple times).\n";
+    std::cout << "                Default is the full decode test set.\n";
+    std::cout << "-threads <n>    Number of decode threads (default 4).\n";
+    std::cout << "-loops <n>      Number of passes over the snapshots on each thread (default 2).\n";
+    std::cout << "-help           This message.\n";
+}
+
+static bool process_cmd_line(int argc, char *argv[])
+{
+    int optIdx = 1;
+
+    while (optIdx < argc)
+    {
+        if ((strcmp(argv[optIdx], "-ss_dir") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            ss_base_dir = argv[optIdx];
+        }
+        else if ((strcmp(argv[optIdx], "-ss") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            ss_names.push_back(argv[optIdx]);
+        }
+        else if ((strcmp(argv[optIdx], "-threads") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            num_threads = atoi(argv[optIdx]);
+            if (num_threads < 1)
+                num_threads = 1;
+        }
+        else if ((strcmp(argv[optIdx], "-loops") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            num_loops = atoi(argv[optIdx]);
+            if (num_loops < 1)
+                num_loops = 1;
+        }
+        else
+        {
+            print_help();
+            return false;
+        }
+        optIdx++;
+    }
+    if (ss_names.empty())
+    {
+        for (int i = 0; default_ss_names[i] != 0; i++)
+            ss_names.push_back(default_ss_names[i]);
+    }
+    return true;
+}
+
+static bool load_buffer(const std::string &name, std::vector<uint8_t> &data)
+{
+    std::ifstream in(name.c_str(), std::ifstream::binary);
+
+    if (!in.is_open())
+        return false;
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+/* read the snapshots and load the trace buffers - on the main thread before decoding */
+static bool read_snapshots(ocsdDefaultErrorLogger &err_log)
+{
+    for (size_t i = 0; i < ss_names.size(); i++)
+    {
+        SnapShotReader *p_reader = new SnapShotReader();
+        std::vector<std::string> buffer_names;
+        CreateDcdTreeFromSnapShot tree_creator;
+
+        p_reader->setSnapshotDir(ss_base_dir + "/" + ss_names[i]);
+        p_reader->setErrorLogger(&err_log);
+        p_reader->setVerboseOutput(false);
+        if (!p_reader->snapshotFound() || !p_reader->readSnapShot() ||
+            !p_reader->getSourceBufferNameList(buffer_names))
+        {
+            std::cout << "Failed to read snapshot " << ss_names[i] << "\n";
+            delete p_reader;
+            return false;
+        }
+
+        tree_creator.initialise(p_reader, &err_log);
+        for (size_t j = 0; j < buffer_names.size(); j++)
+        {
+            test_buffer_t buffer;
+
+            test_buffers.push_back(buffer);
+            test_buffers.back().p_reader = p_reader;
+            test_buffers.back().buffer_name = buffer_names[j];
+            if (!load_buffer(tree_creator.getBufferFileNameFromBuffName(buffer_names[j]), test_buffers.back().data))
+            {
+                std::cout << "Failed to load trace buffer " << buffer_names[j] << " in snapshot " << ss_names[i] << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* create a tree for the buffer, decode it, and return the output */
+static bool decode_buffer(const test_buffer_t &buffer, ITraceErrorLog *p_err_log, std::string &output)
+{
+    CreateDcdTreeFromSnapShot tree_creator;
+    ElemCollect collect;
+    ocsd_datapath_resp_t resp = OCSD_RESP_CONT;
+    uint32_t processed = 0, num_bytes;
+    const uint32_t block_size = 1024;
+
+    tree_creator.initialise(buffer.p_reader, p_err_log);
+    if (!tree_creator.createDecodeTree(buffer.buffer_name, false))
+        return false;
+
+    DecodeTree *dcd_tree = tree_creator.getDecodeTree();
+    dcd_tree->setGenTraceElemOutI(&collect);
+
+    while ((processed < (uint32_t)buffer.data.size()) && !OCSD_DATA_RESP_IS_FATAL(resp))
+    {
+        num_bytes = (uint32_t)buffer.data.size() - processed;
+        if (num_bytes > block_size)
+            num_bytes = block_size;
+        resp = dcd_tree->TraceDataIn(OCSD_OP_DATA, processed, num_bytes, &buffer.data[processed], &num_bytes);
+        processed += num_bytes;
+    }
+    if (!OCSD_DATA_RESP_IS_FATAL(resp))
+        dcd_tree->TraceDataIn(OCSD_OP_EOT, 0, 0, 0, 0);
+
+    tree_creator.destroyDecodeTree();
+    output = collect.getOutput();
+    return true;
+}
+
+static void decode_thread(const int thread_idx, thread_result_t *p_result)
+{
+    ocsdDefaultErrorLogger err_log;     // each thread has its own logger, no output.
+    std::string output;
+    size_t num_buffers = test_buffers.size();
+
+    err_log.initErrorLogger(OCSD_ERR_SEV_ERROR);
+
+    for (int loop = 0; loop < num_loops; loop++)
+    {
+        for (size_t i = 0; i < num_buffers; i++)
+        {
+            // each thread starts at a different buffer
+            const test_buffer_t &buffer = test_buffers[(i + (size_t)thread_idx) % num_buffers];
+            if (!decode_buffer(buffer, &err_log, output))
+                p_result->failures++;
+            else if (output != buffer.ref_output)
+                p_result->mismatches++;
+            p_result->decodes++;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ocsdDefaultErrorLogger err_log;
+    ocsdMsgLogger logger;
+    std::vector<std::thread> threads;
+    std::vector<thread_result_t> results;
+    int total_fails = 0;
+
+    std::cout << "OpenCSD multi-thread decode test.\n";
+    std::cout << "---------------------------------\n\n";
+    std::cout << "Library Version : " << ocsdVersion::vers_str() << "\n\n";
+
+    if (!process_cmd_line(argc, argv))
+        return 1;
+
+    logger.setLogOpts(ocsdMsgLogger::OUT_STDOUT);
+    err_log.initErrorLogger(OCSD_ERR_SEV_ERROR);
+    err_log.setOutputLogger(&logger);
+
+    if (!read_snapshots(err_log))
+        return 1;
+
+    // reference decode on the main thread.
+    for (size_t i = 0; i < test_buffers.size(); i++)
+    {
+        if (!decode_buffer(test_buffers[i], &err_log, test_buffers[i].ref_output))
+        {
+            std::cout << "Failed to create decode tree for buffer " << test_buffers[i].buffer_name << "\n";
+            return 1;
+        }
+    }
+    std::cout << "Reference decode of " << test_buffers.size() << " trace buffers from " << ss_names.size() << " snapshots.\n";
+
+    // decode on all threads at once.
+    results.resize(num_threads);
+    for (int i = 0; i < num_threads; i++)
+    {
+        results[i].decodes = results[i].mismatches = results[i].failures = 0;
+        threads.push_back(std::thread(decode_thread, i, &results[i]));
+    }
+    for (int i = 0; i < num_threads; i++)
+        threads[i].join();
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        std::cout << "Thread " << i << " : " << results[i].decodes << " decodes; " << results[i].mismatches << " output mismatches; " << results[i].failures << " create failures.\n";
+        total_fails += results[i].mismatches + results[i].failures;
+    }
+    std::cout << "\n" << (total_fails ? "FAILED" : "PASSED") << " : " << num_threads << " threads, " << num_loops << " loops.\n";
+
+    for (size_t i = 0; i < test_buffers.size(); i++)
+    {
+        if ((i + 1 == test_buffers.size()) || (test_buffers[i + 1].p_reader != test_buffers[i].p_reader))
+            delete test_buffers[i].p_reader;
+    }
+    return total_fails ? 1 : 0;
+}
+
+/* End of File dcd_thread_test.cpp */
@@ -0,0 +1,287 @@
+/*
+* \file     idec_bench.cpp
+* \brief    OpenCSD: micro-benchmark for the A64 instruction decoder.
+*
+* \copyright  Copyright (c) 2026, ARM Limited. All Rights Reserved.
+*/
+
+/*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS' AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* 
+ * Decode every word of A64 memory images from the test snapshots, timing the
+ * library instruction decoder against a reference using the full chain of 
+ * classifier tests for each opcode. Checks the two give the same results.
+ *
+ * Also times walking the images waypoint to waypoint, decoding every opcode
+ * or using the opcode scan to step over straight line code.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+
+#include "opencsd.h"              // the library
+#include "i_dec/trc_idec_arminst.h"
+#include "i_dec/trc_idec_wp_scan.h"
+
+static std::vector<std::string> image_files;
+static int num_loops = 20;
+
+static const char *default_image = "./snapshots/juno_r1_1/kernel_dump.bin";
+
+static void print_help()
+{
+    std::cout << "idec-bench : A64 instruction decode micro-benchmark\n\n";
+    std::cout << "-f <file>      A64 code image to decode (may be used multiple times).\n";
+    std::cout << "               Default is " << default_image << "\n";
+    std::cout << "-loops <n>     Number of passes over the images (default 20).\n";
+    std::cout << "-help          This message.\n";
+}
+
+static bool process_cmd_line(int argc, char *argv[])
+{
+    int optIdx = 1;
+
+    while (optIdx < argc)
+    {
+        if ((strcmp(argv[optIdx], "-f") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            image_files.push_back(argv[optIdx]);
+        }
+        else if ((strcmp(argv[optIdx], "-loops") == 0) && (optIdx + 1 < argc))
+        {
+            optIdx++;
+            num_loops = atoi(argv[optIdx]);
+            if (num_loops < 1)
+                num_loops = 1;
+        }
+        else
+        {
+            print_help();
+            return false;
+        }
+        optIdx++;
+    }
+    if (image_files.empty())
+        image_files.push_back(default_image);
+    return true;
+}
+
+static bool load_image(const std::string &name, std::vector<uint32_t> &opcodes)
+{
+    std::ifstream in(name.c_str(), std::ifstream::binary);
+    uint32_t opcode;
+
+    if (!in.is_open())
+    {
+        std::cout << "Failed to open image file " << name << "\n";
+        return false;
+    }
+    while (in.read((char *)&opcode, sizeof(opcode)))
+        opcodes.push_back(opcode);
+    return true;
+}
+
+/* reference decode - full classifier chain for every opcode */
+static void ref_decode_A64(ocsd_instr_info *instr_info)
+{
+    struct decode_info info;
+    uint64_t branchAddr = 0;
+    arm_barrier_t barrier;
+
+    info.arch_version = instr_info->pe_type.arch;
+    info.instr_sub_type = OCSD_S_INSTR_NONE;
+
+    instr_info->instr_size = 4;
+    instr_info->type = OCSD_INSTR_OTHER;
+    instr_info->next_isa = instr_info->isa;
+    instr_info->is_link = 0;
+    instr_info->thumb_it_conditions = 0;
+
+    if (inst_A64_is_indirect_branch_link(instr_info->opcode, &instr_info->is_link, &info))
+        instr_info->type = OCSD_INSTR_BR_INDIRECT;
+    else if (inst_A64_is_direct_branch_link(instr_info->opcode, &instr_info->is_link, &info))
+    {
+        inst_A64_branch_destination(instr_info->instr_addr, instr_info->opcode, &branchAddr);
+        instr_info->type = OCSD_INSTR_BR;
+        instr_info->branch_addr = (ocsd_vaddr_t)branchAddr;
+    }
+    else if ((barrier = inst_A64_barrier(instr_info->opcode)) != ARM_BARRIER_NONE)
+    {
+        if (barrier == ARM_BARRIER_ISB)
+            instr_info->type = OCSD_INSTR_ISB;
+        else if (instr_info->dsb_dmb_waypoints)
+            instr_info->type = OCSD_INSTR_DSB_DMB;
+    }
+    else if (instr_info->wfi_wfe_branch && inst_A64_wfiwfe(instr_info->opcode, &info))
+        instr_info->type = OCSD_INSTR_WFI_WFE;
+    else if (OCSD_IS_ARCH_MINVER(info.arch_version, ARCH_AA64) && inst_A64_Tstart(instr_info->opcode))
+        instr_info->type = OCSD_INSTR_TSTART;
+
+    instr_info->is_conditional = inst_A64_is_conditional(instr_info->opcode);
+    instr_info->sub_type = info.instr_sub_type;
+}
+
+static void init_instr_info(ocsd_instr_info &instr_info)
+{
+    memset(&instr_info, 0, sizeof(instr_info));
+    instr_info.pe_type.arch = ARCH_AA64;
+    instr_info.pe_type.profile = profile_CortexA;
+    instr_info.isa = ocsd_isa_aarch64;
+    instr_info.dsb_dmb_waypoints = 1;
+    instr_info.wfi_wfe_branch = 1;
+}
+
+static bool same_result(const ocsd_instr_info &a, const ocsd_instr_info &b)
+{
+    return (a.type == b.type) && (a.sub_type == b.sub_type) && (a.is_link == b.is_link) &&
+           (a.is_conditional == b.is_conditional) && (a.instr_size == b.instr_size) &&
+           (a.next_isa == b.next_isa) && ((a.type != OCSD_INSTR_BR) || (a.branch_addr == b.branch_addr));
+}
+
+/* decode all opcodes num_loops times, return elapsed seconds; count waypoints on first pass */
+template <class DecodeFn>
+static double time_decode(const std::vector<uint32_t> &opcodes, DecodeFn decode, uint64_t &num_wp)
+{
+    ocsd_instr_info instr_info;
+    std::chrono::time_point<std::chrono::steady_clock> start, end;
+
+    init_instr_info(instr_info);
+    num_wp = 0;
+    start = std::chrono::steady_clock::now();
+    for (int loop = 0; loop < num_loops; loop++)
+    {
+        for (size_t i = 0; i < opcodes.size(); i++)
+        {
+            instr_info.instr_addr = (ocsd_vaddr_t)(i * 4);
+            instr_info.opcode = opcodes[i];
+            decode(&instr_info);
+            if (instr_info.type != OCSD_INSTR_OTHER)
+                num_wp++;
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    num_wp /= num_loops;
+    return std::chrono::duration<double>(end - start).count();
+}
+
+/* walk the opcodes to each waypoint, return elapsed seconds; sum of waypoint indexes as a check value */
+static double time_walk(const std::vector<uint32_t> &opcodes, TrcIDecode &idec, const bool use_scan, uint64_t &wp_check)
+{
+    ocsd_instr_info instr_info;
+    std::chrono::time_point<std::chrono::steady_clock> start, end;
+    const uint8_t *p_bytes = (const uint8_t *)opcodes.data();
+    const uint32_t num_opcodes = (uint32_t)opcodes.size();
+
+    init_instr_info(instr_info);
+    wp_check = 0;
+    start = std::chrono::steady_clock::now();
+    for (int loop = 0; loop < num_loops; loop++)
+    {
+        uint32_t i = 0;
+        while (i < num_opcodes)
+        {
+            instr_info.instr_addr = (ocsd_vaddr_t)(i * 4);
+            instr_info.opcode = opcodes[i];
+            idec.DecodeInstruction(&instr_info);
+            if (instr_info.type != OCSD_INSTR_OTHER)
+                wp_check += i;
+            i++;
+            if (use_scan && (instr_info.type == OCSD_INSTR_OTHER))
+                i += inst_A64_scan_to_wp(p_bytes + (i * 4), num_opcodes - i);
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<uint32_t> opcodes;
+    ocsd_instr_info lib_info, ref_info, direct_info;
+    TrcIDecode idec;
+    IInstrDecode *volatile p_idec_if = &idec;  // volatile - keep the interface call virtual.
+    uint64_t mismatches = 0, lib_wp = 0, direct_wp = 0, ref_wp = 0, walk_check = 0, scan_check = 0;
+    double lib_secs, direct_secs, ref_secs, walk_secs, scan_secs, num_decodes;
+
+    if (!process_cmd_line(argc, argv))
+        return 1;
+
+    for (size_t i = 0; i < image_files.size(); i++)
+    {
+        if (!load_image(image_files[i], opcodes))
+            return 1;
+    }
+    if (opcodes.empty())
+    {
+        std::cout << "No opcodes to decode\n";
+        return 1;
+    }
+
+    // check library decode against the reference.
+    init_instr_info(lib_info);
+    init_instr_info(ref_info);
+    init_instr_info(direct_info);
+    for (size_t i = 0; i < opcodes.size(); i++)
+    {
+        lib_info.instr_addr = ref_info.instr_addr = direct_info.instr_addr = (ocsd_vaddr_t)(i * 4);
+        lib_info.opcode = ref_info.opcode = direct_info.opcode = opcodes[i];
+        idec.DecodeInstruction(&lib_info);
+        idec.decodeInstrDirect(&direct_info);
+        ref_decode_A64(&ref_info);
+        if (!same_result(lib_info, ref_info) || !same_result(direct_info, ref_info))
+        {
+            if (mismatches < 10)
+                printf("Mismatch: opcode 0x%08x; lib type %d; ref type %d\n", opcodes[i], lib_info.type, ref_info.type);
+            mismatches++;
+        }
+    }
+
+    ref_secs = time_decode(opcodes, ref_decode_A64, ref_wp);
+    lib_secs = time_decode(opcodes, [p_idec_if](ocsd_instr_info *p_info) { p_idec_if->DecodeInstruction(p_info); }, lib_wp);
+    direct_secs = time_decode(opcodes, [&idec](ocsd_instr_info *p_info) { idec.decodeInstrDirect(p_info); }, direct_wp);
+    walk_secs = time_walk(opcodes, idec, false, walk_check);
+    scan_secs = time_walk(opcodes, idec, true, scan_check);
+    num_decodes = (double)opcodes.size() * num_loops;
+
+    printf("Opcodes: %zu; passes: %d; waypoints per pass: %llu\n", opcodes.size(), num_loops, (unsigned long long)lib_wp);
+    printf("Reference classifier  : %.3f s; %.2f ns per opcode\n", ref_secs, (ref_secs * 1e9) / num_decodes);
+    printf("Library decoder       : %.3f s; %.2f ns per opcode\n", lib_secs, (lib_secs * 1e9) / num_decodes);
+    printf("Library direct decode : %.3f s; %.2f ns per opcode\n", direct_secs, (direct_secs * 1e9) / num_decodes);
+    printf("Walk, decode all      : %.3f s; %.2f ns per opcode\n", walk_secs, (walk_secs * 1e9) / num_decodes);
+    printf("Walk, scan to WP      : %.3f s; %.2f ns per opcode\n", scan_secs, (scan_secs * 1e9) / num_decodes);
+    printf("Mismatches: %llu; Walk waypoints %s\n", (unsigned long long)mismatches, (walk_check == scan_check) ? "match" : "DIFFER");
+    return ((mismatches == 0) && (lib_wp == ref_wp) && (direct_wp == ref_wp) && (walk_check == scan_check)) ? 0 : 1;
+}
+
+/* End of File idec_bench.cpp */
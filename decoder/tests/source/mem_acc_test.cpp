@@ -44,6 +44,8 @@
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <vector>
+#include <chrono>
 
 #include "opencsd.h"  
 
@@ -724,6 +726,1103 @@ void test_mem_spaces()
     log_test_end(__FUNCTION__, passed, failed);
  }
 
+/************************************************************************
+ * Test lookup of accessors with large numbers of accessors in the map.
+ * Emulates clients such as perf loading many small DSO / JIT regions,
+ * with the trace branching between them.
+ *
+ * Checks the correct accessor is found in each memory space, and logs
+ * the cost of each lookup against the number of accessors mapped.
+ */
+
+#define MANY_ACC_ADDR_STRIDE 0x1000
+#define MANY_ACC_NUM_WORDS 4
+#define MANY_ACC_LOOKUPS 0x100000
+
+void test_many_accessors()
+{
+    static const int acc_counts[] = { 16, 64, 256, 1024, 4096 };
+    static const ocsd_mem_space_acc_t spaces[] = { OCSD_MEM_SPACE_EL1N, OCSD_MEM_SPACE_EL2 };
+    int passed = 0, failed = 0;
+    std::ostringstream oss;
+    ocsd_err_t err;
+
+    log_test_start(__FUNCTION__);
+
+    // timing the lookup - do not want cache invalidation costs in the measurement
+    mapper.enableCaching(false);
+
+    for (size_t c = 0; c < sizeof(acc_counts) / sizeof(acc_counts[0]); c++)
+    {
+        const int num_accs = acc_counts[c];
+        std::vector<TrcMemAccBufPtr> accs(num_accs * 2);
+        std::vector<uint32_t> data(num_accs * 2 * MANY_ACC_NUM_WORDS);
+        bool add_ok = true, read_ok = true;
+
+        // pairs of accessors at the same address in different memory spaces.
+        for (int i = 0; i < num_accs; i++)
+        {
+            for (int sp = 0; sp < 2; sp++)
+            {
+                int idx = (i * 2) + sp;
+                for (int w = 0; w < MANY_ACC_NUM_WORDS; w++)
+                    data[(idx * MANY_ACC_NUM_WORDS) + w] = BLOCK_VAL(spaces[sp], w, i);
+                accs[idx].initAccessor((ocsd_vaddr_t)i * MANY_ACC_ADDR_STRIDE, (const uint8_t*)&data[idx * MANY_ACC_NUM_WORDS], MANY_ACC_NUM_WORDS * 4);
+                accs[idx].setMemSpace(spaces[sp]);
+                err = mapper.AddAccessor(&accs[idx], 0);
+                if (err != OCSD_OK)
+                    add_ok = false;
+            }
+        }
+        add_ok ? passed++ : failed++;
+
+        // check all reads land in the correct accessor
+        for (int i = 0; (i < num_accs) && read_ok; i++)
+        {
+            for (int sp = 0; sp < 2; sp++)
+            {
+                uint32_t read_val = 0, num_bytes = 4;
+                ocsd_vaddr_t addr = ((ocsd_vaddr_t)i * MANY_ACC_ADDR_STRIDE) + 4;
+                err = mapper.ReadTargetMemory(addr, 0, spaces[sp], &num_bytes, (uint8_t*)&read_val);
+                if ((err != OCSD_OK) || (num_bytes != 4) || (read_val != BLOCK_VAL(spaces[sp], 1, i)))
+                    read_ok = false;
+            }
+        }
+
+        // gap between accessors must not be found
+        if (read_ok)
+        {
+            uint32_t read_val = 0, num_bytes = 4;
+            err = mapper.ReadTargetMemory(MANY_ACC_ADDR_STRIDE / 2, 0, OCSD_MEM_SPACE_EL1N, &num_bytes, (uint8_t*)&read_val);
+            if ((err != OCSD_OK) || (num_bytes != 0))
+                read_ok = false;
+        }
+        read_ok ? passed++ : failed++;
+
+        // time lookups - stride through the accessors so that every read changes accessor
+        uint32_t read_val = 0, num_bytes, check = 0;
+        int acc_idx = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int l = 0; l < MANY_ACC_LOOKUPS; l++)
+        {
+            num_bytes = 4;
+            mapper.ReadTargetMemory((ocsd_vaddr_t)acc_idx * MANY_ACC_ADDR_STRIDE, 0, spaces[l & 0x1], &num_bytes, (uint8_t*)&read_val);
+            check += num_bytes;
+            acc_idx = (acc_idx + 997) % num_accs;
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (check != (uint32_t)(MANY_ACC_LOOKUPS * 4))
+        {
+            logger.LogMsg("Read Fail: timed lookups did not return all bytes\n");
+            failed++;
+        }
+        else
+            passed++;
+
+        oss.str("");
+        oss << "Accessors: " << std::dec << std::setw(5) << std::setfill(' ') << (num_accs * 2);
+        oss << "; Lookups: " << MANY_ACC_LOOKUPS << "; ns per lookup: " << std::fixed << std::setprecision(1);
+        oss << (elapsed.count() / MANY_ACC_LOOKUPS) << "\n";
+        logger.LogMsg(oss.str());
+
+        mapper.RemoveAllAccessors();
+    }
+
+    mapper.enableCaching(true);
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test pointer reads - buffer accessors return pointers into the buffer,
+ * callback accessors return pointers into cache pages, or the mapper 
+ * buffer if caching is off.
+ */
+bool read_ptr_and_check(ocsd_vaddr_t addr, const uint8_t trcID, const uint8_t* p_expected, const uint32_t expected_bytes, const bool callback)
+{
+    const uint8_t* p_data = 0;
+    uint32_t num_bytes = 4;
+    int PrevAccCallbackCount = AccCallbackCount;
+    std::ostringstream oss;
+    ocsd_err_t err;
+    bool pass = true;
+
+    err = mapper.ReadTargetMemoryPtr(addr, trcID, OCSD_MEM_SPACE_EL1N, &num_bytes, &p_data);
+
+    oss << "Read Ptr Test: Address 0x" << std::hex << std::setw(8) << std::setfill('0') << addr << "; ";
+    if (err != OCSD_OK)
+    {
+        oss << "Error reading target memory\n";
+        pass = false;
+    }
+    else if (num_bytes != expected_bytes)
+    {
+        oss << "Read Fail: valid bytes mismatch (0x" << expected_bytes << " != 0x" << num_bytes << ")\n";
+        pass = false;
+    }
+    else if (!p_data || (memcmp(p_data, p_expected, 4) != 0))
+    {
+        oss << "Read Fail: value read mismatch\n";
+        pass = false;
+    }
+    else if (callback != (PrevAccCallbackCount != AccCallbackCount))
+    {
+        oss << "Read Fail: " << (callback ? "Expected" : "Unexpected") << " callback to access memory\n";
+        pass = false;
+    }
+    else
+        oss << "OK\n";
+    logger.LogMsg(oss.str());
+    return pass;
+}
+
+void test_read_ptr()
+{
+    TrcMemAccBufPtr BufAcc;
+    TrcMemAccCB CBAcc;
+    test_range_array_t ranges;
+    test_range_t range;
+    const uint8_t* p_block = (const uint8_t*)&el01_ns_blocks[0];
+    const uint8_t* p_cb_block = (const uint8_t*)&el01_ns_blocks[1];
+    int passed = 0, failed = 0;
+    ocsd_err_t err;
+
+    log_test_start(__FUNCTION__);
+
+    // buffer accessor - pointer direct into buffer, all bytes to end of buffer valid
+    BufAcc.initAccessor(TEST_ADDR_COMMON, p_block, BLOCK_SIZE_BYTES);
+    BufAcc.setMemSpace(OCSD_MEM_SPACE_EL1N);
+
+    // callback accessor immediately after buffer.
+    ranges.num_ranges = 1;
+    ranges.ranges = &range;
+    set_test_range(range, TEST_ADDR_COMMON + BLOCK_SIZE_BYTES, BLOCK_SIZE_BYTES, p_cb_block, OCSD_MEM_SPACE_EL1N, 0x10);
+    CBAcc.initAccessor(TEST_ADDR_COMMON + BLOCK_SIZE_BYTES, TEST_ADDR_COMMON + (2 * BLOCK_SIZE_BYTES) - 1, OCSD_MEM_SPACE_EL1N);
+    CBAcc.setCBIDIfFn(TestMemAccCB, (void*)&ranges);
+
+    if (((err = mapper.AddAccessor(&BufAcc, 0)) != OCSD_OK) ||
+        ((err = mapper.AddAccessor(&CBAcc, 0)) != OCSD_OK))
+    {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, err, "Failed to set memory accessors"));
+        failed++;
+        goto cleanup;
+    }
+
+    read_ptr_and_check(TEST_ADDR_COMMON + 0x10, 0x10, p_block + 0x10, BLOCK_SIZE_BYTES - 0x10, false) ? passed++ : failed++;
+
+    // callback - loads a cache page, all bytes to end of page valid, then read from the same page
+    read_ptr_and_check(TEST_ADDR_COMMON + BLOCK_SIZE_BYTES, 0x10, p_cb_block, MEM_ACC_CACHE_DEFAULT_PAGE_SIZE, true) ? passed++ : failed++;
+    read_ptr_and_check(TEST_ADDR_COMMON + BLOCK_SIZE_BYTES + 0x20, 0x10, p_cb_block + 0x20, MEM_ACC_CACHE_DEFAULT_PAGE_SIZE - 0x20, false) ? passed++ : failed++;
+
+    // callback with no cache - only the requested bytes are read
+    mapper.enableCaching(false);
+    read_ptr_and_check(TEST_ADDR_COMMON + BLOCK_SIZE_BYTES + 0x20, 0x10, p_cb_block + 0x20, 4, true) ? passed++ : failed++;
+    mapper.enableCaching(true);
+
+cleanup:
+    mapper.RemoveAllAccessors();
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test file accessor ranges - base and offset ranges that extend beyond
+ * the end of the file are rejected, and mapped file pointer reads stop at
+ * the end of the file.
+ */
+#define TEST_FILE_SIZE 0x100
+static const char *test_file_name = "mem_acc_test_file.bin";
+
+static bool add_file_range_and_check(TrcMemAccessorFile *p_acc, const ocsd_vaddr_t addr, const size_t size, const size_t offset, const bool expect_ok)
+{
+    std::ostringstream oss;
+    bool pass = (p_acc->AddOffsetRange(addr, size, offset) == expect_ok);
+
+    oss << "File Range Test: Address 0x" << std::hex << std::setw(8) << std::setfill('0') << addr;
+    oss << "; size 0x" << size << "; offset 0x" << offset << "; ";
+    if (pass)
+        oss << "OK\n";
+    else
+        oss << "Add Fail: range " << (expect_ok ? "rejected" : "accepted") << "\n";
+    logger.LogMsg(oss.str());
+    return pass;
+}
+
+void test_file_ranges()
+{
+    TrcMemAccessorFile *p_acc = 0;
+    const uint8_t* p_file_data = (const uint8_t*)&el01_ns_blocks[1];
+    const ocsd_vaddr_t base_addr = TEST_ADDR_COMMON + 0x1000;
+    int passed = 0, failed = 0;
+    ocsd_err_t err;
+    FILE *fp;
+
+    log_test_start(__FUNCTION__);
+
+    fp = fopen(test_file_name, "wb");
+    if (fp)
+    {
+        if (fwrite(p_file_data, 1, TEST_FILE_SIZE, fp) != TEST_FILE_SIZE)
+        {
+            fclose(fp);
+            fp = 0;
+        }
+        else
+            fclose(fp);
+    }
+    if (!fp)
+    {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, OCSD_ERR_FILE_ERROR, "Failed to write test file"));
+        failed++;
+        goto cleanup;
+    }
+
+    // offset range only - no base range set.
+    err = TrcMemAccessorFile::createFileAccessor(&p_acc, test_file_name, TEST_ADDR_COMMON, 0x10, 0x20, OCSD_FILE_MEM_ACC_OPT_MMAP, OCSD_MEM_SPACE_EL1N);
+    if (err != OCSD_OK)
+    {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, err, "Failed to create file accessor"));
+        failed++;
+        goto cleanup;
+    }
+
+    // base range and offset range past the end of the file, and an empty range.
+    add_file_range_and_check(p_acc, base_addr, TEST_FILE_SIZE + 0x100, 0, false) ? passed++ : failed++;
+    add_file_range_and_check(p_acc, base_addr, TEST_FILE_SIZE, 0x40, false) ? passed++ : failed++;
+    add_file_range_and_check(p_acc, base_addr, 0, 0x40, false) ? passed++ : failed++;
+
+    // base range the size of the file.
+    add_file_range_and_check(p_acc, base_addr, TEST_FILE_SIZE, 0, true) ? passed++ : failed++;
+
+    if ((err = mapper.AddAccessor(p_acc, 0)) != OCSD_OK)
+    {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, err, "Failed to set memory accessors"));
+        failed++;
+        goto cleanup;
+    }
+
+    // pointer reads return bytes to the end of the range, within the file.
+    read_ptr_and_check(TEST_ADDR_COMMON + 0x8, 0, p_file_data + 0x18, 0x18, false) ? passed++ : failed++;
+    read_ptr_and_check(base_addr + TEST_FILE_SIZE - 0x10, 0, p_file_data + TEST_FILE_SIZE - 0x10, 0x10, false) ? passed++ : failed++;
+
+cleanup:
+    mapper.RemoveAllAccessors();
+    if (p_acc)
+        TrcMemAccessorFile::destroyFileAccessor(p_acc);
+    remove(test_file_name);
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test the per trace ID mapper - trace ID accessors used in preference to 
+ * global accessors, and separate caches per trace ID.
+ */
+bool read_id_mapper_and_check(TrcMemAccMapPerTraceID &id_mapper, ocsd_vaddr_t addr, uint8_t trcID, const uint32_t* p_expected, const bool callback)
+{
+    uint32_t read_val = 0, num_bytes = 4;
+    int PrevAccCallbackCount = AccCallbackCount;
+    std::ostringstream oss;
+    ocsd_err_t err;
+    bool pass = true;
+
+    err = id_mapper.ReadTargetMemory(addr, trcID, OCSD_MEM_SPACE_EL1N, &num_bytes, (uint8_t*)&read_val);
+
+    oss << "Read ID Mapper Test: Address 0x" << std::hex << std::setw(8) << std::setfill('0') << addr;
+    oss << "; Trace ID 0x" << std::setw(2) << (uint32_t)trcID << "; ";
+    if (err != OCSD_OK)
+    {
+        oss << "Error reading target memory\n";
+        pass = false;
+    }
+    else if (!p_expected)
+    {
+        if (num_bytes != 0)
+        {
+            oss << "Read Fail: Unexpected bytes read\n";
+            pass = false;
+        }
+    }
+    else if ((num_bytes != 4) || (read_val != *p_expected))
+    {
+        oss << "Read Fail: value read mismatch; 0x" << read_val << " != 0x" << *p_expected << "\n";
+        pass = false;
+    }
+    else if (callback != (PrevAccCallbackCount != AccCallbackCount))
+    {
+        oss << "Read Fail: " << (callback ? "Expected" : "Unexpected") << " callback to access memory\n";
+        pass = false;
+    }
+    if (pass)
+        oss << "OK\n";
+    logger.LogMsg(oss.str());
+    return pass;
+}
+
+void test_per_trace_id_mapper()
+{
+    TrcMemAccMapPerTraceID id_mapper;
+    TrcMemAccBufPtr GlobalAcc, ID10Acc, ID10OverlapAcc, ID11Acc;
+    TrcMemAccCB CBAcc;
+    test_range_array_t ranges;
+    test_range_t cb_ranges[2];
+    int passed = 0, failed = 0;
+    ocsd_err_t err;
+
+    log_test_start(__FUNCTION__);
+
+    id_mapper.setErrorLog(&err_log);
+    id_mapper.enableCaching(true);
+
+    // global block at 0, trace ID 0x10 block at same address, ID 0x11 block at 0x8000 
+    GlobalAcc.initAccessor(0x0000, (const uint8_t*)&el01_ns_blocks[0], BLOCK_SIZE_BYTES);
+    ID10Acc.initAccessor(0x0000, (const uint8_t*)&el01_ns_blocks[1], BLOCK_SIZE_BYTES);
+    ID10OverlapAcc.initAccessor(0x0100, (const uint8_t*)&el2_ns_blocks[1], BLOCK_SIZE_BYTES);
+    ID11Acc.initAccessor(0x8000, (const uint8_t*)&el2_ns_blocks[0], BLOCK_SIZE_BYTES);
+
+    ((id_mapper.AddAccessor(&GlobalAcc, 0) == OCSD_OK) &&
+     (id_mapper.AddAccessor(&ID10Acc, 0x10) == OCSD_OK) &&
+     (id_mapper.AddAccessor(&ID11Acc, 0x11) == OCSD_OK)) ? passed++ : failed++;
+
+    // overlap in the same trace ID, and bad trace ID, rejected.
+    (id_mapper.AddAccessor(&ID10OverlapAcc, 0x10) == OCSD_ERR_MEM_ACC_OVERLAP) ? passed++ : failed++;
+    (id_mapper.AddAccessor(&ID10OverlapAcc, 0x80) == OCSD_ERR_INVALID_ID) ? passed++ : failed++;
+
+    read_id_mapper_and_check(id_mapper, 0x10, 0x10, &el01_ns_blocks[1][4], false) ? passed++ : failed++;
+    read_id_mapper_and_check(id_mapper, 0x10, 0x11, &el01_ns_blocks[0][4], false) ? passed++ : failed++;
+    read_id_mapper_and_check(id_mapper, 0x8010, 0x11, &el2_ns_blocks[0][4], false) ? passed++ : failed++;
+    read_id_mapper_and_check(id_mapper, 0x8010, 0x10, 0, false) ? passed++ : failed++;
+
+    // remove trace ID accessor - global now used.
+    (id_mapper.RemoveAccessorByAddress(0x0000, OCSD_MEM_SPACE_EL1N, 0x10) == OCSD_OK) ? passed++ : failed++;
+    read_id_mapper_and_check(id_mapper, 0x10, 0x10, &el01_ns_blocks[0][4], false) ? passed++ : failed++;
+
+    // no trace ID accessor at the address - global accessor not removed for the ID.
+    (id_mapper.RemoveAccessorByAddress(0x0000, OCSD_MEM_SPACE_EL1N, 0x10) == OCSD_ERR_INVALID_PARAM_VAL) ? passed++ : failed++;
+    read_id_mapper_and_check(id_mapper, 0x10, 0x11, &el01_ns_blocks[0][4], false) ? passed++ : failed++;
+    id_mapper.RemoveAllAccessors();
+
+    // global callback - caches for each ID hold pages independently
+    ranges.num_ranges = 2;
+    ranges.ranges = cb_ranges;
+    set_test_range(cb_ranges[0], 0x0000, BLOCK_SIZE_BYTES, (const uint8_t*)&el01_ns_blocks[0], OCSD_MEM_SPACE_EL1N, 0x10);
+    set_test_range(cb_ranges[1], 0x0000, BLOCK_SIZE_BYTES, (const uint8_t*)&el01_ns_blocks[1], OCSD_MEM_SPACE_EL1N, 0x11);
+    CBAcc.initAccessor(0, 0xFFFFFFFF, OCSD_MEM_SPACE_ANY);
+    CBAcc.setCBIDIfFn(TestMemAccCB, (void*)&ranges);
+    err = id_mapper.AddAccessor(&CBAcc, 0);
+    if (err != OCSD_OK) {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, err, "Failed to set callback memory accessor"));
+        failed++;
+        goto cleanup;
+    }
+    read_id_mapper_and_check(id_mapper, 0x20, 0x10, &el01_ns_blocks[0][8], true) ? passed++ : failed++;
+    read_id_mapper_and_check(id_mapper, 0x20, 0x11, &el01_ns_blocks[1][8], true) ? passed++ : failed++;
+    read_id_mapper_and_check(id_mapper, 0x24, 0x10, &el01_ns_blocks[0][9], false) ? passed++ : failed++;
+    read_id_mapper_and_check(id_mapper, 0x24, 0x11, &el01_ns_blocks[1][9], false) ? passed++ : failed++;
+
+cleanup:
+    id_mapper.RemoveAllAccessors();
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test cache page sets - fill a cache with consecutive pages, which should
+ * all stay resident, and check pages loaded at unaligned addresses are found
+ * across set boundaries. Lookup time logged for small and large caches.
+ */
+
+#define CACHE_SET_PAGE_SIZE 64
+#define CACHE_SET_LOOKUPS 1000000
+
+static int cache_reads_ok(const ocsd_vaddr_t addr, const uint8_t trcID, const uint8_t *p_expected)
+{
+    uint32_t read_val = 0, num_bytes = 4;
+    ocsd_err_t err = mapper.ReadTargetMemory(addr, trcID, OCSD_MEM_SPACE_EL1N, &num_bytes, (uint8_t*)&read_val);
+    return (err == OCSD_OK) && (num_bytes == 4) && (memcmp(&read_val, p_expected, 4) == 0);
+}
+
+void test_cache_page_sets()
+{
+    static const int page_counts[] = { MEM_ACC_CACHE_DEFAULT_MRU_SIZE, MEM_ACC_CACHE_MRU_SIZE_MAX };
+    TrcMemAccCB CBAcc;
+    test_range_array_t ranges;
+    test_range_t cb_range;
+    int passed = 0, failed = 0;
+    std::ostringstream oss;
+    ocsd_err_t err;
+
+    log_test_start(__FUNCTION__);
+
+    std::vector<uint8_t> data((MEM_ACC_CACHE_MRU_SIZE_MAX + 2) * CACHE_SET_PAGE_SIZE);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)((i * 7) + (i >> 8));
+
+    ranges.num_ranges = 1;
+    ranges.ranges = &cb_range;
+    set_test_range(cb_range, 0x0000, (uint32_t)data.size(), &data[0], OCSD_MEM_SPACE_EL1N, 0x10);
+    CBAcc.initAccessor(0, 0xFFFFFFFF, OCSD_MEM_SPACE_ANY);
+    CBAcc.setCBIDIfFn(TestMemAccCB, (void*)&ranges);
+    err = mapper.AddAccessor(&CBAcc, 0);
+    if (err != OCSD_OK) {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, err, "Failed to set callback memory accessor"));
+        failed++;
+        goto cleanup;
+    }
+
+    for (size_t c = 0; c < sizeof(page_counts) / sizeof(page_counts[0]); c++)
+    {
+        const int num_pages = page_counts[c];
+        int start_count, p;
+        bool read_ok = true;
+
+        if (mapper.setCacheSizes(CACHE_SET_PAGE_SIZE, num_pages, true) != OCSD_OK)
+        {
+            failed++;
+            continue;
+        }
+
+        // load a page at each aligned address - one callback per page
+        start_count = AccCallbackCount;
+        for (p = 0; p < num_pages; p++)
+            read_ok = read_ok && cache_reads_ok(p * CACHE_SET_PAGE_SIZE, 0x10, &data[p * CACHE_SET_PAGE_SIZE]);
+        (read_ok && ((AccCallbackCount - start_count) == num_pages)) ? passed++ : failed++;
+
+        // all pages should still be resident
+        start_count = AccCallbackCount;
+        for (p = 0; p < num_pages; p++)
+            read_ok = read_ok && cache_reads_ok((p * CACHE_SET_PAGE_SIZE) + 0x20, 0x10, &data[(p * CACHE_SET_PAGE_SIZE) + 0x20]);
+        (read_ok && (AccCallbackCount == start_count)) ? passed++ : failed++;
+
+        // time lookups - stride through the pages so that every read changes page
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        p = 0;
+        for (int l = 0; l < CACHE_SET_LOOKUPS; l++)
+        {
+            uint32_t read_val, num_bytes = 4;
+            mapper.ReadTargetMemory((p * CACHE_SET_PAGE_SIZE) + 8, 0x10, OCSD_MEM_SPACE_EL1N, &num_bytes, (uint8_t*)&read_val);
+            p = (p + 7) % num_pages;
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        (AccCallbackCount == start_count) ? passed++ : failed++;
+
+        oss.str("");
+        oss << "Cache pages: " << std::dec << std::setw(3) << std::setfill(' ') << num_pages;
+        oss << "; Lookups: " << CACHE_SET_LOOKUPS << "; ns per lookup: " << std::fixed << std::setprecision(1);
+        oss << (elapsed.count() / CACHE_SET_LOOKUPS) << "\n";
+        logger.LogMsg(oss.str());
+
+        // page loaded from an unaligned address - later address in the next page key found without callback
+        const ocsd_vaddr_t unaligned = (num_pages * CACHE_SET_PAGE_SIZE) + 0x30;
+        start_count = AccCallbackCount;
+        read_ok = cache_reads_ok(unaligned, 0x10, &data[unaligned]) &&
+                  cache_reads_ok(unaligned + 0x20, 0x10, &data[unaligned + 0x20]);
+        (read_ok && ((AccCallbackCount - start_count) == 1)) ? passed++ : failed++;
+    }
+
+cleanup:
+    mapper.RemoveAllAccessors();
+    mapper.setCacheSizes(MEM_ACC_CACHE_DEFAULT_PAGE_SIZE, MEM_ACC_CACHE_DEFAULT_MRU_SIZE);
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test context tagged cache pages - callback data changes with the
+ * process, as it would for a client such as perf. Switching back to a
+ * context should hit pages loaded earlier for that context.
+ */
+
+#define CTXT_TAG_A 0x0000000100001000ULL
+#define CTXT_TAG_B 0x0000000100002000ULL
+
+static bool read_ctxt_and_check(const ocsd_mem_space_acc_t mem_space, const uint32_t *p_expected, const bool callback)
+{
+    uint32_t read_val = 0, num_bytes = 4;
+    int PrevAccCallbackCount = AccCallbackCount;
+    ocsd_err_t err = mapper.ReadTargetMemory(0x10, 0x10, mem_space, &num_bytes, (uint8_t*)&read_val);
+    std::ostringstream oss;
+    bool pass = (err == OCSD_OK) && (num_bytes == 4) && (read_val == *p_expected) &&
+                (callback == (PrevAccCallbackCount != AccCallbackCount));
+
+    oss << "Read Context Test: Address 0x00000010; Value 0x" << std::hex << read_val;
+    oss << (pass ? "; Pass\n" : "; Fail\n");
+    logger.LogMsg(oss.str());
+    return pass;
+}
+
+void test_cache_context_tags()
+{
+    TrcMemAccCB CBAcc;
+    test_range_array_t ranges;
+    test_range_t cb_ranges[2];
+    int passed = 0, failed = 0;
+    ocsd_err_t err;
+
+    log_test_start(__FUNCTION__);
+
+    ranges.num_ranges = 2;
+    ranges.ranges = cb_ranges;
+    set_test_range(cb_ranges[0], 0x0000, BLOCK_SIZE_BYTES, (const uint8_t*)&el01_ns_blocks[0], OCSD_MEM_SPACE_EL1N, 0x10);
+    set_test_range(cb_ranges[1], 0x0000, BLOCK_SIZE_BYTES, (const uint8_t*)&el2_ns_blocks[0], OCSD_MEM_SPACE_EL2, 0x10);
+    CBAcc.initAccessor(0, 0xFFFFFFFF, OCSD_MEM_SPACE_ANY);
+    CBAcc.setCBIDIfFn(TestMemAccCB, (void*)&ranges);
+    err = mapper.AddAccessor(&CBAcc, 0);
+    if (err != OCSD_OK) {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, err, "Failed to set callback memory accessor"));
+        failed++;
+        goto cleanup;
+    }
+
+    // load pages for process A then process B
+    mapper.SetMemAccContext(0x10, CTXT_TAG_A);
+    read_ctxt_and_check(OCSD_MEM_SPACE_EL1N, &el01_ns_blocks[0][4], true) ? passed++ : failed++;
+    mapper.SetMemAccContext(0x10, CTXT_TAG_B);
+    cb_ranges[0].buffer = (const uint8_t*)&el01_ns_blocks[1];
+    read_ctxt_and_check(OCSD_MEM_SPACE_EL1N, &el01_ns_blocks[1][4], true) ? passed++ : failed++;
+
+    // switch back and forth - pages still resident
+    mapper.SetMemAccContext(0x10, CTXT_TAG_A);
+    cb_ranges[0].buffer = (const uint8_t*)&el01_ns_blocks[0];
+    read_ctxt_and_check(OCSD_MEM_SPACE_EL1N, &el01_ns_blocks[0][4], false) ? passed++ : failed++;
+    mapper.SetMemAccContext(0x10, CTXT_TAG_B);
+    cb_ranges[0].buffer = (const uint8_t*)&el01_ns_blocks[1];
+    read_ctxt_and_check(OCSD_MEM_SPACE_EL1N, &el01_ns_blocks[1][4], false) ? passed++ : failed++;
+
+    // different memory space at the same address is a separate page
+    read_ctxt_and_check(OCSD_MEM_SPACE_EL2, &el2_ns_blocks[0][4], true) ? passed++ : failed++;
+    read_ctxt_and_check(OCSD_MEM_SPACE_EL1N, &el01_ns_blocks[1][4], false) ? passed++ : failed++;
+
+    // explicit invalidate discards pages for all contexts on the ID
+    mapper.InvalidateMemAccCache(0x10);
+    read_ctxt_and_check(OCSD_MEM_SPACE_EL1N, &el01_ns_blocks[1][4], true) ? passed++ : failed++;
+    mapper.SetMemAccContext(0x10, CTXT_TAG_A);
+    cb_ranges[0].buffer = (const uint8_t*)&el01_ns_blocks[0];
+    read_ctxt_and_check(OCSD_MEM_SPACE_EL1N, &el01_ns_blocks[0][4], true) ? passed++ : failed++;
+
+cleanup:
+    mapper.RemoveAllAccessors();
+    mapper.SetMemAccContext(0x10, 0);
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test memory access statistics - counts for hits, misses, runs, 
+ * invalidation and accessor reads through a callback accessor.
+ */
+
+void test_mem_acc_stats()
+{
+    TrcMemAccCB CBAcc;
+    test_range_array_t ranges;
+    test_range_t cb_range;
+    ocsd_mem_acc_stats_t stats;
+    uint32_t read_val, num_bytes;
+    int passed = 0, failed = 0;
+    std::ostringstream oss;
+    ocsd_err_t err;
+
+    log_test_start(__FUNCTION__);
+
+    ranges.num_ranges = 1;
+    ranges.ranges = &cb_range;
+    set_test_range(cb_range, 0x0000, BLOCK_SIZE_BYTES, (const uint8_t*)&el01_ns_blocks[0], OCSD_MEM_SPACE_EL1N, 0x10);
+    CBAcc.initAccessor(0, 0xFFFFFFFF, OCSD_MEM_SPACE_ANY);
+    CBAcc.setCBIDIfFn(TestMemAccCB, (void*)&ranges);
+    err = mapper.AddAccessor(&CBAcc, 0);
+    if (err != OCSD_OK) {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, err, "Failed to set callback memory accessor"));
+        failed++;
+        goto cleanup;
+    }
+    mapper.resetMemAccStats();
+
+    // miss and page load, then a run of 3 hits
+    for (int i = 0; i < 4; i++) {
+        num_bytes = 4;
+        mapper.ReadTargetMemory(0x10 + (i * 4), 0x10, OCSD_MEM_SPACE_EL1N, &num_bytes, (uint8_t*)&read_val);
+    }
+    mapper.getMemAccStats(stats);
+    ((stats.revision == OCSD_MEM_ACC_STATS_REVISION) &&
+     (stats.cache_misses == 1) && (stats.page_loads == 1) && (stats.cache_hits == 3) &&
+     (stats.hit_runs == 1) && (stats.hit_run_max == 3) &&
+     (stats.acc_reads == 1) && (stats.acc_bytes_cb == MEM_ACC_CACHE_DEFAULT_PAGE_SIZE)) ? passed++ : failed++;
+
+    // invalidate the trace ID - discards the page, next read misses
+    mapper.InvalidateMemAccCache(0x10);
+    num_bytes = 4;
+    mapper.ReadTargetMemory(0x10, 0x10, OCSD_MEM_SPACE_EL1N, &num_bytes, (uint8_t*)&read_val);
+    mapper.getMemAccStats(stats);
+    ((stats.inval_trace_id == 1) && (stats.inval_pages == 1) && (stats.cache_misses == 2) &&
+     (stats.acc_reads == 2)) ? passed++ : failed++;
+
+    // uncached reads counted as accessor reads
+    mapper.enableCaching(false);
+    num_bytes = 4;
+    mapper.ReadTargetMemory(0x10, 0x10, OCSD_MEM_SPACE_EL1N, &num_bytes, (uint8_t*)&read_val);
+    mapper.getMemAccStats(stats);
+    ((stats.cache_misses == 2) && (stats.acc_reads == 3) &&
+     (stats.acc_bytes_cb == (MEM_ACC_CACHE_DEFAULT_PAGE_SIZE * 2) + 4)) ? passed++ : failed++;
+    mapper.enableCaching(true);
+
+    // reset clears the counts
+    mapper.resetMemAccStats();
+    mapper.getMemAccStats(stats);
+    ((stats.cache_hits == 0) && (stats.acc_reads == 0) && (stats.inval_trace_id == 0)) ? passed++ : failed++;
+
+    oss << "Stats: hits " << std::dec << stats.cache_hits << "; misses " << stats.cache_misses << "; accessor reads " << stats.acc_reads << "\n";
+    logger.LogMsg(oss.str());
+
+cleanup:
+    mapper.RemoveAllAccessors();
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test callback accessor read-ahead - sequential reads with the cache 
+ * off should need fewer client callbacks as the read-ahead block grows.
+ */
+
+#define RA_TEST_READS 0x100
+
+static bool read_seq_and_check(const ocsd_vaddr_t start, const int num_reads, int &callbacks)
+{
+    uint32_t read_val, num_bytes;
+    int start_count = AccCallbackCount;
+    bool pass = true;
+
+    for (int i = 0; i < num_reads; i++)
+    {
+        num_bytes = 4;
+        if ((mapper.ReadTargetMemory(start + (i * 4), 0x10, OCSD_MEM_SPACE_EL1N, &num_bytes, (uint8_t*)&read_val) != OCSD_OK) ||
+            (num_bytes != 4) || (read_val != el01_ns_blocks[0][(start / 4) + i]))
+            pass = false;
+    }
+    callbacks = AccCallbackCount - start_count;
+    return pass;
+}
+
+void test_cb_read_ahead()
+{
+    TrcMemAccCB CBAcc;
+    test_range_array_t ranges;
+    test_range_t cb_range;
+    ocsd_mem_acc_stats_t stats;
+    int passed = 0, failed = 0, callbacks = 0;
+    std::ostringstream oss;
+    ocsd_err_t err;
+
+    log_test_start(__FUNCTION__);
+
+    ranges.num_ranges = 1;
+    ranges.ranges = &cb_range;
+    set_test_range(cb_range, 0x0000, BLOCK_SIZE_BYTES, (const uint8_t*)&el01_ns_blocks[0], OCSD_MEM_SPACE_EL1N, 0x10);
+    CBAcc.initAccessor(0, 0xFFFFFFFF, OCSD_MEM_SPACE_ANY);
+    CBAcc.setCBIDIfFn(TestMemAccCB, (void*)&ranges);
+    err = mapper.AddAccessor(&CBAcc, 0);
+    if (err != OCSD_OK) {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, err, "Failed to set callback memory accessor"));
+        failed++;
+        goto cleanup;
+    }
+    mapper.enableCaching(false);
+
+    // invalid sizes rejected
+    ((CBAcc.setReadAhead(8, 256) == OCSD_ERR_INVALID_PARAM_VAL) &&
+     (CBAcc.setReadAhead(256, 16) == OCSD_ERR_INVALID_PARAM_VAL) &&
+     (CBAcc.setReadAhead(16, MEM_ACC_CB_READ_AHEAD_MAX * 2) == OCSD_ERR_INVALID_PARAM_VAL)) ? passed++ : failed++;
+
+    // no read-ahead - one callback per read
+    read_seq_and_check(0, RA_TEST_READS, callbacks) && (callbacks == RA_TEST_READS) ? passed++ : failed++;
+
+    // read-ahead: blocks of 16, 32, 64, 128, then 256 bytes for the remaining 784 bytes.
+    CBAcc.setReadAhead(16, 256);
+    mapper.resetMemAccStats();
+    read_seq_and_check(0, RA_TEST_READS, callbacks) && (callbacks == 8) ? passed++ : failed++;
+    oss << "Sequential reads: " << std::dec << RA_TEST_READS << "; callbacks with read-ahead: " << callbacks << "\n";
+    logger.LogMsg(oss.str());
+    mapper.getMemAccStats(stats);
+    (stats.acc_callbacks == 8) ? passed++ : failed++;
+
+    // re-read the last buffered data - no callback
+    read_seq_and_check((RA_TEST_READS * 4) - 0x10, 4, callbacks) && (callbacks == 0) ? passed++ : failed++;
+
+    // invalidate for the trace ID drops the buffer
+    mapper.InvalidateMemAccCache(0x10);
+    read_seq_and_check((RA_TEST_READS * 4) - 0x10, 4, callbacks) && (callbacks == 1) ? passed++ : failed++;
+
+    // non-sequential read - block back to minimum, 16 bytes buffered
+    read_seq_and_check(0x2000, 4, callbacks) && (callbacks == 1) ? passed++ : failed++;
+    read_seq_and_check(0x2010, 1, callbacks) && (callbacks == 1) ? passed++ : failed++;
+
+    // with the cache on, page loads read through the accessor - data still correct
+    mapper.enableCaching(true);
+    read_seq_and_check(0x1000, RA_TEST_READS, callbacks) ? passed++ : failed++;
+
+    // disable read-ahead
+    CBAcc.setReadAhead(0, 0);
+    mapper.enableCaching(false);
+    read_seq_and_check(0x100, 4, callbacks) && (callbacks == 4) ? passed++ : failed++;
+
+cleanup:
+    mapper.enableCaching(true);
+    mapper.RemoveAllAccessors();
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test negative lookup cache - reads in a gap between accessors are found
+ * in the cache after the first miss. Adding or removing accessors clears it.
+ */
+
+static bool read_nacc_and_check(TrcMemAccMapper &nacc_mapper, const ocsd_vaddr_t address, const ocsd_mem_space_acc_t mem_space, 
+                                const uint8_t trcID, const uint32_t *p_expected, const uint64_t exp_hits)
+{
+    uint32_t read_val = 0, num_bytes = 4;
+    ocsd_mem_acc_stats_t stats;
+    std::ostringstream oss;
+    ocsd_err_t err;
+    bool pass;
+
+    err = nacc_mapper.ReadTargetMemory(address, trcID, mem_space, &num_bytes, (uint8_t*)&read_val);
+    nacc_mapper.getMemAccStats(stats);
+    if (p_expected)
+        pass = (err == OCSD_OK) && (num_bytes == 4) && (read_val == *p_expected);
+    else
+        pass = (err == OCSD_OK) && (num_bytes == 0);
+    pass = pass && (stats.unmapped_hits == exp_hits);
+
+    oss << "Read NACC Test: Address 0x" << std::hex << std::setw(8) << std::setfill('0') << address;
+    oss << "; Traced ID 0x" << std::setw(2) << (uint32_t)trcID << "; negative cache hits " << std::dec << stats.unmapped_hits;
+    oss << (pass ? "; Pass\n" : "; Fail\n");
+    logger.LogMsg(oss.str());
+    return pass;
+}
+
+void test_nacc_cache()
+{
+    TrcMemAccMapPerTraceID id_mapper;
+    TrcMemAccBufPtr LowAcc, HighAcc, GapAcc, IDGapAcc;
+    ocsd_mem_acc_stats_t stats;
+    int passed = 0, failed = 0;
+
+    log_test_start(__FUNCTION__);
+
+    // accessors at 0x0000 and 0x10000 - gap between 0x8000 and 0xFFFF
+    LowAcc.initAccessor(0x0000, (const uint8_t*)&el01_ns_blocks[0], BLOCK_SIZE_BYTES);
+    HighAcc.initAccessor(0x10000, (const uint8_t*)&el01_ns_blocks[1], BLOCK_SIZE_BYTES);
+    GapAcc.initAccessor(0x9000, (const uint8_t*)&el2_ns_blocks[0], 0x1000);
+    ((mapper.AddAccessor(&LowAcc, 0) == OCSD_OK) && (mapper.AddAccessor(&HighAcc, 0) == OCSD_OK)) ? passed++ : failed++;
+    mapper.resetMemAccStats();
+
+    // first miss searches, later reads anywhere in the gap use the negative cache.
+    read_nacc_and_check(mapper, 0x9000, OCSD_MEM_SPACE_EL1N, 0x10, 0, 0) ? passed++ : failed++;
+    read_nacc_and_check(mapper, 0x9004, OCSD_MEM_SPACE_EL1N, 0x10, 0, 1) ? passed++ : failed++;
+    read_nacc_and_check(mapper, 0x8000, OCSD_MEM_SPACE_EL1N, 0x10, 0, 2) ? passed++ : failed++;
+    read_nacc_and_check(mapper, 0xFFFC, OCSD_MEM_SPACE_EL1N, 0x10, 0, 3) ? passed++ : failed++;
+
+    // mapped reads either side of the gap unaffected
+    read_nacc_and_check(mapper, 0x7FF0, OCSD_MEM_SPACE_EL1N, 0x10, &el01_ns_blocks[0][(0x7FF0 / 4)], 3) ? passed++ : failed++;
+    read_nacc_and_check(mapper, 0x10000, OCSD_MEM_SPACE_EL1N, 0x10, &el01_ns_blocks[1][0], 3) ? passed++ : failed++;
+
+    // another memory space is a separate entry
+    read_nacc_and_check(mapper, 0x9000, OCSD_MEM_SPACE_EL2, 0x10, 0, 3) ? passed++ : failed++;
+    read_nacc_and_check(mapper, 0x9000, OCSD_MEM_SPACE_EL2, 0x10, 0, 4) ? passed++ : failed++;
+
+    // adding an accessor in the gap clears the cache
+    (mapper.AddAccessor(&GapAcc, 0) == OCSD_OK) ? passed++ : failed++;
+    read_nacc_and_check(mapper, 0x9000, OCSD_MEM_SPACE_EL1N, 0x10, &el2_ns_blocks[0][0], 4) ? passed++ : failed++;
+
+    // gap now split - 0x8000-0x8FFF missed, read at 0x9000 still mapped.
+    read_nacc_and_check(mapper, 0x8000, OCSD_MEM_SPACE_EL1N, 0x10, 0, 4) ? passed++ : failed++;
+    read_nacc_and_check(mapper, 0x8FFC, OCSD_MEM_SPACE_EL1N, 0x10, 0, 5) ? passed++ : failed++;
+    read_nacc_and_check(mapper, 0x9004, OCSD_MEM_SPACE_EL1N, 0x10, &el2_ns_blocks[0][1], 5) ? passed++ : failed++;
+
+    // removing an accessor clears the cache
+    (mapper.RemoveAccessorByAddress(0x9000, OCSD_MEM_SPACE_ANY) == OCSD_OK) ? passed++ : failed++;
+    read_nacc_and_check(mapper, 0x9000, OCSD_MEM_SPACE_EL1N, 0x10, 0, 5) ? passed++ : failed++;
+    mapper.getMemAccStats(stats);
+    (stats.unmapped_reads == 9) ? passed++ : failed++;
+    mapper.RemoveAllAccessors();
+
+    // per trace ID mapper - a miss for one ID does not hide an accessor for another.
+    id_mapper.setErrorLog(&err_log);
+    IDGapAcc.initAccessor(0x9000, (const uint8_t*)&el2_ns_blocks[0], 0x1000);
+    ((id_mapper.AddAccessor(&LowAcc, 0) == OCSD_OK) && (id_mapper.AddAccessor(&IDGapAcc, 0x10) == OCSD_OK)) ? passed++ : failed++;
+    read_nacc_and_check(id_mapper, 0x9000, OCSD_MEM_SPACE_EL1N, 0x11, 0, 0) ? passed++ : failed++;
+    read_nacc_and_check(id_mapper, 0x9000, OCSD_MEM_SPACE_EL1N, 0x10, &el2_ns_blocks[0][0], 0) ? passed++ : failed++;
+    read_nacc_and_check(id_mapper, 0x9010, OCSD_MEM_SPACE_EL1N, 0x11, 0, 1) ? passed++ : failed++;
+
+    // trace ID 0x10 gap ends below its accessor
+    read_nacc_and_check(id_mapper, 0x8000, OCSD_MEM_SPACE_EL1N, 0x10, 0, 1) ? passed++ : failed++;
+    read_nacc_and_check(id_mapper, 0x8FFC, OCSD_MEM_SPACE_EL1N, 0x10, 0, 2) ? passed++ : failed++;
+    read_nacc_and_check(id_mapper, 0x9FFC, OCSD_MEM_SPACE_EL1N, 0x10, &el2_ns_blocks[0][0x3FF], 2) ? passed++ : failed++;
+    id_mapper.RemoveAllAccessors();
+
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test cache resizing - page data slab reused when shrinking, replaced when 
+ * growing, and the cache left usable by a rejected size.
+ */
+
+void test_cache_resize()
+{
+    static const struct { uint16_t page_size; int num_pages; } sizes[] = {
+        { MEM_ACC_CACHE_PAGE_SIZE_MAX, MEM_ACC_CACHE_MRU_SIZE_MAX },   // largest slab
+        { 1024, 8 },
+        { 100, MEM_ACC_CACHE_MRU_SIZE_MIN },                            // page size not a multiple of the cache line
+        { MEM_ACC_CACHE_DEFAULT_PAGE_SIZE, MEM_ACC_CACHE_DEFAULT_MRU_SIZE },
+    };
+    TrcMemAccCB CBAcc;
+    test_range_array_t ranges;
+    test_range_t cb_range;
+    int passed = 0, failed = 0;
+    const uint8_t *p_block = (const uint8_t *)&el01_ns_blocks[0];
+    bool read_ok;
+    ocsd_err_t err;
+
+    log_test_start(__FUNCTION__);
+
+    ranges.num_ranges = 1;
+    ranges.ranges = &cb_range;
+    set_test_range(cb_range, 0x0000, BLOCK_SIZE_BYTES, p_block, OCSD_MEM_SPACE_EL1N, 0x10);
+    CBAcc.initAccessor(0, 0xFFFFFFFF, OCSD_MEM_SPACE_ANY);
+    CBAcc.setCBIDIfFn(TestMemAccCB, (void*)&ranges);
+    err = mapper.AddAccessor(&CBAcc, 0);
+    if (err != OCSD_OK) {
+        log_error(ocsdError(OCSD_ERR_SEV_ERROR, err, "Failed to set callback memory accessor"));
+        failed++;
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        (mapper.setCacheSizes(sizes[i].page_size, sizes[i].num_pages, true) == OCSD_OK) ? passed++ : failed++;
+
+        // read across several pages - last word in each page
+        read_ok = true;
+        for (ocsd_vaddr_t addr = sizes[i].page_size - 4; addr < BLOCK_SIZE_BYTES; addr += sizes[i].page_size * 3)
+            read_ok = read_ok && cache_reads_ok(addr, 0x10, &p_block[addr]);
+        read_ok ? passed++ : failed++;
+    }
+
+    // bad size rejected - current cache still usable
+    (mapper.setCacheSizes(MEM_ACC_CACHE_DEFAULT_PAGE_SIZE, MEM_ACC_CACHE_MRU_SIZE_MAX + 1, true) == OCSD_ERR_INVALID_PARAM_VAL) ? passed++ : failed++;
+    (cache_reads_ok(0x1000, 0x10, &p_block[0x1000]) && cache_reads_ok(0x7FFC, 0x10, &p_block[0x7FFC])) ? passed++ : failed++;
+
+cleanup:
+    mapper.RemoveAllAccessors();
+    mapper.setCacheSizes(MEM_ACC_CACHE_DEFAULT_PAGE_SIZE, MEM_ACC_CACHE_DEFAULT_MRU_SIZE);
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
+/************************************************************************
+ * Test Thumb opcode reads at the end of accessible memory - the opcode window
+ * used by the PE decoders and the ETMv3 code follower fetch buffer. A 16 bit
+ * opcode in the last halfword is readable, a 32 bit opcode split by the end of
+ * memory is NACC, and a 32 bit opcode across a fetch block boundary refills.
+ */
+
+// memory access interface counting the reads made through the global mapper.
+// Pointer reads can be turned off to give copy reads of the requested size only.
+class MemAccReadCounter : public ITargetMemAccess
+{
+public:
+    MemAccReadCounter() : reads(0), ptr_reads(true) {};
+    virtual ~MemAccReadCounter() {};
+
+    virtual ocsd_err_t ReadTargetMemory(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space,
+                                        uint32_t *num_bytes, uint8_t *p_buffer)
+    {
+        reads++;
+        return mapper.ReadTargetMemory(address, cs_trace_id, mem_space, num_bytes, p_buffer);
+    };
+    virtual ocsd_err_t ReadTargetMemoryPtr(const ocsd_vaddr_t address, const uint8_t cs_trace_id, const ocsd_mem_space_acc_t mem_space,
+                                           uint32_t *num_bytes, const uint8_t **pp_data)
+    {
+        if (!ptr_reads)
+        {
+            *num_bytes = 0;
+            *pp_data = 0;
+            return OCSD_ERR_DCD_INTERFACE_UNUSED;
+        }
+        reads++;
+        return mapper.ReadTargetMemoryPtr(address, cs_trace_id, mem_space, num_bytes, pp_data);
+    };
+    virtual void InvalidateMemAccCache(const uint8_t cs_trace_id) { mapper.InvalidateMemAccCache(cs_trace_id); };
+    virtual ocsd_err_t GetMemAccGeneration(const uint8_t cs_trace_id, uint32_t *p_generation)
+    {
+        return mapper.GetMemAccGeneration(cs_trace_id, p_generation);
+    };
+
+    int reads;
+    bool ptr_reads;
+};
+
+// packet decoder giving access to the opcode read used by the PE decoders.
+class ThumbOpcodeReader : public TrcPktDecodeI
+{
+public:
+    ThumbOpcodeReader() : TrcPktDecodeI("THUMB_OP_RD") {};
+    virtual ~ThumbOpcodeReader() {};
+
+    ocsd_err_t readOpcode(mem_acc_window_t &win, const ocsd_vaddr_t address, uint32_t *num_bytes, uint32_t *p_opcode)
+    {
+        return accessOpcode(win, address, OCSD_MEM_SPACE_ANY, ocsd_isa_thumb2, num_bytes, p_opcode);
+    };
+
+protected:
+    virtual ocsd_datapath_resp_t processPacket() { return OCSD_RESP_CONT; };
+    virtual ocsd_datapath_resp_t onEOT() { return OCSD_RESP_CONT; };
+    virtual ocsd_datapath_resp_t onReset() { return OCSD_RESP_CONT; };
+    virtual ocsd_datapath_resp_t onFlush() { return OCSD_RESP_CONT; };
+    virtual ocsd_err_t onProtocolConfig() { return OCSD_OK; };
+    virtual const uint8_t getCoreSightTraceID() { return 0x10; };
+};
+
+// Thumb code - MOVS r0,#0 (16 bit) and MOV.W r0,#0 (32 bit) opcodes.
+#define T16_MOVS    0x2000
+#define T32_MOVW_0  0xF04F
+#define T32_MOVW_1  0x0000
+#define THUMB_CODE_HWORDS 32
+
+static uint16_t thumb_code_end16[THUMB_CODE_HWORDS];
+static uint16_t thumb_code_end32[THUMB_CODE_HWORDS];
+static MemAccReadCounter thumb_read_counter;
+
+static bool read_thumb_and_check(ThumbOpcodeReader &reader, mem_acc_window_t &win, const ocsd_vaddr_t address,
+                                 const uint32_t exp_bytes, const uint32_t exp_opcode, const int exp_reads)
+{
+    uint32_t opcode = 0, num_bytes = 4;
+    std::ostringstream oss;
+    ocsd_err_t err;
+    bool pass;
+
+    err = reader.readOpcode(win, address, &num_bytes, &opcode);
+    pass = (err == OCSD_OK) && (num_bytes == exp_bytes) && (thumb_read_counter.reads == exp_reads);
+    if (exp_bytes == 4)
+        pass = pass && (opcode == exp_opcode);
+
+    oss << "Thumb Opcode Read: Address 0x" << std::hex << std::setw(8) << std::setfill('0') << address;
+    oss << "; Opcode 0x" << std::setw(8) << opcode << "; Bytes " << std::dec << num_bytes;
+    oss << "; Memory reads " << thumb_read_counter.reads << (pass ? "; Pass\n" : "; Fail\n");
+    logger.LogMsg(oss.str());
+    return pass;
+}
+
+// exp_size 0 for a NACC at the address.
+static bool follow_thumb_and_check(OcsdCodeFollower &follower, const ocsd_vaddr_t address, const uint8_t exp_size, const int exp_reads)
+{
+    std::ostringstream oss;
+    ocsd_err_t err;
+    bool pass;
+
+    follower.clearNacc();
+    err = follower.followSingleAtom(address, ATOM_E);
+    if (exp_size)
+        pass = (err == OCSD_OK) && !follower.isNacc() && (follower.getInstrSize() == exp_size) &&
+               (follower.getRangeEn() == (address + exp_size));
+    else
+        pass = (err == OCSD_ERR_MEM_NACC) && follower.isNacc() && (follower.getNaccAddr() == address);
+    pass = pass && (thumb_read_counter.reads == exp_reads);
+
+    oss << "Thumb Code Follow: Address 0x" << std::hex << std::setw(8) << std::setfill('0') << address;
+    if (follower.isNacc())
+        oss << "; NACC";
+    else
+        oss << "; Size " << std::dec << (uint32_t)follower.getInstrSize();
+    oss << "; Memory reads " << std::dec << thumb_read_counter.reads << (pass ? "; Pass\n" : "; Fail\n");
+    logger.LogMsg(oss.str());
+    return pass;
+}
+
+void test_thumb_end_of_mem()
+{
+    TrcMemAccBufPtr End16Acc, End32Acc;
+    ThumbOpcodeReader reader;
+    mem_acc_window_t win;
+    OcsdCodeFollower follower;
+    TrcIDecode idecode;
+    componentAttachPt<ITargetMemAccess> mem_attach;
+    componentAttachPt<IInstrDecode> idec_attach;
+    ocsd_arch_profile_t arch_profile = { ARCH_V7, profile_CortexA };
+    int passed = 0, failed = 0;
+
+    log_test_start(__FUNCTION__);
+
+    // 0x1000: 32 bit opcode at 0x101E across the fetch block, 16 bit opcode in the last halfword.
+    // 0x2000: 32 bit opcode split by the end of memory.
+    for (int i = 0; i < THUMB_CODE_HWORDS; i++)
+        thumb_code_end16[i] = thumb_code_end32[i] = T16_MOVS;
+    thumb_code_end16[15] = T32_MOVW_0;
+    thumb_code_end16[16] = T32_MOVW_1;
+    thumb_code_end32[THUMB_CODE_HWORDS - 1] = T32_MOVW_0;
+
+    End16Acc.initAccessor(0x1000, (const uint8_t *)thumb_code_end16, sizeof(thumb_code_end16));
+    End32Acc.initAccessor(0x2000, (const uint8_t *)thumb_code_end32, sizeof(thumb_code_end32));
+    ((mapper.AddAccessor(&End16Acc, 0) == OCSD_OK) && (mapper.AddAccessor(&End32Acc, 0) == OCSD_OK)) ? passed++ : failed++;
+
+    // PE decoder opcode window, pointer reads - window is the rest of the buffer.
+    // At 0x203E the wide opcode request for 4 bytes gets the 2 remaining - NACC.
+    reader.getMemoryAccessAttachPt()->attach(&thumb_read_counter);
+    memset(&win, 0, sizeof(win));
+    thumb_read_counter.reads = 0;
+    read_thumb_and_check(reader, win, 0x1000, 4, T16_MOVS, 1) ? passed++ : failed++;
+    read_thumb_and_check(reader, win, 0x101E, 4, ((uint32_t)T32_MOVW_1 << 16) | T32_MOVW_0, 1) ? passed++ : failed++;
+    read_thumb_and_check(reader, win, 0x103E, 4, T16_MOVS, 1) ? passed++ : failed++;
+    read_thumb_and_check(reader, win, 0x203E, 2, 0, 3) ? passed++ : failed++;
+
+    // PE decoder opcode window, copy reads - window filled to the end of the 32 byte block.
+    // Cache pages return all or none of a request, so the 4 byte refill at the end of 
+    // memory is retried for the 2 bytes of the first halfword.
+    thumb_read_counter.ptr_reads = false;
+    memset(&win, 0, sizeof(win));
+    thumb_read_counter.reads = 0;
+    read_thumb_and_check(reader, win, 0x1000, 4, T16_MOVS, 1) ? passed++ : failed++;
+    read_thumb_and_check(reader, win, 0x1002, 4, T16_MOVS, 1) ? passed++ : failed++;
+    read_thumb_and_check(reader, win, 0x101E, 4, ((uint32_t)T32_MOVW_1 << 16) | T32_MOVW_0, 2) ? passed++ : failed++;
+    read_thumb_and_check(reader, win, 0x103E, 4, T16_MOVS, 4) ? passed++ : failed++;
+    read_thumb_and_check(reader, win, 0x203E, 2, 0, 7) ? passed++ : failed++;
+    thumb_read_counter.ptr_reads = true;
+
+    // ETMv3 code follower fetch buffer - copy reads as above.
+    mem_attach.attach(&thumb_read_counter);
+    idec_attach.attach(&idecode);
+    follower.initInterfaces(&mem_attach, &idec_attach);
+    follower.setArchProfile(arch_profile);
+    follower.setMemSpaceAccess(OCSD_MEM_SPACE_ANY);
+    follower.setISA(ocsd_isa_thumb2);
+    thumb_read_counter.reads = 0;
+    follow_thumb_and_check(follower, 0x1000, 2, 1) ? passed++ : failed++;
+    follow_thumb_and_check(follower, 0x1002, 2, 1) ? passed++ : failed++;
+    follow_thumb_and_check(follower, 0x101E, 4, 2) ? passed++ : failed++;
+    follow_thumb_and_check(follower, 0x103E, 2, 4) ? passed++ : failed++;
+    follow_thumb_and_check(follower, 0x203E, 0, 7) ? passed++ : failed++;
+
+    mapper.RemoveAllAccessors();
+    tests_passed += passed;
+    tests_failed += failed;
+    log_test_end(__FUNCTION__, passed, failed);
+}
+
 /************************************************************************
  * main program 
  */
@@ -763,6 +1862,28 @@ int main(int argc, char* argv[])
 
     test_mem_spaces();
 
+    test_many_accessors();
+
+    test_read_ptr();
+
+    test_file_ranges();
+
+    test_per_trace_id_mapper();
+
+    test_cache_page_sets();
+
+    test_cache_context_tags();
+
+    test_mem_acc_stats();
+
+    test_cb_read_ahead();
+
+    test_nacc_cache();
+
+    test_cache_resize();
+
+    test_thumb_end_of_mem();
+
        
     oss.str("");
     oss << "\n*** Memory access tests complete.***\nPassed: " << tests_passed << "; Failed: " << tests_failed << "\n";
@@ -85,6 +85,13 @@ static uint32_t add_create_flags = 0;
 static bool macc_cache_disable = false;
 static uint32_t macc_cache_page_size = 0;
 static uint32_t macc_cache_page_num = 0;
+static uint32_t macc_file_opts = OCSD_FILE_MEM_ACC_OPT_NONE;
+static memacc_mapper_t macc_mapper_type = MEMACC_MAP_GLOBAL;
+static std::vector<std::string> code_map_files;   // pre-decoded code maps for memory images
+static int dcd_threads = 0;     // worker threads for per trace ID decode - 0 to decode on main thread.
+static bool dcd_pipeline = false;   // deformatter on its own thread, feeding the decode worker threads.
+static int seg_threads = 0;     // worker threads for segment decode of a single source - 0 for none.
+static uint32_t seg_size = 0;   // target segment size - 0 for library default.
 
 static SnapShotReader ss_reader;
 
@@ -204,10 +211,17 @@ void print_help()
     oss << "-tpiu_hsync         Input from TPIU - sync by FSYNC and HSYNC.\n";
     oss << "-decode             Full decode of the packets from the trace snapshot (default is to list undecoded packets only)\n";
     oss << "-decode_only        Does not list the undecoded packets, just the trace decode.\n";
+    oss << "-dcd_threads <n>    Decode each trace ID on a pool of <n> worker threads (implies -decode_only).\n";
+    oss << "                    Output for each ID is in order, output for different IDs may interleave differently.\n";
+    oss << "-dcd_pipeline <n>   As -dcd_threads, with the deformatter on its own thread feeding the <n> decode threads.\n";
+    oss << "-seg_threads <n>    Single ETMv4 / ETE source, unformatted: split the trace at sync points and decode\n";
+    oss << "                    the segments on <n> worker threads (implies -decode_only).\n";
+    oss << "-seg_size <n>       Target segment size in bytes for -seg_threads. Minimum " << OCSD_DCD_SEG_SIZE_MIN << ", default " << OCSD_DCD_SEG_SIZE_DEF << ".\n";
     oss << "-o_raw_packed       Output raw packed trace frames\n";
     oss << "-o_raw_unpacked     Output raw unpacked trace data per ID\n";
     oss << "-src_addr_n         ETE protocol: Split source address ranges on N atoms\n";
-    oss << "-stats              Output packet processing statistics (if available).\n";
+    oss << "-merge_ranges       ETMv4 / ETE protocol: Merge atom ranges joined by N atoms into a single range\n";
+    oss << "-stats              Output packet processing and memory access statistics (if available).\n";
     oss << "-no_time_print      Do not output the elapsed time for tests.\n";
     oss << "\nConsistency checks\n\n";
     oss << "-aa64_opcode_chk    Check for correct AA64 opcodes (MSW != 0x0000)\n";
@@ -221,6 +235,10 @@ void print_help()
     oss << "-macc_cache_disable Switch off caching on memory accessor\n";
     oss << "-macc_cache_p_size  Set size of caching pages\n";
     oss << "-macc_cache_p_num   Set number of caching pages\n";
+    oss << "-macc_file_mmap     Map memory image files into memory rather than reading through file streams\n";
+    oss << "-macc_map_trcid     Use memory mapper with separate accessors and caches per trace ID\n";
+    oss << "-no_blk_cache       Switch off caching of decoded instruction blocks in PE decoders\n";
+    oss << "-code_map <file>    Load a code map for a memory image (created by code-map-gen). May be repeated.\n";
     oss << "\nOutput:\n";
     oss << "   Setting any of these options cancels the default output to file & stdout,\n   using _only_ the options supplied.\n\n";
     oss << "-logstdout          Output to stdout -> console.\n";
@@ -425,10 +443,47 @@ bool process_cmd_line_opts(int argc, char* argv[])
                 no_undecoded_packets = true;
                 decode = true; 
             }
+            else if ((strcmp(argv[optIdx], "-dcd_threads") == 0) || (strcmp(argv[optIdx], "-dcd_pipeline") == 0))
+            {
+                dcd_pipeline = (strcmp(argv[optIdx], "-dcd_pipeline") == 0);
+                options_to_process--;
+                optIdx++;
+                if (options_to_process)
+                    dcd_threads = (int)strtol(argv[optIdx], 0, 0);
+                no_undecoded_packets = true;
+                decode = true;
+            }
+            else if (strcmp(argv[optIdx], "-seg_threads") == 0)
+            {
+                options_to_process--;
+                optIdx++;
+                if (options_to_process)
+                    seg_threads = (int)strtol(argv[optIdx], 0, 0);
+                no_undecoded_packets = true;
+                decode = true;
+            }
+            else if (strcmp(argv[optIdx], "-seg_size") == 0)
+            {
+                options_to_process--;
+                optIdx++;
+                if (options_to_process)
+                    seg_size = (uint32_t)strtoul(argv[optIdx], 0, 0);
+                if (seg_size < OCSD_DCD_SEG_SIZE_MIN)
+                {
+                    std::ostringstream errstr;
+                    errstr << "Trace Packet Lister : Error: -seg_size must be at least " << OCSD_DCD_SEG_SIZE_MIN << " bytes\n";
+                    logger.LogMsg(errstr.str());
+                    bOptsOK = false;
+                }
+            }
             else if (strcmp(argv[optIdx], "-src_addr_n") == 0)
             {
                 add_create_flags |= ETE_OPFLG_PKTDEC_SRCADDR_N_ATOMS;
             }
+            else if (strcmp(argv[optIdx], "-merge_ranges") == 0)
+            {
+                add_create_flags |= ETM4_OPFLG_PKTDEC_MERGE_ATOM_RANGES;
+            }
             else if (strcmp(argv[optIdx], "-stats") == 0)
             {
                 stats = true;
@@ -491,6 +546,10 @@ bool process_cmd_line_opts(int argc, char* argv[])
             {
                 add_create_flags |= ETM4_OPFLG_PKTDEC_AA64_OPCODE_CHK;
             }
+            else if (strcmp(argv[optIdx], "-no_blk_cache") == 0)
+            {
+                add_create_flags |= OCSD_OPFLG_PKTDEC_NO_BLK_CACHE;
+            }
             else if (strcmp(argv[optIdx], "-macc_cache_disable") == 0)
             {
                 macc_cache_disable = true;
@@ -509,6 +568,21 @@ bool process_cmd_line_opts(int argc, char* argv[])
                 if (options_to_process)
                     macc_cache_page_num = (uint32_t)strtoul(argv[optIdx], 0, 0);
             }
+            else if (strcmp(argv[optIdx], "-macc_file_mmap") == 0)
+            {
+                macc_file_opts |= OCSD_FILE_MEM_ACC_OPT_MMAP;
+            }
+            else if (strcmp(argv[optIdx], "-macc_map_trcid") == 0)
+            {
+                macc_mapper_type = MEMACC_MAP_PER_TRACE_ID;
+            }
+            else if (strcmp(argv[optIdx], "-code_map") == 0)
+            {
+                options_to_process--;
+                optIdx++;
+                if (options_to_process)
+                    code_map_files.push_back(argv[optIdx]);
+            }
             else
             {
                 std::ostringstream errstr;
@@ -591,6 +665,24 @@ void AttachPacketPrinters( DecodeTree *dcd_tree)
 
 }
 
+void ConfigureMemAccCache(DecodeTree *dcd_tree)
+{
+    if (macc_cache_disable || macc_cache_page_size || macc_cache_page_num)
+    {
+        if (macc_cache_disable)
+            dcd_tree->setMemAccCacheing(false, 0, 0);
+        else 
+        {
+            // one value set - set the other to default
+            if (!macc_cache_page_size)
+                macc_cache_page_size = MEM_ACC_CACHE_DEFAULT_PAGE_SIZE;
+            if (!macc_cache_page_num)
+                macc_cache_page_num = MEM_ACC_CACHE_DEFAULT_MRU_SIZE;
+            dcd_tree->setMemAccCacheing(true, macc_cache_page_size, macc_cache_page_num);
+        }
+    }
+}
+
 void ConfigureFrameDeMux(DecodeTree *dcd_tree, RawFramePrinter **framePrinter)
 {
     // configure the frame deformatter, and attach a frame printer to the frame deformatter if needed
@@ -673,6 +765,22 @@ void PrintDecodeStats(DecodeTree *dcd_tree)
         oss << "Total bytes processed by frame demux: " << std::dec << total << "\n\n";
         logger.LogMsg(oss.str());          
     }
+
+    ocsd_mem_acc_stats_t mem_acc_stats;
+    if (dcd_tree->getMemAccStats(&mem_acc_stats) == OCSD_OK) {
+        oss.str("");
+        oss << "\nMemory Access Stats\n";
+        oss << "Cache hits: " << std::dec << mem_acc_stats.cache_hits << "; misses: " << mem_acc_stats.cache_misses;
+        oss << "; page loads: " << mem_acc_stats.page_loads << "; evictions: " << mem_acc_stats.page_evictions << "\n";
+        oss << "Hit runs: " << mem_acc_stats.hit_runs << "; max run length: " << mem_acc_stats.hit_run_max << "\n";
+        oss << "Invalidate by ID: " << mem_acc_stats.inval_trace_id << "; invalidate all: " << mem_acc_stats.inval_all;
+        oss << "; pages invalidated: " << mem_acc_stats.inval_pages << "\n";
+        oss << "Accessor reads: " << mem_acc_stats.acc_reads << "; bytes from file: " << mem_acc_stats.acc_bytes_file;
+        oss << "; buffer: " << mem_acc_stats.acc_bytes_buffer << "; callback: " << mem_acc_stats.acc_bytes_cb;
+        oss << "; client callbacks: " << mem_acc_stats.acc_callbacks << "\n";
+        oss << "Unmapped reads: " << mem_acc_stats.unmapped_reads << "; negative cache hits: " << mem_acc_stats.unmapped_hits << "\n\n";
+        logger.LogMsg(oss.str());
+    }
 }
 
 bool ProcessInputFile(DecodeTree *dcd_tree, std::string &in_filename, 
@@ -763,6 +871,10 @@ bool ProcessInputFile(DecodeTree *dcd_tree, std::string &in_filename,
             }
         }
 
+        // mark end of trace into the data path - with decode threads, this returns any fatal error from the last data.
+        if (!OCSD_DATA_RESP_IS_FATAL(dataPathResp))
+            dataPathResp = dcd_tree->TraceDataIn(OCSD_OP_EOT, 0, 0, 0, 0);
+
         // fatal error - no futher processing
         if (OCSD_DATA_RESP_IS_FATAL(dataPathResp))
         {
@@ -774,11 +886,6 @@ bool ProcessInputFile(DecodeTree *dcd_tree, std::string &in_filename,
                 logger.LogMsg(ocsdError::getErrorString(perr));
             bOK = false;
         }
-        else
-        {
-            // mark end of trace into the data path
-            dcd_tree->TraceDataIn(OCSD_OP_EOT, 0, 0, 0, 0);            
-        }
 
         // close the input file.
         in.close();
@@ -795,7 +902,7 @@ bool ProcessInputFile(DecodeTree *dcd_tree, std::string &in_filename,
         logger.LogMsg(oss.str());
         if (stats)
             PrintDecodeStats(dcd_tree);
-        if (profile)
+        if (profile && genElemPrinter)
             genElemPrinter->printStats();
 
         // multi-session - reset the decoder for the next pass.
@@ -811,12 +918,142 @@ bool ProcessInputFile(DecodeTree *dcd_tree, std::string &in_filename,
     return bOK;
 }
 
+bool ProcessInputFileSegments(DecodeSegments *dcd_segs, std::string &in_filename,
+                              TrcGenericElementPrinter* genElemPrinter, ocsdDefaultErrorLogger& err_logger)
+{
+    bool bOK = true;
+    std::chrono::time_point<std::chrono::steady_clock> start, end;   // measure decode time
+    std::ifstream in;
+
+    in.open(in_filename, std::ifstream::in | std::ifstream::binary);
+    if (in.is_open())
+    {
+        ocsd_err_t err = OCSD_OK;
+        std::vector<uint8_t> trace_buffer(0x40000);   // segments are split from blocks of the file
+        uint32_t trace_index = 0;
+
+        start = std::chrono::steady_clock::now();
+
+        while (!in.eof() && (err == OCSD_OK))
+        {
+            in.read((char*)trace_buffer.data(), trace_buffer.size());
+            uint32_t nBuffRead = (uint32_t)in.gcount();
+            if (nBuffRead)
+                err = dcd_segs->decodeData(trace_index, nBuffRead, trace_buffer.data());
+            trace_index += nBuffRead;
+        }
+        if (err == OCSD_OK)
+            err = dcd_segs->decodeEnd();
+
+        if (err != OCSD_OK)
+        {
+            std::ostringstream oss;
+            oss << "Trace Packet Lister : Segment decode error : " << ocsdError::getErrorString(ocsdError(OCSD_ERR_SEV_ERROR, err)) << "\n";
+            logger.LogMsg(oss.str());
+            ocsdError* perr = err_logger.GetLastError();
+            if (perr != 0)
+                logger.LogMsg(ocsdError::getErrorString(perr));
+            bOK = false;
+        }
+        in.close();
+
+        std::ostringstream oss;
+        end = std::chrono::steady_clock::now();
+        std::chrono::duration<double> sec_elapsed{end -start};
+
+        oss << "Trace Packet Lister : Trace buffer done, processed " << trace_index << " bytes in " << dcd_segs->numSegments() << " segments";
+        if (no_time_print)
+            oss << ".\n";
+        else
+            oss << " in " << std::setprecision(8) << sec_elapsed.count() << " seconds.\n";
+        logger.LogMsg(oss.str());
+        if (profile && genElemPrinter)
+            genElemPrinter->printStats();
+
+        dcd_segs->reset();
+    }
+    else
+    {
+        std::ostringstream oss;
+        oss << "Trace Packet Lister : Error : Unable to open trace buffer.\n";
+        logger.LogMsg(oss.str());
+    }
+    return bOK;
+}
+
+/* create a decode tree per segment worker - returns 0 if the source cannot be decoded in segments */
+DecodeSegments *CreateSegmentDecode(ocsdDefaultErrorLogger &err_logger, SnapShotReader &reader, const std::string &trace_buffer_name,
+                                    const uint32_t createFlags, TrcGenericElementPrinter *genElemPrinter,
+                                    std::vector<CreateDcdTreeFromSnapShot *> &seg_creators)
+{
+    static ocsdDefaultErrorLogger create_logger;    // snapshot messages already logged creating the main tree.
+    std::ostringstream oss;
+    ocsd_err_t err = OCSD_OK;
+    DecodeSegments *dcd_segs = new (std::nothrow) DecodeSegments();
+
+    create_logger.initErrorLogger(OCSD_ERR_SEV_ERROR);
+    if (!dcd_segs)
+        err = OCSD_ERR_MEM;
+    else if (seg_size)
+        err = dcd_segs->setSegmentSize(seg_size);
+
+    for (int i = 0; (i < seg_threads) && (err == OCSD_OK); i++)
+    {
+        CreateDcdTreeFromSnapShot *p_creator = new (std::nothrow) CreateDcdTreeFromSnapShot();
+        if (!p_creator)
+        {
+            err = OCSD_ERR_MEM;
+            break;
+        }
+        seg_creators.push_back(p_creator);
+        p_creator->initialise(&reader, &create_logger);
+        p_creator->setFileMemAccOpts(macc_file_opts);
+        p_creator->setMemAccMapperType(macc_mapper_type);
+        if (!p_creator->createDecodeTree(trace_buffer_name, false, createFlags))
+        {
+            err = OCSD_ERR_NOT_INIT;
+            break;
+        }
+        DecodeTree *p_tree = p_creator->getDecodeTree();
+        p_tree->setAlternateErrorLogger(&err_logger);
+        ConfigureMemAccCache(p_tree);
+        err = dcd_segs->addWorkerTree(p_tree);
+    }
+
+    if (err == OCSD_OK)
+    {
+        dcd_segs->setGenTraceElemOutI(genElemPrinter);
+        oss << "Trace Packet Lister : Decoding trace segments on " << seg_threads << " worker threads\n";
+    }
+    else
+    {
+        delete dcd_segs;
+        dcd_segs = 0;
+        oss << "Trace Packet Lister : Warning: Failed to set segment decode - " << ocsdError::getErrorString(ocsdError(OCSD_ERR_SEV_WARN, err)) << "\n";
+    }
+    logger.LogMsg(oss.str());
+    return dcd_segs;
+}
+
+void DestroySegmentDecode(DecodeSegments *dcd_segs, std::vector<CreateDcdTreeFromSnapShot *> &seg_creators)
+{
+    delete dcd_segs;
+    for (size_t i = 0; i < seg_creators.size(); i++)
+    {
+        seg_creators[i]->destroyDecodeTree();
+        delete seg_creators[i];
+    }
+    seg_creators.clear();
+}
+
 void ListTracePackets(ocsdDefaultErrorLogger &err_logger, SnapShotReader &reader, const std::string &trace_buffer_name)
 {
     CreateDcdTreeFromSnapShot tree_creator;
     uint32_t createFlags = add_create_flags;
 
     tree_creator.initialise(&reader, &err_logger);
+    tree_creator.setFileMemAccOpts(macc_file_opts);
+    tree_creator.setMemAccMapperType(macc_mapper_type);
 
     if(tree_creator.createDecodeTree(trace_buffer_name, (decode == false), createFlags))
     {
@@ -846,22 +1083,36 @@ void ListTracePackets(ocsdDefaultErrorLogger &err_logger, SnapShotReader &reader
                 genElemPrinter->setMute(true);
                 genElemPrinter->set_collect_stats();
             }
-            if (macc_cache_disable || macc_cache_page_size || macc_cache_page_num)
+            ConfigureMemAccCache(dcd_tree);
+
+            for (size_t i = 0; i < code_map_files.size(); i++)
             {
-                if (macc_cache_disable)
-                    dcd_tree->setMemAccCacheing(false, 0, 0);
-                else 
-                {
-                    // one value set - set the other to default
-                    if (!macc_cache_page_size)
-                        macc_cache_page_size = MEM_ACC_CACHE_DEFAULT_PAGE_SIZE;
-                    if (!macc_cache_page_num)
-                        macc_cache_page_num = MEM_ACC_CACHE_DEFAULT_MRU_SIZE;
-                    dcd_tree->setMemAccCacheing(true, macc_cache_page_size, macc_cache_page_num);
-                }
+                ocsd_err_t map_err = dcd_tree->addCodeMapFile(code_map_files[i], OCSD_MEM_SPACE_ANY);
+                oss.str("");
+                if (map_err == OCSD_OK)
+                    oss << "Trace Packet Lister : Loaded code map " << code_map_files[i] << "\n";
+                else
+                    oss << "Trace Packet Lister : Warning: Failed to load code map " << code_map_files[i] << " - " << ocsdError::getErrorString(ocsdError(OCSD_ERR_SEV_WARN, map_err)) << "\n";
+                logger.LogMsg(oss.str());
             }
         }
 
+        if(decode && dcd_threads)
+        {
+            std::ostringstream oss;
+            ocsd_err_t thread_err = dcd_pipeline ? dcd_tree->setDecodePipeline(dcd_threads) : dcd_tree->setDecodeThreads(dcd_threads);
+            if (thread_err == OCSD_OK)
+                oss << "Trace Packet Lister : Decoding trace IDs on " << dcd_threads << " worker threads" << (dcd_pipeline ? ", deformatter pipelined" : "") << "\n";
+            else
+                oss << "Trace Packet Lister : Warning: Failed to set decode threads - " << ocsdError::getErrorString(ocsdError(OCSD_ERR_SEV_WARN, thread_err)) << "\n";
+            logger.LogMsg(oss.str());
+        }
+
+        DecodeSegments *dcd_segs = 0;
+        std::vector<CreateDcdTreeFromSnapShot *> seg_creators;
+        if(decode && seg_threads)
+            dcd_segs = CreateSegmentDecode(err_logger, reader, trace_buffer_name, createFlags, genElemPrinter, seg_creators);
+
         if(decode)
             dcd_tree->logMappedRanges();    // print out the mapped ranges
 
@@ -878,7 +1129,10 @@ void ListTracePackets(ocsdDefaultErrorLogger &err_logger, SnapShotReader &reader
             if (!multi_session) 
             {
                 binFileName = tree_creator.getBufferFileName();
-                ProcessInputFile(dcd_tree, binFileName, genElemPrinter, err_logger);
+                if (dcd_segs)
+                    ProcessInputFileSegments(dcd_segs, binFileName, genElemPrinter, err_logger);
+                else
+                    ProcessInputFile(dcd_tree, binFileName, genElemPrinter, err_logger);
             }
             else
             {
@@ -902,7 +1156,8 @@ void ListTracePackets(ocsdDefaultErrorLogger &err_logger, SnapShotReader &reader
                         break;
                     }
 
-                    if (!ProcessInputFile(dcd_tree, binFileName, genElemPrinter, err_logger)) {
+                    if (dcd_segs ? !ProcessInputFileSegments(dcd_segs, binFileName, genElemPrinter, err_logger) :
+                                   !ProcessInputFile(dcd_tree, binFileName, genElemPrinter, err_logger)) {
                         oss.str("");
                         oss << "Trace Packet Lister : ERROR : Multi-session decode for buffer " << sourceBuffList[i] << " failed. Aborting.\n\n";
                         logger.LogMsg(oss.str());
@@ -922,6 +1177,7 @@ void ListTracePackets(ocsdDefaultErrorLogger &err_logger, SnapShotReader &reader
         }
 
         // clean up
+        DestroySegmentDecode(dcd_segs, seg_creators);
 
         // get rid of the decode tree.
         tree_creator.destroyDecodeTree();